@@ -35,6 +35,7 @@
 
 namespace KlayGE
 {
+	// Streams of the calling thread. Every line is handed to Logger in the General category, so they don't block on I/O.
 	std::ostream& LogDebug();
 	std::ostream& LogInfo();
 	std::ostream& LogWarn();
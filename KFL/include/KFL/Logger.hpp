@@ -0,0 +1,269 @@
+/**
+ * @file Logger.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#ifndef KFL_LOGGER_HPP
+#define KFL_LOGGER_HPP
+
+#pragma once
+
+#include <KFL/CXX20/format.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+namespace KlayGE
+{
+	enum class LogSeverity : uint8_t
+	{
+		Debug,
+		Info,
+		Warn,
+		Error,
+
+		Num
+	};
+
+	enum class LogCategory : uint8_t
+	{
+		General,
+		Render,
+		Resource,
+		Scene,
+		Audio,
+		Input,
+		Script,
+		Network,
+		Tool,
+		App,
+
+		Num
+	};
+
+	namespace Detail
+	{
+		// How an argument is copied into a log record, and read back on the logging thread. Strings are copied, everything
+		// else has to be trivially copyable.
+		template <typename T>
+		struct LogArgTraits
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "Log arguments have to be strings or trivially copyable");
+
+			using DecodedType = T;
+
+			static uint32_t Size(T const & arg) noexcept
+			{
+				(void)arg;
+				return sizeof(T);
+			}
+			static uint8_t* Encode(uint8_t* dst, T const & arg) noexcept
+			{
+				std::memcpy(dst, &arg, sizeof(T));
+				return dst + sizeof(T);
+			}
+			static T Decode(uint8_t const *& src) noexcept
+			{
+				T ret;
+				std::memcpy(&ret, src, sizeof(T));
+				src += sizeof(T);
+				return ret;
+			}
+		};
+
+		struct LogStringArgTraits
+		{
+			using DecodedType = std::string_view;
+
+			static uint32_t Size(std::string_view arg) noexcept
+			{
+				return static_cast<uint32_t>(sizeof(uint32_t) + arg.size());
+			}
+			static uint8_t* Encode(uint8_t* dst, std::string_view arg) noexcept
+			{
+				uint32_t const size = static_cast<uint32_t>(arg.size());
+				std::memcpy(dst, &size, sizeof(size));
+				std::memcpy(dst + sizeof(size), arg.data(), size);
+				return dst + sizeof(size) + size;
+			}
+			static std::string_view Decode(uint8_t const *& src) noexcept
+			{
+				uint32_t size;
+				std::memcpy(&size, src, sizeof(size));
+				std::string_view const ret(reinterpret_cast<char const *>(src + sizeof(size)), size);
+				src += sizeof(size) + size;
+				return ret;
+			}
+		};
+
+		template <>
+		struct LogArgTraits<std::string> : LogStringArgTraits
+		{
+		};
+		template <>
+		struct LogArgTraits<std::string_view> : LogStringArgTraits
+		{
+		};
+		template <>
+		struct LogArgTraits<char const *> : LogStringArgTraits
+		{
+		};
+		template <>
+		struct LogArgTraits<char*> : LogStringArgTraits
+		{
+		};
+
+		template <typename... Args>
+		std::string FormatLogRecord(char const * format, [[maybe_unused]] uint8_t const * payload)
+		{
+			// payload is unused when there is no argument
+			std::tuple<typename LogArgTraits<Args>::DecodedType...> args{LogArgTraits<Args>::Decode(payload)...};
+			return std::apply([format](auto const &... decoded) { return std::vformat(format, std::make_format_args(decoded...)); },
+				args);
+		}
+	}
+
+	// Asynchronous logging. A record is the format string, a function to format it and the arguments copied in binary. It's
+	// put on a lock free queue of the calling thread, and a background thread formats the records in time order and writes
+	// them to the console and a log file. So logging never waits on I/O, and lines from different threads never interleave.
+	// Errors are the exception, Log waits until they are written in case a crash follows.
+	class Logger final : boost::noncopyable
+	{
+	public:
+		using FormatFunc = std::string (*)(char const * format, uint8_t const * payload);
+
+		static Logger& Instance();
+
+		~Logger();
+
+		static bool Enabled(LogSeverity severity, LogCategory category) noexcept
+		{
+			return (enabled_categories_[static_cast<uint32_t>(severity)].load(std::memory_order_relaxed)
+				>> static_cast<uint32_t>(category)) & 1;
+		}
+		void MinSeverity(LogSeverity severity);
+		void CategoryEnabled(LogCategory category, bool enabled);
+
+		// The file is renamed to file_name.1, file_name.2 and so on once it would grow over max_size bytes. An empty name
+		// disables the log file.
+		void LogFile(std::string const & file_name, uint64_t max_size = 8 * 1024 * 1024, uint32_t max_backups = 3);
+		void ConsoleEnabled(bool enabled);
+
+		// format has to be a string literal, or outlive the logger, since only its pointer is kept. Arguments are copied.
+		// Check Enabled first to skip evaluating them, as KLAYGE_LOG does.
+		template <typename... Args>
+		void Log(LogSeverity severity, LogCategory category, char const * format, Args const &... args)
+		{
+			uint32_t const payload_size = (0 + ... + Detail::LogArgTraits<std::decay_t<Args>>::Size(args));
+			[[maybe_unused]] uint8_t* payload =
+				this->BeginRecord(severity, category, format, &Detail::FormatLogRecord<std::decay_t<Args>...>, payload_size);
+			((payload = Detail::LogArgTraits<std::decay_t<Args>>::Encode(payload, args)), ...);
+			this->EndRecord(severity);
+		}
+
+		// Returns once everything logged before has been written
+		void Flush();
+
+	private:
+		struct ThreadQueue;
+
+		Logger();
+
+		uint8_t* BeginRecord(
+			LogSeverity severity, LogCategory category, char const * format, FormatFunc format_func, uint32_t payload_size);
+		void EndRecord(LogSeverity severity);
+		ThreadQueue& CurrentThreadQueue();
+
+		void UpdateEnabledCategories();
+
+		void BackendFunc();
+		void WriteRecords();
+		void WriteLine(LogSeverity severity, std::string const & line);
+
+	private:
+		// A bit per category, for each severity
+		static std::atomic<uint32_t> enabled_categories_[static_cast<uint32_t>(LogSeverity::Num)];
+
+		std::mutex config_mutex_;
+		LogSeverity min_severity_;
+		uint32_t category_mask_ = ~0U;
+
+		std::mutex queues_mutex_;
+		std::vector<std::shared_ptr<ThreadQueue>> queues_;
+		uint32_t next_thread_index_ = 0;
+
+		std::mutex backend_mutex_;
+		std::condition_variable backend_cond_;
+		std::condition_variable flushed_cond_;
+		uint64_t flush_requests_ = 0;
+		uint64_t flushed_requests_ = 0;
+		bool wakeup_requested_ = false;
+		bool quit_ = false;
+		std::thread backend_thread_;
+
+		// Only touched by the backend thread, or under sink_mutex_
+		std::mutex sink_mutex_;
+		bool console_enabled_ = true;
+		std::string file_name_;
+		uint64_t max_file_size_ = 0;
+		uint32_t max_backups_ = 0;
+		std::unique_ptr<std::ofstream> file_;
+		uint64_t file_size_ = 0;
+		std::chrono::steady_clock::time_point const start_time_;
+	};
+}
+
+#define KLAYGE_LOG(severity, category, ...)                                                                                      \
+	do                                                                                                                           \
+	{                                                                                                                            \
+		if (KlayGE::Logger::Enabled(severity, category))                                                                         \
+		{                                                                                                                        \
+			KlayGE::Logger::Instance().Log(severity, category, __VA_ARGS__);                                                     \
+		}                                                                                                                        \
+	} while (false)
+
+#define KLAYGE_LOG_DEBUG(category, ...) KLAYGE_LOG(KlayGE::LogSeverity::Debug, KlayGE::LogCategory::category, __VA_ARGS__)
+#define KLAYGE_LOG_INFO(category, ...) KLAYGE_LOG(KlayGE::LogSeverity::Info, KlayGE::LogCategory::category, __VA_ARGS__)
+#define KLAYGE_LOG_WARN(category, ...) KLAYGE_LOG(KlayGE::LogSeverity::Warn, KlayGE::LogCategory::category, __VA_ARGS__)
+#define KLAYGE_LOG_ERROR(category, ...) KLAYGE_LOG(KlayGE::LogSeverity::Error, KlayGE::LogCategory::category, __VA_ARGS__)
+
+#endif		// KFL_LOGGER_HPP
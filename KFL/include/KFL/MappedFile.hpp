@@ -0,0 +1,71 @@
+/**
+ * @file MappedFile.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+
+#ifndef KFL_MAPPED_FILE_HPP
+#define KFL_MAPPED_FILE_HPP
+
+#pragma once
+
+#include <KFL/CXX20/span.hpp>
+
+#include <string>
+
+namespace KlayGE
+{
+	// Maps a whole file as read only memory
+	class MappedFile final
+	{
+	public:
+		MappedFile() noexcept;
+		~MappedFile() noexcept;
+
+		MappedFile(MappedFile const & rhs) = delete;
+		MappedFile& operator=(MappedFile const & rhs) = delete;
+
+		bool Map(std::string const & file_name);
+		void Unmap() noexcept;
+
+		std::span<uint8_t const> Data() const noexcept
+		{
+			return std::span(static_cast<uint8_t const*>(data_), size_);
+		}
+
+	private:
+		void* data_ = nullptr;
+		size_t size_ = 0;
+#ifdef KLAYGE_PLATFORM_WINDOWS
+		void* file_handle_ = nullptr;
+		void* mapping_handle_ = nullptr;
+#endif
+	};
+}
+
+#endif		// KFL_MAPPED_FILE_HPP
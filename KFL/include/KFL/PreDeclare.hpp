@@ -49,6 +49,8 @@ namespace KlayGE
 	class JsonValue;
 
 	class ThreadPool;
+	class TaskGroup;
+	class TaskScheduler;
 
 	class half;
 	template <typename T, int N>
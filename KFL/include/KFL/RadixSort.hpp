@@ -0,0 +1,107 @@
+/**
+ * @file RadixSort.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#ifndef KFL_RADIX_SORT_HPP
+#define KFL_RADIX_SORT_HPP
+
+#pragma once
+
+#include <KFL/Types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+namespace KlayGE
+{
+	// Stable LSD radix sort of (key, value) pairs on an unsigned integer key, 8 bits per pass. tmp is used as the scratch buffer,
+	// keeping it around between calls saves the allocation. The passes on the bytes that are the same in all the keys are skipped.
+	template <typename Key, typename Value>
+	void RadixSort(std::vector<std::pair<Key, Value>>& items, std::vector<std::pair<Key, Value>>& tmp)
+	{
+		static_assert(std::is_unsigned_v<Key>);
+
+		uint32_t constexpr NUM_PASSES = sizeof(Key);
+
+		size_t const num_items = items.size();
+		if (num_items <= 1)
+		{
+			return;
+		}
+		BOOST_ASSERT(num_items <= 0xFFFFFFFFU);
+
+		std::array<std::array<uint32_t, 256>, NUM_PASSES> histograms{};
+		for (auto const & item : items)
+		{
+			for (uint32_t pass = 0; pass < NUM_PASSES; ++ pass)
+			{
+				++ histograms[pass][(item.first >> (pass * 8)) & 0xFF];
+			}
+		}
+
+		tmp.resize(num_items);
+		auto* src = items.data();
+		auto* dst = tmp.data();
+		for (uint32_t pass = 0; pass < NUM_PASSES; ++ pass)
+		{
+			auto& histogram = histograms[pass];
+			if (histogram[(src[0].first >> (pass * 8)) & 0xFF] == num_items)
+			{
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (auto& count : histogram)
+			{
+				uint32_t const c = count;
+				count = offset;
+				offset += c;
+			}
+
+			for (size_t i = 0; i < num_items; ++ i)
+			{
+				auto const & item = src[i];
+				dst[histogram[(item.first >> (pass * 8)) & 0xFF]++] = item;
+			}
+			std::swap(src, dst);
+		}
+
+		if (src != items.data())
+		{
+			std::copy(src, src + num_items, items.data());
+		}
+	}
+}
+
+#endif		// KFL_RADIX_SORT_HPP
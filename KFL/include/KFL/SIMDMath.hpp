@@ -34,10 +34,15 @@
 #pragma once
 
 #include <KFL/PreDeclare.hpp>
+#include <KFL/CXX20/span.hpp>
 
 #if defined(KLAYGE_SSE_SUPPORT)
 	#define SIMD_MATH_SSE
 	#include <xmmintrin.h>
+#elif defined(KLAYGE_CPU_ARM64) && !defined(KLAYGE_COMPILER_MSVC)
+	// The general path indexes vector lanes directly, which MSVC's NEON types don't support
+	#define SIMD_MATH_NEON
+	#include <arm_neon.h>
 #else
 	#define SIMD_MATH_GENERAL
 #endif
@@ -46,6 +51,7 @@ namespace KlayGE
 {
 	class SIMDVectorF4;
 	class SIMDMatrixF4;
+	enum class BoundOverlap : uint32_t;
 
 	namespace SIMDMathLib
 	{
@@ -85,6 +91,10 @@ namespace KlayGE
 		void StoreVector2(float2& fs, SIMDVectorF4 const & v);
 		void StoreVector3(float3& fs, SIMDVectorF4 const & v);
 		void StoreVector4(float4& fs, SIMDVectorF4 const & v);
+		SIMDMatrixF4 LoadMatrix(float4x4 const & m);
+		void StoreMatrix(float4x4& m, SIMDMatrixF4 const & v);
+		SIMDVectorF4 LoadQuaternion(Quaternion const & q);
+		void StoreQuaternion(Quaternion& q, SIMDVectorF4 const & v);
 		SIMDVectorF4 SetVector(float x, float y, float z, float w);
 		SIMDVectorF4 SetVector(float v);
 		float GetX(SIMDVectorF4 const & rhs);
@@ -251,6 +261,17 @@ namespace KlayGE
 		// From Game Programming Gems 5, Section 2.6.
 		void ObliqueClipping(SIMDMatrixF4& proj, SIMDVectorF4 const & clip_plane);
 
+		// Bound
+		///////////////////////////////////////////////////////////////////////////////
+		AABBox TransformAABB(AABBox const & aabb, SIMDMatrixF4 const & mat);
+		BoundOverlap IntersectAABBFrustum(AABBox const & aabb, Frustum const & frustum);
+
+		// Batch
+		///////////////////////////////////////////////////////////////////////////////
+		// Same results as the per-item functions. Uses AVX2 to process two vectors or two matrix rows per instruction if the CPU supports it.
+		void TransformVector4(std::span<SIMDVectorF4> out, std::span<SIMDVectorF4 const> vs, SIMDMatrixF4 const & mat);
+		void Multiply(std::span<SIMDMatrixF4> out, std::span<SIMDMatrixF4 const> lhs, std::span<SIMDMatrixF4 const> rhs);
+
 
 		// Color
 		///////////////////////////////////////////////////////////////////////////////
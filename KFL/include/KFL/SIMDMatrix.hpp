@@ -52,8 +52,11 @@ namespace KlayGE
 		constexpr SIMDMatrixF4(SIMDMatrixF4 const& rhs) : m_(rhs.m_)
 		{
 		}
-		SIMDMatrixF4(SIMDVectorF4 const & v1, SIMDVectorF4 const & v2,
-			SIMDVectorF4 const & v3, SIMDVectorF4 const & v4);
+		constexpr SIMDMatrixF4(SIMDVectorF4 const & v1, SIMDVectorF4 const & v2,
+			SIMDVectorF4 const & v3, SIMDVectorF4 const & v4) noexcept
+			: m_{v1, v2, v3, v4}
+		{
+		}
 		SIMDMatrixF4(float f11, float f12, float f13, float f14,
 			float f21, float f22, float f23, float f24,
 			float f31, float f32, float f33, float f34,
@@ -67,8 +70,14 @@ namespace KlayGE
 		static SIMDMatrixF4 const & Zero();
 		static SIMDMatrixF4 const & Identity();
 
-		void Row(size_t index, SIMDVectorF4 const & rhs);
-		SIMDVectorF4 const & Row(size_t index) const;
+		constexpr void Row(size_t index, SIMDVectorF4 const & rhs) noexcept
+		{
+			m_[index] = rhs;
+		}
+		constexpr SIMDVectorF4 const & Row(size_t index) const noexcept
+		{
+			return m_[index];
+		}
 		void Col(size_t index, SIMDVectorF4 const & rhs);
 		SIMDVectorF4 const Col(size_t index) const;
 
@@ -81,7 +90,11 @@ namespace KlayGE
 		SIMDMatrixF4& operator*=(float rhs);
 		SIMDMatrixF4& operator/=(float rhs);
 
-		SIMDMatrixF4& operator=(SIMDMatrixF4 const & rhs);
+		constexpr SIMDMatrixF4& operator=(SIMDMatrixF4 const & rhs) noexcept
+		{
+			m_ = rhs.m_;
+			return *this;
+		}
 
 		constexpr SIMDMatrixF4 const& operator+() const
 		{
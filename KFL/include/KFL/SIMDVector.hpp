@@ -39,6 +39,8 @@ namespace KlayGE
 {
 #if defined(SIMD_MATH_SSE)
 	typedef __m128 V4TYPE;
+#elif defined(SIMD_MATH_NEON)
+	typedef float32x4_t V4TYPE;
 #else
 	typedef std::array<float, 4> V4TYPE;
 #endif
@@ -88,7 +90,11 @@ namespace KlayGE
 		SIMDVectorF4 const & operator/=(SIMDVectorF4 const & rhs);
 		SIMDVectorF4 const & operator/=(float rhs);
 
-		SIMDVectorF4& operator=(SIMDVectorF4 const & rhs);
+		constexpr SIMDVectorF4& operator=(SIMDVectorF4 const & rhs) noexcept
+		{
+			vec_ = rhs.vec_;
+			return *this;
+		}
 
 		constexpr SIMDVectorF4 const& operator+() const
 		{
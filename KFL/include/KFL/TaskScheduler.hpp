@@ -0,0 +1,301 @@
+/**
+ * @file TaskScheduler.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#ifndef KFL_TASK_SCHEDULER_HPP
+#define KFL_TASK_SCHEDULER_HPP
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <boost/assert.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace KlayGE
+{
+	namespace Detail
+	{
+		// Keeps an argument out of template argument deduction, same as std::type_identity_t in C++20
+		template <typename T>
+		struct TaskIdentity
+		{
+			using type = T;
+		};
+		template <typename T>
+		using TaskIdentityT = typename TaskIdentity<T>::type;
+	}
+
+	class TaskGroup;
+
+	// A type erased task. Small trivially copyable functors are stored in place, so spawning them doesn't allocate.
+	struct Task
+	{
+		static size_t constexpr STORAGE_SIZE = 48;
+
+		void (*invoke)(Task const & task);
+		TaskGroup* group;
+		alignas(std::max_align_t) std::byte storage[STORAGE_SIZE];
+	};
+
+	// Tasks that can be waited on together. It has to outlive them, and a continuation can be attached to run when they all
+	// have finished.
+	class TaskGroup final : boost::noncopyable
+	{
+		friend class TaskScheduler;
+
+	public:
+		bool Done() const noexcept
+		{
+			return pending_.load(std::memory_order_acquire) == 0;
+		}
+
+	private:
+		// Set in pending_ when there is a continuation. Sharing one atomic with the counter means the last task to finish
+		// always knows whether a continuation has to run.
+		static uint32_t constexpr CONTINUATION_FLAG = 1U << 31;
+
+		// The number of unfinished tasks, and CONTINUATION_FLAG
+		std::atomic<uint32_t> pending_{0};
+
+		// Written once before CONTINUATION_FLAG is set, read only after that
+		Task continuation_;
+	};
+
+	// Fine grained data parallelism. Every worker owns a deque, pushes and pops its own tasks at the back and steals from the
+	// front of the others when it runs out. Threads that are not workers put tasks on a shared queue. A thread waiting for a
+	// group runs tasks instead of blocking, so tasks can spawn and wait for nested tasks.
+	//
+	// Unlike ThreadPool, spawning a task doesn't allocate or go through a global lock, and there is no future. ThreadPool is
+	// still the choice for long running or blocking jobs, such as loading, which would hold a worker.
+	class TaskScheduler final : boost::noncopyable
+	{
+	public:
+		// 0 workers means one less than the hardware threads, since the thread that waits also runs tasks
+		explicit TaskScheduler(uint32_t num_workers = 0);
+		~TaskScheduler();
+
+		uint32_t NumWorkers() const noexcept
+		{
+			return num_workers_;
+		}
+		// The number of threads that run tasks while one of them waits
+		uint32_t Concurrency() const noexcept
+		{
+			return this->NumWorkers() + 1;
+		}
+
+		// Tasks must not throw
+		template <typename Func>
+		void Run(TaskGroup& group, Func&& func)
+		{
+			group.pending_.fetch_add(1, std::memory_order_relaxed);
+			this->Push(MakeTask(group, std::forward<Func>(func)));
+		}
+
+		// Runs func in next_group once all tasks in group have finished, including the ones they spawn. It's allowed once per
+		// group, and the tasks of group can still be running or spawned after it.
+		template <typename Func>
+		void Continue(TaskGroup& group, TaskGroup& next_group, Func&& func)
+		{
+			BOOST_ASSERT((group.pending_.load(std::memory_order_relaxed) & TaskGroup::CONTINUATION_FLAG) == 0);
+
+			next_group.pending_.fetch_add(1, std::memory_order_relaxed);
+			group.continuation_ = MakeTask(next_group, std::forward<Func>(func));
+
+			// Holds the group while setting the flag, so the continuation runs even if the group has finished already
+			group.pending_.fetch_add(TaskGroup::CONTINUATION_FLAG + 1, std::memory_order_release);
+			this->Finish(group);
+		}
+
+		// Runs tasks until all tasks in the group have finished
+		void Wait(TaskGroup& group);
+
+		// Calls func(sub_begin, sub_end) on subranges of [begin, end) no larger than grain_size, and returns when all of them
+		// are done. The range is split in halves on demand, so idle workers steal large pieces.
+		template <typename Index, typename Func>
+		void ParallelFor(Index begin, Detail::TaskIdentityT<Index> end, Detail::TaskIdentityT<Index> grain_size, Func&& func)
+		{
+			static_assert(std::is_integral_v<Index>);
+
+			if (end <= begin)
+			{
+				return;
+			}
+
+			grain_size = std::max<Index>(grain_size, 1);
+			if ((num_workers_ == 0) || (end - begin <= grain_size))
+			{
+				func(begin, end);
+				return;
+			}
+
+			TaskGroup group;
+			RangeTask<Index, std::remove_reference_t<Func>>{this, &group, &func, begin, end, grain_size}();
+			this->Wait(group);
+		}
+
+		// Reduces func(sub_begin, sub_end) of subranges of [begin, end) with reduce(lhs, rhs), starting from identity. The
+		// subranges are fixed by the range and grain_size, and reduced in order, so the result doesn't depend on the timing.
+		template <typename Index, typename T, typename Func, typename ReduceFunc>
+		T ParallelReduce(Index begin, Detail::TaskIdentityT<Index> end, Detail::TaskIdentityT<Index> grain_size, T const & identity,
+			Func&& func, ReduceFunc&& reduce)
+		{
+			static_assert(std::is_integral_v<Index>);
+
+			if (end <= begin)
+			{
+				return identity;
+			}
+
+			grain_size = std::max<Index>(grain_size, 1);
+			Index const num_chunks = static_cast<Index>((end - begin + grain_size - 1) / grain_size);
+			std::vector<T> partials(num_chunks, identity);
+			this->ParallelFor(Index(0), num_chunks, Index(1), [begin, end, grain_size, &partials, &func](Index first, Index last) {
+				for (Index i = first; i < last; ++ i)
+				{
+					Index const chunk_begin = static_cast<Index>(begin + i * grain_size);
+					partials[i] = func(chunk_begin, static_cast<Index>(std::min<Index>(end - chunk_begin, grain_size) + chunk_begin));
+				}
+			});
+
+			T ret = identity;
+			for (auto const & partial : partials)
+			{
+				ret = reduce(ret, partial);
+			}
+			return ret;
+		}
+
+	private:
+		template <typename Index, typename Func>
+		struct RangeTask
+		{
+			TaskScheduler* scheduler;
+			TaskGroup* group;
+			Func* func;
+			Index begin;
+			Index end;
+			Index grain_size;
+
+			void operator()() const
+			{
+				// Gives away the second half until the rest is small enough
+				Index sub_end = end;
+				while (sub_end - begin > grain_size)
+				{
+					Index const mid = static_cast<Index>(begin + (sub_end - begin) / 2);
+					scheduler->Run(*group, RangeTask{scheduler, group, func, mid, sub_end, grain_size});
+					sub_end = mid;
+				}
+				(*func)(begin, sub_end);
+			}
+		};
+
+		template <typename Func>
+		static Task MakeTask(TaskGroup& group, Func&& func)
+		{
+			using FuncType = std::decay_t<Func>;
+
+			Task task;
+			task.group = &group;
+			if constexpr ((sizeof(FuncType) <= Task::STORAGE_SIZE) && (alignof(FuncType) <= alignof(std::max_align_t))
+				&& std::is_trivially_copyable_v<FuncType> && std::is_trivially_destructible_v<FuncType>)
+			{
+				new (task.storage) FuncType(std::forward<Func>(func));
+				task.invoke = [](Task const & t) { (*std::launder(reinterpret_cast<FuncType const *>(t.storage)))(); };
+			}
+			else
+			{
+				auto* heap_func = new FuncType(std::forward<Func>(func));
+				new (task.storage) FuncType*(heap_func);
+				task.invoke = [](Task const & t) {
+					std::unique_ptr<FuncType> f(*std::launder(reinterpret_cast<FuncType* const *>(t.storage)));
+					(*f)();
+				};
+			}
+			return task;
+		}
+
+		void Push(Task const & task);
+		bool TryPop(uint32_t queue_index, Task& task);
+		bool TrySteal(uint32_t queue_index, Task& task);
+		bool TryRunOne();
+		void Execute(Task const & task);
+		void Finish(TaskGroup& group);
+
+		void WorkerFunc(uint32_t index);
+
+	private:
+		// Guarded by a lock that is almost never contended. Only a thief and the owner ever meet there. Thieves peek at head and
+		// tail without the lock to skip empty queues.
+		struct alignas(64) WorkQueue
+		{
+			std::atomic<bool> locked{false};
+			std::atomic<uint32_t> head{0};
+			std::atomic<uint32_t> tail{0};
+			std::vector<Task> tasks;
+
+			bool Empty() const noexcept
+			{
+				return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_relaxed);
+			}
+
+			void Lock() noexcept;
+			void Unlock() noexcept
+			{
+				locked.store(false, std::memory_order_release);
+			}
+		};
+
+		uint32_t num_workers_;
+
+		// Queues of the workers, the last one is shared by the other threads
+		std::unique_ptr<WorkQueue[]> queues_;
+		std::vector<std::thread> workers_;
+
+		std::atomic<uint32_t> num_queued_{0};
+		std::atomic<uint32_t> num_sleeping_{0};
+		std::mutex sleep_mutex_;
+		std::condition_variable sleep_cond_;
+		bool quit_ = false;
+	};
+}
+
+#endif		// KFL_TASK_SCHEDULER_HPP
@@ -94,6 +94,26 @@ namespace
 #endif
 	}
 
+	// The lower 32 bits of XCR0. Only valid when OSXSAVE is set.
+	uint32_t get_xcr0()
+	{
+#if defined(KLAYGE_COMPILER_MSVC)
+		return static_cast<uint32_t>(_xgetbv(0));
+#elif (defined(KLAYGE_COMPILER_GCC) || defined(KLAYGE_COMPILER_CLANG) || defined(KLAYGE_COMPILER_CLANGCL)) && !defined(KLAYGE_PLATFORM_IOS)
+		uint32_t eax;
+		uint32_t edx;
+		__asm__
+		(
+			"xgetbv"
+			: "=a" (eax), "=d" (edx)
+			: "c" (0)
+		);
+		return eax;
+#else
+		return 0;
+#endif
+	}
+
 	enum CPUIDFeatureMask : uint32_t
 	{
 		// In EBX of type 1. Intel only.
@@ -113,6 +133,10 @@ namespace
 		CFM_AVX			= 1UL << 28,	// 256-bit AVX (Intel Sandy Bridge, AMD Bulldozer)
 		CFM_F16C		= 1UL << 29,	// F16C (Intel Ivy Bridge, AMD Piledriver)
 
+		// In XCR0
+		CFM_XMMState	= 1UL << 1,
+		CFM_YMMState	= 1UL << 2,
+
 		// In EDX of type 1
 		CFM_MMX			= 1UL << 23,	// MMX Technology
 		CFM_SSE			= 1UL << 25,	// SSE
@@ -242,9 +266,11 @@ namespace
 			return edx_;
 		}
 
-		void Call(uint32_t fn)
+		void Call(uint32_t fn, uint32_t sub_fn = 0)
 		{
 			eax_ = fn;
+			// Leaves like 7 have sub-leaves, ecx must not carry over from the previous call
+			ecx_ = sub_fn;
 			get_cpuid(&eax_, &ebx_, &ecx_, &edx_);
 		}
 
@@ -302,14 +328,17 @@ namespace KlayGE
 			feature_mask_ |= (cpuid.Ecx() & CFM_MOVBE) ? CF_MOVBE : 0;
 			feature_mask_ |= (cpuid.Ecx() & CFM_POPCNT) ? CF_POPCNT : 0;
 			feature_mask_ |= (cpuid.Ecx() & CFM_AES) ? CF_AES : 0;
-			if (cpuid.Ecx() & CFM_OSXSAVE)
+			// 256-bit instructions fault unless the OS saves the YMM registers
+			bool const os_saves_ymm = (cpuid.Ecx() & CFM_OSXSAVE)
+				&& ((get_xcr0() & (CFM_XMMState | CFM_YMMState)) == (CFM_XMMState | CFM_YMMState));
+			if (os_saves_ymm)
 			{
 				feature_mask_ |= (cpuid.Ecx() & CFM_FMA3) ? CF_FMA3 : 0;
 				feature_mask_ |= (cpuid.Ecx() & CFM_AVX) ? CF_AVX : 0;
 				feature_mask_ |= (cpuid.Ecx() & CFM_F16C) ? CF_F16C : 0;
 			}
 
-			if (max_std_fn >= 7)
+			if (os_saves_ymm && (max_std_fn >= 7))
 			{
 				cpuid.Call(7);
 
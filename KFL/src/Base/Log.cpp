@@ -29,171 +29,497 @@
  */
 
 #include <KFL/KFL.hpp>
-#include <KFL/CXX20/span.hpp>
+#include <KFL/CXX17/filesystem.hpp>
 #include <KFL/CustomizedStreamBuf.hpp>
 
-#include <cstdarg>
-#include <cstdio>
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 
 #ifdef KLAYGE_PLATFORM_ANDROID
 #include <android/log.h>
-#include <cstring>
-#else
-#include <fstream>
 #endif
 
 #include <KFL/Log.hpp>
+#include <KFL/Logger.hpp>
 
 namespace
 {
 	using namespace KlayGE;
 
-#ifdef KLAYGE_PLATFORM_ANDROID
-	class AndroidLogStreamCallback : boost::noncopyable
+	uint32_t constexpr QUEUE_CAPACITY = 64 * 1024;
+	// Arguments larger than this are copied to the heap instead of the queue
+	uint32_t constexpr MAX_QUEUED_PAYLOAD_SIZE = QUEUE_CAPACITY / 4;
+	uint32_t constexpr BACKEND_INTERVAL_MS = 20;
+
+#ifdef KLAYGE_DEBUG
+	uint32_t constexpr DEFAULT_DEBUG_CATEGORIES = ~0U;
+#else
+	uint32_t constexpr DEFAULT_DEBUG_CATEGORIES = 0;
+#endif
+
+	char const * const SEVERITY_NAMES[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+	char const * const CATEGORY_NAMES[] = {"KlayGE", "Render", "Resource", "Scene", "Audio", "Input", "Script", "Network", "Tool", "App"};
+	static_assert(std::size(SEVERITY_NAMES) == static_cast<uint32_t>(LogSeverity::Num));
+	static_assert(std::size(CATEGORY_NAMES) == static_cast<uint32_t>(LogCategory::Num));
+
+	// Records are contiguous in a queue. When one doesn't fit before the end of the buffer, the rest is skipped with a padding.
+	struct RecordPrefix
+	{
+		uint32_t size;
+		uint32_t padding;
+	};
+
+	struct RecordHeader
+	{
+		RecordPrefix prefix;
+		LogSeverity severity;
+		LogCategory category;
+		Logger::FormatFunc format_func;
+		char const * format;
+		int64_t time;
+		uint8_t* heap_payload;
+	};
+
+	// Turns what is streamed to LogInfo() and co. into a record per line
+	class LogLineCallback : boost::noncopyable
 	{
 	public:
-		explicit AndroidLogStreamCallback(int prio)
-			: prio_(prio)
+		explicit LogLineCallback(LogSeverity severity)
+			: severity_(severity)
 		{
 		}
-		AndroidLogStreamCallback(AndroidLogStreamCallback&& rhs)
-			: prio_(rhs.prio_)
+		LogLineCallback(LogLineCallback&& rhs) noexcept
+			: severity_(rhs.severity_), line_(std::move(rhs.line_))
 		{
 		}
 
 		std::streambuf::int_type operator()(void const * buff, std::streamsize count)
 		{
-			auto tmp = MakeUniquePtr<char[]>(count + 1);
-			std::memcpy(tmp.get(), buff, count);
-			tmp[count] = 0;
-			__android_log_write(prio_, "KlayGE", tmp.get());
+			auto const * chars = static_cast<char const *>(buff);
+			for (std::streamsize i = 0; i < count; ++ i)
+			{
+				if (chars[i] == '\n')
+				{
+					Logger::Instance().Log(severity_, LogCategory::General, "{}", line_);
+					line_.clear();
+				}
+				else
+				{
+					line_.push_back(chars[i]);
+				}
+			}
 			return static_cast<std::streambuf::int_type>(count);
 		}
 
 	private:
-		int prio_;
+		LogSeverity severity_;
+		std::string line_;
+	};
+
+	template <LogSeverity Severity>
+	std::ostream& LogStream()
+	{
+		if (Logger::Enabled(Severity, LogCategory::General))
+		{
+			thread_local CallbackOutputStreamBuf<LogLineCallback> log_stream_buff((LogLineCallback(Severity)));
+			thread_local std::ostream log_stream(&log_stream_buff);
+			return log_stream;
+		}
+		else
+		{
+			// Without a buffer, the stream is bad and skips formatting
+			thread_local std::ostream empty_stream(nullptr);
+			return empty_stream;
+		}
+	}
+}
+
+namespace KlayGE
+{
+	struct Logger::ThreadQueue
+	{
+		uint32_t thread_index;
+		std::unique_ptr<uint64_t[]> buffer;
+
+		// Written by the owner thread
+		alignas(64) std::atomic<uint64_t> write_pos{0};
+		uint64_t record_end = 0;
+		std::atomic<bool> retired{false};
+
+		// Written by the backend thread
+		alignas(64) std::atomic<uint64_t> read_pos{0};
+
+		uint8_t* Data() noexcept
+		{
+			return reinterpret_cast<uint8_t*>(buffer.get());
+		}
 	};
 
-	template <int PRIO>
-	std::ostream& AndroidLog()
+	std::atomic<uint32_t> Logger::enabled_categories_[] = {DEFAULT_DEBUG_CATEGORIES, ~0U, ~0U, ~0U};
+
+	Logger& Logger::Instance()
 	{
-		static CallbackOutputStreamBuf<AndroidLogStreamCallback> log_stream_buff((AndroidLogStreamCallback(PRIO)));
-		static std::ostream log_stream(&log_stream_buff);
-		return log_stream;
+		static Logger logger;
+		return logger;
 	}
+
+	Logger::Logger()
+#ifdef KLAYGE_DEBUG
+		: min_severity_(LogSeverity::Debug),
 #else
-	class MultiOStreamsCallback : boost::noncopyable
+		: min_severity_(LogSeverity::Info),
+#endif
+		  start_time_(std::chrono::steady_clock::now())
+	{
+		this->UpdateEnabledCategories();
+
+#if defined(KLAYGE_DEBUG) && !defined(KLAYGE_PLATFORM_ANDROID)
+		file_name_ = "KlayGE.log";
+		max_file_size_ = 8 * 1024 * 1024;
+		max_backups_ = 3;
+		file_ = MakeUniquePtr<std::ofstream>(file_name_.c_str());
+#endif
+
+		backend_thread_ = std::thread([this] { this->BackendFunc(); });
+	}
+
+	Logger::~Logger()
 	{
-	public:
-		explicit MultiOStreamsCallback(std::span<std::ostream*> oss)
-			: oss_(oss)
 		{
+			std::lock_guard<std::mutex> lock(backend_mutex_);
+			quit_ = true;
 		}
-		MultiOStreamsCallback(MultiOStreamsCallback&& rhs) noexcept
-			: oss_(std::move(rhs.oss_))
+		backend_cond_.notify_one();
+		backend_thread_.join();
+	}
+
+	void Logger::MinSeverity(LogSeverity severity)
+	{
+		std::lock_guard<std::mutex> lock(config_mutex_);
+		min_severity_ = severity;
+		this->UpdateEnabledCategories();
+	}
+
+	void Logger::CategoryEnabled(LogCategory category, bool enabled)
+	{
+		std::lock_guard<std::mutex> lock(config_mutex_);
+		uint32_t const bit = 1U << static_cast<uint32_t>(category);
+		category_mask_ = enabled ? (category_mask_ | bit) : (category_mask_ & ~bit);
+		this->UpdateEnabledCategories();
+	}
+
+	void Logger::UpdateEnabledCategories()
+	{
+		for (uint32_t i = 0; i < static_cast<uint32_t>(LogSeverity::Num); ++ i)
 		{
+			enabled_categories_[i].store(
+				(i >= static_cast<uint32_t>(min_severity_)) ? category_mask_ : 0, std::memory_order_relaxed);
 		}
+	}
 
-		std::streambuf::int_type operator()(void const * buff, std::streamsize count)
+	void Logger::LogFile(std::string const & file_name, uint64_t max_size, uint32_t max_backups)
+	{
+		// What is logged so far goes to the old file
+		this->Flush();
+
+		std::lock_guard<std::mutex> lock(sink_mutex_);
+		file_.reset();
+		file_name_ = file_name;
+		max_file_size_ = max_size;
+		max_backups_ = max_backups;
+		file_size_ = 0;
+		if (!file_name_.empty())
 		{
-			for (auto& os : oss_)
-			{
-				os->write(static_cast<char const *>(buff), count);
-			}
-			return static_cast<std::streambuf::int_type>(count);
+			file_ = MakeUniquePtr<std::ofstream>(file_name_.c_str());
 		}
+	}
 
-	private:
-		std::span<std::ostream*> oss_;
-	};
+	void Logger::ConsoleEnabled(bool enabled)
+	{
+		this->Flush();
+
+		std::lock_guard<std::mutex> lock(sink_mutex_);
+		console_enabled_ = enabled;
+	}
 
-	std::ostream& Log()
+	void Logger::Flush()
 	{
-#ifdef KLAYGE_DEBUG
-		static std::ofstream log_file("KlayGE.log");
-#endif
+		std::unique_lock<std::mutex> lock(backend_mutex_);
+		uint64_t const request = ++ flush_requests_;
+		backend_cond_.notify_one();
+		flushed_cond_.wait(lock, [this, request] { return flushed_requests_ >= request; });
+	}
 
-		static std::ostream* oss[] =
+	Logger::ThreadQueue& Logger::CurrentThreadQueue()
+	{
+		// Marks the queue retired when the thread exits. The backend drops it once it's drained.
+		struct ThreadQueueHolder
 		{
-#ifdef KLAYGE_DEBUG
-			&log_file,
-#endif
-			&std::clog
+			std::shared_ptr<ThreadQueue> queue;
+
+			~ThreadQueueHolder()
+			{
+				if (queue)
+				{
+					queue->retired.store(true, std::memory_order_release);
+				}
+			}
 		};
-		static CallbackOutputStreamBuf<MultiOStreamsCallback> log_stream_buff((MultiOStreamsCallback(oss)));
-		static std::ostream log_stream(&log_stream_buff);
-		return log_stream;
+		thread_local ThreadQueueHolder holder;
+
+		if (!holder.queue)
+		{
+			auto queue = MakeSharedPtr<ThreadQueue>();
+			queue->buffer = MakeUniquePtr<uint64_t[]>(QUEUE_CAPACITY / sizeof(uint64_t));
+
+			std::lock_guard<std::mutex> lock(queues_mutex_);
+			queue->thread_index = next_thread_index_;
+			++ next_thread_index_;
+			queues_.push_back(queue);
+			holder.queue = std::move(queue);
+		}
+		return *holder.queue;
 	}
-#endif
 
-#ifndef KLAYGE_DEBUG
-	class EmptyOStreamsCallback : boost::noncopyable
+	uint8_t* Logger::BeginRecord(
+		LogSeverity severity, LogCategory category, char const * format, FormatFunc format_func, uint32_t payload_size)
 	{
-	public:
-		EmptyOStreamsCallback()
+		auto& queue = this->CurrentThreadQueue();
+
+		bool const on_heap = payload_size > MAX_QUEUED_PAYLOAD_SIZE;
+		uint32_t const size = (sizeof(RecordHeader) + (on_heap ? 0 : payload_size) + 7) & ~7U;
+
+		uint64_t write_pos = queue.write_pos.load(std::memory_order_relaxed);
+		uint32_t offset = static_cast<uint32_t>(write_pos & (QUEUE_CAPACITY - 1));
+		uint32_t const contiguous = QUEUE_CAPACITY - offset;
+		uint32_t const needed = size + ((contiguous < size) ? contiguous : 0);
+
+		if (QUEUE_CAPACITY - (write_pos - queue.read_pos.load(std::memory_order_acquire)) < needed)
 		{
+			// Full. Rare enough to just wake the backend up and wait.
+			{
+				std::lock_guard<std::mutex> lock(backend_mutex_);
+				wakeup_requested_ = true;
+			}
+			backend_cond_.notify_one();
+			do
+			{
+				std::this_thread::yield();
+			} while (QUEUE_CAPACITY - (write_pos - queue.read_pos.load(std::memory_order_acquire)) < needed);
 		}
-		EmptyOStreamsCallback(EmptyOStreamsCallback&& rhs) noexcept
+
+		if (contiguous < size)
 		{
-			KFL_UNUSED(rhs);
+			RecordPrefix const padding{contiguous, 1};
+			std::memcpy(queue.Data() + offset, &padding, sizeof(padding));
+			write_pos += contiguous;
+			offset = 0;
 		}
 
-		std::streambuf::int_type operator()(void const * buff, std::streamsize count)
+		auto* header = new (queue.Data() + offset) RecordHeader;
+		header->prefix = RecordPrefix{size, 0};
+		header->severity = severity;
+		header->category = category;
+		header->format_func = format_func;
+		header->format = format;
+		header->time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time_).count();
+		header->heap_payload = on_heap ? new uint8_t[payload_size] : nullptr;
+		queue.record_end = write_pos + size;
+
+		return on_heap ? header->heap_payload : reinterpret_cast<uint8_t*>(header + 1);
+	}
+
+	void Logger::EndRecord(LogSeverity severity)
+	{
+		auto& queue = this->CurrentThreadQueue();
+		queue.write_pos.store(queue.record_end, std::memory_order_release);
+
+		if (severity == LogSeverity::Error)
 		{
-			KFL_UNUSED(buff);
-			return static_cast<std::streambuf::int_type>(count);
+			this->Flush();
 		}
-	};
+	}
 
-	std::ostream& EmptyLog()
+	void Logger::BackendFunc()
 	{
-		static CallbackOutputStreamBuf<EmptyOStreamsCallback> empty_stream_buff((EmptyOStreamsCallback()));
-		static std::ostream empty_stream(&empty_stream_buff);
-		return empty_stream;
+		for (;;)
+		{
+			uint64_t flush_requests;
+			bool quit;
+			{
+				std::unique_lock<std::mutex> lock(backend_mutex_);
+				backend_cond_.wait_for(lock, std::chrono::milliseconds(BACKEND_INTERVAL_MS),
+					[this] { return quit_ || wakeup_requested_ || (flush_requests_ != flushed_requests_); });
+				wakeup_requested_ = false;
+				flush_requests = flush_requests_;
+				quit = quit_;
+			}
+
+			this->WriteRecords();
+
+			{
+				std::lock_guard<std::mutex> lock(backend_mutex_);
+				flushed_requests_ = flush_requests;
+			}
+			flushed_cond_.notify_all();
+
+			if (quit)
+			{
+				break;
+			}
+		}
 	}
+
+	void Logger::WriteRecords()
+	{
+		std::vector<std::shared_ptr<ThreadQueue>> queues;
+		{
+			std::lock_guard<std::mutex> lock(queues_mutex_);
+			queues = queues_;
+		}
+
+		struct PendingRecord
+		{
+			uint32_t thread_index;
+			RecordHeader* header;
+		};
+		std::vector<PendingRecord> records;
+		std::vector<uint64_t> read_ends(queues.size());
+		for (size_t i = 0; i < queues.size(); ++ i)
+		{
+			auto& queue = *queues[i];
+			uint64_t read_pos = queue.read_pos.load(std::memory_order_relaxed);
+			uint64_t const write_pos = queue.write_pos.load(std::memory_order_acquire);
+			while (read_pos < write_pos)
+			{
+				uint8_t* record = queue.Data() + (read_pos & (QUEUE_CAPACITY - 1));
+				RecordPrefix prefix;
+				std::memcpy(&prefix, record, sizeof(prefix));
+				if (!prefix.padding)
+				{
+					records.push_back({queue.thread_index, reinterpret_cast<RecordHeader*>(record)});
+				}
+				read_pos += prefix.size;
+			}
+			read_ends[i] = write_pos;
+		}
+
+		// Threads are drained one after another, so lines are put back in time order
+		std::stable_sort(records.begin(), records.end(),
+			[](PendingRecord const & lhs, PendingRecord const & rhs) { return lhs.header->time < rhs.header->time; });
+
+		if (!records.empty())
+		{
+			std::lock_guard<std::mutex> lock(sink_mutex_);
+
+			for (auto const & record : records)
+			{
+				auto const & header = *record.header;
+				uint8_t const * payload = header.heap_payload ? header.heap_payload : reinterpret_cast<uint8_t const *>(&header + 1);
+
+				std::string message;
+				try
+				{
+					message = header.format_func(header.format, payload);
+				}
+				catch (std::exception const & e)
+				{
+					message = std::string(header.format) + " <" + e.what() + ">";
+				}
+				delete[] header.heap_payload;
+
+				this->WriteLine(header.severity,
+					std::format("[{:11.6f}] [T{}] ({}) {}: {}\n", header.time / 1e9, record.thread_index,
+						SEVERITY_NAMES[static_cast<uint32_t>(header.severity)], CATEGORY_NAMES[static_cast<uint32_t>(header.category)],
+						message));
+			}
+
+#ifndef KLAYGE_PLATFORM_ANDROID
+			if (console_enabled_)
+			{
+				std::clog.flush();
+			}
 #endif
-}
+			if (file_)
+			{
+				file_->flush();
+			}
+		}
 
-namespace KlayGE
-{
-	std::ostream& LogDebug()
+		for (size_t i = 0; i < queues.size(); ++ i)
+		{
+			queues[i]->read_pos.store(read_ends[i], std::memory_order_release);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(queues_mutex_);
+			queues_.erase(std::remove_if(queues_.begin(), queues_.end(),
+							  [](std::shared_ptr<ThreadQueue> const & queue) {
+								  return queue->retired.load(std::memory_order_acquire) &&
+									  (queue->read_pos.load(std::memory_order_relaxed) ==
+										  queue->write_pos.load(std::memory_order_acquire));
+							  }),
+				queues_.end());
+		}
+	}
+
+	void Logger::WriteLine(LogSeverity severity, std::string const & line)
 	{
-#ifdef KLAYGE_DEBUG
+		if (console_enabled_)
+		{
 #ifdef KLAYGE_PLATFORM_ANDROID
-		return AndroidLog<ANDROID_LOG_DEBUG>();
+			static int const ANDROID_PRIOS[] = {ANDROID_LOG_DEBUG, ANDROID_LOG_INFO, ANDROID_LOG_WARN, ANDROID_LOG_ERROR};
+			__android_log_write(ANDROID_PRIOS[static_cast<uint32_t>(severity)], "KlayGE", line.c_str());
 #else
-		return Log() << "(DEBUG) KlayGE: ";
-#endif
-#else
-		return EmptyLog();
+			KFL_UNUSED(severity);
+			std::clog << line;
 #endif
+		}
+
+		if (file_)
+		{
+			if ((max_file_size_ > 0) && (file_size_ > 0) && (file_size_ + line.size() > max_file_size_))
+			{
+				file_.reset();
+
+				std::error_code ec;
+				if (max_backups_ > 0)
+				{
+					FILESYSTEM_NS::remove(file_name_ + "." + std::to_string(max_backups_), ec);
+					for (uint32_t i = max_backups_ - 1; i > 0; -- i)
+					{
+						FILESYSTEM_NS::rename(file_name_ + "." + std::to_string(i), file_name_ + "." + std::to_string(i + 1), ec);
+					}
+					FILESYSTEM_NS::rename(file_name_, file_name_ + ".1", ec);
+				}
+
+				file_ = MakeUniquePtr<std::ofstream>(file_name_.c_str());
+				file_size_ = 0;
+			}
+
+			*file_ << line;
+			file_size_ += line.size();
+		}
+	}
+
+	std::ostream& LogDebug()
+	{
+		return LogStream<LogSeverity::Debug>();
 	}
 
 	std::ostream& LogInfo()
 	{
-#ifdef KLAYGE_PLATFORM_ANDROID
-		return AndroidLog<ANDROID_LOG_INFO>();
-#else
-		return Log() << "(INFO) KlayGE: ";
-#endif
+		return LogStream<LogSeverity::Info>();
 	}
 
 	std::ostream& LogWarn()
 	{
-#ifdef KLAYGE_PLATFORM_ANDROID
-		return AndroidLog<ANDROID_LOG_WARN>();
-#else
-		return Log() << "(WARN) KlayGE: ";
-#endif
+		return LogStream<LogSeverity::Warn>();
 	}
 
 	std::ostream& LogError()
 	{
-#ifdef KLAYGE_PLATFORM_ANDROID
-		return AndroidLog<ANDROID_LOG_ERROR>();
-#else
-		return Log() << "(ERROR) KlayGE: ";
-#endif
+		return LogStream<LogSeverity::Error>();
 	}
 }
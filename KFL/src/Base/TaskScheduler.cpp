@@ -0,0 +1,251 @@
+/**
+ * @file TaskScheduler.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KFL/KFL.hpp>
+
+#include <KFL/TaskScheduler.hpp>
+
+namespace
+{
+	using namespace KlayGE;
+
+	uint32_t constexpr QUEUE_CAPACITY = 1024;
+	uint32_t constexpr NUM_SPINS_BEFORE_SLEEP = 64;
+
+	// The scheduler a worker thread belongs to, and the index of its queue
+	thread_local TaskScheduler const * tls_scheduler = nullptr;
+	thread_local uint32_t tls_queue_index = 0;
+}
+
+namespace KlayGE
+{
+	void TaskScheduler::WorkQueue::Lock() noexcept
+	{
+		while (locked.exchange(true, std::memory_order_acquire))
+		{
+			while (locked.load(std::memory_order_relaxed))
+			{
+			}
+		}
+	}
+
+	TaskScheduler::TaskScheduler(uint32_t num_workers)
+	{
+		if (num_workers == 0)
+		{
+			num_workers = std::max(std::thread::hardware_concurrency(), 2U) - 1;
+		}
+
+		num_workers_ = num_workers;
+		queues_ = MakeUniquePtr<WorkQueue[]>(num_workers + 1);
+		for (uint32_t i = 0; i <= num_workers; ++ i)
+		{
+			queues_[i].tasks.resize(QUEUE_CAPACITY);
+		}
+
+		workers_.reserve(num_workers);
+		for (uint32_t i = 0; i < num_workers; ++ i)
+		{
+			workers_.emplace_back([this, i] { this->WorkerFunc(i); });
+		}
+	}
+
+	TaskScheduler::~TaskScheduler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex_);
+			quit_ = true;
+		}
+		sleep_cond_.notify_all();
+
+		for (auto& worker : workers_)
+		{
+			worker.join();
+		}
+	}
+
+	void TaskScheduler::Wait(TaskGroup& group)
+	{
+		while (!group.Done())
+		{
+			if (!this->TryRunOne())
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void TaskScheduler::Push(Task const & task)
+	{
+		// Counted first, so a worker that wakes up for it spins until it can see the task rather than going back to sleep
+		num_queued_.fetch_add(1);
+
+		uint32_t const queue_index = (tls_scheduler == this) ? tls_queue_index : this->NumWorkers();
+		auto& queue = queues_[queue_index];
+		queue.Lock();
+		uint32_t const tail = queue.tail.load(std::memory_order_relaxed);
+		if (tail - queue.head.load(std::memory_order_relaxed) == QUEUE_CAPACITY)
+		{
+			queue.Unlock();
+			num_queued_.fetch_sub(1, std::memory_order_relaxed);
+
+			// Too many tasks are waiting already, no point to add one more
+			this->Execute(task);
+			return;
+		}
+		queue.tasks[tail % QUEUE_CAPACITY] = task;
+		queue.tail.store(tail + 1, std::memory_order_relaxed);
+		queue.Unlock();
+
+		if (num_sleeping_.load() > 0)
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex_);
+			sleep_cond_.notify_one();
+		}
+	}
+
+	bool TaskScheduler::TryPop(uint32_t queue_index, Task& task)
+	{
+		auto& queue = queues_[queue_index];
+		queue.Lock();
+		if (queue.Empty())
+		{
+			queue.Unlock();
+			return false;
+		}
+		uint32_t const tail = queue.tail.load(std::memory_order_relaxed) - 1;
+		task = queue.tasks[tail % QUEUE_CAPACITY];
+		queue.tail.store(tail, std::memory_order_relaxed);
+		queue.Unlock();
+
+		num_queued_.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	bool TaskScheduler::TrySteal(uint32_t queue_index, Task& task)
+	{
+		uint32_t const num_queues = this->NumWorkers() + 1;
+		for (uint32_t i = 1; i < num_queues; ++ i)
+		{
+			auto& queue = queues_[(queue_index + i) % num_queues];
+			if (queue.Empty())
+			{
+				continue;
+			}
+
+			queue.Lock();
+			if (!queue.Empty())
+			{
+				uint32_t const head = queue.head.load(std::memory_order_relaxed);
+				task = queue.tasks[head % QUEUE_CAPACITY];
+				queue.head.store(head + 1, std::memory_order_relaxed);
+				queue.Unlock();
+
+				num_queued_.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+			queue.Unlock();
+		}
+
+		return false;
+	}
+
+	bool TaskScheduler::TryRunOne()
+	{
+		if (num_queued_.load(std::memory_order_relaxed) == 0)
+		{
+			return false;
+		}
+
+		// Other threads share the last queue
+		uint32_t const queue_index = (tls_scheduler == this) ? tls_queue_index : this->NumWorkers();
+
+		Task task;
+		if (this->TryPop(queue_index, task) || this->TrySteal(queue_index, task))
+		{
+			this->Execute(task);
+			return true;
+		}
+		return false;
+	}
+
+	void TaskScheduler::Execute(Task const & task)
+	{
+		task.invoke(task);
+		this->Finish(*task.group);
+	}
+
+	void TaskScheduler::Finish(TaskGroup& group)
+	{
+		uint32_t const prev = group.pending_.fetch_sub(1, std::memory_order_acq_rel);
+		if (prev == TaskGroup::CONTINUATION_FLAG + 1)
+		{
+			// The flag keeps the group alive. Once it is cleared, the group can be gone, so the continuation is copied before.
+			Task const continuation = group.continuation_;
+			group.pending_.fetch_and(~TaskGroup::CONTINUATION_FLAG, std::memory_order_acq_rel);
+			this->Push(continuation);
+		}
+	}
+
+	void TaskScheduler::WorkerFunc(uint32_t index)
+	{
+		tls_scheduler = this;
+		tls_queue_index = index;
+
+		for (;;)
+		{
+			if (this->TryRunOne())
+			{
+				continue;
+			}
+
+			// Tasks usually come in bursts, spins for a while before sleeping
+			bool has_task = false;
+			for (uint32_t i = 0; (i < NUM_SPINS_BEFORE_SLEEP) && !has_task; ++ i)
+			{
+				std::this_thread::yield();
+				has_task = (num_queued_.load(std::memory_order_relaxed) > 0);
+			}
+			if (has_task)
+			{
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(sleep_mutex_);
+			num_sleeping_.fetch_add(1);
+			sleep_cond_.wait(lock, [this] { return quit_ || (num_queued_.load() > 0); });
+			num_sleeping_.fetch_sub(1);
+			if (quit_)
+			{
+				return;
+			}
+		}
+	}
+}
@@ -33,6 +33,7 @@
 #include <KFL/Detail/MathHelper.hpp>
 
 #include <KFL/Math.hpp>
+#include <KFL/SIMDMath.hpp>
 
 namespace KlayGE
 {
@@ -761,29 +762,40 @@ namespace KlayGE
 		template <typename T>
 		Matrix4_T<T> mul(Matrix4_T<T> const & lhs, Matrix4_T<T> const & rhs) noexcept
 		{
-			T const * lhs_data = lhs.data();
-			T const * rhs_data = rhs.data();
+#if !defined(SIMD_MATH_GENERAL)
+			if constexpr (std::is_same_v<T, float>)
+			{
+				Matrix4_T<T> ret;
+				SIMDMathLib::StoreMatrix(ret, SIMDMathLib::Multiply(SIMDMathLib::LoadMatrix(lhs), SIMDMathLib::LoadMatrix(rhs)));
+				return ret;
+			}
+			else
+#endif
+			{
+				T const * lhs_data = lhs.data();
+				T const * rhs_data = rhs.data();
 
-			return Matrix4_T<T>(
-				lhs_data[0] * rhs_data[0] + lhs_data[1] * rhs_data[4] + lhs_data[2] * rhs_data[8]  + lhs_data[3] * rhs_data[12],
-				lhs_data[0] * rhs_data[1] + lhs_data[1] * rhs_data[5] + lhs_data[2] * rhs_data[9]  + lhs_data[3] * rhs_data[13],
-				lhs_data[0] * rhs_data[2] + lhs_data[1] * rhs_data[6] + lhs_data[2] * rhs_data[10] + lhs_data[3] * rhs_data[14],
-				lhs_data[0] * rhs_data[3] + lhs_data[1] * rhs_data[7] + lhs_data[2] * rhs_data[11] + lhs_data[3] * rhs_data[15],
+				return Matrix4_T<T>(
+					lhs_data[0] * rhs_data[0] + lhs_data[1] * rhs_data[4] + lhs_data[2] * rhs_data[8]  + lhs_data[3] * rhs_data[12],
+					lhs_data[0] * rhs_data[1] + lhs_data[1] * rhs_data[5] + lhs_data[2] * rhs_data[9]  + lhs_data[3] * rhs_data[13],
+					lhs_data[0] * rhs_data[2] + lhs_data[1] * rhs_data[6] + lhs_data[2] * rhs_data[10] + lhs_data[3] * rhs_data[14],
+					lhs_data[0] * rhs_data[3] + lhs_data[1] * rhs_data[7] + lhs_data[2] * rhs_data[11] + lhs_data[3] * rhs_data[15],
 
-				lhs_data[4] * rhs_data[0] + lhs_data[5] * rhs_data[4] + lhs_data[6] * rhs_data[8]  + lhs_data[7] * rhs_data[12],
-				lhs_data[4] * rhs_data[1] + lhs_data[5] * rhs_data[5] + lhs_data[6] * rhs_data[9]  + lhs_data[7] * rhs_data[13],
-				lhs_data[4] * rhs_data[2] + lhs_data[5] * rhs_data[6] + lhs_data[6] * rhs_data[10] + lhs_data[7] * rhs_data[14],
-				lhs_data[4] * rhs_data[3] + lhs_data[5] * rhs_data[7] + lhs_data[6] * rhs_data[11] + lhs_data[7] * rhs_data[15],
+					lhs_data[4] * rhs_data[0] + lhs_data[5] * rhs_data[4] + lhs_data[6] * rhs_data[8]  + lhs_data[7] * rhs_data[12],
+					lhs_data[4] * rhs_data[1] + lhs_data[5] * rhs_data[5] + lhs_data[6] * rhs_data[9]  + lhs_data[7] * rhs_data[13],
+					lhs_data[4] * rhs_data[2] + lhs_data[5] * rhs_data[6] + lhs_data[6] * rhs_data[10] + lhs_data[7] * rhs_data[14],
+					lhs_data[4] * rhs_data[3] + lhs_data[5] * rhs_data[7] + lhs_data[6] * rhs_data[11] + lhs_data[7] * rhs_data[15],
 
-				lhs_data[8] * rhs_data[0] + lhs_data[9] * rhs_data[4] + lhs_data[10] * rhs_data[8]  + lhs_data[11] * rhs_data[12],
-				lhs_data[8] * rhs_data[1] + lhs_data[9] * rhs_data[5] + lhs_data[10] * rhs_data[9]  + lhs_data[11] * rhs_data[13],
-				lhs_data[8] * rhs_data[2] + lhs_data[9] * rhs_data[6] + lhs_data[10] * rhs_data[10] + lhs_data[11] * rhs_data[14],
-				lhs_data[8] * rhs_data[3] + lhs_data[9] * rhs_data[7] + lhs_data[10] * rhs_data[11] + lhs_data[11] * rhs_data[15],
+					lhs_data[8] * rhs_data[0] + lhs_data[9] * rhs_data[4] + lhs_data[10] * rhs_data[8]  + lhs_data[11] * rhs_data[12],
+					lhs_data[8] * rhs_data[1] + lhs_data[9] * rhs_data[5] + lhs_data[10] * rhs_data[9]  + lhs_data[11] * rhs_data[13],
+					lhs_data[8] * rhs_data[2] + lhs_data[9] * rhs_data[6] + lhs_data[10] * rhs_data[10] + lhs_data[11] * rhs_data[14],
+					lhs_data[8] * rhs_data[3] + lhs_data[9] * rhs_data[7] + lhs_data[10] * rhs_data[11] + lhs_data[11] * rhs_data[15],
 
-				lhs_data[12] * rhs_data[0] + lhs_data[13] * rhs_data[4] + lhs_data[14] * rhs_data[8]  + lhs_data[15] * rhs_data[12],
-				lhs_data[12] * rhs_data[1] + lhs_data[13] * rhs_data[5] + lhs_data[14] * rhs_data[9]  + lhs_data[15] * rhs_data[13],
-				lhs_data[12] * rhs_data[2] + lhs_data[13] * rhs_data[6] + lhs_data[14] * rhs_data[10] + lhs_data[15] * rhs_data[14],
-				lhs_data[12] * rhs_data[3] + lhs_data[13] * rhs_data[7] + lhs_data[14] * rhs_data[11] + lhs_data[15] * rhs_data[15]);
+					lhs_data[12] * rhs_data[0] + lhs_data[13] * rhs_data[4] + lhs_data[14] * rhs_data[8]  + lhs_data[15] * rhs_data[12],
+					lhs_data[12] * rhs_data[1] + lhs_data[13] * rhs_data[5] + lhs_data[14] * rhs_data[9]  + lhs_data[15] * rhs_data[13],
+					lhs_data[12] * rhs_data[2] + lhs_data[13] * rhs_data[6] + lhs_data[14] * rhs_data[10] + lhs_data[15] * rhs_data[14],
+					lhs_data[12] * rhs_data[3] + lhs_data[13] * rhs_data[7] + lhs_data[14] * rhs_data[11] + lhs_data[15] * rhs_data[15]);
+			}
 		}
 
 		template float determinant(float4x4 const & rhs) noexcept;
@@ -811,57 +823,68 @@ namespace KlayGE
 		template <typename T>
 		Matrix4_T<T> inverse(Matrix4_T<T> const & rhs) noexcept
 		{
-			T const * rhs_data = rhs.data();
-
-			T const _2132_2231(rhs_data[4]  * rhs_data[9]  - rhs_data[5]  * rhs_data[8]);
-			T const _2133_2331(rhs_data[4]  * rhs_data[10] - rhs_data[6]  * rhs_data[8]);
-			T const _2134_2431(rhs_data[4]  * rhs_data[11] - rhs_data[7]  * rhs_data[8]);
-			T const _2142_2241(rhs_data[4]  * rhs_data[13] - rhs_data[5]  * rhs_data[12]);
-			T const _2143_2341(rhs_data[4]  * rhs_data[14] - rhs_data[6]  * rhs_data[12]);
-			T const _2144_2441(rhs_data[4]  * rhs_data[15] - rhs_data[7]  * rhs_data[12]);
-			T const _2233_2332(rhs_data[5]  * rhs_data[10] - rhs_data[6]  * rhs_data[9]);
-			T const _2234_2432(rhs_data[5]  * rhs_data[11] - rhs_data[7]  * rhs_data[9]);
-			T const _2243_2342(rhs_data[5]  * rhs_data[14] - rhs_data[6]  * rhs_data[13]);
-			T const _2244_2442(rhs_data[5]  * rhs_data[15] - rhs_data[7]  * rhs_data[13]);
-			T const _2334_2433(rhs_data[6]  * rhs_data[11] - rhs_data[7]  * rhs_data[10]);
-			T const _2344_2443(rhs_data[6]  * rhs_data[15] - rhs_data[7]  * rhs_data[14]);
-			T const _3142_3241(rhs_data[8]  * rhs_data[13] - rhs_data[9]  * rhs_data[12]);
-			T const _3143_3341(rhs_data[8]  * rhs_data[14] - rhs_data[10] * rhs_data[12]);
-			T const _3144_3441(rhs_data[8]  * rhs_data[15] - rhs_data[11] * rhs_data[12]);
-			T const _3243_3342(rhs_data[9]  * rhs_data[14] - rhs_data[10] * rhs_data[13]);
-			T const _3244_3442(rhs_data[9]  * rhs_data[15] - rhs_data[11] * rhs_data[13]);
-			T const _3344_3443(rhs_data[10] * rhs_data[15] - rhs_data[11] * rhs_data[14]);
-
-			// ʽֵ
-			T const det(determinant(rhs));
-			if (equal<T>(det, 0))
+#if !defined(SIMD_MATH_GENERAL)
+			if constexpr (std::is_same_v<T, float>)
 			{
-				return rhs;
+				Matrix4_T<T> ret;
+				SIMDMathLib::StoreMatrix(ret, SIMDMathLib::Inverse(SIMDMathLib::LoadMatrix(rhs)));
+				return ret;
 			}
 			else
-			{
-				T invDet(T(1) / det);
-
-				return Matrix4_T<T>(
-					+invDet * (rhs_data[5] * _3344_3443 - rhs_data[6] * _3244_3442 + rhs_data[7] * _3243_3342),
-					-invDet * (rhs_data[1] * _3344_3443 - rhs_data[2] * _3244_3442 + rhs_data[3] * _3243_3342),
-					+invDet * (rhs_data[1] * _2344_2443 - rhs_data[2] * _2244_2442 + rhs_data[3] * _2243_2342),
-					-invDet * (rhs_data[1] * _2334_2433 - rhs_data[2] * _2234_2432 + rhs_data[3] * _2233_2332),
-
-					-invDet * (rhs_data[4] * _3344_3443 - rhs_data[6] * _3144_3441 + rhs_data[7] * _3143_3341),
-					+invDet * (rhs_data[0] * _3344_3443 - rhs_data[2] * _3144_3441 + rhs_data[3] * _3143_3341),
-					-invDet * (rhs_data[0] * _2344_2443 - rhs_data[2] * _2144_2441 + rhs_data[3] * _2143_2341),
-					+invDet * (rhs_data[0] * _2334_2433 - rhs_data[2] * _2134_2431 + rhs_data[3] * _2133_2331),
-
-					+invDet * (rhs_data[4] * _3244_3442 - rhs_data[5] * _3144_3441 + rhs_data[7] * _3142_3241),
-					-invDet * (rhs_data[0] * _3244_3442 - rhs_data[1] * _3144_3441 + rhs_data[3] * _3142_3241),
-					+invDet * (rhs_data[0] * _2244_2442 - rhs_data[1] * _2144_2441 + rhs_data[3] * _2142_2241),
-					-invDet * (rhs_data[0] * _2234_2432 - rhs_data[1] * _2134_2431 + rhs_data[3] * _2132_2231),
-
-					-invDet * (rhs_data[4] * _3243_3342 - rhs_data[5] * _3143_3341 + rhs_data[6] * _3142_3241),
-					+invDet * (rhs_data[0] * _3243_3342 - rhs_data[1] * _3143_3341 + rhs_data[2] * _3142_3241),
-					-invDet * (rhs_data[0] * _2243_2342 - rhs_data[1] * _2143_2341 + rhs_data[2] * _2142_2241),
-					+invDet * (rhs_data[0] * _2233_2332 - rhs_data[1] * _2133_2331 + rhs_data[2] * _2132_2231));
+#endif
+			{
+				T const * rhs_data = rhs.data();
+
+				T const _2132_2231(rhs_data[4]  * rhs_data[9]  - rhs_data[5]  * rhs_data[8]);
+				T const _2133_2331(rhs_data[4]  * rhs_data[10] - rhs_data[6]  * rhs_data[8]);
+				T const _2134_2431(rhs_data[4]  * rhs_data[11] - rhs_data[7]  * rhs_data[8]);
+				T const _2142_2241(rhs_data[4]  * rhs_data[13] - rhs_data[5]  * rhs_data[12]);
+				T const _2143_2341(rhs_data[4]  * rhs_data[14] - rhs_data[6]  * rhs_data[12]);
+				T const _2144_2441(rhs_data[4]  * rhs_data[15] - rhs_data[7]  * rhs_data[12]);
+				T const _2233_2332(rhs_data[5]  * rhs_data[10] - rhs_data[6]  * rhs_data[9]);
+				T const _2234_2432(rhs_data[5]  * rhs_data[11] - rhs_data[7]  * rhs_data[9]);
+				T const _2243_2342(rhs_data[5]  * rhs_data[14] - rhs_data[6]  * rhs_data[13]);
+				T const _2244_2442(rhs_data[5]  * rhs_data[15] - rhs_data[7]  * rhs_data[13]);
+				T const _2334_2433(rhs_data[6]  * rhs_data[11] - rhs_data[7]  * rhs_data[10]);
+				T const _2344_2443(rhs_data[6]  * rhs_data[15] - rhs_data[7]  * rhs_data[14]);
+				T const _3142_3241(rhs_data[8]  * rhs_data[13] - rhs_data[9]  * rhs_data[12]);
+				T const _3143_3341(rhs_data[8]  * rhs_data[14] - rhs_data[10] * rhs_data[12]);
+				T const _3144_3441(rhs_data[8]  * rhs_data[15] - rhs_data[11] * rhs_data[12]);
+				T const _3243_3342(rhs_data[9]  * rhs_data[14] - rhs_data[10] * rhs_data[13]);
+				T const _3244_3442(rhs_data[9]  * rhs_data[15] - rhs_data[11] * rhs_data[13]);
+				T const _3344_3443(rhs_data[10] * rhs_data[15] - rhs_data[11] * rhs_data[14]);
+
+				// ʽֵ
+				T const det(determinant(rhs));
+				if (equal<T>(det, 0))
+				{
+					return rhs;
+				}
+				else
+				{
+					T invDet(T(1) / det);
+
+					return Matrix4_T<T>(
+						+invDet * (rhs_data[5] * _3344_3443 - rhs_data[6] * _3244_3442 + rhs_data[7] * _3243_3342),
+						-invDet * (rhs_data[1] * _3344_3443 - rhs_data[2] * _3244_3442 + rhs_data[3] * _3243_3342),
+						+invDet * (rhs_data[1] * _2344_2443 - rhs_data[2] * _2244_2442 + rhs_data[3] * _2243_2342),
+						-invDet * (rhs_data[1] * _2334_2433 - rhs_data[2] * _2234_2432 + rhs_data[3] * _2233_2332),
+
+						-invDet * (rhs_data[4] * _3344_3443 - rhs_data[6] * _3144_3441 + rhs_data[7] * _3143_3341),
+						+invDet * (rhs_data[0] * _3344_3443 - rhs_data[2] * _3144_3441 + rhs_data[3] * _3143_3341),
+						-invDet * (rhs_data[0] * _2344_2443 - rhs_data[2] * _2144_2441 + rhs_data[3] * _2143_2341),
+						+invDet * (rhs_data[0] * _2334_2433 - rhs_data[2] * _2134_2431 + rhs_data[3] * _2133_2331),
+
+						+invDet * (rhs_data[4] * _3244_3442 - rhs_data[5] * _3144_3441 + rhs_data[7] * _3142_3241),
+						-invDet * (rhs_data[0] * _3244_3442 - rhs_data[1] * _3144_3441 + rhs_data[3] * _3142_3241),
+						+invDet * (rhs_data[0] * _2244_2442 - rhs_data[1] * _2144_2441 + rhs_data[3] * _2142_2241),
+						-invDet * (rhs_data[0] * _2234_2432 - rhs_data[1] * _2134_2431 + rhs_data[3] * _2132_2231),
+
+						-invDet * (rhs_data[4] * _3243_3342 - rhs_data[5] * _3143_3341 + rhs_data[6] * _3142_3241),
+						+invDet * (rhs_data[0] * _3243_3342 - rhs_data[1] * _3143_3341 + rhs_data[2] * _3142_3241),
+						-invDet * (rhs_data[0] * _2243_2342 - rhs_data[1] * _2143_2341 + rhs_data[2] * _2142_2241),
+						+invDet * (rhs_data[0] * _2233_2332 - rhs_data[1] * _2133_2331 + rhs_data[2] * _2132_2231));
+				}
 			}
 		}
 
@@ -2308,16 +2331,25 @@ namespace KlayGE
 		template <typename T>
 		AABBox_T<T> transform_aabb(AABBox_T<T> const & aabb, Matrix4_T<T> const & mat) noexcept
 		{
-			Vector_T<T, 3> min, max;
-			min = max = transform_coord(aabb.Corner(0), mat);
-			for (size_t j = 1; j < 8; ++j)
+#if !defined(SIMD_MATH_GENERAL)
+			if constexpr (std::is_same_v<T, float>)
 			{
-				Vector_T<T, 3> const vec = transform_coord(aabb.Corner(j), mat);
-				min = minimize(min, vec);
-				max = maximize(max, vec);
+				return SIMDMathLib::TransformAABB(aabb, SIMDMathLib::LoadMatrix(mat));
 			}
+			else
+#endif
+			{
+				Vector_T<T, 3> min, max;
+				min = max = transform_coord(aabb.Corner(0), mat);
+				for (size_t j = 1; j < 8; ++j)
+				{
+					Vector_T<T, 3> const vec = transform_coord(aabb.Corner(j), mat);
+					min = minimize(min, vec);
+					max = maximize(max, vec);
+				}
 
-			return AABBox_T<T>(min, max);
+				return AABBox_T<T>(min, max);
+			}
 		}
 
 		template AABBox transform_aabb(AABBox const & aabb, float3 const & scale, Quaternion const & rot, float3 const & trans) noexcept;
@@ -2800,29 +2832,38 @@ namespace KlayGE
 		template <typename T>
 		BoundOverlap intersect_aabb_frustum(AABBox_T<T> const & aabb, Frustum_T<T> const & frustum) noexcept
 		{
-			Vector_T<T, 3> const & min_pt = aabb.Min();
-			Vector_T<T, 3> const & max_pt = aabb.Max();
-
-			bool intersect = false;
-			for (int i = 0; i < 6; ++ i)
+#if !defined(SIMD_MATH_GENERAL)
+			if constexpr (std::is_same_v<T, float>)
 			{
-				Plane_T<T> const & plane = frustum.FrustumPlane(i);
-
-				// v1 is diagonally opposed to v0
-				Vector_T<T, 3> v0((plane.a() < 0) ? min_pt.x() : max_pt.x(), (plane.b() < 0) ? min_pt.y() : max_pt.y(), (plane.c() < 0) ? min_pt.z() : max_pt.z());
-				Vector_T<T, 3> v1((plane.a() < 0) ? max_pt.x() : min_pt.x(), (plane.b() < 0) ? max_pt.y() : min_pt.y(), (plane.c() < 0) ? max_pt.z() : min_pt.z());
+				return SIMDMathLib::IntersectAABBFrustum(aabb, frustum);
+			}
+			else
+#endif
+			{
+				Vector_T<T, 3> const & min_pt = aabb.Min();
+				Vector_T<T, 3> const & max_pt = aabb.Max();
 
-				if (dot_coord(plane, v0) < 0)
-				{
-					return BoundOverlap::No;
-				}
-				if (dot_coord(plane, v1) < 0)
+				bool intersect = false;
+				for (int i = 0; i < 6; ++ i)
 				{
-					intersect = true;
+					Plane_T<T> const & plane = frustum.FrustumPlane(i);
+
+					// v1 is diagonally opposed to v0
+					Vector_T<T, 3> v0((plane.a() < 0) ? min_pt.x() : max_pt.x(), (plane.b() < 0) ? min_pt.y() : max_pt.y(), (plane.c() < 0) ? min_pt.z() : max_pt.z());
+					Vector_T<T, 3> v1((plane.a() < 0) ? max_pt.x() : min_pt.x(), (plane.b() < 0) ? max_pt.y() : min_pt.y(), (plane.c() < 0) ? max_pt.z() : min_pt.z());
+
+					if (dot_coord(plane, v0) < 0)
+					{
+						return BoundOverlap::No;
+					}
+					if (dot_coord(plane, v1) < 0)
+					{
+						intersect = true;
+					}
 				}
-			}
 
-			return intersect ? BoundOverlap::Partial : BoundOverlap::Yes;
+				return intersect ? BoundOverlap::Partial : BoundOverlap::Yes;
+			}
 		}
 
 		template BoundOverlap intersect_obb_frustum(OBBox const & obb, Frustum const & frustum) noexcept;
@@ -29,12 +29,40 @@
  */
 
 #include <KFL/KFL.hpp>
+#include <KFL/AABBox.hpp>
+#include <KFL/Frustum.hpp>
+#include <KFL/Math.hpp>
+#include <KFL/Matrix.hpp>
+#include <KFL/Quaternion.hpp>
 #include <KFL/SIMDMath.hpp>
 
 #ifdef SIMD_MATH_SSE
 	#include <emmintrin.h>
 #endif
 
+#if defined(SIMD_MATH_NEON)
+namespace
+{
+	// NEON has no 4-way arbitrary shuffle, these are the ones the cross product and transposes need
+	float32x4_t ShuffleYZXNeon(float32x4_t v)
+	{
+		return vsetq_lane_f32(vgetq_lane_f32(v, 0), vextq_f32(v, v, 1), 2);
+	}
+
+	void TransposeNeon(float32x4_t& r0, float32x4_t& r1, float32x4_t& r2, float32x4_t& r3)
+	{
+		float32x4_t const t0 = vtrn1q_f32(r0, r1);
+		float32x4_t const t1 = vtrn2q_f32(r0, r1);
+		float32x4_t const t2 = vtrn1q_f32(r2, r3);
+		float32x4_t const t3 = vtrn2q_f32(r2, r3);
+		r0 = vcombine_f32(vget_low_f32(t0), vget_low_f32(t2));
+		r1 = vcombine_f32(vget_low_f32(t1), vget_low_f32(t3));
+		r2 = vcombine_f32(vget_high_f32(t0), vget_high_f32(t2));
+		r3 = vcombine_f32(vget_high_f32(t1), vget_high_f32(t3));
+	}
+}
+#endif
+
 namespace KlayGE
 {
 	namespace SIMDMathLib
@@ -46,6 +74,8 @@ namespace KlayGE
 			SIMDVectorF4 ret;
 #if defined(SIMD_MATH_SSE)
 			ret.Vec() = _mm_add_ps(lhs.Vec(), rhs.Vec());
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vaddq_f32(lhs.Vec(), rhs.Vec());
 #else
 			for (int i = 0; i < 4; ++ i)
 			{
@@ -60,6 +90,8 @@ namespace KlayGE
 			SIMDVectorF4 ret;
 #if defined(SIMD_MATH_SSE)
 			ret.Vec() = _mm_sub_ps(lhs.Vec(), rhs.Vec());
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vsubq_f32(lhs.Vec(), rhs.Vec());
 #else
 			for (int i = 0; i < 4; ++ i)
 			{
@@ -74,6 +106,8 @@ namespace KlayGE
 			SIMDVectorF4 ret;
 #if defined(SIMD_MATH_SSE)
 			ret.Vec() = _mm_mul_ps(lhs.Vec(), rhs.Vec());
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vmulq_f32(lhs.Vec(), rhs.Vec());
 #else
 			for (int i = 0; i < 4; ++ i)
 			{
@@ -88,6 +122,8 @@ namespace KlayGE
 			SIMDVectorF4 ret;
 #if defined(SIMD_MATH_SSE)
 			ret.Vec() = _mm_div_ps(lhs.Vec(), rhs.Vec());
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vdivq_f32(lhs.Vec(), rhs.Vec());
 #else
 			for (int i = 0; i < 4; ++ i)
 			{
@@ -102,6 +138,8 @@ namespace KlayGE
 			SIMDVectorF4 ret;
 #if defined(SIMD_MATH_SSE)
 			ret.Vec() = _mm_sub_ps(_mm_setzero_ps(), rhs.Vec());
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vnegq_f32(rhs.Vec());
 #else
 			for (int i = 0; i < 4; ++ i)
 			{
@@ -172,6 +210,8 @@ namespace KlayGE
 			__m128 res = x.Vec();
 			__m128 data_temp = _mm_sub_ps(_mm_setzero_ps(), res);
 			ret.Vec() = _mm_max_ps(data_temp, res);
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vabsq_f32(x.Vec());
 #else
 			for (int i = 0; i < 4; ++ i)
 			{
@@ -217,6 +257,8 @@ namespace KlayGE
 			SIMDVectorF4 ret;
 #if defined(SIMD_MATH_SSE)
 			ret.Vec() = _mm_load_ss(&v);
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vsetq_lane_f32(v, vdupq_n_f32(0), 0);
 #else
 			ret.Vec()[0] = v;
 			for (int i = 1; i < 4; ++ i)
@@ -249,6 +291,8 @@ namespace KlayGE
 			__m128 x = _mm_load_ss(&v[0]);
 			__m128 y = _mm_load_ss(&v[1]);
 			ret.Vec() = _mm_unpacklo_ps(x, y);
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vcombine_f32(vld1_f32(v), vdup_n_f32(0));
 #else
 			for (int i = 0; i < 2; ++ i)
 			{
@@ -271,6 +315,8 @@ namespace KlayGE
 			__m128 z = _mm_load_ss(&v[2]);
 			__m128 xy = _mm_unpacklo_ps(x, y);
 			ret.Vec() = _mm_movelh_ps(xy, z);
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vcombine_f32(vld1_f32(v), vset_lane_f32(v[2], vdup_n_f32(0), 0));
 #else
 			for (int i = 0; i < 3; ++ i)
 			{
@@ -289,6 +335,8 @@ namespace KlayGE
 			SIMDVectorF4 ret;
 #if defined(SIMD_MATH_SSE)
 			ret.Vec() = _mm_load_ps(&v[0]);
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vld1q_f32(v);
 #else
 			for (int i = 0; i < 4; ++i)
 			{
@@ -302,6 +350,8 @@ namespace KlayGE
 		{
 #if defined(SIMD_MATH_SSE)
 			_mm_store_ss(&fs, v.Vec());
+#elif defined(SIMD_MATH_NEON)
+			fs = vgetq_lane_f32(v.Vec(), 0);
 #else
 			fs = v.Vec()[0];
 #endif
@@ -314,6 +364,8 @@ namespace KlayGE
 			__m128 y = _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1));
 			_mm_store_ss(&fs[0], x);
 			_mm_store_ss(&fs[1], y);
+#elif defined(SIMD_MATH_NEON)
+			vst1_f32(&fs[0], vget_low_f32(v.Vec()));
 #else
 			for (int i = 0; i < 2; ++ i)
 			{
@@ -331,6 +383,9 @@ namespace KlayGE
 			_mm_store_ss(&fs[0], x);
 			_mm_store_ss(&fs[1], y);
 			_mm_store_ss(&fs[2], z);
+#elif defined(SIMD_MATH_NEON)
+			vst1_f32(&fs[0], vget_low_f32(v.Vec()));
+			fs[2] = vgetq_lane_f32(v.Vec(), 2);
 #else
 			for (int i = 0; i < 3; ++ i)
 			{
@@ -343,6 +398,8 @@ namespace KlayGE
 		{
 #if defined(SIMD_MATH_SSE)
 			_mm_store_ps(&fs[0], v.Vec());
+#elif defined(SIMD_MATH_NEON)
+			vst1q_f32(&fs[0], v.Vec());
 #else
 			for (int i = 0; i < 4; ++ i)
 			{
@@ -351,11 +408,85 @@ namespace KlayGE
 #endif
 		}
 
+		SIMDMatrixF4 LoadMatrix(float4x4 const & m)
+		{
+#if defined(SIMD_MATH_SSE)
+			SIMDVectorF4 r0, r1, r2, r3;
+			r0.Vec() = _mm_loadu_ps(&m.data()[0]);
+			r1.Vec() = _mm_loadu_ps(&m.data()[4]);
+			r2.Vec() = _mm_loadu_ps(&m.data()[8]);
+			r3.Vec() = _mm_loadu_ps(&m.data()[12]);
+			return SIMDMatrixF4(r0, r1, r2, r3);
+#elif defined(SIMD_MATH_NEON)
+			SIMDVectorF4 r0, r1, r2, r3;
+			r0.Vec() = vld1q_f32(&m.data()[0]);
+			r1.Vec() = vld1q_f32(&m.data()[4]);
+			r2.Vec() = vld1q_f32(&m.data()[8]);
+			r3.Vec() = vld1q_f32(&m.data()[12]);
+			return SIMDMatrixF4(r0, r1, r2, r3);
+#else
+			return SIMDMatrixF4(m.data());
+#endif
+		}
+
+		void StoreMatrix(float4x4& m, SIMDMatrixF4 const & v)
+		{
+#if defined(SIMD_MATH_SSE)
+			_mm_storeu_ps(&m.data()[0], v.Row(0).Vec());
+			_mm_storeu_ps(&m.data()[4], v.Row(1).Vec());
+			_mm_storeu_ps(&m.data()[8], v.Row(2).Vec());
+			_mm_storeu_ps(&m.data()[12], v.Row(3).Vec());
+#elif defined(SIMD_MATH_NEON)
+			vst1q_f32(&m.data()[0], v.Row(0).Vec());
+			vst1q_f32(&m.data()[4], v.Row(1).Vec());
+			vst1q_f32(&m.data()[8], v.Row(2).Vec());
+			vst1q_f32(&m.data()[12], v.Row(3).Vec());
+#else
+			for (int i = 0; i < 16; ++ i)
+			{
+				m.data()[i] = v(i / 4, i % 4);
+			}
+#endif
+		}
+
+		SIMDVectorF4 LoadQuaternion(Quaternion const & q)
+		{
+			SIMDVectorF4 ret;
+#if defined(SIMD_MATH_SSE)
+			ret.Vec() = _mm_loadu_ps(&q[0]);
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vld1q_f32(&q[0]);
+#else
+			for (int i = 0; i < 4; ++ i)
+			{
+				ret.Vec()[i] = q[i];
+			}
+#endif
+			return ret;
+		}
+
+		void StoreQuaternion(Quaternion& q, SIMDVectorF4 const & v)
+		{
+#if defined(SIMD_MATH_SSE)
+			_mm_storeu_ps(&q[0], v.Vec());
+#elif defined(SIMD_MATH_NEON)
+			vst1q_f32(&q[0], v.Vec());
+#else
+			for (int i = 0; i < 4; ++ i)
+			{
+				q[i] = v.Vec()[i];
+			}
+#endif
+		}
+
 		SIMDVectorF4 SetVector(float x, float y, float z, float w)
 		{
 			SIMDVectorF4 ret;
 #if defined(SIMD_MATH_SSE)
 			ret.Vec() = _mm_set_ps(w, z, y, x);
+#elif defined(SIMD_MATH_NEON)
+			float const v[] = {x, y, z, w};
+			ret.Vec() = vld1q_f32(v);
 #else
 			ret.Vec()[0] = x;
 			ret.Vec()[1] = y;
@@ -370,6 +501,8 @@ namespace KlayGE
 			SIMDVectorF4 ret;
 #if defined(SIMD_MATH_SSE)
 			ret.Vec() = _mm_set_ps1(v);
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vdupq_n_f32(v);
 #else
 			ret.Vec()[0] = v;
 			ret.Vec()[1] = v;
@@ -383,6 +516,8 @@ namespace KlayGE
 		{
 #if defined(SIMD_MATH_SSE)
 			return _mm_cvtss_f32(rhs.Vec());
+#elif defined(SIMD_MATH_NEON)
+			return vgetq_lane_f32(rhs.Vec(), 0);
 #else
 			return GetByIndex(rhs, 0);
 #endif
@@ -393,6 +528,8 @@ namespace KlayGE
 #if defined(SIMD_MATH_SSE)
 			__m128 tmp = _mm_shuffle_ps(rhs.Vec(), rhs.Vec(), _MM_SHUFFLE(1, 1, 1, 1));
 			return _mm_cvtss_f32(tmp);
+#elif defined(SIMD_MATH_NEON)
+			return vgetq_lane_f32(rhs.Vec(), 1);
 #else
 			return GetByIndex(rhs, 1);
 #endif
@@ -403,6 +540,8 @@ namespace KlayGE
 #if defined(SIMD_MATH_SSE)
 			__m128 tmp = _mm_shuffle_ps(rhs.Vec(), rhs.Vec(), _MM_SHUFFLE(2, 2, 2, 2));
 			return _mm_cvtss_f32(tmp);
+#elif defined(SIMD_MATH_NEON)
+			return vgetq_lane_f32(rhs.Vec(), 2);
 #else
 			return GetByIndex(rhs, 2);
 #endif
@@ -413,6 +552,8 @@ namespace KlayGE
 #if defined(SIMD_MATH_SSE)
 			__m128 tmp = _mm_shuffle_ps(rhs.Vec(), rhs.Vec(), _MM_SHUFFLE(3, 3, 3, 3));
 			return _mm_cvtss_f32(tmp);
+#elif defined(SIMD_MATH_NEON)
+			return vgetq_lane_f32(rhs.Vec(), 3);
 #else
 			return GetByIndex(rhs, 3);
 #endif
@@ -443,6 +584,10 @@ namespace KlayGE
 			SIMDVectorF4 ret;
 			ret.Vec() = _mm_move_ss(rhs.Vec(), _mm_set_ss(v));
 			return ret;
+#elif defined(SIMD_MATH_NEON)
+			SIMDVectorF4 ret;
+			ret.Vec() = vsetq_lane_f32(v, rhs.Vec(), 0);
+			return ret;
 #else
 			return SetByIndex(rhs, v, 0);
 #endif
@@ -456,6 +601,10 @@ namespace KlayGE
 			yxzw = _mm_move_ss(yxzw, _mm_set_ss(v));
 			ret.Vec() = _mm_shuffle_ps(yxzw, yxzw, _MM_SHUFFLE(3, 2, 0, 1));
 			return ret;
+#elif defined(SIMD_MATH_NEON)
+			SIMDVectorF4 ret;
+			ret.Vec() = vsetq_lane_f32(v, rhs.Vec(), 1);
+			return ret;
 #else
 			return SetByIndex(rhs, v, 1);
 #endif
@@ -469,6 +618,10 @@ namespace KlayGE
 			zyxw = _mm_move_ss(zyxw, _mm_set_ss(v));
 			ret.Vec() = _mm_shuffle_ps(zyxw, zyxw, _MM_SHUFFLE(3, 0, 1, 2));
 			return ret;
+#elif defined(SIMD_MATH_NEON)
+			SIMDVectorF4 ret;
+			ret.Vec() = vsetq_lane_f32(v, rhs.Vec(), 2);
+			return ret;
 #else
 			return SetByIndex(rhs, v, 2);
 #endif
@@ -482,6 +635,10 @@ namespace KlayGE
 			wyzx = _mm_move_ss(wyzx, _mm_set_ss(v));
 			ret.Vec() = _mm_shuffle_ps(wyzx, wyzx, _MM_SHUFFLE(0, 2, 1, 3));
 			return ret;
+#elif defined(SIMD_MATH_NEON)
+			SIMDVectorF4 ret;
+			ret.Vec() = vsetq_lane_f32(v, rhs.Vec(), 3);
+			return ret;
 #else
 			return SetByIndex(rhs, v, 3);
 #endif
@@ -514,6 +671,8 @@ namespace KlayGE
 			SIMDVectorF4 ret;
 #if defined(SIMD_MATH_SSE)
 			ret.Vec() = _mm_max_ps(lhs.Vec(), rhs.Vec());
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vmaxq_f32(lhs.Vec(), rhs.Vec());
 #else
 			for (int i = 0; i < 4; ++ i)
 			{
@@ -528,6 +687,8 @@ namespace KlayGE
 			SIMDVectorF4 ret;
 #if defined(SIMD_MATH_SSE)
 			ret.Vec() = _mm_min_ps(lhs.Vec(), rhs.Vec());
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vminq_f32(lhs.Vec(), rhs.Vec());
 #else
 			for (int i = 0; i < 4; ++ i)
 			{
@@ -588,6 +749,8 @@ namespace KlayGE
 			__m128 y = _mm_shuffle_ps(res1, res1, _MM_SHUFFLE(1, 1, 1, 1));
 			res1 = _mm_add_ps(res1, y);
 			ret.Vec() = _mm_shuffle_ps(res1, res1, _MM_SHUFFLE(0, 0, 0, 0));
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vdupq_n_f32(vaddv_f32(vmul_f32(vget_low_f32(lhs.Vec()), vget_low_f32(rhs.Vec()))));
 #else
 			ret = SetVector(GetX(lhs) * GetX(rhs) + GetY(lhs) * GetY(rhs));
 #endif
@@ -604,6 +767,8 @@ namespace KlayGE
 			SIMDVectorF4 ret;
 #if defined(SIMD_MATH_SSE)
 			ret.Vec() = _mm_sqrt_ps(LengthSqVector2(rhs).Vec());
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vsqrtq_f32(LengthSqVector2(rhs).Vec());
 #else
 			ret = SetVector(sqrt(GetX(LengthSqVector2(rhs))));
 #endif
@@ -617,6 +782,8 @@ namespace KlayGE
 			__m128 temp = _mm_sqrt_ps(LengthSqVector2(rhs).Vec());
 			temp = _mm_rcp_ps(temp);
 			ret.Vec() = _mm_mul_ps(rhs.Vec(), temp);
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vdivq_f32(rhs.Vec(), vsqrtq_f32(LengthSqVector2(rhs).Vec()));
 #else
 			ret = rhs * MathLib::recip_sqrt(GetX(LengthSqVector2(rhs)));
 #endif
@@ -699,6 +866,10 @@ namespace KlayGE
 			m2 = _mm_shuffle_ps(rhs.Vec(), rhs.Vec(), _MM_SHUFFLE(0, 0, 2, 1));
 			__m128 res2 = _mm_mul_ps(m1, m2);
 			ret.Vec() = _mm_sub_ps(res1, res2);
+#elif defined(SIMD_MATH_NEON)
+			// cross(a, b) = yzx(a * yzx(b) - yzx(a) * b)
+			float32x4_t const res = vsubq_f32(vmulq_f32(lhs.Vec(), ShuffleYZXNeon(rhs.Vec())), vmulq_f32(ShuffleYZXNeon(lhs.Vec()), rhs.Vec()));
+			ret.Vec() = vsetq_lane_f32(0, ShuffleYZXNeon(res), 3);
 #else
 			ret = SetVector(GetY(lhs) * GetZ(rhs) - GetZ(lhs) * GetY(rhs),
 				GetZ(lhs) * GetX(rhs) - GetX(lhs) * GetZ(rhs),
@@ -720,6 +891,8 @@ namespace KlayGE
 			res1 = _mm_add_ps(res1, y);
 			res1 = _mm_add_ps(res1, z);
 			ret.Vec() = _mm_shuffle_ps(res1, res1, _MM_SHUFFLE(0, 0, 0, 0));
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vdupq_n_f32(vaddvq_f32(vsetq_lane_f32(0, vmulq_f32(lhs.Vec(), rhs.Vec()), 3)));
 #else
 			ret = SetVector(GetX(lhs) * GetX(rhs) + GetY(lhs) * GetY(rhs)
 				+ GetZ(lhs) * GetZ(rhs));
@@ -737,6 +910,8 @@ namespace KlayGE
 			SIMDVectorF4 ret;
 #if defined(SIMD_MATH_SSE)
 			ret.Vec() = _mm_sqrt_ps(LengthSqVector3(rhs).Vec());
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vsqrtq_f32(LengthSqVector3(rhs).Vec());
 #else
 			ret = SetVector(sqrt(GetX(LengthSqVector3(rhs))));
 #endif
@@ -750,6 +925,8 @@ namespace KlayGE
 			__m128 temp = _mm_sqrt_ps(LengthSqVector3(rhs).Vec());
 			temp = _mm_rcp_ps(temp);
 			ret.Vec() = _mm_mul_ps(rhs.Vec(), temp);
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vdivq_f32(rhs.Vec(), vsqrtq_f32(LengthSqVector3(rhs).Vec()));
 #else
 			ret = rhs * MathLib::recip_sqrt(GetX(LengthSqVector3(rhs)));
 #endif
@@ -770,6 +947,20 @@ namespace KlayGE
 			__m128 w = _mm_shuffle_ps(res1, res1, _MM_SHUFFLE(3, 3, 3, 3));
 			__m128 inv_w = _mm_rcp_ps(w);
 			ret.Vec() = _mm_mul_ps(res1, inv_w);
+#elif defined(SIMD_MATH_NEON)
+			float32x4_t const temp = v.Vec();
+			float32x4_t res = vmlaq_laneq_f32(mat.Row(3).Vec(), mat.Row(0).Vec(), temp, 0);
+			res = vmlaq_laneq_f32(res, mat.Row(1).Vec(), temp, 1);
+			res = vmlaq_laneq_f32(res, mat.Row(2).Vec(), temp, 2);
+			float const w = vgetq_lane_f32(res, 3);
+			if (MathLib::equal(w, 0.0f))
+			{
+				ret = SIMDVectorF4::Zero();
+			}
+			else
+			{
+				ret.Vec() = vsetq_lane_f32(0, vdivq_f32(res, vdupq_n_f32(w)), 3);
+			}
 #else
 			SIMDVectorF4 temp;
 			for (int i = 0; i < 4; ++ i)
@@ -806,6 +997,11 @@ namespace KlayGE
 			res1 = _mm_add_ps(res1, res2);
 			res2 = _mm_mul_ps(_mm_shuffle_ps(temp, temp, _MM_SHUFFLE(2, 2, 2, 2)), mat.Row(2).Vec());
 			ret.Vec() = _mm_add_ps(res1, res2);
+#elif defined(SIMD_MATH_NEON)
+			float32x4_t const temp = v.Vec();
+			float32x4_t res = vmulq_laneq_f32(mat.Row(0).Vec(), temp, 0);
+			res = vmlaq_laneq_f32(res, mat.Row(1).Vec(), temp, 1);
+			ret.Vec() = vmlaq_laneq_f32(res, mat.Row(2).Vec(), temp, 2);
 #else
 			for (int i = 0; i < 3; ++ i)
 			{
@@ -926,6 +1122,8 @@ namespace KlayGE
 			__m128 zw = _mm_shuffle_ps(res1, res1, _MM_SHUFFLE(2, 2, 2, 2));
 			res1 = _mm_add_ps(res1, zw);
 			ret.Vec() = _mm_shuffle_ps(res1, res1, _MM_SHUFFLE(0, 0, 0, 0));
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vdupq_n_f32(vaddvq_f32(vmulq_f32(lhs.Vec(), rhs.Vec())));
 #else
 			ret = SetVector(GetX(lhs) * GetX(rhs) + GetY(lhs) * GetY(rhs)
 				+ GetZ(lhs) * GetZ(rhs) + GetW(lhs) * GetW(rhs));
@@ -943,6 +1141,8 @@ namespace KlayGE
 			SIMDVectorF4 ret;
 #if defined(SIMD_MATH_SSE)
 			ret.Vec() = _mm_sqrt_ps(LengthSqVector4(rhs).Vec());
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vsqrtq_f32(LengthSqVector4(rhs).Vec());
 #else
 			ret = SetVector(sqrt(GetX(LengthSqVector4(rhs))));
 #endif
@@ -956,6 +1156,8 @@ namespace KlayGE
 			__m128 temp = _mm_sqrt_ps(LengthSqVector4(rhs).Vec());
 			temp = _mm_rcp_ps(temp);
 			ret.Vec() = _mm_mul_ps(rhs.Vec(), temp);
+#elif defined(SIMD_MATH_NEON)
+			ret.Vec() = vdivq_f32(rhs.Vec(), vsqrtq_f32(LengthSqVector4(rhs).Vec()));
 #else
 			ret = rhs * MathLib::recip_sqrt(GetX(LengthSqVector4(rhs)));
 #endif
@@ -974,6 +1176,12 @@ namespace KlayGE
 			res1 = _mm_add_ps(res1, res2);
 			res2 = _mm_mul_ps(_mm_shuffle_ps(temp, temp, _MM_SHUFFLE(3, 3, 3, 3)), mat.Row(3).Vec());
 			ret.Vec() = _mm_add_ps(res1, res2);
+#elif defined(SIMD_MATH_NEON)
+			float32x4_t const temp = v.Vec();
+			float32x4_t res = vmulq_laneq_f32(mat.Row(0).Vec(), temp, 0);
+			res = vmlaq_laneq_f32(res, mat.Row(1).Vec(), temp, 1);
+			res = vmlaq_laneq_f32(res, mat.Row(2).Vec(), temp, 2);
+			ret.Vec() = vmlaq_laneq_f32(res, mat.Row(3).Vec(), temp, 3);
 #else
 			for (int i = 0; i < 4; ++ i)
 			{
@@ -1043,6 +1251,23 @@ namespace KlayGE
 			row4.Vec() = _mm_add_ps(row4.Vec(), _mm_mul_ps(t3, GetVector(l3, 3)));
 
 			return SIMDMatrixF4(row1, row2,row3,row4);
+#elif defined(SIMD_MATH_NEON)
+			float32x4_t const t0 = rhs.Row(0).Vec();
+			float32x4_t const t1 = rhs.Row(1).Vec();
+			float32x4_t const t2 = rhs.Row(2).Vec();
+			float32x4_t const t3 = rhs.Row(3).Vec();
+
+			SIMDVectorF4 rows[4];
+			for (size_t i = 0; i < 4; ++ i)
+			{
+				float32x4_t const l = lhs.Row(i).Vec();
+				float32x4_t row = vmulq_laneq_f32(t0, l, 0);
+				row = vmlaq_laneq_f32(row, t1, l, 1);
+				row = vmlaq_laneq_f32(row, t2, l, 2);
+				rows[i].Vec() = vmlaq_laneq_f32(row, t3, l, 3);
+			}
+
+			return SIMDMatrixF4(rows[0], rows[1], rows[2], rows[3]);
 #else
 			SIMDMatrixF4 const tmp = Transpose(rhs);
 
@@ -1179,10 +1404,11 @@ namespace KlayGE
 			__m128 row0, row1, row2, row3;
 			__m128 det, tmp1;
 
-			row0 = rhs.Col(0).Vec();
-			row1 = rhs.Col(1).Vec();
-			row2 = rhs.Col(2).Vec();
-			row3 = rhs.Col(3).Vec();
+			row0 = rhs.Row(0).Vec();
+			row1 = rhs.Row(1).Vec();
+			row2 = rhs.Row(2).Vec();
+			row3 = rhs.Row(3).Vec();
+			_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
 			row1 = _mm_shuffle_ps(row1, row1, _MM_SHUFFLE(1, 0, 3, 2));
 			row3 = _mm_shuffle_ps(row3, row3, _MM_SHUFFLE(1, 0, 3, 2));
 
@@ -1244,20 +1470,105 @@ namespace KlayGE
 			det = _mm_mul_ps(row0, minor0);
 			det = _mm_add_ps(_mm_shuffle_ps(det, det, 0x4E), det);
 			det = _mm_add_ss(_mm_shuffle_ps(det, det, 0xB1), det);
-			tmp1 = _mm_rcp_ss(det);
-			det = _mm_sub_ss(_mm_add_ss(tmp1, tmp1), _mm_mul_ss(det, _mm_mul_ss(tmp1, tmp1)));
-			det = _mm_shuffle_ps(det, det, 0x00);
-			SIMDVectorF4 r0;
-			SIMDVectorF4 r1;
-			SIMDVectorF4 r2;
-			SIMDVectorF4 r3;
-			r0.Vec() = _mm_mul_ps(det, minor0);
-			r1.Vec() = _mm_mul_ps(det, minor1);
-			r2.Vec() = _mm_mul_ps(det, minor2);
-			r3.Vec() = _mm_mul_ps(det, minor3);
-			
-			ret = SIMDMatrixF4(r0, r1, r2, r3);
+			if (MathLib::equal(_mm_cvtss_f32(det), 0.0f))
+			{
+				ret = rhs;
+			}
+			else
+			{
+				tmp1 = _mm_rcp_ss(det);
+				det = _mm_sub_ss(_mm_add_ss(tmp1, tmp1), _mm_mul_ss(det, _mm_mul_ss(tmp1, tmp1)));
+				det = _mm_shuffle_ps(det, det, 0x00);
+				SIMDVectorF4 r0;
+				SIMDVectorF4 r1;
+				SIMDVectorF4 r2;
+				SIMDVectorF4 r3;
+				r0.Vec() = _mm_mul_ps(det, minor0);
+				r1.Vec() = _mm_mul_ps(det, minor1);
+				r2.Vec() = _mm_mul_ps(det, minor2);
+				r3.Vec() = _mm_mul_ps(det, minor3);
+
+				ret = SIMDMatrixF4(r0, r1, r2, r3);
+			}
+
+#elif defined(SIMD_MATH_NEON)
+			// Same cofactor expansion as the SSE path. 0xB1 swaps adjacent lanes (vrev64q), 0x4E swaps halves (vextq 2).
+			float32x4_t row0 = rhs.Row(0).Vec();
+			float32x4_t row1 = rhs.Row(1).Vec();
+			float32x4_t row2 = rhs.Row(2).Vec();
+			float32x4_t row3 = rhs.Row(3).Vec();
+			TransposeNeon(row0, row1, row2, row3);
+			row1 = vextq_f32(row1, row1, 2);
+			row3 = vextq_f32(row3, row3, 2);
+
+			float32x4_t minor0, minor1, minor2, minor3;
+			float32x4_t tmp1;
+
+			tmp1 = vrev64q_f32(vmulq_f32(row2, row3));
+			minor0 = vmulq_f32(row1, tmp1);
+			minor1 = vmulq_f32(row0, tmp1);
+			tmp1 = vextq_f32(tmp1, tmp1, 2);
+			minor0 = vsubq_f32(vmulq_f32(row1, tmp1), minor0);
+			minor1 = vsubq_f32(vmulq_f32(row0, tmp1), minor1);
+			minor1 = vextq_f32(minor1, minor1, 2);
+
+			tmp1 = vrev64q_f32(vmulq_f32(row1, row2));
+			minor0 = vaddq_f32(vmulq_f32(row3, tmp1), minor0);
+			minor3 = vmulq_f32(row0, tmp1);
+			tmp1 = vextq_f32(tmp1, tmp1, 2);
+			minor0 = vsubq_f32(minor0, vmulq_f32(row3, tmp1));
+			minor3 = vsubq_f32(vmulq_f32(row0, tmp1), minor3);
+			minor3 = vextq_f32(minor3, minor3, 2);
+
+			tmp1 = vrev64q_f32(vmulq_f32(vextq_f32(row1, row1, 2), row3));
+			row2 = vextq_f32(row2, row2, 2);
+			minor0 = vaddq_f32(vmulq_f32(row2, tmp1), minor0);
+			minor2 = vmulq_f32(row0, tmp1);
+			tmp1 = vextq_f32(tmp1, tmp1, 2);
+			minor0 = vsubq_f32(minor0, vmulq_f32(row2, tmp1));
+			minor2 = vsubq_f32(vmulq_f32(row0, tmp1), minor2);
+			minor2 = vextq_f32(minor2, minor2, 2);
+
+			tmp1 = vrev64q_f32(vmulq_f32(row0, row1));
+			minor2 = vaddq_f32(vmulq_f32(row3, tmp1), minor2);
+			minor3 = vsubq_f32(vmulq_f32(row2, tmp1), minor3);
+			tmp1 = vextq_f32(tmp1, tmp1, 2);
+			minor2 = vsubq_f32(vmulq_f32(row3, tmp1), minor2);
+			minor3 = vsubq_f32(minor3, vmulq_f32(row2, tmp1));
+
+			tmp1 = vrev64q_f32(vmulq_f32(row0, row3));
+			minor1 = vsubq_f32(minor1, vmulq_f32(row2, tmp1));
+			minor2 = vaddq_f32(vmulq_f32(row1, tmp1), minor2);
+			tmp1 = vextq_f32(tmp1, tmp1, 2);
+			minor1 = vaddq_f32(vmulq_f32(row2, tmp1), minor1);
+			minor2 = vsubq_f32(minor2, vmulq_f32(row1, tmp1));
+
+			tmp1 = vrev64q_f32(vmulq_f32(row0, row2));
+			minor1 = vaddq_f32(vmulq_f32(row3, tmp1), minor1);
+			minor3 = vsubq_f32(minor3, vmulq_f32(row1, tmp1));
+			tmp1 = vextq_f32(tmp1, tmp1, 2);
+			minor1 = vsubq_f32(minor1, vmulq_f32(row3, tmp1));
+			minor3 = vaddq_f32(vmulq_f32(row1, tmp1), minor3);
+
+			float const det = vaddvq_f32(vmulq_f32(row0, minor0));
+			if (MathLib::equal(det, 0.0f))
+			{
+				ret = rhs;
+			}
+			else
+			{
+				float32x4_t const inv_det = vdupq_n_f32(1 / det);
+				SIMDVectorF4 r0;
+				SIMDVectorF4 r1;
+				SIMDVectorF4 r2;
+				SIMDVectorF4 r3;
+				r0.Vec() = vmulq_f32(inv_det, minor0);
+				r1.Vec() = vmulq_f32(inv_det, minor1);
+				r2.Vec() = vmulq_f32(inv_det, minor2);
+				r3.Vec() = vmulq_f32(inv_det, minor3);
 
+				ret = SIMDMatrixF4(r0, r1, r2, r3);
+			}
 #else
 			float const _2132_2231 = rhs(1, 0) * rhs(2, 1) - rhs(1, 1) * rhs(2, 0);
 			float const _2133_2331 = rhs(1, 0) * rhs(2, 2) - rhs(1, 2) * rhs(2, 0);
@@ -1615,6 +1926,17 @@ namespace KlayGE
 			r3.Vec() = rhs.Row(3).Vec();
 			_MM_TRANSPOSE4_PS(r0.Vec(), r1.Vec(), r2.Vec(), r3.Vec());
 			return SIMDMatrixF4(r0, r1, r2, r3);
+#elif defined(SIMD_MATH_NEON)
+			SIMDVectorF4 r0;
+			SIMDVectorF4 r1;
+			SIMDVectorF4 r2;
+			SIMDVectorF4 r3;
+			r0.Vec() = rhs.Row(0).Vec();
+			r1.Vec() = rhs.Row(1).Vec();
+			r2.Vec() = rhs.Row(2).Vec();
+			r3.Vec() = rhs.Row(3).Vec();
+			TransposeNeon(r0.Vec(), r1.Vec(), r2.Vec(), r3.Vec());
+			return SIMDMatrixF4(r0, r1, r2, r3);
 #else
 			V4TYPE const & r0 = rhs.Row(0).Vec();
 			V4TYPE const & r1 = rhs.Row(1).Vec();
@@ -1808,11 +2130,56 @@ namespace KlayGE
 
 		SIMDVectorF4 MultiplyQuat(SIMDVectorF4 const & lhs, SIMDVectorF4 const & rhs)
 		{
+#if defined(SIMD_MATH_SSE)
+			__m128 const l = lhs.Vec();
+			__m128 const r = rhs.Vec();
+			__m128 const sign_wzyx = _mm_set_ps(-0.0f, -0.0f, 0.0f, 0.0f);
+			__m128 const sign_yxwz = _mm_set_ps(-0.0f, 0.0f, 0.0f, -0.0f);
+			__m128 const sign_xwzy = _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+
+			// lw * (rx, ry, rz, rw)
+			__m128 ret = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r);
+			// lx * (rw, rz, -ry, -rx)
+			ret = _mm_add_ps(ret, _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)),
+				_mm_xor_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(0, 1, 2, 3)), sign_wzyx)));
+			// ly * (-rz, rw, rx, -ry)
+			ret = _mm_add_ps(ret, _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)),
+				_mm_xor_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 0, 3, 2)), sign_yxwz)));
+			// lz * (ry, -rx, rw, -rz)
+			ret = _mm_add_ps(ret, _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)),
+				_mm_xor_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 3, 0, 1)), sign_xwzy)));
+
+			SIMDVectorF4 q;
+			q.Vec() = ret;
+			return q;
+#elif defined(SIMD_MATH_NEON)
+			static float const sign_wzyx[] = {1, 1, -1, -1};
+			static float const sign_yxwz[] = {-1, 1, 1, -1};
+			static float const sign_xwzy[] = {1, -1, 1, -1};
+
+			float32x4_t const l = lhs.Vec();
+			float32x4_t const r = rhs.Vec();
+			float32x4_t const r_yxwz = vrev64q_f32(r);
+
+			// lw * (rx, ry, rz, rw)
+			float32x4_t ret = vmulq_laneq_f32(r, l, 3);
+			// lx * (rw, rz, -ry, -rx)
+			ret = vmlaq_laneq_f32(ret, vmulq_f32(vextq_f32(r_yxwz, r_yxwz, 2), vld1q_f32(sign_wzyx)), l, 0);
+			// ly * (-rz, rw, rx, -ry)
+			ret = vmlaq_laneq_f32(ret, vmulq_f32(vextq_f32(r, r, 2), vld1q_f32(sign_yxwz)), l, 1);
+			// lz * (ry, -rx, rw, -rz)
+			ret = vmlaq_laneq_f32(ret, vmulq_f32(r_yxwz, vld1q_f32(sign_xwzy)), l, 2);
+
+			SIMDVectorF4 q;
+			q.Vec() = ret;
+			return q;
+#else
 			return SetVector(
 				GetX(lhs) * GetW(rhs) - GetY(lhs) * GetZ(rhs) + GetZ(lhs) * GetY(rhs) + GetW(lhs) * GetX(rhs),
 				GetX(lhs) * GetZ(rhs) + GetY(lhs) * GetW(rhs) - GetZ(lhs) * GetX(rhs) + GetW(lhs) * GetY(rhs),
 				GetY(lhs) * GetX(rhs) - GetX(lhs) * GetY(rhs) + GetZ(lhs) * GetW(rhs) + GetW(lhs) * GetZ(rhs),
 				GetW(lhs) * GetW(rhs) - GetX(lhs) * GetX(rhs) - GetY(lhs) * GetY(rhs) - GetZ(lhs) * GetZ(rhs));
+#endif
 		}
 
 		SIMDVectorF4 RotationAxis(SIMDVectorF4 const & v, float angle)
@@ -2155,6 +2522,208 @@ namespace KlayGE
 			proj.Col(2, clip_plane * SetVector(c));
 		}
 
+		// Bound
+		///////////////////////////////////////////////////////////////////////////////
+		AABBox TransformAABB(AABBox const & aabb, SIMDMatrixF4 const & mat)
+		{
+			float3 const & min = aabb.Min();
+			float3 const & max = aabb.Max();
+
+#if defined(SIMD_MATH_SSE)
+			// Each corner is a sum of one term per axis, so the 6 products are shared by all 8 corners.
+			__m128 const r3 = mat.Row(3).Vec();
+			__m128 const xs[] = {_mm_mul_ps(_mm_set1_ps(min.x()), mat.Row(0).Vec()), _mm_mul_ps(_mm_set1_ps(max.x()), mat.Row(0).Vec())};
+			__m128 const ys[] = {_mm_mul_ps(_mm_set1_ps(min.y()), mat.Row(1).Vec()), _mm_mul_ps(_mm_set1_ps(max.y()), mat.Row(1).Vec())};
+			__m128 const zs[] = {_mm_add_ps(_mm_mul_ps(_mm_set1_ps(min.z()), mat.Row(2).Vec()), r3),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(max.z()), mat.Row(2).Vec()), r3)};
+
+			__m128 const abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+			__m128 const epsilon = _mm_set1_ps(std::numeric_limits<float>::epsilon());
+
+			__m128 ret_min = _mm_set1_ps(+std::numeric_limits<float>::max());
+			__m128 ret_max = _mm_set1_ps(-std::numeric_limits<float>::max());
+			for (size_t i = 0; i < 8; ++ i)
+			{
+				__m128 const v = _mm_add_ps(_mm_add_ps(xs[i & 1], ys[(i >> 1) & 1]), zs[(i >> 2) & 1]);
+				__m128 const w = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+				// Same as MathLib::transform_coord, a corner with w == 0 goes to the origin
+				__m128 const zero_w = _mm_cmple_ps(_mm_and_ps(w, abs_mask), epsilon);
+				__m128 const p = _mm_andnot_ps(zero_w, _mm_div_ps(v, w));
+				ret_min = _mm_min_ps(ret_min, p);
+				ret_max = _mm_max_ps(ret_max, p);
+			}
+
+			alignas(16) float mins[4];
+			alignas(16) float maxs[4];
+			_mm_store_ps(mins, ret_min);
+			_mm_store_ps(maxs, ret_max);
+			return AABBox(float3(mins[0], mins[1], mins[2]), float3(maxs[0], maxs[1], maxs[2]));
+#elif defined(SIMD_MATH_NEON)
+			float32x4_t const r3 = mat.Row(3).Vec();
+			float32x4_t const xs[] = {vmulq_n_f32(mat.Row(0).Vec(), min.x()), vmulq_n_f32(mat.Row(0).Vec(), max.x())};
+			float32x4_t const ys[] = {vmulq_n_f32(mat.Row(1).Vec(), min.y()), vmulq_n_f32(mat.Row(1).Vec(), max.y())};
+			float32x4_t const zs[] = {vmlaq_n_f32(r3, mat.Row(2).Vec(), min.z()), vmlaq_n_f32(r3, mat.Row(2).Vec(), max.z())};
+
+			float32x4_t const zero = vdupq_n_f32(0);
+			float32x4_t const epsilon = vdupq_n_f32(std::numeric_limits<float>::epsilon());
+
+			float32x4_t ret_min = vdupq_n_f32(+std::numeric_limits<float>::max());
+			float32x4_t ret_max = vdupq_n_f32(-std::numeric_limits<float>::max());
+			for (size_t i = 0; i < 8; ++ i)
+			{
+				float32x4_t const v = vaddq_f32(vaddq_f32(xs[i & 1], ys[(i >> 1) & 1]), zs[(i >> 2) & 1]);
+				float32x4_t const w = vdupq_laneq_f32(v, 3);
+				// Same as MathLib::transform_coord, a corner with w == 0 goes to the origin
+				uint32x4_t const zero_w = vcleq_f32(vabsq_f32(w), epsilon);
+				float32x4_t const p = vbslq_f32(zero_w, zero, vdivq_f32(v, w));
+				ret_min = vminq_f32(ret_min, p);
+				ret_max = vmaxq_f32(ret_max, p);
+			}
+
+			float mins[4];
+			float maxs[4];
+			vst1q_f32(mins, ret_min);
+			vst1q_f32(maxs, ret_max);
+			return AABBox(float3(mins[0], mins[1], mins[2]), float3(maxs[0], maxs[1], maxs[2]));
+#else
+			float3 ret_min(+std::numeric_limits<float>::max(), +std::numeric_limits<float>::max(), +std::numeric_limits<float>::max());
+			float3 ret_max(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+			for (size_t i = 0; i < 8; ++ i)
+			{
+				float const x = (i & 1) ? max.x() : min.x();
+				float const y = (i & 2) ? max.y() : min.y();
+				float const z = (i & 4) ? max.z() : min.z();
+				float v[4];
+				for (int j = 0; j < 4; ++ j)
+				{
+					v[j] = x * mat(0, j) + y * mat(1, j) + z * mat(2, j) + mat(3, j);
+				}
+
+				float3 p(0, 0, 0);
+				if (!MathLib::equal(v[3], 0.0f))
+				{
+					p = float3(v[0], v[1], v[2]) / v[3];
+				}
+				ret_min = MathLib::minimize(ret_min, p);
+				ret_max = MathLib::maximize(ret_max, p);
+			}
+			return AABBox(ret_min, ret_max);
+#endif
+		}
+
+		BoundOverlap IntersectAABBFrustum(AABBox const & aabb, Frustum const & frustum)
+		{
+			float3 const & min = aabb.Min();
+			float3 const & max = aabb.Max();
+
+#if defined(SIMD_MATH_SSE)
+			__m128 const min_x = _mm_set1_ps(min.x());
+			__m128 const min_y = _mm_set1_ps(min.y());
+			__m128 const min_z = _mm_set1_ps(min.z());
+			__m128 const max_x = _mm_set1_ps(max.x());
+			__m128 const max_y = _mm_set1_ps(max.y());
+			__m128 const max_z = _mm_set1_ps(max.z());
+
+			__m128 const zero = _mm_setzero_ps();
+			__m128 outside = zero;
+			__m128 intersect = zero;
+			// 6 planes in 2 batches of 4, the last batch repeats planes 4 and 5
+			for (uint32_t batch = 0; batch < 2; ++ batch)
+			{
+				__m128 a, b, c, d;
+				{
+					Plane const & p0 = frustum.FrustumPlane(batch * 4 + 0);
+					Plane const & p1 = frustum.FrustumPlane(batch * 4 + 1);
+					Plane const & p2 = frustum.FrustumPlane(batch * 4 + 2 - batch * 2);
+					Plane const & p3 = frustum.FrustumPlane(batch * 4 + 3 - batch * 2);
+					a = _mm_setr_ps(p0.a(), p0.b(), p0.c(), p0.d());
+					b = _mm_setr_ps(p1.a(), p1.b(), p1.c(), p1.d());
+					c = _mm_setr_ps(p2.a(), p2.b(), p2.c(), p2.d());
+					d = _mm_setr_ps(p3.a(), p3.b(), p3.c(), p3.d());
+					_MM_TRANSPOSE4_PS(a, b, c, d);
+				}
+
+				// Signed distances of the farthest and the nearest corners along each plane normal
+				__m128 const ax0 = _mm_mul_ps(a, min_x);
+				__m128 const ax1 = _mm_mul_ps(a, max_x);
+				__m128 const by0 = _mm_mul_ps(b, min_y);
+				__m128 const by1 = _mm_mul_ps(b, max_y);
+				__m128 const cz0 = _mm_mul_ps(c, min_z);
+				__m128 const cz1 = _mm_mul_ps(c, max_z);
+				__m128 const far_dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_max_ps(ax0, ax1), _mm_max_ps(by0, by1)),
+					_mm_max_ps(cz0, cz1)), d);
+				__m128 const near_dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_min_ps(ax0, ax1), _mm_min_ps(by0, by1)),
+					_mm_min_ps(cz0, cz1)), d);
+
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(far_dist, zero));
+				intersect = _mm_or_ps(intersect, _mm_cmplt_ps(near_dist, zero));
+			}
+
+			if (_mm_movemask_ps(outside) != 0)
+			{
+				return BoundOverlap::No;
+			}
+			return (_mm_movemask_ps(intersect) != 0) ? BoundOverlap::Partial : BoundOverlap::Yes;
+#elif defined(SIMD_MATH_NEON)
+			float32x4_t const zero = vdupq_n_f32(0);
+			uint32x4_t outside = vdupq_n_u32(0);
+			uint32x4_t intersect = vdupq_n_u32(0);
+			// 6 planes in 2 batches of 4, the last batch repeats planes 4 and 5
+			for (uint32_t batch = 0; batch < 2; ++ batch)
+			{
+				float32x4_t a = vld1q_f32(&frustum.FrustumPlane(batch * 4 + 0).a());
+				float32x4_t b = vld1q_f32(&frustum.FrustumPlane(batch * 4 + 1).a());
+				float32x4_t c = vld1q_f32(&frustum.FrustumPlane(batch * 4 + 2 - batch * 2).a());
+				float32x4_t d = vld1q_f32(&frustum.FrustumPlane(batch * 4 + 3 - batch * 2).a());
+				TransposeNeon(a, b, c, d);
+
+				// Signed distances of the farthest and the nearest corners along each plane normal
+				float32x4_t const ax0 = vmulq_n_f32(a, min.x());
+				float32x4_t const ax1 = vmulq_n_f32(a, max.x());
+				float32x4_t const by0 = vmulq_n_f32(b, min.y());
+				float32x4_t const by1 = vmulq_n_f32(b, max.y());
+				float32x4_t const cz0 = vmulq_n_f32(c, min.z());
+				float32x4_t const cz1 = vmulq_n_f32(c, max.z());
+				float32x4_t const far_dist = vaddq_f32(vaddq_f32(vaddq_f32(vmaxq_f32(ax0, ax1), vmaxq_f32(by0, by1)),
+					vmaxq_f32(cz0, cz1)), d);
+				float32x4_t const near_dist = vaddq_f32(vaddq_f32(vaddq_f32(vminq_f32(ax0, ax1), vminq_f32(by0, by1)),
+					vminq_f32(cz0, cz1)), d);
+
+				outside = vorrq_u32(outside, vcltq_f32(far_dist, zero));
+				intersect = vorrq_u32(intersect, vcltq_f32(near_dist, zero));
+			}
+
+			if (vmaxvq_u32(outside) != 0)
+			{
+				return BoundOverlap::No;
+			}
+			return (vmaxvq_u32(intersect) != 0) ? BoundOverlap::Partial : BoundOverlap::Yes;
+#else
+			bool intersect = false;
+			for (uint32_t i = 0; i < 6; ++ i)
+			{
+				Plane const & plane = frustum.FrustumPlane(i);
+
+				float const ax0 = plane.a() * min.x();
+				float const ax1 = plane.a() * max.x();
+				float const by0 = plane.b() * min.y();
+				float const by1 = plane.b() * max.y();
+				float const cz0 = plane.c() * min.z();
+				float const cz1 = plane.c() * max.z();
+				if (std::max(ax0, ax1) + std::max(by0, by1) + std::max(cz0, cz1) + plane.d() < 0)
+				{
+					return BoundOverlap::No;
+				}
+				if (std::min(ax0, ax1) + std::min(by0, by1) + std::min(cz0, cz1) + plane.d() < 0)
+				{
+					intersect = true;
+				}
+			}
+
+			return intersect ? BoundOverlap::Partial : BoundOverlap::Yes;
+#endif
+		}
+
 		// Color
 		///////////////////////////////////////////////////////////////////////////////
 		SIMDVectorF4 NegativeColor(SIMDVectorF4 const & rhs)
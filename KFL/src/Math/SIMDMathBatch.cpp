@@ -0,0 +1,202 @@
+/**
+ * @file SIMDMathBatch.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KFL, a subproject of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KFL/KFL.hpp>
+#include <KFL/SIMDMath.hpp>
+
+#if defined(SIMD_MATH_SSE)
+	#include <immintrin.h>
+
+	#include <KFL/CpuInfo.hpp>
+#endif
+
+namespace
+{
+	using namespace KlayGE;
+
+#if defined(SIMD_MATH_SSE)
+	// Builds only assume SSE2, so the AVX2 code is enabled per function and selected at runtime.
+#if defined(KLAYGE_COMPILER_MSVC)
+	#define KLAYGE_TARGET_AVX2
+#else
+	#define KLAYGE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+	// Two SIMDVectorF4 side by side in one 256-bit register. Every operation works on the two 128-bit halves
+	// independently, with the same instruction order as the SSE path, so the results are bitwise identical.
+	class SIMDVectorF8
+	{
+	public:
+		KLAYGE_TARGET_AVX2 static SIMDVectorF8 Load(SIMDVectorF4 const & lo, SIMDVectorF4 const & hi)
+		{
+			return SIMDVectorF8(_mm256_insertf128_ps(_mm256_castps128_ps256(lo.Vec()), hi.Vec(), 1));
+		}
+
+		KLAYGE_TARGET_AVX2 static SIMDVectorF8 Broadcast(SIMDVectorF4 const & v)
+		{
+			return SIMDVectorF8(_mm256_broadcast_ps(&v.Vec()));
+		}
+
+		KLAYGE_TARGET_AVX2 void Store(SIMDVectorF4& lo, SIMDVectorF4& hi) const
+		{
+			lo.Vec() = _mm256_castps256_ps128(v_);
+			hi.Vec() = _mm256_extractf128_ps(v_, 1);
+		}
+
+		template <int I>
+		KLAYGE_TARGET_AVX2 SIMDVectorF8 Splat() const
+		{
+			return SIMDVectorF8(_mm256_shuffle_ps(v_, v_, _MM_SHUFFLE(I, I, I, I)));
+		}
+
+		KLAYGE_TARGET_AVX2 friend SIMDVectorF8 operator+(SIMDVectorF8 const & lhs, SIMDVectorF8 const & rhs)
+		{
+			return SIMDVectorF8(_mm256_add_ps(lhs.v_, rhs.v_));
+		}
+
+		KLAYGE_TARGET_AVX2 friend SIMDVectorF8 operator*(SIMDVectorF8 const & lhs, SIMDVectorF8 const & rhs)
+		{
+			return SIMDVectorF8(_mm256_mul_ps(lhs.v_, rhs.v_));
+		}
+
+	private:
+		KLAYGE_TARGET_AVX2 explicit SIMDVectorF8(__m256 v)
+			: v_(v)
+		{
+		}
+
+	private:
+		__m256 v_;
+	};
+
+	KLAYGE_TARGET_AVX2 void TransformVector4Avx2(std::span<SIMDVectorF4> out, std::span<SIMDVectorF4 const> vs,
+		SIMDMatrixF4 const & mat)
+	{
+		SIMDVectorF8 const r0 = SIMDVectorF8::Broadcast(mat.Row(0));
+		SIMDVectorF8 const r1 = SIMDVectorF8::Broadcast(mat.Row(1));
+		SIMDVectorF8 const r2 = SIMDVectorF8::Broadcast(mat.Row(2));
+		SIMDVectorF8 const r3 = SIMDVectorF8::Broadcast(mat.Row(3));
+
+		size_t i = 0;
+		for (; i + 2 <= vs.size(); i += 2)
+		{
+			SIMDVectorF8 const v = SIMDVectorF8::Load(vs[i + 0], vs[i + 1]);
+			SIMDVectorF8 res = v.Splat<0>() * r0;
+			res = res + v.Splat<1>() * r1;
+			res = res + v.Splat<2>() * r2;
+			res = res + v.Splat<3>() * r3;
+			res.Store(out[i + 0], out[i + 1]);
+		}
+		for (; i < vs.size(); ++ i)
+		{
+			out[i] = SIMDMathLib::TransformVector4(vs[i], mat);
+		}
+	}
+
+	KLAYGE_TARGET_AVX2 void MultiplyAvx2(std::span<SIMDMatrixF4> out, std::span<SIMDMatrixF4 const> lhs,
+		std::span<SIMDMatrixF4 const> rhs)
+	{
+		for (size_t i = 0; i < lhs.size(); ++ i)
+		{
+			SIMDMatrixF4 const & l = lhs[i];
+			SIMDMatrixF4 const & r = rhs[i];
+
+			SIMDVectorF8 const t0 = SIMDVectorF8::Broadcast(r.Row(0));
+			SIMDVectorF8 const t1 = SIMDVectorF8::Broadcast(r.Row(1));
+			SIMDVectorF8 const t2 = SIMDVectorF8::Broadcast(r.Row(2));
+			SIMDVectorF8 const t3 = SIMDVectorF8::Broadcast(r.Row(3));
+
+			SIMDVectorF4 rows[4];
+			for (size_t j = 0; j < 4; j += 2)
+			{
+				SIMDVectorF8 const lr = SIMDVectorF8::Load(l.Row(j + 0), l.Row(j + 1));
+				SIMDVectorF8 res = t0 * lr.Splat<0>();
+				res = res + t1 * lr.Splat<1>();
+				res = res + t2 * lr.Splat<2>();
+				res = res + t3 * lr.Splat<3>();
+				res.Store(rows[j + 0], rows[j + 1]);
+			}
+			out[i] = SIMDMatrixF4(rows[0], rows[1], rows[2], rows[3]);
+		}
+	}
+
+	bool HasAvx2()
+	{
+		// CF_AVX is only set when the OS saves the YMM registers
+		static bool const has_avx2 = [] {
+			CpuInfo const cpu_info;
+			return cpu_info.IsFeatureSupport(CpuInfo::CF_AVX) && cpu_info.IsFeatureSupport(CpuInfo::CF_AVX2);
+		}();
+		return has_avx2;
+	}
+#endif
+}
+
+namespace KlayGE
+{
+	namespace SIMDMathLib
+	{
+		void TransformVector4(std::span<SIMDVectorF4> out, std::span<SIMDVectorF4 const> vs, SIMDMatrixF4 const & mat)
+		{
+			BOOST_ASSERT(out.size() == vs.size());
+
+#if defined(SIMD_MATH_SSE)
+			if (HasAvx2())
+			{
+				TransformVector4Avx2(out, vs, mat);
+				return;
+			}
+#endif
+
+			for (size_t i = 0; i < vs.size(); ++ i)
+			{
+				out[i] = TransformVector4(vs[i], mat);
+			}
+		}
+
+		void Multiply(std::span<SIMDMatrixF4> out, std::span<SIMDMatrixF4 const> lhs, std::span<SIMDMatrixF4 const> rhs)
+		{
+			BOOST_ASSERT((out.size() == lhs.size()) && (lhs.size() == rhs.size()));
+
+#if defined(SIMD_MATH_SSE)
+			if (HasAvx2())
+			{
+				MultiplyAvx2(out, lhs, rhs);
+				return;
+			}
+#endif
+
+			for (size_t i = 0; i < lhs.size(); ++ i)
+			{
+				out[i] = Multiply(lhs[i], rhs[i]);
+			}
+		}
+	}
+}
@@ -86,15 +86,6 @@ namespace KlayGE
 		return this->operator*=(1.0f / rhs);
 	}
 
-	SIMDVectorF4& SIMDVectorF4::operator=(SIMDVectorF4 const & rhs)
-	{
-		if (this != &rhs)
-		{
-			vec_ = rhs.vec_;
-		}
-		return *this;
-	}
-
 	SIMDVectorF4 const SIMDVectorF4::operator-() const
 	{
 		return SIMDMathLib::Negative(*this);
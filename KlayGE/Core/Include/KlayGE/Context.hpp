@@ -174,6 +174,11 @@ namespace KlayGE
 		{
 			return *gtp_instance_;
 		}
+		// Shared by the fine grained parallel work, such as culling, skinning and particles
+		TaskScheduler& TaskSchedulerInstance()
+		{
+			return *task_scheduler_;
+		}
 
 	private:
 		void DestroyAll();
@@ -216,6 +221,7 @@ namespace KlayGE
 #endif
 
 		std::unique_ptr<ThreadPool> gtp_instance_;
+		std::unique_ptr<TaskScheduler> task_scheduler_;
 	};
 }
 
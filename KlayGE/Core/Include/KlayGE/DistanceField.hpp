@@ -39,12 +39,21 @@
 
 namespace KlayGE
 {
+	enum class DistanceFieldAlgorithm
+	{
+		// Propagates the distances to the anti-aliased edges until nothing changes
+		AAEuclidean,
+		// Finds the nearest edge pixels by an exact linear time Euclidean distance transform, then adds the sub-pixel distances
+		// to the edges. Much faster, and differs from AAEuclidean by a fraction of a pixel.
+		ExactEuclidean
+	};
+
 	template <typename T>
 	KLAYGE_CORE_API void Downsample2x(std::vector<T> const & input_data, uint32_t input_width, uint32_t input_height,
 		std::vector<T>& output_data);
 
 	KLAYGE_CORE_API void ComputeDistance(std::vector<float> const & aa_2x_data, uint32_t input_width, uint32_t input_height,
-		std::vector<float>& dist_data);
+		std::vector<float>& dist_data, DistanceFieldAlgorithm algorithm = DistanceFieldAlgorithm::AAEuclidean);
 }
 
 #endif		// _KLAYGE_DISTANCE_FIELD_HPP
@@ -84,6 +84,11 @@ namespace KlayGE
 			std::wstring_view text, float font_size, uint32_t align);
 		void RenderText(float4x4 const & mvp, Color const & clr, std::wstring_view text, float font_size);
 
+		// Chars looked up in the texture, counted over all the Fonts sharing the font file
+		uint64_t NumCacheHits() const;
+		uint64_t NumCacheMisses() const;
+		uint64_t NumCacheEvictions() const;
+
 	private:
 		std::shared_ptr<FontRenderable> font_renderable_;
 		uint32_t fsn_attrib_;
@@ -30,7 +30,9 @@
 #include <KlayGE/PreDeclare.hpp>
 #include <KlayGE/Renderable.hpp>
 #include <KlayGE/RenderLayout.hpp>
+#include <KFL/CXX20/span.hpp>
 #include <KFL/Math.hpp>
+#include <KFL/SIMDMath.hpp>
 #include <KlayGE/SceneNode.hpp>
 #include <KlayGE/SceneComponent.hpp>
 
@@ -304,6 +306,60 @@ namespace KlayGE
 		AABBox Frame(float frame) const;
 	};
 
+	// Key frames of all joints in a compact form, one track per joint. Rotations keep their 3 smallest components
+	// in 15 bits each, translations and scales are 16 bits over the range of their track. Channels that never change
+	// are stored once, and keys that can be interpolated from their neighbors are dropped.
+	struct KLAYGE_CORE_API AnimationClip
+	{
+		enum TrackFlag
+		{
+			TF_ConstantRotation = 1UL << 0,
+			TF_ConstantTranslation = 1UL << 1,
+			TF_ConstantScale = 1UL << 2
+		};
+
+		struct Track
+		{
+			uint32_t flags;
+			uint32_t num_keys;
+
+			// Offsets into the arrays of the clip
+			uint32_t first_key;
+			uint32_t first_rotation;
+			uint32_t first_translation;
+			uint32_t first_scale;
+
+			float3 translation_min;
+			float3 translation_step;
+			float scale_min;
+			float scale_step;
+		};
+
+		std::vector<Track> tracks;
+		std::vector<uint32_t> frame_id;
+		std::vector<uint16_t> rotations;
+		std::vector<uint16_t> translations;
+		std::vector<uint16_t> scales;
+
+		AnimationClip();
+		// tolerance is the largest error allowed at the source keys, in radians for rotations, and in model units for
+		// translations and scales. 0 keeps every key that isn't redundant after quantization.
+		AnimationClip(std::span<KeyFrameSet const> kfs, float tolerance);
+
+		// Rebuilds the offsets after the tracks are filled in
+		void UpdateOffsets();
+
+		KeyFrameSet Decompress(uint32_t joint) const;
+		void DecodeKey(uint32_t joint, uint32_t key, Quaternion& real, Quaternion& dual, float& scale) const;
+
+		// Finds the keys around frame, key0 <= frame < key1. cursor is the key found by the last call, so sequential
+		// playback gets there in a step or two instead of searching.
+		void LocateKeys(uint32_t joint, float frame, uint32_t& cursor, uint32_t& key0, uint32_t& key1, float& factor) const;
+		std::tuple<Quaternion, Quaternion, float> Frame(uint32_t joint, float frame, uint32_t& cursor) const;
+
+		size_t CompressedSize() const;
+	};
+
 	struct KLAYGE_CORE_API Animation
 	{
 		std::string name;
@@ -342,15 +398,17 @@ namespace KlayGE
 		void AssignJoints(ForwardIterator first, ForwardIterator last)
 		{
 			joints_.assign(first, last);
+			flat_joints_.clear();
 			this->UpdateBinds();
 		}
-		void AttachKeyFrameSets(std::shared_ptr<std::vector<KeyFrameSet>> const & kf)
-		{
-			key_frame_sets_ = kf;
-		}
-		std::shared_ptr<std::vector<KeyFrameSet>> const & GetKeyFrameSets() const
+		// Compresses the key frames into a clip without dropping keys that matter
+		void AttachKeyFrameSets(std::shared_ptr<std::vector<KeyFrameSet>> const & kf);
+		// Decompressed from the clip on the first call if only the clip is attached
+		std::shared_ptr<std::vector<KeyFrameSet>> const & GetKeyFrameSets() const;
+		void AttachAnimationClip(std::shared_ptr<AnimationClip const> const & clip);
+		std::shared_ptr<AnimationClip const> const & GetAnimationClip() const
 		{
-			return key_frame_sets_;
+			return animation_clip_;
 		}
 		uint32_t NumFrames() const
 		{
@@ -371,6 +429,8 @@ namespace KlayGE
 
 		float GetFrame() const;
 		void SetFrame(float frame);
+		// Same as calling SetFrame on each model, but the skeletons are evaluated on the thread pool
+		static void SetFrames(std::span<SkinnedModel* const> models, std::span<float const> frames);
 
 		void RebindJoints();
 		void UnbindJoints();
@@ -387,15 +447,40 @@ namespace KlayGE
 
 	protected:
 		void BuildBones(float frame);
+		void EvaluateBones(float frame);
+		void BuildFlatJoints();
 		void UpdateBinds();
 		void SetToEffect();
 
 	protected:
+		// A joint in evaluation order. Parents precede their children, so a whole skeleton is evaluated in one pass
+		// without going through the scene graph.
+		struct FlatJoint
+		{
+			SIMDVectorF4 bind_real;
+			SIMDVectorF4 bind_dual;
+			float bind_scale;
+
+			uint32_t joint_index;
+			int32_t parent;
+			uint32_t key_frame_cursor;
+
+			// The decoded keys around the cursor, kept until the cursor moves to the next key
+			uint32_t cached_key;
+			float key_scales[2];
+			SIMDVectorF4 key_reals[2];
+			SIMDVectorF4 key_duals[2];
+		};
+
 		std::vector<JointComponentPtr> joints_;
 		std::vector<float4> bind_reals_;
 		std::vector<float4> bind_duals_;
 
-		std::shared_ptr<std::vector<KeyFrameSet>> key_frame_sets_;
+		// Resolved from the scene graph on the first evaluation
+		std::vector<FlatJoint> flat_joints_;
+
+		std::shared_ptr<AnimationClip const> animation_clip_;
+		mutable std::shared_ptr<std::vector<KeyFrameSet>> key_frame_sets_;
 		float last_frame_;
 
 		uint32_t num_frames_;
@@ -34,9 +34,11 @@
 #pragma once
 
 #include <KlayGE/PreDeclare.hpp>
+#include <KFL/CXX20/span.hpp>
 #include <KFL/Math.hpp>
 #include <KlayGE/SceneNode.hpp>
 
+#include <array>
 #include <mutex>
 #include <random>
 #include <vector>
@@ -55,6 +57,23 @@ namespace KlayGE
 		float init_life;
 	};
 
+	// A contiguous range of particles, every attribute is in its own array
+	struct ParticleBatch
+	{
+		std::span<float3> pos;
+		std::span<float3> vel;
+		std::span<float> life;
+		std::span<float> spin;
+		std::span<float> size;
+		std::span<float> alpha;
+		std::span<float const> init_life;
+
+		uint32_t NumParticles() const
+		{
+			return static_cast<uint32_t>(life.size());
+		}
+	};
+
 	class KLAYGE_CORE_API ParticleEmitter : boost::noncopyable
 	{
 	public:
@@ -211,7 +230,8 @@ namespace KlayGE
 		virtual std::string const & Type() const = 0;
 		virtual ParticleUpdaterPtr Clone() = 0;
 
-		virtual void Update(Particle& par, float elapse_time) = 0;
+		// Disjoint batches are updated concurrently, the updater's own states can only be read here
+		virtual void Update(ParticleBatch const & batch, float elapse_time) = 0;
 		virtual void SnapParams() = 0;
 
 	protected:
@@ -289,20 +309,11 @@ namespace KlayGE
 
 		uint32_t NumParticles() const
 		{
-			return static_cast<uint32_t>(particles_.size());
+			return static_cast<uint32_t>(particles_.life.size());
 		}
 		uint32_t NumActiveParticles() const;
 		uint32_t GetActiveParticleIndex(uint32_t i) const;
-		Particle const & GetParticle(uint32_t i) const
-		{
-			BOOST_ASSERT(i < particles_.size());
-			return particles_[i];
-		}
-		Particle& GetParticle(uint32_t i)
-		{
-			BOOST_ASSERT(i < particles_.size());
-			return particles_[i];
-		}
+		Particle GetParticle(uint32_t i) const;
 		void ClearParticles();
 
 		void ParticleAlphaFromTex(std::string const & tex_name);
@@ -328,9 +339,29 @@ namespace KlayGE
 
 		void SceneDepthTexture(TexturePtr const & depth_tex);
 
+	private:
+		// Structure of arrays, the alive particles are packed at the beginning
+		struct ParticleArrays
+		{
+			std::vector<float3> pos;
+			std::vector<float3> vel;
+			std::vector<float> life;
+			std::vector<float> spin;
+			std::vector<float> size;
+			std::vector<float> alpha;
+			std::vector<float> init_life;
+
+			void Resize(uint32_t num_particles);
+			ParticleBatch Batch(uint32_t begin, uint32_t end);
+			Particle Load(uint32_t index) const;
+			void Store(uint32_t index, Particle const & par);
+			void Move(uint32_t from, uint32_t to);
+		};
+
 	private:
 		void UpdateParticlesNoLock(float elapsed_time);
 		void UpdateParticleBufferNoLock();
+		uint32_t RemoveDeadParticles(uint32_t begin, uint32_t end);
 
 	private:
 		SceneNodePtr root_node_;
@@ -339,8 +370,11 @@ namespace KlayGE
 		std::vector<ParticleEmitterPtr> emitters_;
 		std::vector<ParticleUpdaterPtr> updaters_;
 
-		std::vector<Particle> particles_;
-		std::vector<std::pair<uint32_t, float>> actived_particles_;
+		ParticleArrays particles_;
+		uint32_t num_actived_particles_ = 0;
+		// Back to front order of the actived particles, as (depth key, index)
+		std::vector<std::pair<uint32_t, uint32_t>> sorted_particles_;
+		std::vector<std::pair<uint32_t, uint32_t>> sorted_particles_tmp_;
 		mutable std::mutex actived_particles_mutex_;
 
 		float gravity_;
@@ -417,19 +451,22 @@ namespace KlayGE
 			return opacity_over_life_;
 		}
 
-		void Update(Particle& par, float elapse_time) override;
+		void Update(ParticleBatch const & batch, float elapse_time) override;
 		void SnapParams() override;
 
 	private:
+		// The polylines are sampled uniformly over the life when the params are snapped
+		static uint32_t constexpr LIFE_TABLE_SIZE = 256;
+
 		std::mutex update_mutex_;
 
 		std::vector<float2> size_over_life_;
 		std::vector<float2> mass_over_life_;
 		std::vector<float2> opacity_over_life_;
 
-		std::vector<float2> this_frame_size_over_life_;
-		std::vector<float2> this_frame_mass_over_life_;
-		std::vector<float2> this_frame_opacity_over_life_;
+		std::array<float, LIFE_TABLE_SIZE + 1> this_frame_size_table_;
+		std::array<float, LIFE_TABLE_SIZE + 1> this_frame_mass_table_;
+		std::array<float, LIFE_TABLE_SIZE + 1> this_frame_opacity_table_;
 	};
 }
 
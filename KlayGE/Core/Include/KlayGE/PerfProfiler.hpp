@@ -37,9 +37,14 @@
 
 #include <KFL/Timer.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <tuple>
+#include <vector>
 
 namespace KlayGE
 {
@@ -67,6 +72,8 @@ namespace KlayGE
 		}
 
 	private:
+		std::string name_;
+
 		Timer cpu_timer_;
 		QueryPtr gpu_timer_query_;
 
@@ -74,11 +81,16 @@ namespace KlayGE
 		double gpu_time_ = 0;
 
 		bool dirty_ = false;
+		bool zone_begun_ = false;
+
+		friend class PerfProfiler;
 	};
 
 	class KLAYGE_CORE_API PerfProfiler final : boost::noncopyable
 	{
 	public:
+		PerfProfiler();
+
 		static PerfProfiler& Instance();
 		static void Destroy();
 
@@ -90,8 +102,57 @@ namespace KlayGE
 
 		void ExportToCSV(std::string const& file_name) const;
 
+		// Timeline capture. Zones, frame markers and counters are recorded into a ring buffer per thread without locks, and
+		// only while capturing. Names are kept as pointers, so they have to outlive the export. String literals usually are.
+		static bool Capturing() noexcept
+		{
+			return capturing_.load(std::memory_order_relaxed);
+		}
+		void StartCapture();
+		void StopCapture();
+
+		void ThreadName(std::string const& name);
+		// Recorded unconditionally, so check Capturing before BeginZone and always pair it. PerfZone does both.
+		void BeginZone(char const* name);
+		void EndZone();
+		void FrameMarker();
+		void Counter(char const* name, double value);
+
+		// Chrome trace event format, which can be opened in chrome://tracing or Perfetto. Call it after StopCapture.
+		void ExportToChromeTrace(std::string const& file_name) const;
+
+	private:
+		enum class EventType : uint8_t
+		{
+			BeginZone,
+			EndZone,
+			FrameMarker,
+			Counter
+		};
+
+		struct Event
+		{
+			int64_t time;
+			char const* name;
+			double value;
+			EventType type;
+		};
+
+		// Only written by its thread. Others read it after the capture has stopped.
+		struct ThreadTimeline
+		{
+			std::string name;
+			uint32_t thread_index;
+			std::unique_ptr<Event[]> events;
+			std::atomic<uint64_t> num_events{0};
+		};
+
+		ThreadTimeline& CurrentThreadTimeline();
+		void Record(EventType type, char const* name, double value);
+
 	private:
 		static std::unique_ptr<PerfProfiler> perf_profiler_instance_;
+		static std::atomic<bool> capturing_;
 
 		struct FramePerfInfo
 		{
@@ -110,7 +171,46 @@ namespace KlayGE
 
 		std::vector<PerfInfo> perf_regions_;
 		uint32_t frame_id_ = 0;
+
+		uint64_t const instance_id_;
+		std::chrono::steady_clock::time_point const start_time_ = std::chrono::steady_clock::now();
+		int64_t capture_start_time_ = 0;
+		uint32_t capture_frame_id_ = 0;
+
+		mutable std::mutex timelines_mutex_;
+		std::vector<std::unique_ptr<ThreadTimeline>> timelines_;
+	};
+
+	// Records a zone on the timeline of the current thread from here to the end of the scope. When nothing is being captured,
+	// it costs a load and a branch.
+	class PerfZone final : boost::noncopyable
+	{
+	public:
+		explicit PerfZone(char const* name)
+			: begun_(PerfProfiler::Capturing())
+		{
+			if (begun_)
+			{
+				PerfProfiler::Instance().BeginZone(name);
+			}
+		}
+		~PerfZone()
+		{
+			if (begun_)
+			{
+				PerfProfiler::Instance().EndZone();
+			}
+		}
+
+	private:
+		bool const begun_;
 	};
 } // namespace KlayGE
 
+#ifndef KLAYGE_SHIP
+#define KLAYGE_PERF_ZONE(name) KlayGE::PerfZone KFL_JOIN(perf_zone_, __LINE__)(name)
+#else
+#define KLAYGE_PERF_ZONE(name)
+#endif
+
 #endif // KLAYGE_CORE_PERF_PROFILER_HPP
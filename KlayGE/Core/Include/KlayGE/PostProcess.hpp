@@ -32,6 +32,7 @@
 #include <KlayGE/RenderFactory.hpp>
 #include <KlayGE/FrameBuffer.hpp>
 #include <KlayGE/RenderableHelper.hpp>
+#include <KlayGE/RenderEffect.hpp>
 #include <KlayGE/RenderView.hpp>
 
 #include <string_view>
@@ -191,6 +192,14 @@ namespace KlayGE
 
 		RenderEffectParameter* width_height_ep_;
 		RenderEffectParameter* inv_width_height_ep_;
+
+		// Resolved once per effect, so rebinding after a technique change doesn't search by name
+		std::vector<RenderEffectParameterHandle> input_pin_handles_;
+		std::vector<RenderEffectParameterHandle> output_pin_handles_;
+		std::vector<RenderEffectParameterHandle> param_handles_;
+		RenderEffectParameterHandle pp_mvp_handle_{CT_HASH("pp_mvp")};
+		RenderEffectParameterHandle width_height_handle_{CT_HASH("width_height")};
+		RenderEffectParameterHandle inv_width_height_handle_{CT_HASH("inv_width_height")};
 	};
 
 	KLAYGE_CORE_API PostProcessPtr SyncLoadPostProcess(std::string_view ppml_name, std::string_view pp_name);
@@ -111,6 +111,8 @@ namespace KlayGE
 		bool pack_to_rgba_required : 1;
 		bool draw_indirect_support : 1;
 		bool no_overwrite_support : 1;
+		bool constant_buffer_partial_update_support : 1;
+		bool constant_buffer_offset_support : 1;
 		bool full_npot_texture_support : 1;
 		bool render_to_texture_array_support : 1;
 		bool explicit_multi_sample_support : 1;
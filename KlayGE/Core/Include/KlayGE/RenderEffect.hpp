@@ -56,10 +56,13 @@
 
 #include <KlayGE/PreDeclare.hpp>
 #include <KFL/CXX20/span.hpp>
+#include <KFL/Hash.hpp>
 
+#include <atomic>
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <limits>
 
 #include <KlayGE/RenderEngine.hpp>
 #include <KlayGE/Texture.hpp>
@@ -446,6 +449,44 @@ namespace KlayGE
 		std::vector<StrcutMemberType> members_;
 	};
 
+	// A parameter or technique name hashed at compile time, such as RenderEffectParameterHandle(CT_HASH("color")). It keeps
+	// the index it was resolved to in the last effect it was used with, so using it again on that effect, or on any clone of
+	// it, doesn't search at all.
+	template <typename T>
+	class RenderEffectHandle final
+	{
+		friend class RenderEffect;
+
+	public:
+		constexpr explicit RenderEffectHandle(size_t name_hash) noexcept : name_hash_(name_hash)
+		{
+		}
+
+		RenderEffectHandle(RenderEffectHandle const& rhs) noexcept
+			: name_hash_(rhs.name_hash_), resolved_(rhs.resolved_.load(std::memory_order_relaxed))
+		{
+		}
+		RenderEffectHandle& operator=(RenderEffectHandle const& rhs) noexcept
+		{
+			name_hash_ = rhs.name_hash_;
+			resolved_.store(rhs.resolved_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			return *this;
+		}
+
+		size_t NameHash() const noexcept
+		{
+			return name_hash_;
+		}
+
+	private:
+		size_t name_hash_;
+		// The layout id of the effect in the high 32 bits, and the index in the low 32 bits. 0 means not resolved yet.
+		mutable std::atomic<uint64_t> resolved_{0};
+	};
+
+	using RenderEffectParameterHandle = RenderEffectHandle<RenderEffectParameter>;
+	using RenderTechniqueHandle = RenderEffectHandle<RenderTechnique>;
+
 	// ȾЧ
 	//////////////////////////////////////////////////////////////////////////////////
 	class KLAYGE_CORE_API RenderEffect final : boost::noncopyable
@@ -482,6 +523,8 @@ namespace KlayGE
 		RenderEffectParameter const* ParameterByName(std::string_view name) const noexcept;
 		RenderEffectParameter* ParameterByIndex(uint32_t n) noexcept;
 		RenderEffectParameter const* ParameterByIndex(uint32_t n) const noexcept;
+		RenderEffectParameter* ParameterByHandle(RenderEffectParameterHandle const& handle) noexcept;
+		RenderEffectParameter const* ParameterByHandle(RenderEffectParameterHandle const& handle) const noexcept;
 
 		uint32_t NumCBuffers() const noexcept
 		{
@@ -507,6 +550,7 @@ namespace KlayGE
 		}
 		RenderTechnique* TechniqueByName(std::string_view name) const noexcept;
 		RenderTechnique* TechniqueByIndex(uint32_t n) const noexcept;
+		RenderTechnique* TechniqueByHandle(RenderTechniqueHandle const& handle) const noexcept;
 
 		uint32_t NumShaderFragments() const noexcept
 		{
@@ -553,6 +597,12 @@ namespace KlayGE
 		void Load(XMLNode const& root);
 #endif
 
+		void BuildNameIndices();
+		uint32_t FindParameter(size_t name_hash) const noexcept;
+		uint32_t FindTechnique(size_t name_hash) const noexcept;
+		template <typename T>
+		uint32_t ResolveHandle(RenderEffectHandle<T> const& handle) const noexcept;
+
 	private:
 		struct Immutable final : boost::noncopyable
 		{
@@ -578,6 +628,13 @@ namespace KlayGE
 			std::vector<ShaderDesc> shader_descs;
 
 			std::vector<RenderShaderGraphNode> shader_graph_nodes;
+
+			// (name hash, index) of parameters and techniques, sorted by hash. layout_id is new every time they are built, so
+			// handles resolved against an older layout are resolved again. 0 means not built yet. It's stored with release after
+			// the indices are built, and loaded with acquire before they are read, since an effect can be looked up while it loads.
+			std::vector<std::pair<size_t, uint32_t>> param_name_index;
+			std::vector<std::pair<size_t, uint32_t>> tech_name_index;
+			std::atomic<uint32_t> layout_id{0};
 		};
 
 		std::shared_ptr<Immutable> immutable_;
@@ -810,13 +867,37 @@ namespace KlayGE
 			return r2t.t;
 		}
 
+		// Marks the whole buffer, or nothing, to be uploaded
 		void Dirty(bool dirty) noexcept
 		{
-			dirty_ = dirty;
+			if (dirty)
+			{
+				dirty_begin_ = 0;
+				dirty_end_ = std::numeric_limits<uint32_t>::max();
+			}
+			else
+			{
+				dirty_begin_ = std::numeric_limits<uint32_t>::max();
+				dirty_end_ = 0;
+			}
+		}
+		// Adds [offset, offset + size) to the range to be uploaded
+		void Dirty(uint32_t offset, uint32_t size) noexcept
+		{
+			dirty_begin_ = std::min(dirty_begin_, offset);
+			dirty_end_ = std::max(dirty_end_, offset + size);
 		}
 		bool Dirty() const noexcept
 		{
-			return dirty_;
+			return dirty_begin_ < dirty_end_;
+		}
+
+		// A transient cbuffer is written to the per-frame constant ring of the render engine, where the device can bind constant
+		// buffers at offsets, instead of to its own buffer
+		void Transient(bool transient);
+		bool Transient() const noexcept
+		{
+			return transient_;
 		}
 
 		void Update();
@@ -824,10 +905,15 @@ namespace KlayGE
 		{
 			return hw_buff_;
 		}
+		uint32_t HWBuffOffset() const noexcept
+		{
+			return hw_buff_offset_;
+		}
 		void BindHWBuff(GraphicsBufferPtr const & buff);
 
 	private:
 		void RebindParameters(RenderEffectConstantBuffer& dst_cbuffer, RenderEffect& dst_effect);
+		bool InConstantRing() const noexcept;
 
 	private:
 		RenderEffect& effect_;
@@ -842,8 +928,13 @@ namespace KlayGE
 		std::shared_ptr<std::vector<uint32_t>> param_indices_;
 
 		GraphicsBufferPtr hw_buff_;
+		uint32_t hw_buff_offset_ = 0;
 		std::vector<uint8_t> buff_;
-		bool dirty_ = true;
+		uint32_t dirty_begin_ = 0;
+		uint32_t dirty_end_ = std::numeric_limits<uint32_t>::max();
+
+		bool transient_ = false;
+		uint32_t ring_frame_ = std::numeric_limits<uint32_t>::max();
 	};
 
 	class KLAYGE_CORE_API RenderEffectParameter final
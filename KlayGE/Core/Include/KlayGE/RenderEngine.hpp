@@ -113,6 +113,20 @@ namespace KlayGE
 		uint32_t NumVerticesJustRendered();
 		uint32_t NumDrawsJustCalled();
 		uint32_t NumDispatchesJustCalled();
+		uint32_t NumConstantBytesJustUploaded();
+		void AddConstantBytesUploaded(uint32_t bytes) noexcept
+		{
+			num_constant_bytes_just_uploaded_ += bytes;
+		}
+
+		// Copies constants to the per-frame ring and returns their offset in TransientConstantBuffer(). They stay valid until the
+		// end of the frame.
+		uint32_t AllocTransientConstants(void const * data, uint32_t size);
+		GraphicsBufferPtr const & TransientConstantBuffer() const;
+		uint32_t NumFramesEnded() const noexcept
+		{
+			return num_frames_ended_;
+		}
 
 		void CreateRenderWindow(std::string const & name, RenderSettings& settings);
 		void DestroyRenderWindow();
@@ -477,6 +491,10 @@ namespace KlayGE
 		uint32_t num_vertices_just_rendered_;
 		uint32_t num_draws_just_called_;
 		uint32_t num_dispatches_just_called_;
+		uint32_t num_constant_bytes_just_uploaded_;
+		uint32_t num_frames_ended_ = 0;
+
+		std::unique_ptr<TransientBuffer> transient_cbuffer_;
 
 		RenderDeviceCaps caps_;
 
@@ -174,6 +174,9 @@ namespace KlayGE
 		{
 			return active_lod_;
 		}
+		// How far a LoD is from LoD 0, in model units. When known, automatic LoDs are picked by their error on screen.
+		void LodError(uint32_t lod, float error);
+		float LodError(uint32_t lod) const;
 		virtual RenderLayout& GetRenderLayout() const;
 		virtual RenderLayout& GetRenderLayout(uint32_t lod) const;
 		virtual std::wstring const & Name() const;
@@ -293,6 +296,7 @@ namespace KlayGE
 		virtual void UpdateBoundBox();
 
 		float CalcLod(float3 const & eye_pos, float fov_scale) const;
+		int32_t SelectLod(Camera const & camera, uint32_t viewport_height) const;
 
 		// For deferred only
 		void BindDeferredEffect(RenderEffectPtr const & deferred_effect);
@@ -312,6 +316,7 @@ namespace KlayGE
 		RenderTechnique* technique_ = nullptr;
 
 		std::vector<RenderLayoutPtr> rls_;
+		std::vector<float> lod_errors_;
 
 		int32_t active_lod_ = 0;
 
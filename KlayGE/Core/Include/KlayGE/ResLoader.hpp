@@ -34,8 +34,11 @@
 #pragma once
 
 #include <KlayGE/PreDeclare.hpp>
+#include <array>
+#include <atomic>
 #include <istream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <KFL/ResIdentifier.hpp>
@@ -66,6 +69,8 @@ namespace KlayGE
 		virtual bool HasSubThreadStage() const = 0;
 
 		virtual bool Match(ResLoadingDesc const & rhs) const = 0;
+		// Content key of the desc. Two descs that Match must have the same hash.
+		virtual uint64_t Hash() const = 0;
 		virtual void CopyDataFrom(ResLoadingDesc const & rhs) = 0;
 		virtual std::shared_ptr<void> CloneResourceFrom(std::shared_ptr<void> const & resource) = 0;
 
@@ -101,7 +106,9 @@ namespace KlayGE
 		std::string AbsPath(std::string_view path);
 
 		std::shared_ptr<void> SyncQuery(ResLoadingDescPtr const & res_desc);
-		std::shared_ptr<void> ASyncQuery(ResLoadingDescPtr const & res_desc);
+		// Requests with higher priority get their SubThreadStage and MainThreadStage earlier.
+		// A request is canceled if the returned resource is released before its loading starts.
+		std::shared_ptr<void> ASyncQuery(ResLoadingDescPtr const & res_desc, float priority = 0);
 		void Unload(std::shared_ptr<void> const & res);
 
 		template <typename T>
@@ -111,9 +118,9 @@ namespace KlayGE
 		}
 
 		template <typename T>
-		std::shared_ptr<T> ASyncQueryT(ResLoadingDescPtr const & res_desc)
+		std::shared_ptr<T> ASyncQueryT(ResLoadingDescPtr const & res_desc, float priority = 0)
 		{
-			return std::static_pointer_cast<T>(this->ASyncQuery(res_desc));
+			return std::static_pointer_cast<T>(this->ASyncQuery(res_desc, priority));
 		}
 
 		template <typename T>
@@ -124,9 +131,25 @@ namespace KlayGE
 
 		void Update();
 
+		uint32_t NumLoadingThreads() const
+		{
+			return static_cast<uint32_t>(loading_threads_.size());
+		}
+		void NumLoadingThreads(uint32_t num);
+
+		// Time in seconds that Update can spend on MainThreadStage per frame. 0 means unlimited.
+		float MainThreadStageBudget() const
+		{
+			return main_thread_stage_budget_;
+		}
+		void MainThreadStageBudget(float budget)
+		{
+			main_thread_stage_budget_ = budget;
+		}
+
 		uint32_t NumLoadingResources() const
 		{
-			return static_cast<uint32_t>(loading_res_.size());
+			return num_loading_res_;
 		}
 
 	private:
@@ -136,10 +159,14 @@ namespace KlayGE
 		void DecomposePackageName(std::string_view path,
 			std::string& package_path, std::string& password, std::string& path_in_package);
 
-		void AddLoadedResource(ResLoadingDescPtr const & res_desc, std::shared_ptr<void> const & res);
-		std::shared_ptr<void> FindMatchLoadedResource(ResLoadingDescPtr const & res_desc);
+		void AddLoadedResource(ResLoadingDescPtr const & res_desc, uint64_t hash, std::shared_ptr<void> const & res);
+		std::shared_ptr<void> FindMatchLoadedResource(ResLoadingDescPtr const & res_desc, uint64_t hash);
 		void RemoveUnrefResources();
 
+		static uint32_t ShardIndex(uint64_t hash) noexcept;
+
+		void StartLoadingThreads(uint32_t num);
+		void StopLoadingThreads();
 		void LoadingThreadFunc();
 
 #if defined(KLAYGE_PLATFORM_ANDROID)
@@ -156,27 +183,70 @@ namespace KlayGE
 		enum LoadingStatus
 		{
 			LS_Loading,
+			LS_Processing,
 			LS_Complete,
+			LS_Canceled,
 			LS_CanBeRemoved
 		};
 
+		// Shared by all requests that join the same loading
+		struct LoadingState
+		{
+			std::atomic<LoadingStatus> status{LS_Loading};
+			float priority;
+			uint64_t hash;
+
+			// The desc that SubThreadStage runs on, whichever heap entry gets to it first
+			ResLoadingDescPtr res_desc;
+
+			// Used to detect that nobody references the resource any more. Not tracked if the desc doesn't create a resource upfront.
+			std::weak_ptr<void> res;
+			long internal_refs = -1;
+		};
+
+		struct LoadingRequest
+		{
+			float priority;
+			uint64_t seq;
+			ResLoadingDescPtr res_desc;
+			std::shared_ptr<LoadingState> state;
+
+			bool operator<(LoadingRequest const & rhs) const noexcept
+			{
+				// Max heap on priority, FIFO among the same priority
+				return (priority < rhs.priority) || ((priority == rhs.priority) && (seq > rhs.seq));
+			}
+		};
+
 		std::string exe_path_;
 		std::string local_path_;
 		std::vector<std::tuple<uint64_t, uint32_t, std::string, PackagePtr>> paths_;
 		std::mutex paths_mutex_;
 
-		std::mutex loaded_mutex_;
-		std::mutex loading_mutex_;
-		std::vector<std::pair<ResLoadingDescPtr, std::weak_ptr<void>>> loaded_res_;
-		std::vector<std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>>> loading_res_;
+		// Loaded and in-flight resources are indexed by ResLoadingDesc::Hash, and split into shards with their own locks
+		static uint32_t constexpr NUM_RES_INDEX_SHARDS = 16;
+
+		template <typename T>
+		struct ResIndexShard
+		{
+			std::mutex mutex;
+			std::unordered_multimap<uint64_t, std::pair<ResLoadingDescPtr, T>> entries;
+		};
+
+		std::array<ResIndexShard<std::weak_ptr<void>>, NUM_RES_INDEX_SHARDS> loaded_res_;
+		std::array<ResIndexShard<std::shared_ptr<LoadingState>>, NUM_RES_INDEX_SHARDS> loading_res_;
+		std::atomic<uint32_t> num_loading_res_{0};
+		std::atomic<uint32_t> unref_sweep_shard_{0};
 
-		bool non_empty_loading_res_queue_ = false;
 		std::condition_variable loading_res_queue_cv_;
 		std::mutex loading_res_queue_mutex_;
-		std::vector<std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>>> loading_res_queue_;
+		std::vector<LoadingRequest> loading_res_queue_; // Binary heap
+		uint64_t loading_res_seq_ = 0;
+
+		std::vector<std::future<void>> loading_threads_;
+		bool quit_ = false;
 
-		std::future<void> loading_thread_;
-		volatile bool quit_{false};
+		float main_thread_stage_budget_ = 0.004f;
 	};
 }
 
@@ -25,6 +25,7 @@
 
 #include <KlayGE/SceneNode.hpp>
 #include <KlayGE/Renderable.hpp>
+#include <KFL/CXX20/span.hpp>
 #include <KFL/Frustum.hpp>
 #include <KFL/Thread.hpp>
 
@@ -36,6 +37,10 @@ namespace KlayGE
 {
 	class KLAYGE_CORE_API SceneManager : boost::noncopyable
 	{
+	public:
+		// Visibility of the scene nodes to a camera. Bit i is for the i-th node of CullNodes().
+		using VisibilityBitset = std::vector<uint64_t>;
+
 	public:
 		SceneManager();
 		virtual ~SceneManager();
@@ -87,6 +92,17 @@ namespace KlayGE
 
 		virtual void ClearObject();
 
+		// Culls the scene against the cameras concurrently, one job per camera on the thread pool. The results go to the bitsets
+		// instead of the visible marks of the nodes, so it can be done outside the passes. Not to be called during a flush.
+		void CullCameras(std::span<Camera const * const> cameras, float small_obj_threshold, std::span<VisibilityBitset> visibilities);
+		std::vector<SceneNode*> const & CullNodes() const
+		{
+			return cull_nodes_;
+		}
+		// Culls the cameras that are going to be rendered in this frame ahead of time. A flush with these cameras later in the frame
+		// uses the results instead of ClipScene.
+		void PrecullCameras(std::span<Camera const * const> cameras, float small_obj_threshold);
+
 		void Update();
 
 		uint32_t NumObjectsRendered() const;
@@ -95,8 +111,13 @@ namespace KlayGE
 		uint32_t NumVerticesRendered() const;
 		uint32_t NumDrawCalls() const;
 		uint32_t NumDispatchCalls() const;
+		uint32_t NumConstantBytesUploaded() const;
+		// Time in seconds spent on building and sorting the render queues in the last frame
+		float RenderQueueBuildTime() const;
 
-		virtual void OnSceneChanged() = 0;
+		// The node and its subtree are attached to or detached from the scene graph
+		virtual void OnNodeAttached(SceneNode& node) = 0;
+		virtual void OnNodeDetached(SceneNode& node) = 0;
 
 		bool NodesUpdated() const
 		{
@@ -113,6 +134,18 @@ namespace KlayGE
 
 		BoundOverlap VisibleTestFromParent(SceneNode const & node, uint32_t camera_index);
 
+		// Called before the culling jobs are started, on the calling thread
+		virtual void PrepareCullCameras();
+		// Tests the nodes' own bounds against one camera, with a spatial structure for example. Bit i of tested is set if the result of
+		// node i is in visibility, the other nodes are tested one by one afterwards. It runs on several threads at the same time.
+		virtual void CullCamera(Camera const & camera, float small_obj_threshold, VisibilityBitset& visibility,
+			VisibilityBitset& tested) const;
+
+	private:
+		void ResolveCullHierarchy(Camera const & camera, float small_obj_threshold, VisibilityBitset& visibility,
+			VisibilityBitset const & tested) const;
+		bool ApplyPrecull(Viewport const & viewport, std::vector<SceneNode*> const & scene_nodes);
+
 	protected:
 		std::vector<CameraPtr> frame_cameras_;
 		std::vector<Frustum const*> camera_frustums_;
@@ -130,13 +163,29 @@ namespace KlayGE
 		std::vector<SceneNode*> all_scene_nodes_;
 		std::vector<SceneNode*> all_overlay_nodes_;
 
+		std::vector<SceneNode*> cull_nodes_;
+		std::vector<int32_t> cull_parents_;
+
 	private:
 		void FlushScene();
+		void SortRenderQueue(Viewport const & viewport);
 
 	private:
+		struct render_item_t
+		{
+			Renderable* renderable;
+			uint32_t technique_id;
+			uint32_t material_id;
+		};
+
 		uint32_t urt_;
 
-		std::vector<std::pair<RenderTechnique const *, std::vector<Renderable*>>> render_queue_;
+		std::vector<render_item_t> render_queue_;
+		std::unordered_map<RenderTechnique const *, uint32_t> render_technique_ids_;
+		std::vector<RenderTechnique const *> render_techniques_;
+		std::unordered_map<RenderMaterial const *, uint32_t> render_material_ids_;
+		std::vector<std::pair<uint64_t, uint32_t>> render_keys_;
+		std::vector<std::pair<uint64_t, uint32_t>> render_keys_tmp_;
 
 		uint32_t num_objects_rendered_;
 		uint32_t num_renderables_rendered_;
@@ -144,6 +193,12 @@ namespace KlayGE
 		uint32_t num_vertices_rendered_;
 		uint32_t num_draw_calls_;
 		uint32_t num_dispatch_calls_;
+		uint32_t num_constant_bytes_uploaded_;
+		float queue_build_time_ = 0;
+		float frame_queue_build_time_ = 0;
+
+		std::unordered_map<Camera const *, VisibilityBitset> precull_visibilities_;
+		float precull_small_obj_threshold_ = 0;
 
 		std::mutex update_mutex_;
 		std::optional<std::future<void>> update_thread_;
@@ -200,7 +200,7 @@ namespace KlayGE
 		void FindAllNode(std::vector<SceneNode*>& nodes, std::wstring_view name);
 
 		void Parent(SceneNode* so);
-		void EmitSceneChanged();
+		SceneManager* OwnerSceneManager() const;
 
 	protected:
 		std::wstring name_;
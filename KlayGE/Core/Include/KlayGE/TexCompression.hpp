@@ -36,11 +36,14 @@
 #include <KlayGE/PreDeclare.hpp>
 
 #include <array>
+#include <functional>
+#include <memory>
 
 namespace KlayGE
 {
 	enum TexCompressionMethod
 	{
+		TCM_Realtime,	// Bounding box fit for runtime transcoding. Only BC1-5 have a dedicated path, others treat it as TCM_Speed
 		TCM_Speed,
 		TCM_Balanced,
 		TCM_Quality
@@ -63,9 +66,23 @@ namespace KlayGE
 	public:
 		virtual ~TexCompression() noexcept;
 
+		// Creates a codec of the same kind. Used to give every worker thread its own codec state.
+		virtual std::unique_ptr<TexCompression> Clone() const = 0;
+
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) = 0;
 		virtual void DecodeBlock(void* output, void const * input) = 0;
 
+		// Number of threads EncodeMem and DecodeMem split the block rows across. 0 means one per hardware thread.
+		// The output is identical to the serial one.
+		uint32_t NumThreads() const
+		{
+			return num_threads_;
+		}
+		void NumThreads(uint32_t num)
+		{
+			num_threads_ = num;
+		}
+
 		virtual void EncodeMem(uint32_t width, uint32_t height, 
 			void* output, uint32_t out_row_pitch, uint32_t out_slice_pitch,
 			void const * input, uint32_t in_row_pitch, uint32_t in_slice_pitch,
@@ -77,8 +94,12 @@ namespace KlayGE
 		virtual void EncodeTex(TexturePtr const & out_tex, TexturePtr const & in_tex, TexCompressionMethod method);
 		virtual void DecodeTex(TexturePtr const & out_tex, TexturePtr const & in_tex);
 
+	protected:
+		void ForEachBlockRow(uint32_t num_block_rows, std::function<void(TexCompression& codec, uint32_t block_row)> const & func);
+
 	protected:
 		ElementFormat compression_format_;
+		uint32_t num_threads_ = 1;
 	};
 
 	class ARGBColor32 final : boost::equality_comparable<ARGBColor32>
@@ -85,6 +85,7 @@ namespace KlayGE
 	public:
 		TexCompressionBC1();
 
+		virtual std::unique_ptr<TexCompression> Clone() const override;
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
 
@@ -96,6 +97,7 @@ namespace KlayGE
 		uint32_t MatchColorsBlock(ARGBColor32 const * argb, ARGBColor32 const & min_clr, ARGBColor32 const & max_clr, bool alpha) const;
 		void OptimizeColorsBlock(ARGBColor32 const * argb, ARGBColor32& min_clr, ARGBColor32& max_clr, TexCompressionMethod method) const;
 		bool RefineBlock(ARGBColor32 const * argb, ARGBColor32& min_clr, ARGBColor32& max_clr, uint32_t mask) const;
+		uint32_t RealtimeColorsBlock(ARGBColor32 const * argb, uint16_t& min16, uint16_t& max16) const;
 	};
 
 	class KLAYGE_CORE_API TexCompressionBC2 final : public TexCompression
@@ -103,6 +105,7 @@ namespace KlayGE
 	public:
 		TexCompressionBC2();
 
+		virtual std::unique_ptr<TexCompression> Clone() const override;
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
 
@@ -115,6 +118,7 @@ namespace KlayGE
 	public:
 		TexCompressionBC4();
 
+		virtual std::unique_ptr<TexCompression> Clone() const override;
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
 	};
@@ -124,6 +128,7 @@ namespace KlayGE
 	public:
 		TexCompressionBC3();
 
+		virtual std::unique_ptr<TexCompression> Clone() const override;
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
 
@@ -137,6 +142,7 @@ namespace KlayGE
 	public:
 		TexCompressionBC5();
 
+		virtual std::unique_ptr<TexCompression> Clone() const override;
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
 
@@ -149,6 +155,7 @@ namespace KlayGE
 	public:
 		TexCompressionBC6U();
 
+		virtual std::unique_ptr<TexCompression> Clone() const override;
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
 
@@ -210,6 +217,7 @@ namespace KlayGE
 	public:
 		TexCompressionBC6S();
 
+		virtual std::unique_ptr<TexCompression> Clone() const override;
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
 
@@ -275,6 +283,7 @@ namespace KlayGE
 	public:
 		TexCompressionBC7();
 
+		virtual std::unique_ptr<TexCompression> Clone() const override;
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
 
@@ -134,6 +134,7 @@ namespace KlayGE
 	public:
 		TexCompressionETC1();
 
+		virtual std::unique_ptr<TexCompression> Clone() const override;
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
 
@@ -211,6 +212,7 @@ namespace KlayGE
 	public:
 		TexCompressionETC2RGB8();
 
+		virtual std::unique_ptr<TexCompression> Clone() const override;
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
 
@@ -227,6 +229,7 @@ namespace KlayGE
 	public:
 		TexCompressionETC2RGB8A1();
 
+		virtual std::unique_ptr<TexCompression> Clone() const override;
 		virtual void EncodeBlock(void* output, void const * input, TexCompressionMethod method) override;
 		virtual void DecodeBlock(void* output, void const * input) override;
 
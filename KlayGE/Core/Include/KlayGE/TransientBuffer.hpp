@@ -74,9 +74,13 @@ namespace KlayGE
 		enum BindFlag
 		{
 			BF_Vertex,
-			BF_Index
+			BF_Index,
+			BF_Constant
 		};
 
+		// Constant buffers are bound at offsets in multiples of this
+		static uint32_t constexpr CONSTANT_ALIGNMENT = 256;
+
 	public:
 		TransientBuffer(uint32_t size_in_byte, BindFlag bind_flag);
 
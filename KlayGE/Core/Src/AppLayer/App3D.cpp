@@ -40,6 +40,7 @@
 #include <KlayGE/UI.hpp>
 #include <KlayGE/SceneManager.hpp>
 #include <KlayGE/DeferredRenderingLayer.hpp>
+#include <KlayGE/PerfProfiler.hpp>
 
 #include <boost/assert.hpp>
 
@@ -527,6 +528,10 @@ namespace KlayGE
 	{
 		RenderEngine& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
 
+#ifndef KLAYGE_SHIP
+		PerfProfiler::Instance().ThreadName("Main");
+#endif
+
 #if defined KLAYGE_PLATFORM_WINDOWS_DESKTOP
 		bool gotMsg;
 		MSG  msg;
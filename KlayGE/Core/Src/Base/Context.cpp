@@ -25,6 +25,7 @@
 #include <KFL/Util.hpp>
 #include <KFL/Math.hpp>
 #include <KFL/Log.hpp>
+#include <KFL/TaskScheduler.hpp>
 #include <KlayGE/DevHelper.hpp>
 #include <KlayGE/SceneManager.hpp>
 #include <KlayGE/RenderFactory.hpp>
@@ -107,6 +108,7 @@ namespace KlayGE
 #endif
 
 		gtp_instance_ = MakeUniquePtr<ThreadPool>(1, 16);
+		task_scheduler_ = MakeUniquePtr<TaskScheduler>();
 	}
 
 	Context::~Context()
@@ -135,6 +137,7 @@ namespace KlayGE
 
 		app_ = nullptr;
 
+		task_scheduler_.reset();
 		gtp_instance_.reset();
 	}
 
@@ -29,24 +29,76 @@
  */
 
 #include <KlayGE/KlayGE.hpp>
+#include <KFL/ErrorHandling.hpp>
 
 #include <KlayGE/Query.hpp>
 #include <KlayGE/RenderEngine.hpp>
 #include <KlayGE/RenderFactory.hpp>
 
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <mutex>
+#include <string_view>
 
 #include <KlayGE/PerfProfiler.hpp>
 
 namespace
 {
+	using namespace KlayGE;
+
 	std::mutex singleton_mutex;
+
+	// 2MB per thread, a few seconds of a typical frame
+	uint32_t const TIMELINE_CAPACITY = 1U << 16;
+
+	std::atomic<uint64_t> next_instance_id{1};
+
+	// Profilers are identified by id instead of address, so a timeline of a destroyed profiler is never reused
+	struct ThreadTimelineCache
+	{
+		uint64_t instance_id = 0;
+		void* timeline = nullptr;
+	};
+	thread_local ThreadTimelineCache tls_timeline;
+
+	void WriteJsonString(std::ostream& os, std::string_view str)
+	{
+		os << '"';
+		for (char const ch : str)
+		{
+			switch (ch)
+			{
+			case '"':
+				os << "\\\"";
+				break;
+
+			case '\\':
+				os << "\\\\";
+				break;
+
+			default:
+				if (static_cast<uint8_t>(ch) < 0x20)
+				{
+					char buff[8];
+					std::snprintf(buff, sizeof(buff), "\\u%04x", static_cast<uint8_t>(ch));
+					os << buff;
+				}
+				else
+				{
+					os << ch;
+				}
+				break;
+			}
+		}
+		os << '"';
+	}
 }
 
 namespace KlayGE
 {
 	std::unique_ptr<PerfProfiler> PerfProfiler::perf_profiler_instance_;
+	std::atomic<bool> PerfProfiler::capturing_{false};
 
 	PerfRegion::PerfRegion()
 	{
@@ -59,6 +111,12 @@ namespace KlayGE
 
 	void PerfRegion::Begin()
 	{
+		if (PerfProfiler::Capturing())
+		{
+			zone_begun_ = true;
+			PerfProfiler::Instance().BeginZone(name_.c_str());
+		}
+
 		if (Context::Instance().Config().perf_profiler)
 		{
 			dirty_ = true;
@@ -80,6 +138,12 @@ namespace KlayGE
 				gpu_timer_query_->End();
 			}
 		}
+
+		if (zone_begun_)
+		{
+			zone_begun_ = false;
+			PerfProfiler::Instance().EndZone();
+		}
 	}
 
 	void PerfRegion::CollectData()
@@ -95,6 +159,11 @@ namespace KlayGE
 	}
 
 
+	PerfProfiler::PerfProfiler()
+		: instance_id_(next_instance_id.fetch_add(1, std::memory_order_relaxed))
+	{
+	}
+
 	PerfProfiler& PerfProfiler::Instance()
 	{
 		if (!perf_profiler_instance_)
@@ -125,6 +194,7 @@ namespace KlayGE
 	PerfRegion* PerfProfiler::CreatePerfRegion(int category, std::string const& name)
 	{
 		auto perf_region = MakeUniquePtr<PerfRegion>();
+		perf_region->name_ = name;
 		auto* ret = perf_region.get();
 		perf_regions_.emplace_back(PerfInfo{category, name, std::move(perf_region), {}});
 		return ret;
@@ -171,4 +241,183 @@ namespace KlayGE
 			ofs << '\n';
 		}
 	}
+
+	void PerfProfiler::StartCapture()
+	{
+		capture_start_time_ = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time_).count();
+		capture_frame_id_ = 0;
+		capturing_.store(true, std::memory_order_relaxed);
+	}
+
+	void PerfProfiler::StopCapture()
+	{
+		capturing_.store(false, std::memory_order_relaxed);
+	}
+
+	void PerfProfiler::ThreadName(std::string const& name)
+	{
+		auto& timeline = this->CurrentThreadTimeline();
+
+		std::lock_guard<std::mutex> lock(timelines_mutex_);
+		timeline.name = name;
+	}
+
+	void PerfProfiler::BeginZone(char const* name)
+	{
+		this->Record(EventType::BeginZone, name, 0);
+	}
+
+	void PerfProfiler::EndZone()
+	{
+		this->Record(EventType::EndZone, nullptr, 0);
+	}
+
+	void PerfProfiler::FrameMarker()
+	{
+		if (Capturing())
+		{
+			this->Record(EventType::FrameMarker, "Frame", capture_frame_id_);
+			++capture_frame_id_;
+		}
+	}
+
+	void PerfProfiler::Counter(char const* name, double value)
+	{
+		if (Capturing())
+		{
+			this->Record(EventType::Counter, name, value);
+		}
+	}
+
+	PerfProfiler::ThreadTimeline& PerfProfiler::CurrentThreadTimeline()
+	{
+		if (tls_timeline.instance_id != instance_id_)
+		{
+			auto timeline = MakeUniquePtr<ThreadTimeline>();
+
+			std::lock_guard<std::mutex> lock(timelines_mutex_);
+			timeline->thread_index = static_cast<uint32_t>(timelines_.size());
+			tls_timeline.instance_id = instance_id_;
+			tls_timeline.timeline = timeline.get();
+			timelines_.emplace_back(std::move(timeline));
+		}
+		return *static_cast<ThreadTimeline*>(tls_timeline.timeline);
+	}
+
+	void PerfProfiler::Record(EventType type, char const* name, double value)
+	{
+		auto& timeline = this->CurrentThreadTimeline();
+		if (!timeline.events)
+		{
+			std::lock_guard<std::mutex> lock(timelines_mutex_);
+			timeline.events = MakeUniquePtr<Event[]>(TIMELINE_CAPACITY);
+		}
+
+		// Only this thread writes num_events, so it can be published without a read-modify-write
+		uint64_t const index = timeline.num_events.load(std::memory_order_relaxed);
+		auto& event = timeline.events[index & (TIMELINE_CAPACITY - 1)];
+		event.time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time_).count();
+		event.name = name;
+		event.value = value;
+		event.type = type;
+		timeline.num_events.store(index + 1, std::memory_order_release);
+	}
+
+	void PerfProfiler::ExportToChromeTrace(std::string const& file_name) const
+	{
+		std::ofstream ofs(file_name.c_str());
+		ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+		bool first_event = true;
+		auto begin_event = [&ofs, &first_event](char const* phase, uint32_t tid, int64_t time) {
+			ofs << (first_event ? "\n" : ",\n");
+			first_event = false;
+			ofs << "{\"ph\":\"" << phase << "\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << time / 1000 << '.';
+			char buff[4];
+			std::snprintf(buff, sizeof(buff), "%03d", static_cast<int>(time % 1000));
+			ofs << buff;
+		};
+
+		std::vector<Event> events;
+
+		std::lock_guard<std::mutex> lock(timelines_mutex_);
+		for (auto const& timeline : timelines_)
+		{
+			uint32_t const tid = timeline->thread_index + 1;
+
+			begin_event("M", tid, 0);
+			ofs << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+			WriteJsonString(ofs, timeline->name.empty() ? "Thread " + std::to_string(tid) : timeline->name);
+			ofs << "}}";
+
+			if (!timeline->events)
+			{
+				continue;
+			}
+
+			// The ring may still be written by a zone that was open when the capture stopped. Events overwritten while
+			// copying are dropped.
+			uint64_t const end = timeline->num_events.load(std::memory_order_acquire);
+			uint64_t const begin = end > TIMELINE_CAPACITY ? end - TIMELINE_CAPACITY : 0;
+			events.clear();
+			for (uint64_t i = begin; i < end; ++ i)
+			{
+				events.push_back(timeline->events[i & (TIMELINE_CAPACITY - 1)]);
+			}
+			uint64_t const new_end = timeline->num_events.load(std::memory_order_acquire);
+			size_t const num_overwritten =
+				static_cast<size_t>(std::min<uint64_t>(new_end > TIMELINE_CAPACITY + begin ? new_end - TIMELINE_CAPACITY - begin : 0,
+					events.size()));
+
+			uint32_t depth = 0;
+			for (size_t i = num_overwritten; i < events.size(); ++ i)
+			{
+				auto const& event = events[i];
+				if (event.time < capture_start_time_)
+				{
+					continue;
+				}
+
+				switch (event.type)
+				{
+				case EventType::BeginZone:
+					++depth;
+					begin_event("B", tid, event.time);
+					ofs << ",\"name\":";
+					WriteJsonString(ofs, event.name);
+					ofs << '}';
+					break;
+
+				case EventType::EndZone:
+					// Zones began before the capture or lost to the ring have no beginning
+					if (depth > 0)
+					{
+						--depth;
+						begin_event("E", tid, event.time);
+						ofs << '}';
+					}
+					break;
+
+				case EventType::FrameMarker:
+					begin_event("i", tid, event.time);
+					ofs << ",\"s\":\"g\",\"name\":";
+					WriteJsonString(ofs, event.name);
+					ofs << ",\"args\":{\"frame\":" << static_cast<uint64_t>(event.value) << "}}";
+					break;
+
+				case EventType::Counter:
+					begin_event("C", tid, event.time);
+					ofs << ",\"name\":";
+					WriteJsonString(ofs, event.name);
+					ofs << ",\"args\":{\"value\":" << event.value << "}}";
+					break;
+
+				default:
+					KFL_UNREACHABLE("Invalid event type");
+				}
+			}
+		}
+
+		ofs << "\n]}\n";
+	}
 } // namespace KlayGE
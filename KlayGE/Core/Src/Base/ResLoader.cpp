@@ -30,13 +30,16 @@
 
 #include <KlayGE/KlayGE.hpp>
 #include <KFL/Hash.hpp>
+#include <KFL/Timer.hpp>
 #include <KFL/Util.hpp>
 #include <KlayGE/Package.hpp>
+#include <KlayGE/PerfProfiler.hpp>
 #include <KFL/CXX17/filesystem.hpp>
 
 #if defined KLAYGE_PLATFORM_LINUX
 #include <cstring>
 #endif
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
@@ -203,20 +206,14 @@ namespace KlayGE
 #endif
 #endif
 
-		loading_thread_ = Context::Instance().ThreadPoolInstance().QueueThread([this] { this->LoadingThreadFunc(); });
+		// Leave the other half of the cores to the main and render threads
+		uint32_t const num_loading_threads = std::clamp(std::thread::hardware_concurrency() / 2, 1U, 4U);
+		this->StartLoadingThreads(num_loading_threads);
 	}
 
 	ResLoader::~ResLoader()
 	{
-		quit_ = true;
-
-		{
-			std::unique_lock<std::mutex> lock(loading_res_queue_mutex_, std::try_to_lock);
-			non_empty_loading_res_queue_ = true;
-			loading_res_queue_cv_.notify_one();
-		}
-
-		loading_thread_.wait();
+		this->StopLoadingThreads();
 	}
 
 	ResLoader& ResLoader::Instance()
@@ -679,7 +676,8 @@ namespace KlayGE
 	{
 		this->RemoveUnrefResources();
 
-		std::shared_ptr<void> loaded_res = this->FindMatchLoadedResource(res_desc);
+		uint64_t const hash = res_desc->Hash();
+		std::shared_ptr<void> loaded_res = this->FindMatchLoadedResource(res_desc, hash);
 		std::shared_ptr<void> res;
 		if (loaded_res)
 		{
@@ -692,32 +690,32 @@ namespace KlayGE
 				res = res_desc->CloneResourceFrom(loaded_res);
 				if (res != loaded_res)
 				{
-					this->AddLoadedResource(res_desc, res);
+					this->AddLoadedResource(res_desc, hash, res);
 				}
 			}
 		}
 		else
 		{
-			std::shared_ptr<volatile LoadingStatus> async_is_done;
-			bool found = false;
+			std::shared_ptr<LoadingState> async_state;
 			{
-				std::lock_guard<std::mutex> lock(loading_mutex_);
+				auto& shard = loading_res_[ShardIndex(hash)];
+				std::lock_guard<std::mutex> lock(shard.mutex);
 
-				for (auto const & lrq : loading_res_)
+				auto const range = shard.entries.equal_range(hash);
+				for (auto iter = range.first; iter != range.second; ++ iter)
 				{
-					if (lrq.first->Match(*res_desc))
+					if ((iter->second.second->status != LS_Canceled) && iter->second.first->Match(*res_desc))
 					{
-						res_desc->CopyDataFrom(*lrq.first);
-						async_is_done = lrq.second;
-						found = true;
+						res_desc->CopyDataFrom(*iter->second.first);
+						async_state = iter->second.second;
 						break;
 					}
 				}
 			}
 
-			if (found)
+			if (async_state)
 			{
-				*async_is_done = LS_Complete;
+				async_state->status = LS_Complete;
 			}
 			else
 			{
@@ -731,17 +729,18 @@ namespace KlayGE
 
 			res_desc->MainThreadStage();
 			res = res_desc->Resource();
-			this->AddLoadedResource(res_desc, res);
+			this->AddLoadedResource(res_desc, hash, res);
 		}
 
 		return res;
 	}
 
-	std::shared_ptr<void> ResLoader::ASyncQuery(ResLoadingDescPtr const & res_desc)
+	std::shared_ptr<void> ResLoader::ASyncQuery(ResLoadingDescPtr const & res_desc, float priority)
 	{
 		this->RemoveUnrefResources();
 
-		std::shared_ptr<void> loaded_res = this->FindMatchLoadedResource(res_desc);
+		uint64_t const hash = res_desc->Hash();
+		std::shared_ptr<void> loaded_res = this->FindMatchLoadedResource(res_desc, hash);
 		std::shared_ptr<void> res;
 		if (loaded_res)
 		{
@@ -754,37 +753,58 @@ namespace KlayGE
 				res = res_desc->CloneResourceFrom(loaded_res);
 				if (res != loaded_res)
 				{
-					this->AddLoadedResource(res_desc, res);
+					this->AddLoadedResource(res_desc, hash, res);
 				}
 			}
 		}
 		else
 		{
-			std::shared_ptr<volatile LoadingStatus> async_is_done;
-			bool found = false;
+			auto& shard = loading_res_[ShardIndex(hash)];
+
+			std::shared_ptr<LoadingState> async_state;
+			bool bump_priority = false;
 			{
-				std::lock_guard<std::mutex> lock(loading_mutex_);
+				std::lock_guard<std::mutex> lock(shard.mutex);
 
-				for (auto const & lrq : loading_res_)
+				auto const range = shard.entries.equal_range(hash);
+				for (auto iter = range.first; iter != range.second; ++ iter)
 				{
-					if (lrq.first->Match(*res_desc))
+					if ((iter->second.second->status != LS_Canceled) && iter->second.first->Match(*res_desc))
 					{
-						res_desc->CopyDataFrom(*lrq.first);
-						async_is_done = lrq.second;
-						found = true;
+						res_desc->CopyDataFrom(*iter->second.first);
+						async_state = iter->second.second;
 						break;
 					}
 				}
+
+				if (async_state)
+				{
+					if (!res_desc->StateLess())
+					{
+						shard.entries.emplace(hash, std::make_pair(res_desc, async_state));
+						++ num_loading_res_;
+					}
+
+					if (priority > async_state->priority)
+					{
+						async_state->priority = priority;
+						bump_priority = (LS_Loading == async_state->status);
+					}
+				}
 			}
 
-			if (found)
+			if (async_state)
 			{
 				res = res_desc->Resource();
 
-				if (!res_desc->StateLess())
+				if (bump_priority)
 				{
-					std::lock_guard<std::mutex> lock(loading_mutex_);
-					loading_res_.emplace_back(res_desc, async_is_done);
+					// The old entry is still in the heap. Only the first one popped can claim the state, the other one is skipped.
+					std::lock_guard<std::mutex> lock(loading_res_queue_mutex_);
+					loading_res_queue_.push_back({ priority, loading_res_seq_, async_state->res_desc, async_state });
+					std::push_heap(loading_res_queue_.begin(), loading_res_queue_.end());
+					++ loading_res_seq_;
+					loading_res_queue_cv_.notify_one();
 				}
 			}
 			else
@@ -793,16 +813,26 @@ namespace KlayGE
 				{
 					res = res_desc->CreateResource();
 
-					async_is_done = MakeSharedPtr<LoadingStatus>(LS_Loading);
+					async_state = MakeSharedPtr<LoadingState>();
+					async_state->priority = priority;
+					async_state->hash = hash;
+					async_state->res_desc = res_desc;
+					if (res)
+					{
+						async_state->res = res;
+						async_state->internal_refs = res.use_count() - 1;
+					}
 
 					{
-						std::lock_guard<std::mutex> lock(loading_mutex_);
-						loading_res_.emplace_back(res_desc, async_is_done);
+						std::lock_guard<std::mutex> lock(shard.mutex);
+						shard.entries.emplace(hash, std::make_pair(res_desc, async_state));
+						++ num_loading_res_;
 					}
 					{
-						std::unique_lock<std::mutex> lock(loading_res_queue_mutex_, std::try_to_lock);
-						loading_res_queue_.emplace_back(res_desc, async_is_done);
-						non_empty_loading_res_queue_ = true;
+						std::lock_guard<std::mutex> lock(loading_res_queue_mutex_);
+						loading_res_queue_.push_back({ priority, loading_res_seq_, res_desc, async_state });
+						std::push_heap(loading_res_queue_.begin(), loading_res_queue_.end());
+						++ loading_res_seq_;
 						loading_res_queue_cv_.notify_one();
 					}
 				}
@@ -810,7 +840,7 @@ namespace KlayGE
 				{
 					res_desc->MainThreadStage();
 					res = res_desc->Resource();
-					this->AddLoadedResource(res_desc, res);
+					this->AddLoadedResource(res_desc, hash, res);
 				}
 			}
 		}
@@ -819,87 +849,141 @@ namespace KlayGE
 
 	void ResLoader::Unload(std::shared_ptr<void> const & res)
 	{
-		std::lock_guard<std::mutex> lock(loaded_mutex_);
-
-		for (auto iter = loaded_res_.begin(); iter != loaded_res_.end(); ++ iter)
+		for (auto& shard : loaded_res_)
 		{
-			if (res == iter->second.lock())
+			std::lock_guard<std::mutex> lock(shard.mutex);
+
+			for (auto iter = shard.entries.begin(); iter != shard.entries.end(); ++ iter)
 			{
-				loaded_res_.erase(iter);
-				break;
+				if (res == iter->second.second.lock())
+				{
+					shard.entries.erase(iter);
+					return;
+				}
 			}
 		}
 	}
 
-	void ResLoader::AddLoadedResource(ResLoadingDescPtr const & res_desc, std::shared_ptr<void> const & res)
+	uint32_t ResLoader::ShardIndex(uint64_t hash) noexcept
 	{
-		std::lock_guard<std::mutex> lock(loaded_mutex_);
+		// Fibonacci hashing, so that the shard doesn't correlate with the bucket inside the shard
+		return static_cast<uint32_t>((hash * 0x9E3779B97F4A7C15ULL) >> 60) % NUM_RES_INDEX_SHARDS;
+	}
 
-		bool found = false;
-		for (auto& c_desc : loaded_res_)
+	void ResLoader::AddLoadedResource(ResLoadingDescPtr const & res_desc, uint64_t hash, std::shared_ptr<void> const & res)
+	{
+		auto& shard = loaded_res_[ShardIndex(hash)];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		auto const range = shard.entries.equal_range(hash);
+		for (auto iter = range.first; iter != range.second; ++ iter)
 		{
-			if (c_desc.first == res_desc)
+			if (iter->second.first == res_desc)
 			{
-				c_desc.second = std::weak_ptr<void>(res);
-				found = true;
-				break;
+				iter->second.second = std::weak_ptr<void>(res);
+				return;
 			}
 		}
-		if (!found)
-		{
-			loaded_res_.emplace_back(res_desc, std::weak_ptr<void>(res));
-		}
+		shard.entries.emplace(hash, std::make_pair(res_desc, std::weak_ptr<void>(res)));
 	}
 
-	std::shared_ptr<void> ResLoader::FindMatchLoadedResource(ResLoadingDescPtr const & res_desc)
+	std::shared_ptr<void> ResLoader::FindMatchLoadedResource(ResLoadingDescPtr const & res_desc, uint64_t hash)
 	{
-		std::lock_guard<std::mutex> lock(loaded_mutex_);
+		auto& shard = loaded_res_[ShardIndex(hash)];
+		std::lock_guard<std::mutex> lock(shard.mutex);
 
-		std::shared_ptr<void> loaded_res;
-		for (auto const & lr : loaded_res_)
+		auto const range = shard.entries.equal_range(hash);
+		for (auto iter = range.first; iter != range.second;)
 		{
-			if (lr.first->Match(*res_desc))
+			std::shared_ptr<void> loaded_res = iter->second.second.lock();
+			if (!loaded_res)
 			{
-				loaded_res = lr.second.lock();
-				break;
+				// Reclaim dead entries on the way, the sweep in RemoveUnrefResources will get to the rest
+				iter = shard.entries.erase(iter);
+			}
+			else if (iter->second.first->Match(*res_desc))
+			{
+				return loaded_res;
+			}
+			else
+			{
+				++ iter;
 			}
 		}
-		return loaded_res;
+		return std::shared_ptr<void>();
 	}
 
 	void ResLoader::RemoveUnrefResources()
 	{
-		std::lock_guard<std::mutex> lock(loaded_mutex_);
+		// Only one shard is swept per call. It keeps the cost of a query bounded no matter how many resources are loaded.
+		auto& shard = loaded_res_[unref_sweep_shard_.fetch_add(1, std::memory_order_relaxed) % NUM_RES_INDEX_SHARDS];
+		std::lock_guard<std::mutex> lock(shard.mutex);
 
-		for (auto iter = loaded_res_.begin(); iter != loaded_res_.end();)
+		for (auto iter = shard.entries.begin(); iter != shard.entries.end();)
 		{
-			if (iter->second.lock())
+			if (iter->second.second.expired())
 			{
-				++ iter;
+				iter = shard.entries.erase(iter);
 			}
 			else
 			{
-				iter = loaded_res_.erase(iter);
+				++ iter;
 			}
 		}
 	}
 
 	void ResLoader::Update()
 	{
-		std::vector<std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>>> tmp_loading_res;
+		// Requests joined to the same loading share one state, and have to be finished in the same batch
+		std::vector<std::pair<std::shared_ptr<LoadingState>, std::vector<ResLoadingDescPtr>>> complete_res;
+		bool has_canceled = false;
+		for (auto& shard : loading_res_)
+		{
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			for (auto const & lrq : shard.entries)
+			{
+				auto const & state = lrq.second.second;
+				if (LS_Complete == state->status)
+				{
+					auto iter = std::find_if(complete_res.begin(), complete_res.end(),
+						[&state](auto const & cr) { return cr.first == state; });
+					if (iter == complete_res.end())
+					{
+						complete_res.emplace_back(state, std::vector<ResLoadingDescPtr>());
+						iter = complete_res.end() - 1;
+					}
+					iter->second.push_back(lrq.second.first);
+				}
+				else if (LS_Canceled == state->status)
+				{
+					has_canceled = true;
+				}
+			}
+		}
+
+		if (complete_res.empty() && !has_canceled)
 		{
-			std::lock_guard<std::mutex> lock(loading_mutex_);
-			tmp_loading_res = loading_res_;
+			return;
 		}
 
-		for (auto& lrq : tmp_loading_res)
+		std::stable_sort(complete_res.begin(), complete_res.end(),
+			[](auto const & lhs, auto const & rhs) { return lhs.first->priority > rhs.first->priority; });
+
+		Timer timer;
+		for (auto& cr : complete_res)
 		{
-			if (LS_Complete == *lrq.second)
+			// At least one batch goes through every frame, or a single huge resource would never get loaded
+			if ((main_thread_stage_budget_ > 0) && (&cr != &complete_res.front()) && (timer.elapsed() > main_thread_stage_budget_))
+			{
+				break;
+			}
+
+			for (auto const & res_desc : cr.second)
 			{
-				ResLoadingDescPtr const & res_desc = lrq.first;
+				uint64_t const hash = res_desc->Hash();
 
 				std::shared_ptr<void> res;
-				std::shared_ptr<void> loaded_res = this->FindMatchLoadedResource(res_desc);
+				std::shared_ptr<void> loaded_res = this->FindMatchLoadedResource(res_desc, hash);
 				if (loaded_res)
 				{
 					if (!res_desc->StateLess())
@@ -907,7 +991,7 @@ namespace KlayGE
 						res = res_desc->CloneResourceFrom(loaded_res);
 						if (res != loaded_res)
 						{
-							this->AddLoadedResource(res_desc, res);
+							this->AddLoadedResource(res_desc, hash, res);
 						}
 					}
 				}
@@ -915,25 +999,23 @@ namespace KlayGE
 				{
 					res_desc->MainThreadStage();
 					res = res_desc->Resource();
-					this->AddLoadedResource(res_desc, res);
+					this->AddLoadedResource(res_desc, hash, res);
 				}
 			}
-		}
-		for (auto& lrq : tmp_loading_res)
-		{
-			if (LS_Complete == *lrq.second)
-			{
-				*lrq.second = LS_CanBeRemoved;
-			}
+
+			cr.first->status = LS_CanBeRemoved;
 		}
 
+		for (auto& shard : loading_res_)
 		{
-			std::lock_guard<std::mutex> lock(loading_mutex_);
-			for (auto iter = loading_res_.begin(); iter != loading_res_.end();)
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			for (auto iter = shard.entries.begin(); iter != shard.entries.end();)
 			{
-				if (LS_CanBeRemoved == *(iter->second))
+				LoadingStatus const status = iter->second.second->status;
+				if ((LS_CanBeRemoved == status) || (LS_Canceled == status))
 				{
-					iter = loading_res_.erase(iter);
+					iter = shard.entries.erase(iter);
+					-- num_loading_res_;
 				}
 				else
 				{
@@ -943,30 +1025,94 @@ namespace KlayGE
 		}
 	}
 
-	void ResLoader::LoadingThreadFunc()
+	void ResLoader::NumLoadingThreads(uint32_t num)
+	{
+		BOOST_ASSERT(num > 0);
+
+		if (num != loading_threads_.size())
+		{
+			this->StopLoadingThreads();
+			this->StartLoadingThreads(num);
+		}
+	}
+
+	void ResLoader::StartLoadingThreads(uint32_t num)
 	{
-		while (!quit_)
 		{
-			std::vector<std::pair<ResLoadingDescPtr, std::shared_ptr<volatile LoadingStatus>>> loading_res_queue_copy;
+			std::lock_guard<std::mutex> lock(loading_res_queue_mutex_);
+			quit_ = false;
+		}
+
+		auto& thread_pool = Context::Instance().ThreadPoolInstance();
+		for (uint32_t i = 0; i < num; ++ i)
+		{
+			loading_threads_.push_back(thread_pool.QueueThread([this] { this->LoadingThreadFunc(); }));
+		}
+	}
 
+	void ResLoader::StopLoadingThreads()
+	{
+		{
+			std::lock_guard<std::mutex> lock(loading_res_queue_mutex_);
+			quit_ = true;
+		}
+		loading_res_queue_cv_.notify_all();
+
+		for (auto& thread : loading_threads_)
+		{
+			thread.wait();
+		}
+		loading_threads_.clear();
+	}
+
+	void ResLoader::LoadingThreadFunc()
+	{
+#ifndef KLAYGE_SHIP
+		PerfProfiler::Instance().ThreadName("Resource loading");
+#endif
+
+		for (;;)
+		{
+			LoadingRequest request;
 			{
 				std::unique_lock<std::mutex> lock(loading_res_queue_mutex_);
-				loading_res_queue_cv_.wait(lock, [this] { return non_empty_loading_res_queue_; });
+				loading_res_queue_cv_.wait(lock, [this] { return quit_ || !loading_res_queue_.empty(); });
+				if (quit_)
+				{
+					break;
+				}
 
-				loading_res_queue_copy.swap(loading_res_queue_);
-				non_empty_loading_res_queue_ = false;
+				std::pop_heap(loading_res_queue_.begin(), loading_res_queue_.end());
+				request = std::move(loading_res_queue_.back());
+				loading_res_queue_.pop_back();
 			}
 
-			for (auto& res_pair : loading_res_queue_copy)
+			// A request can be in the heap more than once after its priority is raised. Claiming the state makes sure it is loaded
+			// only once.
+			auto& state = *request.state;
+			LoadingStatus expected = LS_Loading;
+			if (state.status.compare_exchange_strong(expected, LS_Processing))
 			{
-				if (LS_Loading == *res_pair.second)
+				bool canceled = false;
+				if (state.internal_refs >= 0)
 				{
-					res_pair.first->SubThreadStage();
-					*res_pair.second = LS_Complete;
+					// Under the shard lock, so that no request can join while the loading is being canceled
+					auto& shard = loading_res_[ShardIndex(state.hash)];
+					std::lock_guard<std::mutex> lock(shard.mutex);
+					if (state.res.use_count() <= state.internal_refs)
+					{
+						state.status = LS_Canceled;
+						canceled = true;
+					}
 				}
-			}
 
-			Sleep(10);
+				if (!canceled)
+				{
+					KLAYGE_PERF_ZONE("Load resource");
+					request.res_desc->SubThreadStage();
+					state.status = LS_Complete;
+				}
+			}
 		}
 	}
 
@@ -33,7 +33,6 @@
 #include <KlayGE/ResLoader.hpp>
 #include <KFL/DllLoader.hpp>
 
-#include <cstring>
 #include <mutex>
 
 #include <C/LzmaLib.h>
@@ -199,10 +198,7 @@ namespace KlayGE
 
 	void LZMACodec::Decode(void* output, std::span<uint8_t const> input, uint64_t original_len)
 	{
-		uint8_t const * p = static_cast<uint8_t const *>(input.data());
-
-		auto in_data = MakeUniquePtr<uint8_t[]>(static_cast<size_t>(input.size()));
-		std::memcpy(in_data.get(), p, static_cast<std::streamsize>(input.size()));
+		uint8_t const * in_data = input.data();
 
 		SizeT s_out_len = static_cast<SizeT>(original_len);
 
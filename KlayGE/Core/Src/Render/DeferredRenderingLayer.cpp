@@ -75,6 +75,9 @@ namespace
 
 	float const ESM_SCALE_FACTOR = 300.0f;
 
+	// Objects smaller than this on a shadow map are skipped. Used by both the precull and the shadow passes.
+	float const SHADOW_SMALL_OBJ_THRESHOLD = 0.002f;
+
 #if DEFAULT_DEFERRED == LIGHT_INDEXED_DEFERRED
 	uint32_t const TILE_SIZE = 32;
 #endif
@@ -399,9 +402,15 @@ namespace
 			PostProcess::OnRenderBegin();
 
 			Camera const & camera = Context::Instance().AppInstance().ActiveCamera();
-			*(effect_->ParameterByName("inv_proj")) = camera.InverseProjMatrix();
-			*(effect_->ParameterByName("depth_near_far_invfar")) = float3(camera.NearPlane(), camera.FarPlane(), 1 / camera.FarPlane());
+			*(effect_->ParameterByHandle(inv_proj_handle_)) = camera.InverseProjMatrix();
+			*(effect_->ParameterByHandle(depth_near_far_invfar_handle_)) =
+				float3(camera.NearPlane(), camera.FarPlane(), 1 / camera.FarPlane());
 		}
+
+	private:
+		// The effect is loaded asynchronously, so the parameters are looked up every frame
+		RenderEffectParameterHandle inv_proj_handle_{CT_HASH("inv_proj")};
+		RenderEffectParameterHandle depth_near_far_invfar_handle_{CT_HASH("depth_near_far_invfar")};
 	};
 }
 
@@ -1693,6 +1702,39 @@ namespace KlayGE
 
 			this->BuildLightList();
 
+			// The shadow map cameras of spot and point lights are already updated. Cull them all at once, in parallel.
+			// Their shadow passes pick up the results instead of culling one camera at a time.
+			std::vector<Camera const *> sm_cameras;
+			for (size_t i = 0; i < lights_.size(); ++ i)
+			{
+				if (shadow_map_light_indices_[i].first >= 0)
+				{
+					auto const & light = *lights_[i];
+					switch (light.Type())
+					{
+					case LightSource::LT_Spot:
+						sm_cameras.push_back(light.SMCamera(0).get());
+						break;
+
+					case LightSource::LT_Point:
+					case LightSource::LT_SphereArea:
+					case LightSource::LT_TubeArea:
+						for (uint32_t j = 0; j < 6; ++ j)
+						{
+							sm_cameras.push_back(light.SMCamera(j).get());
+						}
+						break;
+
+					default:
+						break;
+					}
+				}
+			}
+			if (!sm_cameras.empty())
+			{
+				scene_mgr.PrecullCameras(sm_cameras, SHADOW_SMALL_OBJ_THRESHOLD);
+			}
+
 			bool has_opaque_objs = false;
 			bool has_transparency_back_objs = false;
 			bool has_transparency_front_objs = false;
@@ -4580,7 +4622,7 @@ namespace KlayGE
 				curr_cascade_index_ = index_in_pass;
 			}
 
-			scene_mgr.SmallObjectThreshold(0.002f);
+			scene_mgr.SmallObjectThreshold(SHADOW_SMALL_OBJ_THRESHOLD);
 
 			auto const& shadow_map_camera = light.SMCamera(
 				((light_type == LightSource::LT_Spot) || (light_type == LightSource::LT_Directional)) ? 0 : index_in_pass);
@@ -31,6 +31,8 @@
 #include <KlayGE/KlayGE.hpp>
 #include <KlayGE/DistanceField.hpp>
 
+#include <limits>
+
 namespace
 {
 	using namespace KlayGE;
@@ -190,6 +192,135 @@ namespace
 		} while (changed);
 	}
 
+	// Distance from pixel (x, y) to the edge in pixel (ex, ey)
+	float EdgePixelDistance(std::vector<float> const & img, std::vector<float2> const & grad, int width, int x, int y, int ex, int ey)
+	{
+		int const edge = ey * width + ex;
+		float const val = std::min(img[edge], 1.0f);
+		if ((ex == x) && (ey == y))
+		{
+			return (val < 1) ? EdgeDistance(grad[edge], val) : 0;
+		}
+		else
+		{
+			float2 const offset(static_cast<float>(x - ex), static_cast<float>(y - ey));
+			return MathLib::length(offset) + EdgeDistance(offset, val);
+		}
+	}
+
+	// Felzenszwalb and Huttenlocher, "Distance Transforms of Sampled Functions". A column pass finds the nearest edge pixel
+	// in each column, and a row pass finds the lowest of the parabolas formed by the columns. Both are linear.
+	// The column pass runs on whole rows without branches, so it's vectorized across the columns.
+	void ExactEuclideanDistance(std::vector<float> const & img, std::vector<float2> const & grad,
+		int width, int height, std::vector<float>& dist)
+	{
+		// A row out of the image, far enough to never be the nearest one
+		int const no_edge = -2 * (width + height);
+
+		std::vector<int> nearest_y(img.size());
+		for (int x = 0; x < width; ++ x)
+		{
+			nearest_y[x] = (img[x] > 0) ? 0 : no_edge;
+		}
+		for (int y = 1; y < height; ++ y)
+		{
+			float const * img_row = &img[y * width];
+			int const * above = &nearest_y[(y - 1) * width];
+			int* row = &nearest_y[y * width];
+			for (int x = 0; x < width; ++ x)
+			{
+				row[x] = (img_row[x] > 0) ? y : above[x];
+			}
+		}
+		for (int y = height - 2; y >= 0; -- y)
+		{
+			int const * below = &nearest_y[(y + 1) * width];
+			int* row = &nearest_y[y * width];
+			for (int x = 0; x < width; ++ x)
+			{
+				row[x] = (std::abs(below[x] - y) < y - row[x]) ? below[x] : row[x];
+			}
+		}
+
+		std::vector<int> sites(width);
+		std::vector<float> site_dist_sq(width);
+		std::vector<float> boundaries(width + 1);
+		for (int y = 0; y < height; ++ y)
+		{
+			int const * row = &nearest_y[y * width];
+
+			// Lower envelope of the parabolas of the columns that have edge pixels
+			int num_sites = 0;
+			for (int q = 0; q < width; ++ q)
+			{
+				if (row[q] < 0)
+				{
+					continue;
+				}
+
+				float const dy = static_cast<float>(row[q] - y);
+				float const f = dy * dy;
+				float s = -std::numeric_limits<float>::max();
+				while (num_sites > 0)
+				{
+					int const v = sites[num_sites - 1];
+					s = ((f + q * q) - (site_dist_sq[num_sites - 1] + v * v)) / (2.0f * (q - v));
+					if (s > boundaries[num_sites - 1])
+					{
+						break;
+					}
+					-- num_sites;
+				}
+				if (num_sites == 0)
+				{
+					s = -std::numeric_limits<float>::max();
+				}
+				sites[num_sites] = q;
+				site_dist_sq[num_sites] = f;
+				boundaries[num_sites] = s;
+				++ num_sites;
+			}
+
+			float* dist_row = &dist[y * width];
+			if (num_sites == 0)
+			{
+				std::fill(dist_row, dist_row + width, 1e10f);
+				continue;
+			}
+
+			boundaries[num_sites] = std::numeric_limits<float>::max();
+			int k = 0;
+			for (int x = 0; x < width; ++ x)
+			{
+				while (boundaries[k + 1] < x)
+				{
+					++ k;
+				}
+
+				int const closest_x = sites[k];
+				int const closest_y = row[closest_x];
+				float min_dist = EdgePixelDistance(img, grad, width, x, y, closest_x, closest_y);
+
+				// The edge in a neighbor of the nearest edge pixel could be closer. The edge distance is never less than
+				// -sqrt(2)/2, so most of them are skipped without computing it.
+				for (int ey = std::max(closest_y - 1, 0); ey <= std::min(closest_y + 1, height - 1); ++ ey)
+				{
+					for (int ex = std::max(closest_x - 1, 0); ex <= std::min(closest_x + 1, width - 1); ++ ex)
+					{
+						int const dx = x - ex;
+						int const dy = y - ey;
+						float const max_di = min_dist + SQRT2 / 2;
+						if ((img[ey * width + ex] > 0) && (static_cast<float>(dx * dx + dy * dy) < max_di * max_di))
+						{
+							min_dist = std::min(min_dist, EdgePixelDistance(img, grad, width, x, y, ex, ey));
+						}
+					}
+				}
+				dist_row[x] = min_dist;
+			}
+		}
+	}
+
 	void ComputeGradient(std::vector<float> const& img, int w, int h, std::vector<float2>& grad)
 	{
 		BOOST_ASSERT(img.size() == static_cast<size_t>(w * h));
@@ -231,18 +362,18 @@ namespace KlayGE
 
 		for (uint32_t y = 0; y < output_height; ++ y)
 		{
+			T const * row0 = &input_data[(y * 2 + 0) * input_width];
+			T const * row1 = &input_data[(y * 2 + 1) * input_width];
+			T* output_row = &output_data[y * output_width];
 			for (uint32_t x = 0; x < output_width; ++ x)
 			{
-				output_data[y * output_width + x] = (input_data[(y * 2 + 0) * input_width + (x * 2 + 0)]
-					+ input_data[(y * 2 + 0) * input_width + (x * 2 + 1)]
-					+ input_data[(y * 2 + 1) * input_width + (x * 2 + 0)]
-					+ input_data[(y * 2 + 1) * input_width + (x * 2 + 1)]) * 0.25f;
+				output_row[x] = (row0[x * 2 + 0] + row0[x * 2 + 1] + row1[x * 2 + 0] + row1[x * 2 + 1]) * 0.25f;
 			}
 		}
 	}
 
 	void ComputeDistance(std::vector<float> const & aa_2x_data, uint32_t input_width, uint32_t input_height,
-		std::vector<float>& dist_data)
+		std::vector<float>& dist_data, DistanceFieldAlgorithm algorithm)
 	{
 		BOOST_ASSERT((input_width & 0x1) == 0);
 		BOOST_ASSERT((input_height & 0x1) == 0);
@@ -256,8 +387,10 @@ namespace KlayGE
 		std::vector<float2> grad_data(aa_data.size());
 		Downsample2x(grad_2x_data, input_width, input_height, grad_data);
 
+		auto distance_func = (algorithm == DistanceFieldAlgorithm::ExactEuclidean) ? ExactEuclideanDistance : AAEuclideanDistance;
+
 		std::vector<float> outside(grad_data.size());
-		AAEuclideanDistance(aa_data, grad_data, input_width / 2, input_height / 2, outside);
+		distance_func(aa_data, grad_data, input_width / 2, input_height / 2, outside);
 
 		for (size_t i = 0; i < grad_data.size(); ++ i)
 		{
@@ -266,7 +399,7 @@ namespace KlayGE
 		}
 
 		std::vector<float> inside(grad_data.size());
-		AAEuclideanDistance(aa_data, grad_data, input_width / 2, input_height / 2, inside);
+		distance_func(aa_data, grad_data, input_width / 2, input_height / 2, inside);
 
 		dist_data.resize(outside.size());
 		for (uint32_t i = 0; i < outside.size(); ++ i)
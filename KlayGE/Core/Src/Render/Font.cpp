@@ -29,6 +29,7 @@
  */
 
 #include <KlayGE/KlayGE.hpp>
+#include <KFL/ErrorHandling.hpp>
 #include <KFL/Util.hpp>
 #include <KFL/Half.hpp>
 #include <KlayGE/RenderLayout.hpp>
@@ -48,6 +49,7 @@
 #include <KlayGE/LZMACodec.hpp>
 #include <KlayGE/TransientBuffer.hpp>
 #include <KFL/Hash.hpp>
+#include <KFL/TaskScheduler.hpp>
 #include <KlayGE/App3D.hpp>
 #include <KlayGE/Window.hpp>
 
@@ -65,6 +67,11 @@
 
 #include <KlayGE/Font.hpp>
 
+namespace
+{
+	uint32_t constexpr PARALLEL_GLYPH_GRAIN_SIZE = 16;
+}
+
 namespace KlayGE
 {
 	class FontRenderable : public Renderable
@@ -96,9 +103,15 @@ namespace KlayGE
 			RenderDeviceCaps const & caps = renderEngine.DeviceCaps();
 			uint32_t size = std::min<uint32_t>(2048U, std::min<uint32_t>(caps.max_texture_width, caps.max_texture_height)) / kfont_char_size * kfont_char_size;
 			dist_texture_ = rf.MakeTexture2D(size, size, 1, 1, EF_R8, 1, 0, EAH_GPU_Read);
-			a_char_data_.resize(kfont_char_size * kfont_char_size);
+			dist_data_.resize(size * size);
 
-			char_free_list_.emplace_back(0, size * size / kfont_char_size / kfont_char_size);
+			uint32_t const num_slots = size * size / kfont_char_size / kfont_char_size;
+			char_slots_.resize(num_slots);
+			free_slots_.resize(num_slots);
+			for (uint32_t i = 0; i < num_slots; ++ i)
+			{
+				free_slots_[i] = num_slots - 1 - i;
+			}
 
 			effect_ = SyncLoadRenderEffect("Font.fxml");
 			*(effect_->ParameterByName("distance_tex")) = dist_texture_;
@@ -167,6 +180,7 @@ namespace KlayGE
 		{
 			RenderEngine& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
 
+			this->FlushPendingChars();
 			this->OnRenderBegin();
 
 			BOOST_ASSERT(tb_vb_sub_allocs_.size() == tb_ib_sub_allocs_.size());
@@ -253,6 +267,19 @@ namespace KlayGE
 			this->AddText(0, 0, 0, 1, 1, clr, text, font_size);
 		}
 
+		uint64_t NumCacheHits() const
+		{
+			return num_cache_hits_;
+		}
+		uint64_t NumCacheMisses() const
+		{
+			return num_cache_misses_;
+		}
+		uint64_t NumCacheEvictions() const
+		{
+			return num_cache_evictions_;
+		}
+
 	private:
 		void AddText(Rect const & rc, float sz,
 			float xScale, float yScale, Color const & clr, std::wstring_view text, float font_size, uint32_t align)
@@ -260,7 +287,7 @@ namespace KlayGE
 			this->UpdateTexture(text);
 
 			KFont const & kl = *kfont_loader_;
-			auto const & cim = char_info_map_;
+			auto const & cim = char_slot_map_;
 
 			std::vector<FontVert> vertices;
 			std::vector<uint16_t> indices;
@@ -342,7 +369,7 @@ namespace KlayGE
 
 				for (auto const & ch : lines[i].second)
 				{
-					std::pair<int32_t, uint32_t> const & offset_adv = kl.CharIndexAdvance(ch);
+					std::pair<int32_t, uint32_t> const offset_adv = kl.CharIndexAdvance(ch);
 					if (offset_adv.first != -1)
 					{
 						KFont::font_info const & ci = kl.CharInfo(offset_adv.first);
@@ -353,12 +380,12 @@ namespace KlayGE
 						float height = ci.height * rel_size_y;
 
 						auto cmiter = cim.find(ch);
-						Rect const & texRect(cmiter->second.rc);
-
 						Rect pos_rc(x + left, y + top, x + left + width, y + top + height);
 						Rect intersect_rc = pos_rc & rc;
-						if ((intersect_rc.Width() > 0) && (intersect_rc.Height() > 0))
+						if ((cmiter != cim.end()) && (intersect_rc.Width() > 0) && (intersect_rc.Height() > 0))
 						{
+							Rect const & texRect(char_slots_[cmiter->second].rc);
+
 							vertices.push_back(FontVert(float3(pos_rc.left(), pos_rc.top(), sz),
 													clr32,
 													float2(texRect.left(), texRect.top())));
@@ -415,7 +442,7 @@ namespace KlayGE
 			this->UpdateTexture(text);
 
 			KFont const & kl = *kfont_loader_;
-			auto const & cim = char_info_map_;
+			auto const & cim = char_slot_map_;
 
 			std::vector<FontVert> vertices;
 			std::vector<uint16_t> indices;
@@ -437,7 +464,7 @@ namespace KlayGE
 			{
 				if (ch != L'\n')
 				{
-					std::pair<int32_t, uint32_t> const & offset_adv = kl.CharIndexAdvance(ch);
+					std::pair<int32_t, uint32_t> const offset_adv = kl.CharIndexAdvance(ch);
 					if (offset_adv.first != -1)
 					{
 						KFont::font_info const & ci = kl.CharInfo(offset_adv.first);
@@ -450,7 +477,7 @@ namespace KlayGE
 						auto cmiter = cim.find(ch);
 						if (cmiter != cim.end())
 						{
-							Rect const & texRect(cmiter->second.rc);
+							Rect const & texRect(char_slots_[cmiter->second].rc);
 							Rect pos_rc(x + left, y + top, x + left + width, y + top + height);
 
 							vertices.push_back(FontVert(float3(pos_rc.left(), pos_rc.top(), sz),
@@ -526,138 +553,180 @@ namespace KlayGE
 			uint32_t const tex_size = dist_texture_->Width(0);
 
 			KFont& kl = *kfont_loader_;
-			auto& cim = char_info_map_;
+			auto& cim = char_slot_map_;
 
 			uint32_t const kfont_char_size = kl.CharSize();
-
 			uint32_t const num_chars_a_row = tex_size / kfont_char_size;
-			uint32_t const num_total_chars = num_chars_a_row * num_chars_a_row;
 
 			for (auto const & ch : text)
 			{
-				int32_t offset = kl.CharIndex(ch);
-				if (offset != -1)
+				int32_t const offset = kl.CharIndex(ch);
+				if (offset == -1)
 				{
-					auto cmiter = cim.find(ch);
-					if (cmiter != cim.end())
-					{
-						// ҵ
+					continue;
+				}
 
-						cmiter->second.tick = tick_;
+				auto cmiter = cim.find(ch);
+				if (cmiter != cim.end())
+				{
+					++ num_cache_hits_;
+
+					uint32_t const slot = cmiter->second;
+					char_slots_[slot].tick = tick_;
+					this->UnlinkSlot(slot);
+					this->LinkSlotToFront(slot);
+				}
+				else
+				{
+					uint32_t slot;
+					if (!free_slots_.empty())
+					{
+						slot = free_slots_.back();
+						free_slots_.pop_back();
 					}
 					else
 					{
-						// ҲԵ
+						// The least recently used one, unless the atlas is already full of this text
+						slot = lru_tail_;
+						if (char_slots_[slot].tick == tick_)
+						{
+							continue;
+						}
 
-						KFont::font_info const & ci = kl.CharInfo(offset);
+						++ num_cache_evictions_;
 
-						uint32_t width = ci.width;
-						uint32_t height = ci.height;
+						this->UnlinkSlot(slot);
+						cim.erase(char_slots_[slot].ch);
+					}
 
-						int2 char_pos;
-						CharInfo charInfo;
-						if (cim.size() < num_total_chars)
-						{
-							// пռ
+					++ num_cache_misses_;
+
+					KFont::font_info const & ci = kl.CharInfo(offset);
+					uint32_t const x = slot % num_chars_a_row * kfont_char_size;
+					uint32_t const y = slot / num_chars_a_row * kfont_char_size;
+
+					CharInfo& char_info = char_slots_[slot];
+					char_info.rc.left() = static_cast<float>(x) / tex_size;
+					char_info.rc.top() = static_cast<float>(y) / tex_size;
+					char_info.rc.right() = static_cast<float>(x + ci.width) / tex_size;
+					char_info.rc.bottom() = static_cast<float>(y + ci.height) / tex_size;
+					char_info.tick = tick_;
+					char_info.ch = ch;
+					char_info.index = offset;
+					if (!char_info.pending)
+					{
+						char_info.pending = true;
+						pending_slots_.push_back(slot);
+					}
+
+					this->LinkSlotToFront(slot);
+					cim.emplace(ch, slot);
+				}
+			}
+		}
 
-							uint32_t const s = char_free_list_.front().first;
-						
-							char_pos.y() = s / num_chars_a_row;
-							char_pos.x() = s - char_pos.y() * num_chars_a_row;
+		// Decodes all the chars added since the last rendering, and updates the texture in one call
+		void FlushPendingChars()
+		{
+			if (pending_slots_.empty())
+			{
+				return;
+			}
 
-							char_pos.x() *= kfont_char_size;
-							char_pos.y() *= kfont_char_size;
+			uint32_t const tex_size = dist_texture_->Width(0);
 
-							charInfo.rc.left() = static_cast<float>(char_pos.x()) / tex_size;
-							charInfo.rc.top() = static_cast<float>(char_pos.y()) / tex_size;
+			KFont const & kl = *kfont_loader_;
+			uint32_t const kfont_char_size = kl.CharSize();
+			uint32_t const num_chars_a_row = tex_size / kfont_char_size;
 
-							++ char_free_list_.front().first;
-							if (char_free_list_.front().first == char_free_list_.front().second)
-							{
-								char_free_list_.pop_front();
-							}
-						}
-						else
-						{
-							// ҵʹʱûʹõ
-
-							uint64_t min_tick = cim.begin()->second.tick;
-							auto min_chiter = cim.begin();
-							for (auto chiter = cim.begin(); chiter != cim.end(); ++ chiter)
-							{
-								if (chiter->second.tick < min_tick)
-								{
-									min_tick = chiter->second.tick;
-									min_chiter = chiter;
-								}
-							}
-
-							char_pos.x() = static_cast<int32_t>(min_chiter->second.rc.left() * tex_size);
-							char_pos.y() = static_cast<int32_t>(min_chiter->second.rc.top() * tex_size);
-							charInfo.rc.left() = min_chiter->second.rc.left();
-							charInfo.rc.top() = min_chiter->second.rc.top();
-
-							for (auto chiter = cim.begin(); chiter != cim.end(); ++ chiter)
-							{
-								if (chiter->second.tick == min_tick)
-								{
-									uint32_t const x = static_cast<int32_t>(chiter->second.rc.left() * tex_size);
-									uint32_t const y = static_cast<int32_t>(chiter->second.rc.top() * tex_size);
-									uint32_t const id = y * num_chars_a_row + x;
-									auto freeiter = char_free_list_.begin();
-									while ((freeiter != char_free_list_.end()) && (freeiter->second <= id))
-									{
-										++ freeiter;
-									}
-									char_free_list_.emplace(freeiter, id, id + 1);
-
-									cim.erase(chiter);
-									break;
-								}
-							}
-							for (auto freeiter = char_free_list_.begin(); freeiter != char_free_list_.end();)
-							{
-								auto nextiter = freeiter;
-								++ nextiter;
-
-								if (nextiter != char_free_list_.end())
-								{
-									if (freeiter->second == nextiter->first)
-									{
-										freeiter->second = nextiter->second;
-										char_free_list_.erase(nextiter);
-									}
-									else
-									{
-										++ freeiter;
-									}
-								}
-								else
-								{
-									break;
-								}
-							}
-						}
+			// The font is read in place, so each task decodes straight from it
+			uint32_t const num_pending = static_cast<uint32_t>(pending_slots_.size());
+			auto decode = [this, &kl, tex_size, kfont_char_size, num_chars_a_row](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++ i)
+				{
+					uint32_t const slot = pending_slots_[i];
+					uint32_t const x = slot % num_chars_a_row * kfont_char_size;
+					uint32_t const y = slot / num_chars_a_row * kfont_char_size;
+					kl.GetDistanceData(&dist_data_[y * tex_size + x], tex_size, char_slots_[slot].index);
+				}
+			};
 
-						charInfo.rc.right()		= charInfo.rc.left() + static_cast<float>(width) / tex_size;
-						charInfo.rc.bottom()	= charInfo.rc.top() + static_cast<float>(height) / tex_size;
-						charInfo.tick			= tick_;
+			Context::Instance().TaskSchedulerInstance().ParallelFor(0U, num_pending, PARALLEL_GLYPH_GRAIN_SIZE, decode);
 
-						kl.GetDistanceData(&a_char_data_[0], kfont_char_size, offset);
-						dist_texture_->UpdateSubresource2D(0, 0, char_pos.x(), char_pos.y(), kfont_char_size, kfont_char_size,
-							&a_char_data_[0], kfont_char_size);
+			uint32_t min_x = tex_size;
+			uint32_t min_y = tex_size;
+			uint32_t max_x = 0;
+			uint32_t max_y = 0;
+			for (auto const slot : pending_slots_)
+			{
+				uint32_t const x = slot % num_chars_a_row * kfont_char_size;
+				uint32_t const y = slot / num_chars_a_row * kfont_char_size;
+				min_x = std::min(min_x, x);
+				min_y = std::min(min_y, y);
+				max_x = std::max(max_x, x + kfont_char_size);
+				max_y = std::max(max_y, y + kfont_char_size);
+
+				char_slots_[slot].pending = false;
+			}
+			pending_slots_.clear();
 
-						cim.emplace(ch, charInfo);
-					}
-				}
+			dist_texture_->UpdateSubresource2D(0, 0, min_x, min_y, max_x - min_x, max_y - min_y,
+				&dist_data_[min_y * tex_size + min_x], tex_size);
+		}
+
+		void UnlinkSlot(uint32_t slot)
+		{
+			CharInfo& char_info = char_slots_[slot];
+			if (char_info.prev != INVALID_SLOT)
+			{
+				char_slots_[char_info.prev].next = char_info.next;
 			}
+			else
+			{
+				lru_head_ = char_info.next;
+			}
+			if (char_info.next != INVALID_SLOT)
+			{
+				char_slots_[char_info.next].prev = char_info.prev;
+			}
+			else
+			{
+				lru_tail_ = char_info.prev;
+			}
+			char_info.prev = INVALID_SLOT;
+			char_info.next = INVALID_SLOT;
+		}
+
+		void LinkSlotToFront(uint32_t slot)
+		{
+			CharInfo& char_info = char_slots_[slot];
+			char_info.prev = INVALID_SLOT;
+			char_info.next = lru_head_;
+			if (lru_head_ != INVALID_SLOT)
+			{
+				char_slots_[lru_head_].prev = slot;
+			}
+			else
+			{
+				lru_tail_ = slot;
+			}
+			lru_head_ = slot;
 		}
 
 	private:
+		static uint32_t constexpr INVALID_SLOT = 0xFFFFFFFFU;
+
+		// One per cell of the texture, the used ones are linked from the most recently used to the least
 		struct CharInfo
 		{
 			Rect rc;
-			uint64_t tick;
+			uint64_t tick = 0;
+			wchar_t ch = 0;
+			int32_t index = -1;
+			uint32_t prev = INVALID_SLOT;
+			uint32_t next = INVALID_SLOT;
+			bool pending = false;
 		};
 
 #ifdef KLAYGE_HAS_STRUCT_PACK
@@ -684,8 +753,12 @@ namespace KlayGE
 
 		bool restart_;
 
-		std::unordered_map<wchar_t, CharInfo> char_info_map_;
-		std::list<std::pair<uint32_t, uint32_t>> char_free_list_;
+		std::vector<CharInfo> char_slots_;
+		std::unordered_map<wchar_t, uint32_t> char_slot_map_;
+		std::vector<uint32_t> free_slots_;
+		uint32_t lru_head_ = INVALID_SLOT;
+		uint32_t lru_tail_ = INVALID_SLOT;
+		std::vector<uint32_t> pending_slots_;
 
 		bool three_dim_;
 
@@ -695,7 +768,8 @@ namespace KlayGE
 		std::vector<SubAlloc> tb_ib_sub_allocs_;
 
 		TexturePtr		dist_texture_;
-		std::vector<uint8_t> a_char_data_;
+		// A copy of the texture, so the pending chars go up in one update
+		std::vector<uint8_t> dist_data_;
 
 		RenderEffectParameter* half_width_height_ep_;
 		RenderEffectParameter* dpi_scale_ep_;
@@ -704,6 +778,10 @@ namespace KlayGE
 		std::shared_ptr<KFont> kfont_loader_;
 
 		uint64_t tick_;
+
+		uint64_t num_cache_hits_ = 0;
+		uint64_t num_cache_misses_ = 0;
+		uint64_t num_cache_evictions_ = 0;
 	};
 }
 
@@ -752,8 +830,16 @@ namespace
 				return;
 			}
 
-			ResIdentifierPtr kfont_input = ResLoader::Instance().Open(font_desc_.res_name);
-			font_desc_.kfont_loader->Load(kfont_input);
+			// Fonts on disk are memory mapped, the ones in packages are read through a stream
+			std::string const kfont_path = ResLoader::Instance().Locate(font_desc_.res_name);
+			if (kfont_path.empty() || !font_desc_.kfont_loader->Load(kfont_path))
+			{
+				ResIdentifierPtr kfont_input = ResLoader::Instance().Open(font_desc_.res_name);
+				if (kfont_input && !font_desc_.kfont_loader->Load(kfont_input))
+				{
+					TERRC(std::errc::illegal_byte_sequence);
+				}
+			}
 
 			RenderFactory& rf = Context::Instance().RenderFactoryInstance();
 			RenderDeviceCaps const & caps = rf.RenderEngineInstance().DeviceCaps();
@@ -785,6 +871,14 @@ namespace
 			return false;
 		}
 
+		uint64_t Hash() const override
+		{
+			size_t seed = static_cast<size_t>(this->Type());
+			HashRange(seed, font_desc_.res_name.begin(), font_desc_.res_name.end());
+			HashCombine(seed, font_desc_.flag);
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -904,6 +998,21 @@ namespace KlayGE
 		}
 	}
 
+	uint64_t Font::NumCacheHits() const
+	{
+		return font_renderable_->NumCacheHits();
+	}
+
+	uint64_t Font::NumCacheMisses() const
+	{
+		return font_renderable_->NumCacheMisses();
+	}
+
+	uint64_t Font::NumCacheEvictions() const
+	{
+		return font_renderable_->NumCacheEvictions();
+	}
+
 
 	FontPtr SyncLoadFont(std::string_view font_name, uint32_t flags)
 	{
@@ -134,6 +134,13 @@ namespace KlayGE
 			return false;
 		}
 
+		uint64_t Hash() const override
+		{
+			size_t seed = static_cast<size_t>(this->Type());
+			HashRange(seed, imposter_desc_.res_name.begin(), imposter_desc_.res_name.end());
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
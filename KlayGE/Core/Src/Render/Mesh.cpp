@@ -24,6 +24,7 @@
 #include <KFL/CXX20/span.hpp>
 #include <KFL/ErrorHandling.hpp>
 #include <KFL/Math.hpp>
+#include <KFL/SIMDMath.hpp>
 #include <KlayGE/Context.hpp>
 #include <KlayGE/RenderFactory.hpp>
 #include <KlayGE/Texture.hpp>
@@ -36,21 +37,176 @@
 #include <KlayGE/RenderMaterial.hpp>
 #include <KlayGE/DevHelper.hpp>
 #include <KFL/Hash.hpp>
+#include <KFL/TaskScheduler.hpp>
 #include <KlayGE/DeferredRenderingLayer.hpp>
 #include <KlayGE/SceneManager.hpp>
 
 #include <algorithm>
 #include <fstream>
+#include <future>
 #include <sstream>
 #include <cstring>
 
+#include <nonstd/scope.hpp>
+
 #include <KlayGE/Mesh.hpp>
 
 namespace
 {
 	using namespace KlayGE;
 
-	uint32_t const MODEL_BIN_VERSION = 19;
+	uint32_t const MODEL_BIN_VERSION = 22;
+
+	// A .model_bin has a section of everything but the vertex and index data, then one section per vertex stream,
+	// then one for the indices. Sections are compressed independently, and start at multiples of this.
+	uint32_t const MODEL_BIN_SECTION_ALIGNMENT = 64;
+	// Sections LZMA can't shrink below this fraction are stored as they are, and read straight into their buffers
+	float const MODEL_BIN_MIN_COMPRESSION_RATIO = 0.9f;
+
+	struct ModelBinSection
+	{
+		uint64_t offset;
+		uint64_t stored_len;
+		uint64_t original_len;
+	};
+
+	void ReadModelBinSection(ResIdentifier& res, ModelBinSection const & section, void* output)
+	{
+		res.seekg(static_cast<int64_t>(section.offset), std::ios_base::beg);
+		if (section.stored_len == section.original_len)
+		{
+			res.read(output, static_cast<size_t>(section.original_len));
+		}
+		else
+		{
+			std::vector<uint8_t> compressed(static_cast<size_t>(section.stored_len));
+			res.read(compressed.data(), compressed.size());
+
+			LZMACodec lzma;
+			lzma.Decode(output, compressed, section.original_len);
+		}
+	}
+
+	// Creates a buffer for each section and decodes the section straight into it. The compressed sections are read one
+	// by one, and then decoded in parallel.
+	std::vector<GraphicsBufferPtr> LoadModelBinStreams(ResIdentifier& res, std::span<ModelBinSection const> sections)
+	{
+		std::vector<GraphicsBufferPtr> buffers(sections.size());
+		std::vector<std::vector<uint8_t>> compressed(sections.size());
+		std::vector<size_t> compressed_indices;
+		for (size_t i = 0; i < sections.size(); ++ i)
+		{
+			auto const & section = sections[i];
+
+			auto buffer = MakeSharedPtr<SoftwareGraphicsBuffer>(static_cast<uint32_t>(section.original_len), false);
+			buffer->CreateHWResource(nullptr);
+			buffers[i] = buffer;
+
+			res.seekg(static_cast<int64_t>(section.offset), std::ios_base::beg);
+			if (section.stored_len == section.original_len)
+			{
+				GraphicsBuffer::Mapper mapper(*buffer, BA_Write_Only);
+				res.read(mapper.Pointer<uint8_t>(), static_cast<size_t>(section.original_len));
+			}
+			else
+			{
+				compressed[i].resize(static_cast<size_t>(section.stored_len));
+				res.read(compressed[i].data(), compressed[i].size());
+				compressed_indices.push_back(i);
+			}
+		}
+
+		auto decode = [&buffers, &compressed, &sections](size_t index)
+		{
+			GraphicsBuffer::Mapper mapper(*buffers[index], BA_Write_Only);
+			LZMACodec lzma;
+			lzma.Decode(mapper.Pointer<uint8_t>(), compressed[index], sections[index].original_len);
+			std::vector<uint8_t>().swap(compressed[index]);
+		};
+
+		if (compressed_indices.size() > 1)
+		{
+			auto& thread_pool = Context::Instance().ThreadPoolInstance();
+			std::vector<std::future<void>> joiners;
+			joiners.reserve(compressed_indices.size() - 1);
+
+			// The tasks use the locals here. Every one of them has to finish before an exception leaves the function.
+			auto on_exit = nonstd::make_scope_exit([&joiners] {
+				for (auto& joiner : joiners)
+				{
+					if (joiner.valid())
+					{
+						joiner.wait();
+					}
+				}
+			});
+
+			for (size_t i = 1; i < compressed_indices.size(); ++ i)
+			{
+				joiners.push_back(thread_pool.QueueThread([&decode, index = compressed_indices[i]] { decode(index); }));
+			}
+			decode(compressed_indices[0]);
+			for (auto& joiner : joiners)
+			{
+				joiner.get();
+			}
+		}
+		else if (!compressed_indices.empty())
+		{
+			decode(compressed_indices[0]);
+		}
+
+		return buffers;
+	}
+
+	void WriteModelBinSections(std::ostream& os, std::span<std::span<uint8_t const> const> sections)
+	{
+		// Everything is compressed first, the table in front needs the sizes
+		LZMACodec lzma;
+		std::vector<std::vector<uint8_t>> compressed(sections.size());
+		std::vector<ModelBinSection> table(sections.size());
+		uint64_t offset = static_cast<uint64_t>(os.tellp()) + sizeof(uint32_t) + table.size() * sizeof(uint64_t) * 3;
+		for (size_t i = 0; i < sections.size(); ++ i)
+		{
+			if (!sections[i].empty())
+			{
+				lzma.Encode(compressed[i], sections[i]);
+				if (compressed[i].size() >= sections[i].size() * MODEL_BIN_MIN_COMPRESSION_RATIO)
+				{
+					compressed[i].clear();
+				}
+			}
+
+			offset = (offset + MODEL_BIN_SECTION_ALIGNMENT - 1) & ~static_cast<uint64_t>(MODEL_BIN_SECTION_ALIGNMENT - 1);
+			table[i].offset = offset;
+			table[i].original_len = sections[i].size();
+			table[i].stored_len = compressed[i].empty() ? table[i].original_len : compressed[i].size();
+			offset += table[i].stored_len;
+		}
+
+		uint32_t num_sections = Native2LE(static_cast<uint32_t>(table.size()));
+		os.write(reinterpret_cast<char*>(&num_sections), sizeof(num_sections));
+		for (auto const & section : table)
+		{
+			uint64_t const fields[] = {Native2LE(section.offset), Native2LE(section.stored_len), Native2LE(section.original_len)};
+			os.write(reinterpret_cast<char const *>(fields), sizeof(fields));
+		}
+
+		for (size_t i = 0; i < sections.size(); ++ i)
+		{
+			char const padding[MODEL_BIN_SECTION_ALIGNMENT] = {};
+			os.write(padding, static_cast<std::streamsize>(table[i].offset - static_cast<uint64_t>(os.tellp())));
+
+			if (compressed[i].empty())
+			{
+				os.write(reinterpret_cast<char const *>(sections[i].data()), static_cast<std::streamsize>(sections[i].size()));
+			}
+			else
+			{
+				os.write(reinterpret_cast<char const *>(compressed[i].data()), static_cast<std::streamsize>(compressed[i].size()));
+			}
+		}
+	}
 
 	class RenderModelLoadingDesc : public ResLoadingDesc
 	{
@@ -141,6 +297,14 @@ namespace
 			return false;
 		}
 
+		uint64_t Hash() const override
+		{
+			// Models never match each other, so spread them by identity instead of piling them up under one name
+			size_t seed = static_cast<size_t>(this->Type());
+			HashCombine(seed, this);
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -340,6 +504,209 @@ namespace
 		ModelDesc model_desc_;
 		std::mutex main_thread_stage_mutex_;
 	};
+
+	size_t const PARALLEL_SKELETON_GRAIN_SIZE = 16;
+
+	// Quantizing rotations to 15 bits costs up to about 8e-5 radians, so dropping keys is never held to less than this
+	float const KEY_FRAME_MIN_TOLERANCE = 1e-4f;
+	// Limits the cost of dropping keys on long tracks
+	uint32_t const KEY_FRAME_MAX_SPAN = 256;
+
+	// Smallest 3 components in 15 bits each. The index of the largest one goes to the top bits of the first 2.
+	void EncodeRotation(uint16_t* out, Quaternion const & rot)
+	{
+		uint32_t largest = 0;
+		for (uint32_t i = 1; i < 4; ++ i)
+		{
+			if (std::abs(rot[i]) > std::abs(rot[largest]))
+			{
+				largest = i;
+			}
+		}
+
+		float const sign = (rot[largest] < 0) ? -1.0f : 1.0f;
+		uint32_t index = 0;
+		for (uint32_t i = 0; i < 4; ++ i)
+		{
+			if (i != largest)
+			{
+				float const v = std::clamp(rot[i] * sign * SQRT_2 + 0.5f, 0.0f, 1.0f);
+				out[index] = static_cast<uint16_t>(v * 32767 + 0.5f);
+				++ index;
+			}
+		}
+		out[0] |= static_cast<uint16_t>((largest & 1) << 15);
+		out[1] |= static_cast<uint16_t>((largest >> 1) << 15);
+	}
+
+	Quaternion DecodeRotation(uint16_t const * in)
+	{
+		uint32_t const largest = (in[0] >> 15) | ((in[1] >> 15) << 1);
+
+		Quaternion rot;
+		float sum_sq = 0;
+		uint32_t index = 0;
+		for (uint32_t i = 0; i < 4; ++ i)
+		{
+			if (i != largest)
+			{
+				float const v = ((in[index] & 0x7FFF) / 32767.0f - 0.5f) * SQRT2;
+				rot[i] = v;
+				sum_sq += v * v;
+				++ index;
+			}
+		}
+		rot[largest] = std::sqrt(std::max(1 - sum_sq, 0.0f));
+		return rot;
+	}
+
+	uint16_t QuantizeToUInt16(float v, float min, float step)
+	{
+		return (step > 0) ? static_cast<uint16_t>(std::clamp((v - min) / step + 0.5f, 0.0f, 65535.0f)) : 0;
+	}
+
+	// The angle between 2 rotations. Unlike the acos of the dot, it stays accurate for small angles.
+	float RotationError(Quaternion const & lhs, Quaternion const & rhs)
+	{
+		Quaternion const diff = (MathLib::dot(lhs, rhs) < 0) ? lhs + rhs : lhs - rhs;
+		return 4 * std::asin(std::min(MathLib::length(diff) / 2, 1.0f));
+	}
+
+	template <typename T>
+	void ReadArray(ResIdentifier& res, std::vector<T>& v, size_t count)
+	{
+		size_t const offset = v.size();
+		v.resize(offset + count);
+		res.read(v.data() + offset, count * sizeof(T));
+		for (size_t i = offset; i < v.size(); ++ i)
+		{
+			v[i] = LE2Native(v[i]);
+		}
+	}
+
+	template <typename T>
+	void WriteArray(std::ostream& os, T const * data, size_t count)
+	{
+		for (size_t i = 0; i < count; ++ i)
+		{
+			T const v = Native2LE(data[i]);
+			os.write(reinterpret_cast<char const *>(&v), sizeof(v));
+		}
+	}
+
+	// MathLib::sclerp with the dual quaternion products on SIMD registers. Only the screw parameters are scalar.
+	void SClerp(SIMDVectorF4& out_real, SIMDVectorF4& out_dual, SIMDVectorF4 const & lhs_real, SIMDVectorF4 const & lhs_dual,
+		SIMDVectorF4 rhs_real, SIMDVectorF4 rhs_dual, float s)
+	{
+		if (SIMDMathLib::GetX(SIMDMathLib::DotVector4(lhs_real, rhs_real)) < 0)
+		{
+			rhs_real = -rhs_real;
+			rhs_dual = -rhs_dual;
+		}
+
+		float const sqr_len_0 = SIMDMathLib::GetX(SIMDMathLib::DotVector4(lhs_real, lhs_real));
+		float const sqr_len_e = 2.0f * SIMDMathLib::GetX(SIMDMathLib::DotVector4(lhs_real, lhs_dual));
+		float const inv_sqr_len_0 = 1.0f / sqr_len_0;
+		float const inv_sqr_len_e = -sqr_len_e / (sqr_len_0 * sqr_len_0);
+		SIMDVectorF4 const conj_sign = SIMDMathLib::SetVector(-1, -1, -1, 1);
+		SIMDVectorF4 const conj_real = lhs_real * conj_sign;
+		SIMDVectorF4 const inv_real = conj_real * inv_sqr_len_0;
+		SIMDVectorF4 const inv_dual = lhs_dual * conj_sign * inv_sqr_len_0 + conj_real * inv_sqr_len_e;
+
+		Quaternion dif_real;
+		Quaternion dif_dual;
+		SIMDMathLib::StoreQuaternion(dif_real, SIMDMathLib::MultiplyQuat(inv_real, rhs_real));
+		SIMDMathLib::StoreQuaternion(dif_dual,
+			SIMDMathLib::MultiplyQuat(inv_real, rhs_dual) + SIMDMathLib::MultiplyQuat(inv_dual, rhs_real));
+
+		float angle, pitch;
+		float3 direction, moment;
+		MathLib::udq_to_screw(angle, pitch, direction, moment, dif_real, dif_dual);
+		auto const screw = MathLib::udq_from_screw(angle * s, pitch * s, direction, moment);
+		SIMDVectorF4 const screw_real = SIMDMathLib::LoadQuaternion(screw.first);
+		SIMDVectorF4 const screw_dual = SIMDMathLib::LoadQuaternion(screw.second);
+
+		out_real = SIMDMathLib::MultiplyQuat(lhs_real, screw_real);
+		out_dual = SIMDMathLib::MultiplyQuat(lhs_real, screw_dual) + SIMDMathLib::MultiplyQuat(lhs_dual, screw_real);
+	}
+
+	// Composes 2 scaled dual quaternions through matrices. The dual quaternion product can't represent negative scales.
+	float ComposeWithMatrix(Quaternion& real, Quaternion& dual, float& scale, Quaternion const & lhs_real, Quaternion const & lhs_dual,
+		float lhs_scale, Quaternion const & rhs_real, Quaternion const & rhs_dual, float rhs_scale)
+	{
+		float4x4 tmp_mat = MathLib::scaling(MathLib::abs(lhs_scale), MathLib::abs(lhs_scale), lhs_scale)
+			* MathLib::to_matrix(lhs_real)
+			* MathLib::translation(MathLib::udq_to_trans(lhs_real, lhs_dual))
+			* MathLib::scaling(MathLib::abs(rhs_scale), MathLib::abs(rhs_scale), rhs_scale)
+			* MathLib::to_matrix(rhs_real)
+			* MathLib::translation(MathLib::udq_to_trans(rhs_real, rhs_dual));
+
+		float flip = 1;
+		if (MathLib::dot(MathLib::cross(float3(tmp_mat(0, 0), tmp_mat(0, 1), tmp_mat(0, 2)),
+			float3(tmp_mat(1, 0), tmp_mat(1, 1), tmp_mat(1, 2))),
+			float3(tmp_mat(2, 0), tmp_mat(2, 1), tmp_mat(2, 2))) < 0)
+		{
+			tmp_mat(2, 0) = -tmp_mat(2, 0);
+			tmp_mat(2, 1) = -tmp_mat(2, 1);
+			tmp_mat(2, 2) = -tmp_mat(2, 2);
+
+			flip = -1;
+		}
+
+		float3 scaling;
+		float3 trans;
+		MathLib::decompose(scaling, real, trans, tmp_mat);
+		dual = MathLib::quat_trans_to_udq(real, trans);
+		scale = scaling.x();
+
+		return flip;
+	}
+
+	// The joint transform that goes to the shader, the inverse origin followed by the bind pose, with the scale folded into the real part
+	void SkinningDualQuat(float4& out_real, float4& out_dual, JointComponent const & joint, SIMDVectorF4 const & bind_real,
+		SIMDVectorF4 const & bind_dual, float bind_scale)
+	{
+		SIMDVectorF4 real;
+		SIMDVectorF4 dual;
+		float scale;
+		if ((MathLib::SignBit(joint.InverseOriginScale()) > 0) && (MathLib::SignBit(bind_scale) > 0))
+		{
+			SIMDVectorF4 const inv_origin_real = SIMDMathLib::LoadQuaternion(joint.InverseOriginReal());
+			SIMDVectorF4 const inv_origin_dual = SIMDMathLib::LoadQuaternion(joint.InverseOriginDual());
+			real = SIMDMathLib::MultiplyQuat(inv_origin_real, bind_real);
+			dual = SIMDMathLib::MultiplyQuat(inv_origin_real, bind_dual) + SIMDMathLib::MultiplyQuat(inv_origin_dual, bind_real);
+			scale = joint.InverseOriginScale() * bind_scale;
+
+			if (MathLib::SignBit(SIMDMathLib::GetW(real)) < 0)
+			{
+				real = -real;
+				dual = -dual;
+			}
+		}
+		else
+		{
+			Quaternion q_bind_real;
+			Quaternion q_bind_dual;
+			SIMDMathLib::StoreQuaternion(q_bind_real, bind_real);
+			SIMDMathLib::StoreQuaternion(q_bind_dual, bind_dual);
+
+			Quaternion q_real;
+			Quaternion q_dual;
+			float const flip = ComposeWithMatrix(q_real, q_dual, scale, joint.InverseOriginReal(), joint.InverseOriginDual(),
+				joint.InverseOriginScale(), q_bind_real, q_bind_dual, bind_scale);
+			real = SIMDMathLib::LoadQuaternion(q_real);
+			dual = SIMDMathLib::LoadQuaternion(q_dual);
+
+			if (flip * MathLib::SignBit(q_real.w()) < 0)
+			{
+				real = -real;
+				dual = -dual;
+			}
+		}
+
+		SIMDMathLib::StoreVector4(out_real, real * scale);
+		SIMDMathLib::StoreVector4(out_dual, dual);
+	}
 }
 
 namespace KlayGE
@@ -475,6 +842,7 @@ namespace KlayGE
 					mesh.NumIndices(lod, src_mesh.NumIndices(lod));
 					mesh.StartVertexLocation(lod, src_mesh.StartVertexLocation(lod));
 					mesh.StartIndexLocation(lod, src_mesh.StartIndexLocation(lod));
+					mesh.LodError(lod, src_mesh.LodError(lod));
 				}
 			}
 
@@ -673,6 +1041,289 @@ namespace KlayGE
 	}
 
 
+	AnimationClip::AnimationClip() = default;
+
+	AnimationClip::AnimationClip(std::span<KeyFrameSet const> kfs, float tolerance)
+	{
+		tolerance = std::max(tolerance, KEY_FRAME_MIN_TOLERANCE);
+
+		tracks.resize(kfs.size());
+		for (size_t joint = 0; joint < kfs.size(); ++ joint)
+		{
+			auto const & kf = kfs[joint];
+			auto& track = tracks[joint];
+			uint32_t const num_src_keys = static_cast<uint32_t>(kf.frame_id.size());
+
+			track.flags = TF_ConstantRotation | TF_ConstantTranslation | TF_ConstantScale;
+			track.num_keys = 0;
+			track.translation_min = float3(0, 0, 0);
+			track.translation_step = float3(0, 0, 0);
+			track.scale_min = 1;
+			track.scale_step = 0;
+			if (num_src_keys == 0)
+			{
+				continue;
+			}
+
+			std::vector<float3> src_trans(num_src_keys);
+			float3 trans_min = MathLib::udq_to_trans(kf.bind_real[0], kf.bind_dual[0]);
+			float3 trans_max = trans_min;
+			float scale_min = kf.bind_scale[0];
+			float scale_max = scale_min;
+			for (uint32_t k = 0; k < num_src_keys; ++ k)
+			{
+				src_trans[k] = MathLib::udq_to_trans(kf.bind_real[k], kf.bind_dual[k]);
+				trans_min = MathLib::minimize(trans_min, src_trans[k]);
+				trans_max = MathLib::maximize(trans_max, src_trans[k]);
+				scale_min = std::min(scale_min, kf.bind_scale[k]);
+				scale_max = std::max(scale_max, kf.bind_scale[k]);
+
+				if (RotationError(kf.bind_real[k], kf.bind_real[0]) > tolerance)
+				{
+					track.flags &= ~TF_ConstantRotation;
+				}
+			}
+
+			// A constant channel keeps the middle of its range, which is within tolerance / 2 of every key
+			float3 const trans_extent = trans_max - trans_min;
+			if (std::max({trans_extent.x(), trans_extent.y(), trans_extent.z()}) > tolerance)
+			{
+				track.flags &= ~TF_ConstantTranslation;
+				track.translation_min = trans_min;
+				track.translation_step = trans_extent / 65535.0f;
+			}
+			else
+			{
+				track.translation_min = (trans_min + trans_max) / 2;
+			}
+			if (scale_max - scale_min > tolerance)
+			{
+				track.flags &= ~TF_ConstantScale;
+				track.scale_min = scale_min;
+				track.scale_step = (scale_max - scale_min) / 65535.0f;
+			}
+			else
+			{
+				track.scale_min = (scale_min + scale_max) / 2;
+			}
+
+			// Quantizes every key first, so that dropping keys accounts for the quantization error
+			std::vector<uint16_t> q_rotations(num_src_keys * 3);
+			std::vector<uint16_t> q_translations(num_src_keys * 3);
+			std::vector<uint16_t> q_scales(num_src_keys);
+			std::vector<Quaternion> dec_reals(num_src_keys);
+			std::vector<Quaternion> dec_duals(num_src_keys);
+			std::vector<float> dec_scales(num_src_keys);
+			for (uint32_t k = 0; k < num_src_keys; ++ k)
+			{
+				EncodeRotation(&q_rotations[k * 3], kf.bind_real[(track.flags & TF_ConstantRotation) ? 0 : k]);
+				dec_reals[k] = DecodeRotation(&q_rotations[k * 3]);
+
+				float3 trans = track.translation_min;
+				for (uint32_t i = 0; i < 3; ++ i)
+				{
+					q_translations[k * 3 + i] = QuantizeToUInt16(src_trans[k][i], track.translation_min[i], track.translation_step[i]);
+					trans[i] += q_translations[k * 3 + i] * track.translation_step[i];
+				}
+				dec_duals[k] = MathLib::quat_trans_to_udq(dec_reals[k], trans);
+
+				q_scales[k] = QuantizeToUInt16(kf.bind_scale[k], track.scale_min, track.scale_step);
+				dec_scales[k] = track.scale_min + q_scales[k] * track.scale_step;
+			}
+
+			auto can_interpolate = [&](uint32_t key0, uint32_t key1)
+			{
+				for (uint32_t k = key0 + 1; k < key1; ++ k)
+				{
+					float const factor = static_cast<float>(kf.frame_id[k] - kf.frame_id[key0]) / (kf.frame_id[key1] - kf.frame_id[key0]);
+					auto const dq = MathLib::sclerp(dec_reals[key0], dec_duals[key0], dec_reals[key1], dec_duals[key1], factor);
+					float const scale = MathLib::lerp(dec_scales[key0], dec_scales[key1], factor);
+					if ((RotationError(dq.first, kf.bind_real[k]) > tolerance)
+						|| (MathLib::length(MathLib::udq_to_trans(dq.first, dq.second) - src_trans[k]) > tolerance)
+						|| (std::abs(scale - kf.bind_scale[k]) > tolerance))
+					{
+						return false;
+					}
+				}
+				return true;
+			};
+
+			// The first and last keys are always kept, they decide the loop length
+			std::vector<uint32_t> kept_keys(1, 0);
+			if ((track.flags & (TF_ConstantRotation | TF_ConstantTranslation | TF_ConstantScale))
+				!= (TF_ConstantRotation | TF_ConstantTranslation | TF_ConstantScale))
+			{
+				uint32_t anchor = 0;
+				for (uint32_t k = 2; k < num_src_keys; ++ k)
+				{
+					if ((k - anchor > KEY_FRAME_MAX_SPAN) || !can_interpolate(anchor, k))
+					{
+						anchor = k - 1;
+						kept_keys.push_back(anchor);
+					}
+				}
+				if (num_src_keys > 1)
+				{
+					kept_keys.push_back(num_src_keys - 1);
+				}
+			}
+
+			track.num_keys = static_cast<uint32_t>(kept_keys.size());
+			for (uint32_t k : kept_keys)
+			{
+				frame_id.push_back(kf.frame_id[k]);
+				if (!(track.flags & TF_ConstantRotation) || (k == 0))
+				{
+					rotations.insert(rotations.end(), &q_rotations[k * 3], &q_rotations[k * 3] + 3);
+				}
+				if (!(track.flags & TF_ConstantTranslation))
+				{
+					translations.insert(translations.end(), &q_translations[k * 3], &q_translations[k * 3] + 3);
+				}
+				if (!(track.flags & TF_ConstantScale))
+				{
+					scales.push_back(q_scales[k]);
+				}
+			}
+		}
+
+		this->UpdateOffsets();
+	}
+
+	void AnimationClip::UpdateOffsets()
+	{
+		uint32_t key = 0;
+		uint32_t rotation = 0;
+		uint32_t translation = 0;
+		uint32_t scale = 0;
+		for (auto& track : tracks)
+		{
+			track.first_key = key;
+			track.first_rotation = rotation;
+			track.first_translation = translation;
+			track.first_scale = scale;
+
+			key += track.num_keys;
+			rotation += ((track.flags & TF_ConstantRotation) ? std::min(track.num_keys, 1U) : track.num_keys) * 3;
+			translation += (track.flags & TF_ConstantTranslation) ? 0 : track.num_keys * 3;
+			scale += (track.flags & TF_ConstantScale) ? 0 : track.num_keys;
+		}
+	}
+
+	KeyFrameSet AnimationClip::Decompress(uint32_t joint) const
+	{
+		auto const & track = tracks[joint];
+
+		KeyFrameSet kf;
+		kf.frame_id.assign(frame_id.begin() + track.first_key, frame_id.begin() + track.first_key + track.num_keys);
+		kf.bind_real.resize(track.num_keys);
+		kf.bind_dual.resize(track.num_keys);
+		kf.bind_scale.resize(track.num_keys);
+		for (uint32_t k = 0; k < track.num_keys; ++ k)
+		{
+			this->DecodeKey(joint, k, kf.bind_real[k], kf.bind_dual[k], kf.bind_scale[k]);
+		}
+		return kf;
+	}
+
+	void AnimationClip::DecodeKey(uint32_t joint, uint32_t key, Quaternion& real, Quaternion& dual, float& scale) const
+	{
+		auto const & track = tracks[joint];
+
+		real = DecodeRotation(&rotations[track.first_rotation + ((track.flags & TF_ConstantRotation) ? 0 : key * 3)]);
+
+		float3 trans = track.translation_min;
+		if (!(track.flags & TF_ConstantTranslation))
+		{
+			uint16_t const * q_trans = &translations[track.first_translation + key * 3];
+			trans += float3(q_trans[0], q_trans[1], q_trans[2]) * track.translation_step;
+		}
+		dual = MathLib::quat_trans_to_udq(real, trans);
+
+		scale = track.scale_min;
+		if (!(track.flags & TF_ConstantScale))
+		{
+			scale += scales[track.first_scale + key] * track.scale_step;
+		}
+	}
+
+	void AnimationClip::LocateKeys(uint32_t joint, float frame, uint32_t& cursor, uint32_t& key0, uint32_t& key1, float& factor) const
+	{
+		auto const & track = tracks[joint];
+		uint32_t const num_keys = track.num_keys;
+		if (num_keys <= 1)
+		{
+			key0 = 0;
+			key1 = 0;
+			factor = 0;
+			return;
+		}
+
+		auto const ids_begin = frame_id.begin() + track.first_key;
+		auto const ids_end = ids_begin + num_keys;
+
+		frame = std::fmod(frame, static_cast<float>(ids_begin[num_keys - 1] + 1));
+
+		// Same result as an upper_bound, but starts from the cursor
+		uint32_t index = std::clamp(cursor, 1U, num_keys);
+		if (ids_begin[index - 1] <= frame)
+		{
+			uint32_t steps = 0;
+			while ((index < num_keys) && (ids_begin[index] <= frame) && (steps < 4))
+			{
+				++ index;
+				++ steps;
+			}
+			if ((index < num_keys) && (ids_begin[index] <= frame))
+			{
+				index = static_cast<uint32_t>(std::upper_bound(ids_begin + index, ids_end, frame) - ids_begin);
+			}
+		}
+		else
+		{
+			index = static_cast<uint32_t>(std::upper_bound(ids_begin, ids_begin + index, frame) - ids_begin);
+		}
+		cursor = index;
+
+		key0 = index - 1;
+		key1 = index % num_keys;
+		int const frame0 = ids_begin[key0];
+		int const frame1 = ids_begin[key1];
+		factor = (frame - frame0) / (frame1 - frame0);
+	}
+
+	std::tuple<Quaternion, Quaternion, float> AnimationClip::Frame(uint32_t joint, float frame, uint32_t& cursor) const
+	{
+		uint32_t const num_keys = tracks[joint].num_keys;
+		if (num_keys == 0)
+		{
+			return std::make_tuple(Quaternion::Identity(), Quaternion(0, 0, 0, 0), 1.0f);
+		}
+
+		uint32_t key0, key1;
+		float factor;
+		this->LocateKeys(joint, frame, cursor, key0, key1, factor);
+
+		Quaternion real0, dual0, real1, dual1;
+		float scale0, scale1;
+		this->DecodeKey(joint, key0, real0, dual0, scale0);
+		if (key1 == key0)
+		{
+			return std::make_tuple(real0, dual0, scale0);
+		}
+
+		this->DecodeKey(joint, key1, real1, dual1, scale1);
+		auto const dq = MathLib::sclerp(real0, dual0, real1, dual1, factor);
+		return std::make_tuple(dq.first, dq.second, MathLib::lerp(scale0, scale1, factor));
+	}
+
+	size_t AnimationClip::CompressedSize() const
+	{
+		return tracks.size() * sizeof(Track) + frame_id.size() * sizeof(frame_id[0])
+			+ (rotations.size() + translations.size() + scales.size()) * sizeof(uint16_t);
+	}
+
+
 	SceneComponentPtr JointComponent::Clone() const
 	{
 		auto ret = MakeSharedPtr<JointComponent>();
@@ -723,142 +1374,190 @@ namespace KlayGE
 
 	void SkinnedModel::BuildBones(float frame)
 	{
-		for (size_t i = 0; i < joints_.size(); ++ i)
+		this->EvaluateBones(frame);
+		this->SetToEffect();
+	}
+
+	void SkinnedModel::EvaluateBones(float frame)
+	{
+		if (flat_joints_.size() != joints_.size())
 		{
-			auto& joint = *joints_[i];
-			KeyFrameSet const & kf = (*key_frame_sets_)[i];
+			this->BuildFlatJoints();
+		}
 
-			std::tuple<Quaternion, Quaternion, float> key_dq = kf.Frame(frame);
+		auto const & clip = *animation_clip_;
 
-			bool is_root = false;
-			auto* parent_node = joint.BoundSceneNode()->Parent();
-			if (parent_node)
+		bind_reals_.resize(joints_.size());
+		bind_duals_.resize(joints_.size());
+		for (auto& flat_joint : flat_joints_)
+		{
+			auto& joint = *joints_[flat_joint.joint_index];
+			uint32_t const num_keys = clip.tracks[flat_joint.joint_index].num_keys;
+
+			SIMDVectorF4 key_real;
+			SIMDVectorF4 key_dual;
+			float key_scale;
+			if (num_keys == 0)
+			{
+				key_real = SIMDMathLib::SetVector(0, 0, 0, 1);
+				key_dual = SIMDVectorF4::Zero();
+				key_scale = 1;
+			}
+			else
 			{
-				auto* parent_joint = parent_node->FirstComponentOfType<JointComponent>();
-				if (parent_joint == nullptr)
+				uint32_t key0, key1;
+				float factor;
+				clip.LocateKeys(flat_joint.joint_index, frame, flat_joint.key_frame_cursor, key0, key1, factor);
+				if (flat_joint.cached_key != key0)
+				{
+					uint32_t const keys[] = {key0, key1};
+					for (uint32_t i = 0; i < std::min(num_keys, 2U); ++ i)
+					{
+						Quaternion real, dual;
+						clip.DecodeKey(flat_joint.joint_index, keys[i], real, dual, flat_joint.key_scales[i]);
+						flat_joint.key_reals[i] = SIMDMathLib::LoadQuaternion(real);
+						flat_joint.key_duals[i] = SIMDMathLib::LoadQuaternion(dual);
+					}
+					flat_joint.cached_key = key0;
+				}
+
+				if (num_keys == 1)
+				{
+					key_real = flat_joint.key_reals[0];
+					key_dual = flat_joint.key_duals[0];
+					key_scale = flat_joint.key_scales[0];
+				}
+				else
 				{
-					is_root = true;
+					SClerp(key_real, key_dual, flat_joint.key_reals[0], flat_joint.key_duals[0], flat_joint.key_reals[1],
+						flat_joint.key_duals[1], factor);
+					key_scale = MathLib::lerp(flat_joint.key_scales[0], flat_joint.key_scales[1], factor);
 				}
 			}
 
-			if (is_root)
+			if (flat_joint.parent < 0)
 			{
-				joint.BindParams(std::get<0>(key_dq), std::get<1>(key_dq), std::get<2>(key_dq));
+				flat_joint.bind_real = key_real;
+				flat_joint.bind_dual = key_dual;
+				flat_joint.bind_scale = key_scale;
 			}
 			else
 			{
-				auto const& parent = *parent_node->FirstComponentOfType<JointComponent>();
+				auto const & parent = flat_joints_[flat_joint.parent];
 
-				if (MathLib::dot(std::get<0>(key_dq), parent.BindReal()) < 0)
+				if (SIMDMathLib::GetX(SIMDMathLib::DotVector4(key_real, parent.bind_real)) < 0)
 				{
-					std::get<0>(key_dq) = -std::get<0>(key_dq);
-					std::get<1>(key_dq) = -std::get<1>(key_dq);
+					key_real = -key_real;
+					key_dual = -key_dual;
 				}
 
-				if ((MathLib::SignBit(std::get<2>(key_dq)) > 0) && (MathLib::SignBit(parent.BindScale()) > 0))
+				if ((MathLib::SignBit(key_scale) > 0) && (MathLib::SignBit(parent.bind_scale) > 0))
 				{
-					joint.BindParams(MathLib::mul_real(std::get<0>(key_dq), parent.BindReal()),
-						MathLib::mul_dual(
-							std::get<0>(key_dq), std::get<1>(key_dq) * parent.BindScale(), parent.BindReal(), parent.BindDual()),
-						std::get<2>(key_dq) * parent.BindScale());
+					flat_joint.bind_real = SIMDMathLib::MultiplyQuat(key_real, parent.bind_real);
+					flat_joint.bind_dual = SIMDMathLib::MultiplyQuat(key_real, parent.bind_dual)
+						+ SIMDMathLib::MultiplyQuat(key_dual * parent.bind_scale, parent.bind_real);
+					flat_joint.bind_scale = key_scale * parent.bind_scale;
 				}
 				else
 				{
-					float const key_scale = std::get<2>(key_dq);
-					float4x4 tmp_mat = MathLib::scaling(MathLib::abs(key_scale), MathLib::abs(key_scale), key_scale)
-						* MathLib::to_matrix(std::get<0>(key_dq))
-						* MathLib::translation(MathLib::udq_to_trans(std::get<0>(key_dq), std::get<1>(key_dq)))
-						* MathLib::scaling(MathLib::abs(parent.BindScale()), MathLib::abs(parent.BindScale()), parent.BindScale())
-						* MathLib::to_matrix(parent.BindReal())
-						* MathLib::translation(MathLib::udq_to_trans(parent.BindReal(), parent.BindDual()));
-
-					float flip = 1;
-					if (MathLib::dot(MathLib::cross(float3(tmp_mat(0, 0), tmp_mat(0, 1), tmp_mat(0, 2)),
-						float3(tmp_mat(1, 0), tmp_mat(1, 1), tmp_mat(1, 2))),
-						float3(tmp_mat(2, 0), tmp_mat(2, 1), tmp_mat(2, 2))) < 0)
-					{
-						tmp_mat(2, 0) = -tmp_mat(2, 0);
-						tmp_mat(2, 1) = -tmp_mat(2, 1);
-						tmp_mat(2, 2) = -tmp_mat(2, 2);
-
-						flip = -1;
-					}
-
-					float3 scale;
-					Quaternion rot;
-					float3 trans;
-					MathLib::decompose(scale, rot, trans, tmp_mat);
-
-					joint.BindParams(rot, MathLib::quat_trans_to_udq(rot, trans), flip * scale.x());
+					Quaternion q_key_real, q_key_dual, q_parent_real, q_parent_dual;
+					SIMDMathLib::StoreQuaternion(q_key_real, key_real);
+					SIMDMathLib::StoreQuaternion(q_key_dual, key_dual);
+					SIMDMathLib::StoreQuaternion(q_parent_real, parent.bind_real);
+					SIMDMathLib::StoreQuaternion(q_parent_dual, parent.bind_dual);
+
+					Quaternion rot, dual;
+					float scale;
+					float const flip = ComposeWithMatrix(rot, dual, scale, q_key_real, q_key_dual, key_scale, q_parent_real,
+						q_parent_dual, parent.bind_scale);
+					flat_joint.bind_real = SIMDMathLib::LoadQuaternion(rot);
+					flat_joint.bind_dual = SIMDMathLib::LoadQuaternion(dual);
+					flat_joint.bind_scale = flip * scale;
 				}
 			}
-		}
 
-		this->UpdateBinds();
+			Quaternion bind_real, bind_dual;
+			SIMDMathLib::StoreQuaternion(bind_real, flat_joint.bind_real);
+			SIMDMathLib::StoreQuaternion(bind_dual, flat_joint.bind_dual);
+			joint.BindParams(bind_real, bind_dual, flat_joint.bind_scale);
+
+			SkinningDualQuat(bind_reals_[flat_joint.joint_index], bind_duals_[flat_joint.joint_index], joint, flat_joint.bind_real,
+				flat_joint.bind_dual, flat_joint.bind_scale);
+		}
 	}
 
-	void SkinnedModel::UpdateBinds()
+	void SkinnedModel::BuildFlatJoints()
 	{
-		bind_reals_.resize(joints_.size());
-		bind_duals_.resize(joints_.size());
-		for (size_t i = 0; i < joints_.size(); ++i)
-		{
-			auto const& joint = *joints_[i];
+		uint32_t const num_joints = static_cast<uint32_t>(joints_.size());
 
-			Quaternion bind_real, bind_dual;
-			float bind_scale;
-			if ((MathLib::SignBit(joint.InverseOriginScale()) > 0) && (MathLib::SignBit(joint.BindScale()) > 0))
+		std::vector<int32_t> parents(num_joints, -1);
+		for (uint32_t i = 0; i < num_joints; ++ i)
+		{
+			auto const * node = joints_[i]->BoundSceneNode();
+			auto const * parent_node = node ? node->Parent() : nullptr;
+			auto const * parent_joint = parent_node ? parent_node->FirstComponentOfType<JointComponent>() : nullptr;
+			if (parent_joint != nullptr)
 			{
-				bind_real = MathLib::mul_real(joint.InverseOriginReal(), joint.BindReal());
-				bind_dual = MathLib::mul_dual(joint.InverseOriginReal(), joint.InverseOriginDual(),
-					joint.BindReal(), joint.BindDual());
-				bind_scale = joint.InverseOriginScale() * joint.BindScale();
-
-				if (MathLib::SignBit(bind_real.w()) < 0)
+				for (uint32_t j = 0; j < num_joints; ++ j)
 				{
-					bind_real = -bind_real;
-					bind_dual = -bind_dual;
+					if (joints_[j].get() == parent_joint)
+					{
+						parents[i] = static_cast<int32_t>(j);
+						break;
+					}
 				}
 			}
-			else
+		}
+
+		std::vector<uint32_t> depths(num_joints);
+		for (uint32_t i = 0; i < num_joints; ++ i)
+		{
+			uint32_t depth = 0;
+			for (int32_t parent = parents[i]; (parent >= 0) && (depth < num_joints); parent = parents[parent])
 			{
-				float4x4 tmp_mat = MathLib::scaling(MathLib::abs(joint.InverseOriginScale()), MathLib::abs(joint.InverseOriginScale()), joint.InverseOriginScale())
-					* MathLib::to_matrix(joint.InverseOriginReal())
-					* MathLib::translation(MathLib::udq_to_trans(joint.InverseOriginReal(), joint.InverseOriginDual()))
-					* MathLib::scaling(MathLib::abs(joint.BindScale()), MathLib::abs(joint.BindScale()), joint.BindScale())
-					* MathLib::to_matrix(joint.BindReal())
-					* MathLib::translation(MathLib::udq_to_trans(joint.BindReal(), joint.BindDual()));
-
-				float flip = 1;
-				if (MathLib::dot(MathLib::cross(float3(tmp_mat(0, 0), tmp_mat(0, 1), tmp_mat(0, 2)),
-					float3(tmp_mat(1, 0), tmp_mat(1, 1), tmp_mat(1, 2))),
-					float3(tmp_mat(2, 0), tmp_mat(2, 1), tmp_mat(2, 2))) < 0)
-				{
-					tmp_mat(2, 0) = -tmp_mat(2, 0);
-					tmp_mat(2, 1) = -tmp_mat(2, 1);
-					tmp_mat(2, 2) = -tmp_mat(2, 2);
+				++ depth;
+			}
+			depths[i] = depth;
+		}
 
-					flip = -1;
-				}
+		std::vector<uint32_t> order(num_joints);
+		for (uint32_t i = 0; i < num_joints; ++ i)
+		{
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [&depths](uint32_t lhs, uint32_t rhs) { return depths[lhs] < depths[rhs]; });
 
-				float3 scale;
-				Quaternion rot;
-				float3 trans;
-				MathLib::decompose(scale, rot, trans, tmp_mat);
+		std::vector<int32_t> flat_indices(num_joints);
+		for (uint32_t i = 0; i < num_joints; ++ i)
+		{
+			flat_indices[order[i]] = static_cast<int32_t>(i);
+		}
 
-				bind_real = rot;
-				bind_dual = MathLib::quat_trans_to_udq(rot, trans);
-				bind_scale = scale.x();
+		flat_joints_.resize(num_joints);
+		for (uint32_t i = 0; i < num_joints; ++ i)
+		{
+			auto& flat_joint = flat_joints_[i];
+			auto const & joint = *joints_[order[i]];
 
-				if (flip * MathLib::SignBit(bind_real.w()) < 0)
-				{
-					bind_real = -bind_real;
-					bind_dual = -bind_dual;
-				}
-			}
+			flat_joint.bind_real = SIMDMathLib::LoadQuaternion(joint.BindReal());
+			flat_joint.bind_dual = SIMDMathLib::LoadQuaternion(joint.BindDual());
+			flat_joint.bind_scale = joint.BindScale();
+			flat_joint.joint_index = order[i];
+			flat_joint.parent = (parents[order[i]] >= 0) ? flat_indices[parents[order[i]]] : -1;
+			flat_joint.key_frame_cursor = 0;
+			flat_joint.cached_key = ~0U;
+		}
+	}
 
-			bind_reals_[i] = float4(bind_real.x(), bind_real.y(), bind_real.z(), bind_real.w()) * bind_scale;
-			bind_duals_[i] = float4(bind_dual.x(), bind_dual.y(), bind_dual.z(), bind_dual.w());
+	void SkinnedModel::UpdateBinds()
+	{
+		bind_reals_.resize(joints_.size());
+		bind_duals_.resize(joints_.size());
+		for (size_t i = 0; i < joints_.size(); ++i)
+		{
+			auto const& joint = *joints_[i];
+			SkinningDualQuat(bind_reals_[i], bind_duals_[i], joint, SIMDMathLib::LoadQuaternion(joint.BindReal()),
+				SIMDMathLib::LoadQuaternion(joint.BindDual()), joint.BindScale());
 		}
 
 		this->SetToEffect();
@@ -879,6 +1578,68 @@ namespace KlayGE
 		}
 	}
 
+	void SkinnedModel::SetFrames(std::span<SkinnedModel* const> models, std::span<float const> frames)
+	{
+		BOOST_ASSERT(models.size() == frames.size());
+
+		std::vector<SkinnedModel*> dirty_models;
+		dirty_models.reserve(models.size());
+		for (size_t i = 0; i < models.size(); ++ i)
+		{
+			auto& model = *models[i];
+			if (model.last_frame_ != frames[i])
+			{
+				model.last_frame_ = frames[i];
+				dirty_models.push_back(&model);
+			}
+		}
+
+		// Models don't share any mutable state, so each task evaluates a contiguous range of them
+		auto evaluate = [&dirty_models](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++ i)
+			{
+				dirty_models[i]->EvaluateBones(dirty_models[i]->last_frame_);
+			}
+		};
+
+		Context::Instance().TaskSchedulerInstance().ParallelFor(size_t(0), dirty_models.size(), PARALLEL_SKELETON_GRAIN_SIZE, evaluate);
+
+		// Effects are shared between models, so the parameters are set on this thread
+		for (auto* model : dirty_models)
+		{
+			model->SetToEffect();
+		}
+	}
+
+	void SkinnedModel::AttachKeyFrameSets(std::shared_ptr<std::vector<KeyFrameSet>> const & kf)
+	{
+		animation_clip_ = kf ? MakeSharedPtr<AnimationClip>(*kf, 0.0f) : nullptr;
+		key_frame_sets_ = kf;
+		flat_joints_.clear();
+	}
+
+	std::shared_ptr<std::vector<KeyFrameSet>> const & SkinnedModel::GetKeyFrameSets() const
+	{
+		if (!key_frame_sets_ && animation_clip_)
+		{
+			auto kfs = MakeSharedPtr<std::vector<KeyFrameSet>>(animation_clip_->tracks.size());
+			for (uint32_t i = 0; i < kfs->size(); ++ i)
+			{
+				(*kfs)[i] = animation_clip_->Decompress(i);
+			}
+			key_frame_sets_ = kfs;
+		}
+		return key_frame_sets_;
+	}
+
+	void SkinnedModel::AttachAnimationClip(std::shared_ptr<AnimationClip const> const & clip)
+	{
+		animation_clip_ = clip;
+		key_frame_sets_.reset();
+		flat_joints_.clear();
+	}
+
 	void SkinnedModel::RebindJoints()
 	{
 		this->BuildBones(last_frame_);
@@ -969,7 +1730,7 @@ namespace KlayGE
 				joints[i] = checked_pointer_cast<JointComponent>(src_skinned_model.GetJoint(i)->Clone());
 			}
 			skinned_model.AssignJoints(joints.begin(), joints.end());
-			skinned_model.AttachKeyFrameSets(src_skinned_model.GetKeyFrameSets());
+			skinned_model.AttachAnimationClip(src_skinned_model.GetAnimationClip());
 
 			auto& root_node = *skinned_model.RootNode();
 			for (uint32_t i = 0; i < root_node.NumComponents(); ++i)
@@ -1134,8 +1895,8 @@ namespace KlayGE
 		std::vector<RenderMaterialPtr> mtls;
 		std::vector<VertexElement> merged_ves;
 		char all_is_index_16_bit;
-		std::vector<std::vector<uint8_t>> merged_buff;
-		std::vector<uint8_t> merged_indices;
+		std::vector<GraphicsBufferPtr> merged_vbs;
+		GraphicsBufferPtr merged_ib;
 		std::vector<std::string> mesh_names;
 		std::vector<int32_t> mtl_ids;
 		std::vector<uint32_t> mesh_lods;
@@ -1145,10 +1906,11 @@ namespace KlayGE
 		std::vector<uint32_t> mesh_base_vertices;
 		std::vector<uint32_t> mesh_num_indices;
 		std::vector<uint32_t> mesh_start_indices;
+		std::vector<float> mesh_lod_errors;
 		std::vector<NodeInfo> nodes;
 		std::vector<JointComponentPtr> joints;
 		std::shared_ptr<std::vector<Animation>> animations;
-		std::shared_ptr<std::vector<KeyFrameSet>> kfs;
+		std::shared_ptr<AnimationClip> clip;
 		uint32_t num_frames = 0;
 		uint32_t frame_rate = 0;
 		std::vector<std::shared_ptr<AABBKeyFrameSet>> frame_pos_bbs;
@@ -1165,18 +1927,26 @@ namespace KlayGE
 		ver = LE2Native(ver);
 		BOOST_ASSERT(MODEL_BIN_VERSION == ver);
 
-		std::shared_ptr<std::stringstream> ss = MakeSharedPtr<std::stringstream>();
-
-		uint64_t original_len, len;
-		runtime_file->read(&original_len, sizeof(original_len));
-		original_len = LE2Native(original_len);
-		runtime_file->read(&len, sizeof(len));
-		len = LE2Native(len);
-
-		LZMACodec lzma;
-		lzma.Decode(*ss, runtime_file, len, original_len);
+		uint32_t num_sections;
+		runtime_file->read(&num_sections, sizeof(num_sections));
+		num_sections = LE2Native(num_sections);
+		if (num_sections == 0)
+		{
+			TERRC(std::errc::illegal_byte_sequence);
+		}
+		std::vector<ModelBinSection> sections(num_sections);
+		for (auto& section : sections)
+		{
+			runtime_file->read(&section, sizeof(section));
+			section.offset = LE2Native(section.offset);
+			section.stored_len = LE2Native(section.stored_len);
+			section.original_len = LE2Native(section.original_len);
+		}
 
-		ResIdentifierPtr decoded = MakeSharedPtr<ResIdentifier>(runtime_file->ResName(), runtime_file->Timestamp(), ss);
+		std::string header(static_cast<size_t>(sections[0].original_len), '\0');
+		ReadModelBinSection(*runtime_file, sections[0], header.data());
+		ResIdentifierPtr decoded = MakeSharedPtr<ResIdentifier>(runtime_file->ResName(), runtime_file->Timestamp(),
+			MakeSharedPtr<std::stringstream>(std::move(header)));
 
 		uint32_t num_mtls;
 		decoded->read(&num_mtls, sizeof(num_mtls));
@@ -1321,14 +2091,25 @@ namespace KlayGE
 
 		int const index_elem_size = all_is_index_16_bit ? 2 : 4;
 
-		merged_buff.resize(merged_ves.size());
-		for (size_t i = 0; i < merged_buff.size(); ++ i)
+		// The streams are read straight into buffers of these sizes, so a corrupt file must not get any further
+		if (sections.size() != merged_ves.size() + 2)
+		{
+			TERRC(std::errc::illegal_byte_sequence);
+		}
+		for (size_t i = 0; i < merged_ves.size(); ++ i)
+		{
+			if (sections[i + 1].original_len != static_cast<uint64_t>(all_num_vertices) * merged_ves[i].element_size())
+			{
+				TERRC(std::errc::illegal_byte_sequence);
+			}
+		}
+		if (sections.back().original_len != static_cast<uint64_t>(all_num_indices) * index_elem_size)
 		{
-			merged_buff[i].resize(all_num_vertices * merged_ves[i].element_size());
-			decoded->read(&merged_buff[i][0], merged_buff[i].size() * sizeof(merged_buff[i][0]));
+			TERRC(std::errc::illegal_byte_sequence);
 		}
-		merged_indices.resize(all_num_indices * index_elem_size);
-		decoded->read(&merged_indices[0], merged_indices.size() * sizeof(merged_indices[0]));
+
+		merged_vbs = LoadModelBinStreams(*runtime_file, std::span(sections).subspan(1, merged_ves.size()));
+		merged_ib = std::move(LoadModelBinStreams(*runtime_file, std::span(sections).last(1))[0]);
 
 		mesh_names.resize(num_meshes);
 		mtl_ids.resize(num_meshes);
@@ -1339,6 +2120,7 @@ namespace KlayGE
 		mesh_base_vertices.clear();
 		mesh_num_indices.clear();
 		mesh_start_indices.clear();
+		mesh_lod_errors.clear();
 		for (uint32_t mesh_index = 0; mesh_index < num_meshes; ++ mesh_index)
 		{
 			mesh_names[mesh_index] = ReadShortString(*decoded);
@@ -1383,6 +2165,10 @@ namespace KlayGE
 				mesh_num_indices.push_back(LE2Native(tmp));
 				decoded->read(&tmp, sizeof(tmp));
 				mesh_start_indices.push_back(LE2Native(tmp));
+
+				float lod_error;
+				decoded->read(&lod_error, sizeof(lod_error));
+				mesh_lod_errors.push_back(LE2Native(lod_error));
 			}
 		}
 
@@ -1498,48 +2284,35 @@ namespace KlayGE
 			decoded->read(&frame_rate, sizeof(frame_rate));
 			frame_rate = LE2Native(frame_rate);
 
-			kfs = MakeSharedPtr<std::vector<KeyFrameSet>>(joints.size());
+			clip = MakeSharedPtr<AnimationClip>();
+			clip->tracks.resize(std::max(num_kfs, num_joints));
 			for (uint32_t kf_index = 0; kf_index < num_kfs; ++ kf_index)
 			{
-				uint32_t joint_index = kf_index;
-
-				uint32_t num_kf;
-				decoded->read(&num_kf, sizeof(num_kf));
-				num_kf = LE2Native(num_kf);
+				auto& track = clip->tracks[kf_index];
 
-				KeyFrameSet kf;
-				kf.frame_id.resize(num_kf);
-				kf.bind_real.resize(num_kf);
-				kf.bind_dual.resize(num_kf);
-				kf.bind_scale.resize(num_kf);
-				for (uint32_t k_index = 0; k_index < num_kf; ++ k_index)
+				decoded->read(&track.flags, sizeof(track.flags));
+				track.flags = LE2Native(track.flags);
+				decoded->read(&track.num_keys, sizeof(track.num_keys));
+				track.num_keys = LE2Native(track.num_keys);
+				decoded->read(&track.translation_min, sizeof(track.translation_min));
+				decoded->read(&track.translation_step, sizeof(track.translation_step));
+				for (uint32_t i = 0; i < 3; ++ i)
 				{
-					decoded->read(&kf.frame_id[k_index], sizeof(kf.frame_id[k_index]));
-					kf.frame_id[k_index] = LE2Native(kf.frame_id[k_index]);
-					decoded->read(&kf.bind_real[k_index], sizeof(kf.bind_real[k_index]));
-					kf.bind_real[k_index][0] = LE2Native(kf.bind_real[k_index][0]);
-					kf.bind_real[k_index][1] = LE2Native(kf.bind_real[k_index][1]);
-					kf.bind_real[k_index][2] = LE2Native(kf.bind_real[k_index][2]);
-					kf.bind_real[k_index][3] = LE2Native(kf.bind_real[k_index][3]);
-					decoded->read(&kf.bind_dual[k_index], sizeof(kf.bind_dual[k_index]));
-					kf.bind_dual[k_index][0] = LE2Native(kf.bind_dual[k_index][0]);
-					kf.bind_dual[k_index][1] = LE2Native(kf.bind_dual[k_index][1]);
-					kf.bind_dual[k_index][2] = LE2Native(kf.bind_dual[k_index][2]);
-					kf.bind_dual[k_index][3] = LE2Native(kf.bind_dual[k_index][3]);
-
-					float flip = MathLib::SignBit(kf.bind_real[k_index].w());
-
-					kf.bind_scale[k_index] = MathLib::length(kf.bind_real[k_index]);
-					kf.bind_real[k_index] /= kf.bind_scale[k_index];
-
-					kf.bind_scale[k_index] *= flip;
+					track.translation_min[i] = LE2Native(track.translation_min[i]);
+					track.translation_step[i] = LE2Native(track.translation_step[i]);
 				}
+				decoded->read(&track.scale_min, sizeof(track.scale_min));
+				track.scale_min = LE2Native(track.scale_min);
+				decoded->read(&track.scale_step, sizeof(track.scale_step));
+				track.scale_step = LE2Native(track.scale_step);
 
-				if (joint_index < num_joints)
-				{
-					(*kfs)[joint_index] = kf;
-				}
+				ReadArray(*decoded, clip->frame_id, track.num_keys);
+				ReadArray(*decoded, clip->rotations,
+					((track.flags & AnimationClip::TF_ConstantRotation) ? std::min(track.num_keys, 1U) : track.num_keys) * 3);
+				ReadArray(*decoded, clip->translations, (track.flags & AnimationClip::TF_ConstantTranslation) ? 0 : track.num_keys * 3);
+				ReadArray(*decoded, clip->scales, (track.flags & AnimationClip::TF_ConstantScale) ? 0 : track.num_keys);
 			}
+			clip->UpdateOffsets();
 
 			frame_pos_bbs.resize(num_meshes);
 			for (uint32_t mesh_index = 0; mesh_index < num_meshes; ++ mesh_index)
@@ -1586,7 +2359,7 @@ namespace KlayGE
 			}
 		}
 
-		bool const skinned = kfs && !kfs->empty();
+		bool const skinned = clip && !clip->tracks.empty();
 
 		RenderModelPtr model;
 		if (skinned)
@@ -1604,17 +2377,6 @@ namespace KlayGE
 			model->GetMaterial(mtl_index) = mtls[mtl_index];
 		}
 
-		std::vector<GraphicsBufferPtr> merged_vbs(merged_buff.size());
-		for (size_t i = 0; i < merged_buff.size(); ++ i)
-		{
-			auto vb = MakeSharedPtr<SoftwareGraphicsBuffer>(static_cast<uint32_t>(merged_buff[i].size()), false);
-			vb->CreateHWResource(merged_buff[i].data());
-
-			merged_vbs[i] = vb;
-		}
-		auto merged_ib = MakeSharedPtr<SoftwareGraphicsBuffer>(static_cast<uint32_t>(merged_indices.size()), false);
-		merged_ib->CreateHWResource(merged_indices.data());
-
 		uint32_t mesh_lod_index = 0;
 		std::vector<StaticMeshPtr> meshes(num_meshes);
 		for (uint32_t mesh_index = 0; mesh_index < num_meshes; ++ mesh_index)
@@ -1640,7 +2402,7 @@ namespace KlayGE
 			mesh->NumLods(lods);
 			for (uint32_t lod = 0; lod < lods; ++ lod, ++ mesh_lod_index)
 			{
-				for (uint32_t ve_index = 0; ve_index < merged_buff.size(); ++ ve_index)
+				for (uint32_t ve_index = 0; ve_index < merged_vbs.size(); ++ ve_index)
 				{
 					mesh->AddVertexStream(lod, merged_vbs[ve_index], merged_ves[ve_index]);
 				}
@@ -1650,17 +2412,18 @@ namespace KlayGE
 				mesh->NumIndices(lod, mesh_num_indices[mesh_lod_index]);
 				mesh->StartVertexLocation(lod, mesh_base_vertices[mesh_lod_index]);
 				mesh->StartIndexLocation(lod, mesh_start_indices[mesh_lod_index]);
+				mesh->LodError(lod, mesh_lod_errors[mesh_lod_index]);
 			}
 		}
 
-		if (kfs && !kfs->empty())
+		if (clip && !clip->tracks.empty())
 		{
 			if (!joints.empty())
 			{
 				SkinnedModelPtr skinned_model = checked_pointer_cast<SkinnedModel>(model);
 
 				skinned_model->AssignJoints(joints.begin(), joints.end());
-				skinned_model->AttachKeyFrameSets(kfs);
+				skinned_model->AttachAnimationClip(clip);
 
 				skinned_model->NumFrames(num_frames);
 				skinned_model->FrameRate(frame_rate);
@@ -1779,9 +2542,8 @@ namespace
 		std::vector<AABBox> const & pos_bbs, std::vector<AABBox> const & tc_bbs,
 		std::vector<uint32_t> const & mesh_num_vertices, std::vector<uint32_t> const & mesh_base_vertices,
 		std::vector<uint32_t> const & mesh_num_indices, std::vector<uint32_t> const & mesh_start_indices,
-		std::vector<VertexElement> const & merged_ves,
-		std::vector<std::vector<uint8_t>> const & merged_vertices, std::vector<uint8_t> const & merged_indices,
-		char is_index_16_bit, std::ostream& os)
+		std::vector<float> const & mesh_lod_errors, std::vector<VertexElement> const & merged_ves, char is_index_16_bit,
+		std::ostream& os)
 	{
 		uint32_t num_merged_ves = Native2LE(static_cast<uint32_t>(merged_ves.size()));
 		os.write(reinterpret_cast<char*>(&num_merged_ves), sizeof(num_merged_ves));
@@ -1799,12 +2561,6 @@ namespace
 		os.write(reinterpret_cast<char*>(&num_indices), sizeof(num_indices));
 		os.write(&is_index_16_bit, sizeof(is_index_16_bit));
 
-		for (size_t i = 0; i < merged_vertices.size(); ++ i)
-		{
-			os.write(reinterpret_cast<char const *>(&merged_vertices[i][0]), merged_vertices[i].size() * sizeof(merged_vertices[i][0]));
-		}
-		os.write(reinterpret_cast<char const *>(&merged_indices[0]), merged_indices.size() * sizeof(merged_indices[0]));
-
 		uint32_t mesh_lod_index = 0;
 		for (uint32_t mesh_index = 0; mesh_index < mesh_names.size(); ++ mesh_index)
 		{
@@ -1846,6 +2602,8 @@ namespace
 				os.write(reinterpret_cast<char*>(&ni), sizeof(ni));
 				uint32_t si = Native2LE(mesh_start_indices[mesh_lod_index]);
 				os.write(reinterpret_cast<char*>(&si), sizeof(si));
+				float lod_error = Native2LE(mesh_lod_errors[mesh_lod_index]);
+				os.write(reinterpret_cast<char*>(&lod_error), sizeof(lod_error));
 			}
 		}
 	}
@@ -1978,39 +2736,28 @@ namespace
 		}
 	}
 
-	void WriteKeyFramesChunk(uint32_t num_frames, uint32_t frame_rate, std::vector<KeyFrameSet>& kfs,
-		std::ostream& os)
+	void WriteKeyFramesChunk(uint32_t num_frames, uint32_t frame_rate, AnimationClip const & clip, std::ostream& os)
 	{
 		num_frames = Native2LE(num_frames);
 		os.write(reinterpret_cast<char*>(&num_frames), sizeof(num_frames));
 		frame_rate = Native2LE(frame_rate);
 		os.write(reinterpret_cast<char*>(&frame_rate), sizeof(frame_rate));
 
-		for (size_t i = 0; i < kfs.size(); ++ i)
+		for (auto const & track : clip.tracks)
 		{
-			uint32_t num_kf = Native2LE(static_cast<uint32_t>(kfs[i].frame_id.size()));
-			os.write(reinterpret_cast<char*>(&num_kf), sizeof(num_kf));
-
-			for (size_t j = 0; j < kfs[i].frame_id.size(); ++ j)
-			{
-				Quaternion bind_real = kfs[i].bind_real[j];
-				Quaternion bind_dual = kfs[i].bind_dual[j];
-				float bind_scale = kfs[i].bind_scale[j];
+			WriteArray(os, &track.flags, 1);
+			WriteArray(os, &track.num_keys, 1);
+			WriteArray(os, &track.translation_min[0], 3);
+			WriteArray(os, &track.translation_step[0], 3);
+			WriteArray(os, &track.scale_min, 1);
+			WriteArray(os, &track.scale_step, 1);
 
-				uint32_t frame_id = Native2LE(kfs[i].frame_id[j]);
-				os.write(reinterpret_cast<char*>(&frame_id), sizeof(frame_id));
-				bind_real *= bind_scale;
-				bind_real.x() = Native2LE(bind_real.x());
-				bind_real.y() = Native2LE(bind_real.y());
-				bind_real.z() = Native2LE(bind_real.z());
-				bind_real.w() = Native2LE(bind_real.w());
-				os.write(reinterpret_cast<char*>(&bind_real), sizeof(bind_real));
-				bind_dual.x() = Native2LE(bind_dual.x());
-				bind_dual.y() = Native2LE(bind_dual.y());
-				bind_dual.z() = Native2LE(bind_dual.z());
-				bind_dual.w() = Native2LE(bind_dual.w());
-				os.write(reinterpret_cast<char*>(&bind_dual), sizeof(bind_dual));
-			}
+			WriteArray(os, clip.frame_id.data() + track.first_key, track.num_keys);
+			WriteArray(os, clip.rotations.data() + track.first_rotation,
+				((track.flags & AnimationClip::TF_ConstantRotation) ? std::min(track.num_keys, 1U) : track.num_keys) * 3);
+			WriteArray(os, clip.translations.data() + track.first_translation,
+				(track.flags & AnimationClip::TF_ConstantTranslation) ? 0 : track.num_keys * 3);
+			WriteArray(os, clip.scales.data() + track.first_scale, (track.flags & AnimationClip::TF_ConstantScale) ? 0 : track.num_keys);
 		}
 	}
 
@@ -2062,9 +2809,9 @@ namespace
 		std::vector<AABBox> const & pos_bbs, std::vector<AABBox> const & tc_bbs,
 		std::vector<uint32_t> const & mesh_num_vertices, std::vector<uint32_t> const & mesh_base_vertices,
 		std::vector<uint32_t> const & mesh_num_indices, std::vector<uint32_t> const & mesh_base_indices,
-		std::vector<SceneNode const *> const & nodes, std::vector<Renderable const *> const & renderables,
+		std::vector<float> const & mesh_lod_errors, std::vector<SceneNode const *> const & nodes, std::vector<Renderable const *> const & renderables,
 		std::vector<JointComponent const*> const & joints, std::shared_ptr<std::vector<Animation>> const & animations,
-		std::shared_ptr<std::vector<KeyFrameSet>> const & kfs, uint32_t num_frames, uint32_t frame_rate,
+		std::shared_ptr<AnimationClip const> const & clip, uint32_t num_frames, uint32_t frame_rate,
 		std::vector<std::shared_ptr<AABBKeyFrameSet>> const & frame_pos_bbs)
 	{
 		std::ostringstream ss;
@@ -2082,7 +2829,7 @@ namespace
 			uint32_t num_joints = Native2LE(static_cast<uint32_t>(joints.size()));
 			ss.write(reinterpret_cast<char*>(&num_joints), sizeof(num_joints));
 
-			uint32_t num_kfs = Native2LE(kfs ? static_cast<uint32_t>(kfs->size()) : 0);
+			uint32_t num_kfs = Native2LE(clip ? static_cast<uint32_t>(clip->tracks.size()) : 0);
 			ss.write(reinterpret_cast<char*>(&num_kfs), sizeof(num_kfs));
 
 			uint32_t num_animations = Native2LE(animations ? std::max(static_cast<uint32_t>(animations->size()), 1U) : 0);
@@ -2097,8 +2844,8 @@ namespace
 		if (!mesh_names.empty())
 		{
 			WriteMeshesChunk(mesh_names, mtl_ids, mesh_lods, pos_bbs, tc_bbs,
-				mesh_num_vertices, mesh_base_vertices, mesh_num_indices, mesh_base_indices,
-				merged_ves, merged_buffs, merged_indices, all_is_index_16_bit, ss);
+				mesh_num_vertices, mesh_base_vertices, mesh_num_indices, mesh_base_indices, mesh_lod_errors,
+				merged_ves, all_is_index_16_bit, ss);
 		}
 
 		if (!nodes.empty())
@@ -2111,9 +2858,9 @@ namespace
 			WriteBonesChunk(joints, ss);
 		}
 
-		if (kfs && !kfs->empty())
+		if (clip && !clip->tracks.empty())
 		{
-			WriteKeyFramesChunk(num_frames, frame_rate, *kfs, ss);
+			WriteKeyFramesChunk(num_frames, frame_rate, *clip, ss);
 
 			WriteBBKeyFramesChunk(frame_pos_bbs, ss);
 
@@ -2129,19 +2876,14 @@ namespace
 		ofs.write(reinterpret_cast<char*>(&ver), sizeof(ver));
 
 		auto const & ss_str = ss.str();
-		uint64_t original_len = Native2LE(static_cast<uint64_t>(ss_str.size()));
-		ofs.write(reinterpret_cast<char*>(&original_len), sizeof(original_len));
-
-		std::ofstream::pos_type p = ofs.tellp();
-		uint64_t len = 0;
-		ofs.write(reinterpret_cast<char*>(&len), sizeof(len));
-
-		LZMACodec lzma;
-		len = lzma.Encode(ofs, MakeSpan(reinterpret_cast<uint8_t const *>(ss_str.c_str()), ss_str.size()));
-
-		ofs.seekp(p, std::ios_base::beg);
-		len = Native2LE(len);
-		ofs.write(reinterpret_cast<char*>(&len), sizeof(len));
+		std::vector<std::span<uint8_t const>> sections;
+		sections.push_back(MakeSpan(reinterpret_cast<uint8_t const *>(ss_str.data()), ss_str.size()));
+		for (auto const & buff : merged_buffs)
+		{
+			sections.push_back(buff);
+		}
+		sections.push_back(merged_indices);
+		WriteModelBinSections(ofs, sections);
 	}
 } // namespace
 
@@ -2180,6 +2922,7 @@ namespace KlayGE
 		std::vector<uint32_t> mesh_base_vertices;
 		std::vector<uint32_t> mesh_num_indices;
 		std::vector<uint32_t> mesh_base_indices;
+		std::vector<float> mesh_lod_errors;
 		if (!mesh_names.empty())
 		{
 			{
@@ -2265,6 +3008,7 @@ namespace KlayGE
 					mesh_base_vertices.push_back(mesh.StartVertexLocation(lod));
 					mesh_num_indices.push_back(mesh.NumIndices(lod));
 					mesh_base_indices.push_back(mesh.StartIndexLocation(lod));
+					mesh_lod_errors.push_back(mesh.LodError(lod));
 				}
 			}
 
@@ -2287,7 +3031,7 @@ namespace KlayGE
 
 		std::vector<JointComponent const*> joints;
 		std::shared_ptr<std::vector<Animation>> animations;
-		std::shared_ptr<std::vector<KeyFrameSet>> kfs;
+		std::shared_ptr<AnimationClip const> clip;
 		uint32_t num_frame = 0;
 		uint32_t frame_rate = 0;
 		std::vector<std::shared_ptr<AABBKeyFrameSet>> frame_pos_bbs;
@@ -2307,7 +3051,7 @@ namespace KlayGE
 			num_frame = skinned_model.NumFrames();
 			frame_rate = skinned_model.FrameRate();
 
-			kfs = skinned_model.GetKeyFrameSets();
+			clip = skinned_model.GetAnimationClip();
 
 			frame_pos_bbs.resize(mesh_names.size());
 			for (uint32_t mesh_index = 0; mesh_index < mesh_names.size(); ++ mesh_index)
@@ -2319,9 +3063,9 @@ namespace KlayGE
 
 		::SaveModel(output_path.string(), mtls, merged_ves, all_is_index_16_bit, merged_buffs, merged_indices,
 			mesh_names, mtl_ids, mesh_lods, pos_bbs, tc_bbs,
-			mesh_num_vertices, mesh_base_vertices, mesh_num_indices, mesh_base_indices,
+			mesh_num_vertices, mesh_base_vertices, mesh_num_indices, mesh_base_indices, mesh_lod_errors,
 			nodes, renderables,
-			joints, animations, kfs, num_frame, frame_rate, frame_pos_bbs);
+			joints, animations, clip, num_frame, frame_rate, frame_pos_bbs);
 
 #if KLAYGE_IS_DEV_PLATFORM
 		if (need_conversion)
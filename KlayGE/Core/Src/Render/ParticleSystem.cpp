@@ -30,6 +30,7 @@
 
 #include <KlayGE/KlayGE.hpp>
 
+#include <KFL/CXX20/bit.hpp>
 #include <KFL/CXX20/format.hpp>
 #include <KFL/ErrorHandling.hpp>
 #include <KFL/StringUtil.hpp>
@@ -45,10 +46,16 @@
 #include <KFL/XMLDom.hpp>
 #include <KlayGE/DeferredRenderingLayer.hpp>
 #include <KFL/Hash.hpp>
+#include <KFL/RadixSort.hpp>
+#include <KFL/TaskScheduler.hpp>
 
 #include <fstream>
 #include <string>
 
+#if defined(KLAYGE_SSE2_SUPPORT)
+#include <emmintrin.h>
+#endif
+
 #include <KlayGE/ParticleSystem.hpp>
 
 namespace
@@ -56,6 +63,29 @@ namespace
 	using namespace KlayGE;
 
 	uint32_t const NUM_PARTICLES = 4096;
+	// The particles are processed in tasks of at most this many
+	uint32_t constexpr PARALLEL_PARTICLE_GRAIN_SIZE = 4096;
+
+	// Sorts as unsigned integers from the farthest to the nearest
+	uint32_t BackToFrontSortKey(float depth)
+	{
+		uint32_t const bits = std::bit_cast<uint32_t>(depth);
+		return (bits & 0x80000000U) ? bits : ~(bits | 0x80000000U);
+	}
+
+	float EvaluatePolyline(std::vector<float2> const & polyline, float x)
+	{
+		for (auto iter = std::next(polyline.begin()); iter != polyline.end(); ++ iter)
+		{
+			if (iter->x() >= x)
+			{
+				float2 const & prev = *std::prev(iter);
+				float const s = (x - prev.x()) / (iter->x() - prev.x());
+				return MathLib::lerp(prev.y(), iter->y(), s);
+			}
+		}
+		return polyline.back().y();
+	}
 
 	class ParticleSystemLoadingDesc : public ResLoadingDesc
 	{
@@ -336,6 +366,13 @@ namespace
 			return false;
 		}
 
+		uint64_t Hash() const override
+		{
+			size_t seed = static_cast<size_t>(this->Type());
+			HashRange(seed, ps_desc_.res_name.begin(), ps_desc_.res_name.end());
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -585,10 +622,10 @@ namespace KlayGE
 
 	ParticleSystem::ParticleSystem(uint32_t max_num_particles, bool sort_particles)
 		: root_node_(MakeSharedPtr<SceneNode>(L"ParticleSystemRootNode", SceneNode::SOA_Moveable | SceneNode::SOA_NotCastShadow)),
-			particles_(max_num_particles),
 			gravity_(0.5f), force_(0, 0, 0), media_density_(0.0f),
 			sort_particles_(sort_particles)
 	{
+		particles_.Resize(max_num_particles);
 		this->ClearParticles();
 
 		RenderFactory& rf = Context::Instance().RenderFactoryInstance();
@@ -725,120 +762,147 @@ namespace KlayGE
 	uint32_t ParticleSystem::NumActiveParticles() const
 	{
 		std::lock_guard<std::mutex> lock(actived_particles_mutex_);
-		return static_cast<uint32_t>(actived_particles_.size());
+		return num_actived_particles_;
 	}
 
 	uint32_t ParticleSystem::GetActiveParticleIndex(uint32_t i) const
 	{
 		std::lock_guard<std::mutex> lock(actived_particles_mutex_);
-		return actived_particles_[i].first;
+		BOOST_ASSERT(i < num_actived_particles_);
+		return sort_particles_ ? sorted_particles_[i].second : i;
+	}
+
+	Particle ParticleSystem::GetParticle(uint32_t i) const
+	{
+		BOOST_ASSERT(i < this->NumParticles());
+		return particles_.Load(i);
 	}
 
 	void ParticleSystem::ClearParticles()
 	{
-		for (auto& particle : particles_)
+		std::fill(particles_.life.begin(), particles_.life.end(), 0.0f);
+		num_actived_particles_ = 0;
+	}
+
+	// Keeps the order of the alive ones, returns the new end
+	uint32_t ParticleSystem::RemoveDeadParticles(uint32_t begin, uint32_t end)
+	{
+		uint32_t num_alive = begin;
+		for (uint32_t i = begin; i < end; ++ i)
 		{
-			particle.life = 0;
+			if (particles_.life[i] > 0)
+			{
+				if (i != num_alive)
+				{
+					particles_.Move(i, num_alive);
+				}
+				++ num_alive;
+			}
 		}
+		return num_alive;
 	}
 
 	void ParticleSystem::UpdateParticlesNoLock(float elapsed_time)
 	{
-		auto emitter_iter = emitters_.begin();
-		uint32_t new_particle = (*emitter_iter)->Update(elapsed_time);
-
-		auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
-		auto const& camera = *re.DefaultFrameBuffer()->Viewport()->Camera();
-		float4x4 const& view_mat = camera.ViewMatrix();
-
-		actived_particles_.clear();
-
-		float3 min_bb(+1e10f, +1e10f, +1e10f);
-		float3 max_bb(-1e10f, -1e10f, -1e10f);
-
 		for (auto const & updater : updaters_)
 		{
 			updater->SnapParams();
 		}
 
-		for (uint32_t i = 0; i < particles_.size(); ++ i)
-		{
-			Particle& particle = particles_[i];
+		auto& task_scheduler = Context::Instance().TaskSchedulerInstance();
 
-			if (particle.life > 0)
+		uint32_t num_particles = num_actived_particles_;
+		task_scheduler.ParallelFor(0U, num_particles, PARALLEL_PARTICLE_GRAIN_SIZE,
+			[this, elapsed_time](uint32_t begin, uint32_t end)
 			{
+				ParticleBatch const batch = particles_.Batch(begin, end);
 				for (auto const & updater : updaters_)
 				{
-					updater->Update(particle, elapsed_time);
+					updater->Update(batch, elapsed_time);
 				}
+			});
+		num_particles = this->RemoveDeadParticles(0, num_particles);
+
+		// Emitters keep their own random states, so the new particles are emitted here
+		uint32_t const first_new_particle = num_particles;
+		uint32_t const max_num_particles = this->NumParticles();
+		for (auto const & emitter : emitters_)
+		{
+			uint32_t const num_new_particles = std::min(emitter->Update(elapsed_time), max_num_particles - num_particles);
+			for (uint32_t i = 0; i < num_new_particles; ++ i)
+			{
+				Particle par;
+				emitter->Emit(par);
+				particles_.Store(num_particles, par);
+				++ num_particles;
 			}
-			else
+		}
+		if (num_particles > first_new_particle)
+		{
+			ParticleBatch const batch = particles_.Batch(first_new_particle, num_particles);
+			for (auto const & updater : updaters_)
 			{
-				if (new_particle > 0)
-				{
-					(*emitter_iter)->Emit(particle);
-					for (auto const & updater : updaters_)
-					{
-						updater->Update(particle, 0);
-					}
-					-- new_particle;
-				}
-				else
-				{
-					if (emitter_iter != emitters_.end())
-					{
-						++ emitter_iter;
-						if (emitter_iter != emitters_.end())
-						{
-							new_particle = (*emitter_iter)->Update(elapsed_time);
-						}
-					}
-				}
+				updater->Update(batch, 0);
 			}
+			num_particles = this->RemoveDeadParticles(first_new_particle, num_particles);
+		}
 
-			if (particle.life > 0)
-			{
-				float3 const & pos = particle.pos;
+		num_actived_particles_ = num_particles;
+		if (num_particles == 0)
+		{
+			return;
+		}
 
-				float depth_es;
-				if (sort_particles_)
-				{
-					float4 const pos4(pos.x(), pos.y(), pos.z(), 1);
-					float4 const z_row = view_mat.Col(2);
-					float4 const w_row = view_mat.Col(3);
+		auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+		auto const& camera = *re.DefaultFrameBuffer()->Viewport()->Camera();
+		float4x4 const& view_mat = camera.ViewMatrix();
+		float4 const z_row = view_mat.Col(2);
+		float4 const w_row = view_mat.Col(3);
 
-					depth_es = MathLib::dot(pos4, z_row) / MathLib::dot(pos4, w_row);
-				}
-				else
+		if (sort_particles_)
+		{
+			sorted_particles_.resize(num_particles);
+		}
+
+		AABBox const bound = task_scheduler.ParallelReduce(0U, num_particles, PARALLEL_PARTICLE_GRAIN_SIZE,
+			AABBox(particles_.pos[0], particles_.pos[0]),
+			[this, &z_row, &w_row](uint32_t begin, uint32_t end)
+			{
+				float3 min_bb(+1e10f, +1e10f, +1e10f);
+				float3 max_bb(-1e10f, -1e10f, -1e10f);
+				for (uint32_t i = begin; i < end; ++ i)
 				{
-					depth_es = 0;
+					float3 const & pos = particles_.pos[i];
+					min_bb = MathLib::minimize(min_bb, pos);
+					max_bb = MathLib::maximize(max_bb, pos);
 				}
 
-				actived_particles_.emplace_back(i, depth_es);
+				if (sort_particles_)
+				{
+					for (uint32_t i = begin; i < end; ++ i)
+					{
+						float3 const & pos = particles_.pos[i];
+						float4 const pos4(pos.x(), pos.y(), pos.z(), 1);
+						float const depth_es = MathLib::dot(pos4, z_row) / MathLib::dot(pos4, w_row);
+						sorted_particles_[i] = std::make_pair(BackToFrontSortKey(depth_es), i);
+					}
+				}
 
-				min_bb = MathLib::minimize(min_bb, pos);
-				max_bb = MathLib::maximize(min_bb, pos);
-			}
-		}
+				return AABBox(min_bb, max_bb);
+			},
+			[](AABBox lhs, AABBox const & rhs) { return lhs |= rhs; });
 
-		if (!actived_particles_.empty())
+		if (sort_particles_)
 		{
-			if (sort_particles_)
-			{
-				std::sort(actived_particles_.begin(), actived_particles_.end(),
-					[](std::pair<uint32_t, float> const & lhs, std::pair<uint32_t, float> const & rhs)
-					{
-						return lhs.second > rhs.second;
-					});
-			}
-
-			checked_cast<RenderParticles&>(*render_particles_).PosBound(AABBox(min_bb, max_bb));
+			RadixSort(sorted_particles_, sorted_particles_tmp_);
 		}
+
+		checked_cast<RenderParticles&>(*render_particles_).PosBound(bound);
 	}
 
 	void ParticleSystem::UpdateParticleBufferNoLock()
 	{
-		if (!actived_particles_.empty())
+		if (num_actived_particles_ > 0)
 		{
 			RenderLayout& rl = render_particles_->GetRenderLayout();
 
@@ -852,7 +916,7 @@ namespace KlayGE
 				instance_gb = rl.InstanceStream();
 			}
 
-			uint32_t const num_active_particles = static_cast<uint32_t>(actived_particles_.size());
+			uint32_t const num_active_particles = num_actived_particles_;
 			uint32_t const new_instance_size = num_active_particles * sizeof(ParticleInstance);
 			if (!instance_gb || (instance_gb->Size() < new_instance_size))
 			{
@@ -885,20 +949,88 @@ namespace KlayGE
 			{
 				GraphicsBuffer::Mapper mapper(*instance_gb, BA_Write_Only);
 				ParticleInstance* instance_data = mapper.Pointer<ParticleInstance>();
-				for (uint32_t i = 0; i < num_active_particles; ++ i, ++ instance_data)
-				{
-					Particle const & par = particles_[actived_particles_[i].first];
-					instance_data->pos = par.pos;
-					instance_data->life = par.life;
-					instance_data->spin = par.spin;
-					instance_data->size = par.size;
-					instance_data->life_factor = (par.init_life - par.life) / par.init_life;
-					instance_data->alpha = par.alpha;
-				}
+				Context::Instance().TaskSchedulerInstance().ParallelFor(0U, num_active_particles, PARALLEL_PARTICLE_GRAIN_SIZE,
+					[this, instance_data](uint32_t begin, uint32_t end)
+					{
+						for (uint32_t i = begin; i < end; ++ i)
+						{
+							uint32_t const index = sort_particles_ ? sorted_particles_[i].second : i;
+							ParticleInstance& instance = instance_data[i];
+							instance.pos = particles_.pos[index];
+							instance.life = particles_.life[index];
+							instance.spin = particles_.spin[index];
+							instance.size = particles_.size[index];
+							instance.life_factor = (particles_.init_life[index] - particles_.life[index]) / particles_.init_life[index];
+							instance.alpha = particles_.alpha[index];
+						}
+					});
 			}
 		}
 	}
 
+	void ParticleSystem::ParticleArrays::Resize(uint32_t num_particles)
+	{
+		pos.resize(num_particles);
+		vel.resize(num_particles);
+		life.resize(num_particles);
+		spin.resize(num_particles);
+		size.resize(num_particles);
+		alpha.resize(num_particles);
+		init_life.resize(num_particles);
+	}
+
+	ParticleBatch ParticleSystem::ParticleArrays::Batch(uint32_t begin, uint32_t end)
+	{
+		BOOST_ASSERT(begin <= end);
+		BOOST_ASSERT(end <= life.size());
+
+		uint32_t const count = end - begin;
+		ParticleBatch ret;
+		ret.pos = std::span(pos).subspan(begin, count);
+		ret.vel = std::span(vel).subspan(begin, count);
+		ret.life = std::span(life).subspan(begin, count);
+		ret.spin = std::span(spin).subspan(begin, count);
+		ret.size = std::span(size).subspan(begin, count);
+		ret.alpha = std::span(alpha).subspan(begin, count);
+		ret.init_life = std::span<float const>(init_life).subspan(begin, count);
+		return ret;
+	}
+
+	Particle ParticleSystem::ParticleArrays::Load(uint32_t index) const
+	{
+		Particle par;
+		par.pos = pos[index];
+		par.vel = vel[index];
+		par.life = life[index];
+		par.spin = spin[index];
+		par.size = size[index];
+		par.alpha = alpha[index];
+		par.init_life = init_life[index];
+		return par;
+	}
+
+	void ParticleSystem::ParticleArrays::Store(uint32_t index, Particle const & par)
+	{
+		pos[index] = par.pos;
+		vel[index] = par.vel;
+		life[index] = par.life;
+		spin[index] = par.spin;
+		size[index] = par.size;
+		alpha[index] = par.alpha;
+		init_life[index] = par.init_life;
+	}
+
+	void ParticleSystem::ParticleArrays::Move(uint32_t from, uint32_t to)
+	{
+		pos[to] = pos[from];
+		vel[to] = vel[from];
+		life[to] = life[from];
+		spin[to] = spin[from];
+		size[to] = size[from];
+		alpha[to] = alpha[from];
+		init_life[to] = init_life[from];
+	}
+
 	void ParticleSystem::ParticleAlphaFromTex(std::string const & tex_name)
 	{
 		particle_alpha_from_tex_name_ = tex_name;
@@ -1146,67 +1278,118 @@ namespace KlayGE
 		return ret;
 	}
 
-	void PolylineParticleUpdater::Update(Particle& par, float elapse_time)
+	void PolylineParticleUpdater::Update(ParticleBatch const & batch, float elapse_time)
 	{
-		BOOST_ASSERT(!this_frame_size_over_life_.empty());
-		BOOST_ASSERT(!this_frame_mass_over_life_.empty());
-		BOOST_ASSERT(!this_frame_opacity_over_life_.empty());
-
-		float pos = (par.init_life - par.life) / par.init_life;
-
-		float cur_size = this_frame_size_over_life_.back().y();
-		for (auto iter = std::next(this_frame_size_over_life_.begin()); iter != this_frame_size_over_life_.end(); ++ iter)
+		ParticleSystemPtr ps = ps_.lock();
+		float const gravity = ps->Gravity();
+		float const buoyancy_factor = 4.0f / 3 * PI * ps->MediaDensity() * gravity;
+		float3 const force = ps->Force();
+
+		// No branches in the loop, the curves are read from the tables
+		uint32_t const num_particles = batch.NumParticles();
+		uint32_t i = 0;
+#if defined(KLAYGE_SSE2_SUPPORT)
+		static_assert(sizeof(float3) == 3 * sizeof(float));
+
+		// 4 particles per register. Only the table reads stay scalar, SSE2 has no gather.
+		__m128 const zero = _mm_setzero_ps();
+		__m128 const one = _mm_set1_ps(1.0f);
+		__m128 const table_size = _mm_set1_ps(static_cast<float>(LIFE_TABLE_SIZE));
+		__m128 const max_index = _mm_set1_ps(static_cast<float>(LIFE_TABLE_SIZE - 1));
+		__m128 const v_buoyancy_factor = _mm_set1_ps(buoyancy_factor);
+		__m128 const v_gravity = _mm_set1_ps(gravity);
+		__m128 const force_x = _mm_set1_ps(force.x());
+		__m128 const force_y = _mm_set1_ps(force.y());
+		__m128 const force_z = _mm_set1_ps(force.z());
+		__m128 const v_elapse_time = _mm_set1_ps(elapse_time);
+		__m128 const spin_step = _mm_set1_ps(0.001f);
+		for (; i + 4 <= num_particles; i += 4)
 		{
-			if (iter->x() >= pos)
+			__m128 const init_life = _mm_loadu_ps(&batch.init_life[i]);
+			__m128 const life = _mm_loadu_ps(&batch.life[i]);
+			__m128 const life_pos =
+				_mm_mul_ps(_mm_max_ps(zero, _mm_min_ps(one, _mm_div_ps(_mm_sub_ps(init_life, life), init_life))), table_size);
+			__m128i const index = _mm_cvttps_epi32(_mm_min_ps(life_pos, max_index));
+			__m128 const s = _mm_sub_ps(life_pos, _mm_cvtepi32_ps(index));
+
+			alignas(16) int32_t indices[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices), index);
+			auto const lerp_table = [&indices, s](std::array<float, LIFE_TABLE_SIZE + 1> const & table)
 			{
-				float2 const & prev = *std::prev(iter);
-				float const s = (pos - prev.x()) / (iter->x() - prev.x());
-				cur_size = MathLib::lerp(prev.y(), iter->y(), s);
-				break;
-			}
-		}
-
-		float cur_mass = this_frame_mass_over_life_.back().y();
-		for (auto iter = std::next(this_frame_mass_over_life_.begin()); iter != this_frame_mass_over_life_.end(); ++ iter)
-		{
-			if (iter->x() >= pos)
+				__m128 const lhs = _mm_setr_ps(table[indices[0]], table[indices[1]], table[indices[2]], table[indices[3]]);
+				__m128 const rhs =
+					_mm_setr_ps(table[indices[0] + 1], table[indices[1] + 1], table[indices[2] + 1], table[indices[3] + 1]);
+				return _mm_add_ps(lhs, _mm_mul_ps(_mm_sub_ps(rhs, lhs), s));
+			};
+			__m128 const cur_size = lerp_table(this_frame_size_table_);
+			__m128 const cur_mass = lerp_table(this_frame_mass_table_);
+			__m128 const cur_alpha = lerp_table(this_frame_opacity_table_);
+
+			__m128 const buoyancy = _mm_mul_ps(v_buoyancy_factor, _mm_mul_ps(_mm_mul_ps(cur_size, cur_size), cur_size));
+			__m128 const accel_x = _mm_div_ps(force_x, cur_mass);
+			__m128 const accel_y = _mm_sub_ps(_mm_div_ps(_mm_add_ps(force_y, buoyancy), cur_mass), v_gravity);
+			__m128 const accel_z = _mm_div_ps(force_z, cur_mass);
+
+			// Transposes the accelerations into the xyz layout of 4 float3s, so vel and pos are updated as 3 registers each
+			__m128 const xy_lo = _mm_unpacklo_ps(accel_x, accel_y);
+			__m128 const xy_hi = _mm_unpackhi_ps(accel_x, accel_y);
+			__m128 const accel[] =
 			{
-				float2 const & prev = *std::prev(iter);
-				float const s = (pos - prev.x()) / (iter->x() - prev.x());
-				cur_mass = MathLib::lerp(prev.y(), iter->y(), s);
-				break;
+				_mm_shuffle_ps(xy_lo, _mm_shuffle_ps(accel_z, accel_x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)),
+				_mm_shuffle_ps(_mm_shuffle_ps(accel_y, accel_z, _MM_SHUFFLE(1, 1, 1, 1)), xy_hi, _MM_SHUFFLE(1, 0, 2, 0)),
+				_mm_shuffle_ps(_mm_shuffle_ps(accel_z, accel_x, _MM_SHUFFLE(3, 3, 2, 2)),
+					_mm_shuffle_ps(accel_y, accel_z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0))
+			};
+			float* vel = batch.vel[i].data();
+			float* pos = batch.pos[i].data();
+			for (uint32_t j = 0; j < 3; ++ j)
+			{
+				__m128 const v = _mm_add_ps(_mm_loadu_ps(vel + j * 4), _mm_mul_ps(accel[j], v_elapse_time));
+				_mm_storeu_ps(vel + j * 4, v);
+				_mm_storeu_ps(pos + j * 4, _mm_add_ps(_mm_loadu_ps(pos + j * 4), _mm_mul_ps(v, v_elapse_time)));
 			}
-		}
 
-		float cur_alpha = this_frame_opacity_over_life_.back().y();
-		for (auto iter = std::next(this_frame_opacity_over_life_.begin()); iter != this_frame_opacity_over_life_.end(); ++ iter)
+			_mm_storeu_ps(&batch.life[i], _mm_sub_ps(life, v_elapse_time));
+			_mm_storeu_ps(&batch.spin[i], _mm_add_ps(_mm_loadu_ps(&batch.spin[i]), spin_step));
+			_mm_storeu_ps(&batch.size[i], cur_size);
+			_mm_storeu_ps(&batch.alpha[i], cur_alpha);
+		}
+#endif
+		for (; i < num_particles; ++ i)
 		{
-			if (iter->x() >= pos)
-			{
-				float2 const & prev = *std::prev(iter);
-				float const s = (pos - prev.x()) / (iter->x() - prev.x());
-				cur_alpha = MathLib::lerp(prev.y(), iter->y(), s);
-				break;
-			}
+			float const life_pos = MathLib::clamp((batch.init_life[i] - batch.life[i]) / batch.init_life[i], 0.0f, 1.0f) * LIFE_TABLE_SIZE;
+			uint32_t const index = std::min(static_cast<uint32_t>(life_pos), LIFE_TABLE_SIZE - 1);
+			float const s = life_pos - index;
+
+			float const cur_size = MathLib::lerp(this_frame_size_table_[index], this_frame_size_table_[index + 1], s);
+			float const cur_mass = MathLib::lerp(this_frame_mass_table_[index], this_frame_mass_table_[index + 1], s);
+			float const cur_alpha = MathLib::lerp(this_frame_opacity_table_[index], this_frame_opacity_table_[index + 1], s);
+
+			float const buoyancy = buoyancy_factor * MathLib::cube(cur_size);
+			float3 const accel = (force + float3(0, buoyancy, 0)) / cur_mass - float3(0, gravity, 0);
+			batch.vel[i] += accel * elapse_time;
+			batch.pos[i] += batch.vel[i] * elapse_time;
+			batch.life[i] -= elapse_time;
+			batch.spin[i] += 0.001f;
+			batch.size[i] = cur_size;
+			batch.alpha[i] = cur_alpha;
 		}
-
-		ParticleSystemPtr ps = ps_.lock();
-		float buoyancy = 4.0f / 3 * PI * MathLib::cube(cur_size) * ps->MediaDensity() * ps->Gravity();
-		float3 accel = (ps->Force() + float3(0, buoyancy, 0)) / cur_mass - float3(0, ps->Gravity(), 0);
-		par.vel += accel * elapse_time;
-		par.pos += par.vel * elapse_time;
-		par.life -= elapse_time;
-		par.spin += 0.001f;
-		par.size = cur_size;
-		par.alpha = cur_alpha;
 	}
 
 	void PolylineParticleUpdater::SnapParams()
 	{
 		std::lock_guard<std::mutex> lock(update_mutex_);
 
-		this_frame_size_over_life_ = size_over_life_;
-		this_frame_mass_over_life_ = mass_over_life_;
-		this_frame_opacity_over_life_ = opacity_over_life_;
+		BOOST_ASSERT(!size_over_life_.empty());
+		BOOST_ASSERT(!mass_over_life_.empty());
+		BOOST_ASSERT(!opacity_over_life_.empty());
+
+		for (uint32_t i = 0; i <= LIFE_TABLE_SIZE; ++ i)
+		{
+			float const life_pos = static_cast<float>(i) / LIFE_TABLE_SIZE;
+			this_frame_size_table_[i] = EvaluatePolyline(size_over_life_, life_pos);
+			this_frame_mass_table_[i] = EvaluatePolyline(mass_over_life_, life_pos);
+			this_frame_opacity_table_[i] = EvaluatePolyline(opacity_over_life_, life_pos);
+		}
 	}
 }
@@ -195,6 +195,14 @@ namespace
 			return false;
 		}
 
+		uint64_t Hash() const override
+		{
+			size_t seed = static_cast<size_t>(this->Type());
+			HashRange(seed, pp_desc_.res_name.begin(), pp_desc_.res_name.end());
+			HashRange(seed, pp_desc_.pp_name.begin(), pp_desc_.pp_name.end());
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -261,16 +269,19 @@ namespace KlayGE
 		for (size_t i = 0; i < input_pin_names.size(); ++ i)
 		{
 			input_pins_[i].first = input_pin_names[i];
+			input_pin_handles_.emplace_back(HashValue(input_pin_names[i]));
 		}
 		output_pins_.resize(output_pin_names.size());
 		for (size_t i = 0; i < output_pin_names.size(); ++i)
 		{
 			std::get<0>(output_pins_[i]) = output_pin_names[i];
+			output_pin_handles_.emplace_back(HashValue(output_pin_names[i]));
 		}
 		params_.resize(param_names.size());
 		for (size_t i = 0; i < param_names.size(); ++i)
 		{
 			params_[i].first = param_names[i];
+			param_handles_.emplace_back(HashValue(param_names[i]));
 		}
 		input_pins_ep_.resize(input_pin_names.size());
 		this->Technique(effect, tech);
@@ -325,7 +336,7 @@ namespace KlayGE
 
 			if (volumetric_)
 			{
-				pp_mvp_param_ = effect_->ParameterByName("pp_mvp");
+				pp_mvp_param_ = effect_->ParameterByHandle(pp_mvp_handle_);
 			}
 			else
 			{
@@ -353,22 +364,22 @@ namespace KlayGE
 			input_pins_ep_.resize(input_pins_.size());
 			for (size_t i = 0; i < input_pins_.size(); ++ i)
 			{
-				input_pins_ep_[i] = effect_->ParameterByName(input_pins_[i].first);
+				input_pins_ep_[i] = effect_->ParameterByHandle(input_pin_handles_[i]);
 			}
 
 			output_pins_ep_.resize(output_pins_.size());
 			for (size_t i = 0; i < output_pins_.size(); ++ i)
 			{
-				output_pins_ep_[i] = effect_->ParameterByName(std::get<0>(output_pins_[i]));
+				output_pins_ep_[i] = effect_->ParameterByHandle(output_pin_handles_[i]);
 			}
 
 			for (size_t i = 0; i < params_.size(); ++ i)
 			{
-				params_[i].second = effect_->ParameterByName(params_[i].first);
+				params_[i].second = effect_->ParameterByHandle(param_handles_[i]);
 			}
 
-			width_height_ep_ = effect_->ParameterByName("width_height");
-			inv_width_height_ep_ = effect_->ParameterByName("inv_width_height");
+			width_height_ep_ = effect_->ParameterByHandle(width_height_handle_);
+			inv_width_height_ep_ = effect_->ParameterByHandle(inv_width_height_handle_);
 		}
 	}
 
@@ -544,7 +544,7 @@ namespace
 				if (val_in_cbuff != value)
 				{
 					val_in_cbuff = value;
-					cbuff->Dirty(true);
+					cbuff->Dirty(cbuff_desc.offset, sizeof(T));
 				}
 			}
 			else
@@ -1798,7 +1798,7 @@ namespace
 					dst += dst_cbuff_desc.stride;
 				}
 
-				concrete.CBuffer()->Dirty(true);
+				concrete.CBuffer()->Dirty(dst_cbuff_desc.offset, size_ * dst_cbuff_desc.stride);
 			}
 			else
 			{
@@ -1829,7 +1829,7 @@ namespace
 					dst += cbuff_desc.stride;
 				}
 
-				this->CBuffer()->Dirty(true);
+				this->CBuffer()->Dirty(cbuff_desc.offset, size_ * cbuff_desc.stride);
 			}
 			else
 			{
@@ -1963,7 +1963,7 @@ namespace
 					dst += cbuff_desc.stride;
 				}
 
-				this->CBuffer()->Dirty(true);
+				this->CBuffer()->Dirty(cbuff_desc.offset, size_ * cbuff_desc.stride);
 			}
 			else
 			{
@@ -3136,7 +3136,7 @@ namespace
 
 				memcpy(dst, src, size_ * sizeof(float4x4));
 
-				ret->CBuffer()->Dirty(true);
+				ret->CBuffer()->Dirty(dst_cbuff_desc.offset, static_cast<uint32_t>(size_ * sizeof(float4x4)));
 			}
 			else
 			{
@@ -3246,7 +3246,7 @@ namespace
 					++dst;
 				}
 
-				this->CBuffer()->Dirty(true);
+				this->CBuffer()->Dirty(cbuff_desc.offset, static_cast<uint32_t>(size_ * sizeof(float4x4)));
 			}
 			else
 			{
@@ -4158,6 +4158,31 @@ namespace
 		checked_cast<RenderVariableIOable const&>(var).StreamOut(os);
 	}
 #endif
+
+	template <typename T>
+	void BuildNameIndex(std::vector<T> const& items, std::vector<std::pair<size_t, uint32_t>>& name_index)
+	{
+		name_index.resize(items.size());
+		for (uint32_t i = 0; i < items.size(); ++i)
+		{
+			name_index[i] = {items[i].NameHash(), i};
+		}
+
+		// Stable, so the first one wins for duplicated names, as in a linear search
+		std::stable_sort(name_index.begin(), name_index.end(),
+			[](std::pair<size_t, uint32_t> const& lhs, std::pair<size_t, uint32_t> const& rhs) { return lhs.first < rhs.first; });
+	}
+
+	uint32_t FindInNameIndex(std::vector<std::pair<size_t, uint32_t>> const& name_index, size_t name_hash) noexcept
+	{
+		auto const iter = std::lower_bound(name_index.begin(), name_index.end(), name_hash,
+			[](std::pair<size_t, uint32_t> const& lhs, size_t rhs) { return lhs.first < rhs; });
+		if ((iter != name_index.end()) && (iter->first == name_hash))
+		{
+			return iter->second;
+		}
+		return static_cast<uint32_t>(-1);
+	}
 }
 
 namespace KlayGE
@@ -4240,6 +4265,16 @@ namespace KlayGE
 			return false;
 		}
 
+		uint64_t Hash() const override
+		{
+			size_t seed = static_cast<size_t>(this->Type());
+			for (auto const & name : effect_desc_.res_name)
+			{
+				HashRange(seed, name.begin(), name.end());
+			}
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -4440,6 +4475,7 @@ namespace KlayGE
 		{
 			immutable_ = MakeSharedPtr<Immutable>();
 		}
+		immutable_->layout_id.store(0, std::memory_order_release);
 
 		FILESYSTEM_NS::path first_fxml_path(ResLoader::Instance().Locate(*names.begin()));
 		FILESYSTEM_NS::path first_fxml_directory = first_fxml_path.parent_path();
@@ -4542,6 +4578,8 @@ namespace KlayGE
 			}
 #endif
 		}
+
+		this->BuildNameIndices();
 	}
 
 #if KLAYGE_IS_DEV_PLATFORM
@@ -4635,38 +4673,89 @@ namespace KlayGE
 		return hw_res_ready_;
 	}
 
-	RenderEffectParameter* RenderEffect::ParameterBySemantic(std::string_view semantic) noexcept
+	void RenderEffect::BuildNameIndices()
 	{
-		size_t const semantic_hash = HashValue(std::move(semantic));
-		for (auto& param : params_)
+		static std::atomic<uint32_t> next_layout_id(1);
+
+		BuildNameIndex(params_, immutable_->param_name_index);
+		BuildNameIndex(immutable_->techniques, immutable_->tech_name_index);
+
+		uint32_t layout_id;
+		do
 		{
-			if (semantic_hash == param.SemanticHash())
+			layout_id = next_layout_id.fetch_add(1, std::memory_order_relaxed);
+		} while (layout_id == 0);
+		immutable_->layout_id.store(layout_id, std::memory_order_release);
+	}
+
+	uint32_t RenderEffect::FindParameter(size_t name_hash) const noexcept
+	{
+		if (immutable_ && (immutable_->layout_id.load(std::memory_order_acquire) != 0))
+		{
+			return FindInNameIndex(immutable_->param_name_index, name_hash);
+		}
+
+		// Still loading
+		for (uint32_t i = 0; i < params_.size(); ++i)
+		{
+			if (name_hash == params_[i].NameHash())
 			{
-				return &param;
+				return i;
 			}
 		}
-		return nullptr;
+		return static_cast<uint32_t>(-1);
 	}
 
-	RenderEffectParameter const* RenderEffect::ParameterBySemantic(std::string_view semantic) const noexcept
+	uint32_t RenderEffect::FindTechnique(size_t name_hash) const noexcept
 	{
-		size_t const semantic_hash = HashValue(std::move(semantic));
-		for (auto const& param : params_)
+		if (immutable_)
 		{
-			if (semantic_hash == param.SemanticHash())
+			if (immutable_->layout_id.load(std::memory_order_acquire) != 0)
 			{
-				return &param;
+				return FindInNameIndex(immutable_->tech_name_index, name_hash);
+			}
+
+			// Still loading
+			for (uint32_t i = 0; i < immutable_->techniques.size(); ++i)
+			{
+				if (name_hash == immutable_->techniques[i].NameHash())
+				{
+					return i;
+				}
 			}
 		}
-		return nullptr;
+		return static_cast<uint32_t>(-1);
 	}
 
-	RenderEffectParameter* RenderEffect::ParameterByName(std::string_view name) noexcept
+	template <typename T>
+	uint32_t RenderEffect::ResolveHandle(RenderEffectHandle<T> const& handle) const noexcept
 	{
-		size_t const name_hash = HashValue(std::move(name));
+		bool constexpr is_tech = std::is_same_v<T, RenderTechnique>;
+
+		uint32_t const layout_id = immutable_ ? immutable_->layout_id.load(std::memory_order_acquire) : 0;
+		if (layout_id == 0)
+		{
+			return is_tech ? this->FindTechnique(handle.name_hash_) : this->FindParameter(handle.name_hash_);
+		}
+
+		uint64_t const resolved = handle.resolved_.load(std::memory_order_relaxed);
+		if ((resolved >> 32) == layout_id)
+		{
+			return static_cast<uint32_t>(resolved);
+		}
+
+		uint32_t const index =
+			FindInNameIndex(is_tech ? immutable_->tech_name_index : immutable_->param_name_index, handle.name_hash_);
+		handle.resolved_.store((static_cast<uint64_t>(layout_id) << 32) | index, std::memory_order_relaxed);
+		return index;
+	}
+
+	RenderEffectParameter* RenderEffect::ParameterBySemantic(std::string_view semantic) noexcept
+	{
+		size_t const semantic_hash = HashValue(std::move(semantic));
 		for (auto& param : params_)
 		{
-			if (name_hash == param.NameHash())
+			if (semantic_hash == param.SemanticHash())
 			{
 				return &param;
 			}
@@ -4674,12 +4763,12 @@ namespace KlayGE
 		return nullptr;
 	}
 
-	RenderEffectParameter const* RenderEffect::ParameterByName(std::string_view name) const noexcept
+	RenderEffectParameter const* RenderEffect::ParameterBySemantic(std::string_view semantic) const noexcept
 	{
-		size_t const name_hash = HashValue(std::move(name));
+		size_t const semantic_hash = HashValue(std::move(semantic));
 		for (auto const& param : params_)
 		{
-			if (name_hash == param.NameHash())
+			if (semantic_hash == param.SemanticHash())
 			{
 				return &param;
 			}
@@ -4687,6 +4776,18 @@ namespace KlayGE
 		return nullptr;
 	}
 
+	RenderEffectParameter* RenderEffect::ParameterByName(std::string_view name) noexcept
+	{
+		uint32_t const index = this->FindParameter(HashValue(std::move(name)));
+		return (index != static_cast<uint32_t>(-1)) ? &params_[index] : nullptr;
+	}
+
+	RenderEffectParameter const* RenderEffect::ParameterByName(std::string_view name) const noexcept
+	{
+		uint32_t const index = this->FindParameter(HashValue(std::move(name)));
+		return (index != static_cast<uint32_t>(-1)) ? &params_[index] : nullptr;
+	}
+
 	RenderEffectParameter* RenderEffect::ParameterByIndex(uint32_t n) noexcept
 	{
 		BOOST_ASSERT(n < this->NumParameters());
@@ -4699,6 +4800,18 @@ namespace KlayGE
 		return &params_[n];
 	}
 
+	RenderEffectParameter* RenderEffect::ParameterByHandle(RenderEffectParameterHandle const& handle) noexcept
+	{
+		uint32_t const index = this->ResolveHandle(handle);
+		return (index != static_cast<uint32_t>(-1)) ? &params_[index] : nullptr;
+	}
+
+	RenderEffectParameter const* RenderEffect::ParameterByHandle(RenderEffectParameterHandle const& handle) const noexcept
+	{
+		uint32_t const index = this->ResolveHandle(handle);
+		return (index != static_cast<uint32_t>(-1)) ? &params_[index] : nullptr;
+	}
+
 	RenderEffectConstantBuffer* RenderEffect::CBufferByName(std::string_view name) const noexcept
 	{
 		uint32_t index = this->FindCBuffer(name);
@@ -4772,15 +4885,8 @@ namespace KlayGE
 
 	RenderTechnique* RenderEffect::TechniqueByName(std::string_view name) const noexcept
 	{
-		size_t const name_hash = HashValue(std::move(name));
-		for (auto& tech : immutable_->techniques)
-		{
-			if (name_hash == tech.NameHash())
-			{
-				return &tech;
-			}
-		}
-		return nullptr;
+		uint32_t const index = this->FindTechnique(HashValue(std::move(name)));
+		return (index != static_cast<uint32_t>(-1)) ? &immutable_->techniques[index] : nullptr;
 	}
 
 	RenderTechnique* RenderEffect::TechniqueByIndex(uint32_t n) const noexcept
@@ -4789,6 +4895,12 @@ namespace KlayGE
 		return &immutable_->techniques[n];
 	}
 
+	RenderTechnique* RenderEffect::TechniqueByHandle(RenderTechniqueHandle const& handle) const noexcept
+	{
+		uint32_t const index = this->ResolveHandle(handle);
+		return (index != static_cast<uint32_t>(-1)) ? &immutable_->techniques[index] : nullptr;
+	}
+
 	RenderShaderFragment const& RenderEffect::ShaderFragmentByIndex(uint32_t n) const noexcept
 	{
 		BOOST_ASSERT(n < this->NumShaderFragments());
@@ -7103,6 +7215,7 @@ namespace KlayGE
 		}
 		dst_cbuffer.immutable_ = immutable_;
 		dst_cbuffer.buff_ = buff_;
+		dst_cbuffer.Transient(transient_);
 		dst_cbuffer.Resize(static_cast<uint32_t>(buff_.size()));
 
 		this->RebindParameters(dst_cbuffer, dst_effect);
@@ -7160,7 +7273,7 @@ namespace KlayGE
 	void RenderEffectConstantBuffer::Resize(uint32_t size)
 	{
 		buff_.resize(size);
-		if (size > 0)
+		if ((size > 0) && !this->InConstantRing())
 		{
 			if (!hw_buff_ || (size > hw_buff_->Size()))
 			{
@@ -7169,22 +7282,82 @@ namespace KlayGE
 			}
 		}
 
-		dirty_ = true;
+		this->Dirty(true);
+	}
+
+	void RenderEffectConstantBuffer::Transient(bool transient)
+	{
+		bool const was_in_ring = this->InConstantRing();
+		transient_ = transient;
+		if (this->InConstantRing() != was_in_ring)
+		{
+			hw_buff_.reset();
+			hw_buff_offset_ = 0;
+			ring_frame_ = std::numeric_limits<uint32_t>::max();
+			this->Resize(static_cast<uint32_t>(buff_.size()));
+		}
+	}
+
+	bool RenderEffectConstantBuffer::InConstantRing() const noexcept
+	{
+		return transient_ && Context::Instance().RenderFactoryInstance().RenderEngineInstance().DeviceCaps().constant_buffer_offset_support;
 	}
 
 	void RenderEffectConstantBuffer::Update()
 	{
-		if (dirty_)
+		if (this->InConstantRing())
+		{
+			auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+
+			// A ring alloc only lives through the frame it's made in, so the first use in a frame writes it again
+			if (!buff_.empty() && (this->Dirty() || (ring_frame_ != re.NumFramesEnded())))
+			{
+				uint32_t const size = static_cast<uint32_t>(buff_.size());
+				hw_buff_offset_ = re.AllocTransientConstants(buff_.data(), size);
+				hw_buff_ = re.TransientConstantBuffer();
+				ring_frame_ = re.NumFramesEnded();
+				re.AddConstantBytesUploaded(size);
+			}
+
+			this->Dirty(false);
+		}
+		else if (this->Dirty())
 		{
-			hw_buff_->UpdateSubresource(0, static_cast<uint32_t>(buff_.size()), &buff_[0]);
+			auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+
+			uint32_t const size = static_cast<uint32_t>(buff_.size());
+			uint32_t begin;
+			uint32_t end;
+			if (re.DeviceCaps().constant_buffer_partial_update_support)
+			{
+				// Partial updates have to be in whole registers
+				begin = dirty_begin_ & ~15U;
+				end = std::min((std::min(dirty_end_, size) + 15U) & ~15U, size);
+			}
+			else
+			{
+				begin = 0;
+				end = size;
+			}
+
+			if (begin < end)
+			{
+				if (hw_buff_)
+				{
+					hw_buff_->UpdateSubresource(begin, end - begin, &buff_[begin]);
+				}
+				re.AddConstantBytesUploaded(end - begin);
+			}
 
-			dirty_ = false;
+			this->Dirty(false);
 		}
 	}
 
 	void RenderEffectConstantBuffer::BindHWBuff(GraphicsBufferPtr const & buff)
 	{
+		transient_ = false;
 		hw_buff_ = buff;
+		hw_buff_offset_ = 0;
 		buff_.resize(buff->Size());
 	}
 
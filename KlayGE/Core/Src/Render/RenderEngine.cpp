@@ -52,6 +52,7 @@
 #include <KlayGE/RenderFactory.hpp>
 #include <KlayGE/RenderEffect.hpp>
 #include <KlayGE/RenderView.hpp>
+#include <KlayGE/TransientBuffer.hpp>
 #include <KlayGE/PostProcess.hpp>
 #include <KlayGE/HDRPostProcess.hpp>
 #include <KlayGE/SceneManager.hpp>
@@ -80,7 +81,7 @@ namespace KlayGE
 	/////////////////////////////////////////////////////////////////////////////////
 	RenderEngine::RenderEngine()
 		: num_primitives_just_rendered_(0), num_vertices_just_rendered_(0),
-			num_draws_just_called_(0), num_dispatches_just_called_(0),
+			num_draws_just_called_(0), num_dispatches_just_called_(0), num_constant_bytes_just_uploaded_(0),
 			default_fov_(PI / 4), default_render_width_scale_(1), default_render_height_scale_(1),
 			stereo_method_(STM_None), stereo_separation_(0),
 			fb_stage_(0), force_line_mode_(false)
@@ -118,6 +119,11 @@ namespace KlayGE
 
 	void RenderEngine::EndFrame()
 	{
+		if (transient_cbuffer_)
+		{
+			transient_cbuffer_->OnPresent();
+		}
+		++ num_frames_ended_;
 	}
 
 	// Ⱦ
@@ -659,6 +665,34 @@ namespace KlayGE
 		return ret;
 	}
 
+	uint32_t RenderEngine::NumConstantBytesJustUploaded()
+	{
+		uint32_t const ret = num_constant_bytes_just_uploaded_;
+		num_constant_bytes_just_uploaded_ = 0;
+		return ret;
+	}
+
+	uint32_t RenderEngine::AllocTransientConstants(void const * data, uint32_t size)
+	{
+		BOOST_ASSERT(caps_.constant_buffer_offset_support);
+
+		if (!transient_cbuffer_)
+		{
+			transient_cbuffer_ = MakeUniquePtr<TransientBuffer>(64 * 1024, TransientBuffer::BF_Constant);
+		}
+
+		SubAlloc const alloc = transient_cbuffer_->Alloc(size, data);
+		// Nothing uses it after this frame, so it's retired right away. The space is reused once the GPU is done with the frame.
+		transient_cbuffer_->Dealloc(alloc);
+		return alloc.offset_;
+	}
+
+	GraphicsBufferPtr const & RenderEngine::TransientConstantBuffer() const
+	{
+		BOOST_ASSERT(transient_cbuffer_);
+		return transient_cbuffer_->GetBuffer();
+	}
+
 	// ȡȾ豸
 	/////////////////////////////////////////////////////////////////////////////////
 	RenderDeviceCaps const & RenderEngine::DeviceCaps() const
@@ -1060,10 +1094,19 @@ namespace KlayGE
 	{
 		if (Context::Instance().AppInstance().MainWnd()->Active())
 		{
-			Context::Instance().SceneManagerInstance().Update();
+			SceneManager& scene_mgr = Context::Instance().SceneManagerInstance();
+			scene_mgr.Update();
 
 #ifndef KLAYGE_SHIP
-			PerfProfiler::Instance().CollectData();
+			PerfProfiler& profiler = PerfProfiler::Instance();
+			profiler.CollectData();
+			if (profiler.Capturing())
+			{
+				profiler.FrameMarker();
+				profiler.Counter("Draw calls", scene_mgr.NumDrawCalls());
+				profiler.Counter("Constant bytes uploaded", scene_mgr.NumConstantBytesUploaded());
+				profiler.Counter("Loading resources", ResLoader::Instance().NumLoadingResources());
+			}
 #endif
 		}
 	}
@@ -1420,6 +1463,8 @@ namespace KlayGE
 		predefined_model_cb_.reset();
 		predefined_camera_cb_.reset();
 
+		transient_cbuffer_.reset();
+
 		mipmapper_.reset();
 
 		cur_frame_buffer_.reset();
@@ -1703,6 +1748,8 @@ namespace KlayGE
 	{
 		effect_ = SyncLoadRenderEffect("PredefinedCBuffers.fxml");
 		predefined_cbuffer_ = effect_->CBufferByName("klayge_model");
+		// Changes from draw to draw. The clones in renderables take the flag too.
+		predefined_cbuffer_->Transient(true);
 
 		model_offset_ = effect_->ParameterByName("model")->CBufferOffset();
 		inv_model_offset_ = effect_->ParameterByName("inv_model")->CBufferOffset();
@@ -1726,6 +1773,7 @@ namespace KlayGE
 	{
 		effect_ = SyncLoadRenderEffect("PredefinedCBuffers.fxml");
 		predefined_cbuffer_ = effect_->CBufferByName("klayge_camera");
+		predefined_cbuffer_->Transient(true);
 
 		num_cameras_offset_ = effect_->ParameterByName("num_cameras")->CBufferOffset();
 		camera_indices_offset_ = effect_->ParameterByName("camera_indices")->CBufferOffset();
@@ -75,6 +75,7 @@ namespace KlayGE
 	void Renderable::NumLods(uint32_t lods)
 	{
 		rls_.resize(lods);
+		lod_errors_.resize(lods, 0);
 	}
 
 	uint32_t Renderable::NumLods() const
@@ -95,6 +96,16 @@ namespace KlayGE
 		}
 	}
 
+	void Renderable::LodError(uint32_t lod, float error)
+	{
+		lod_errors_[lod] = error;
+	}
+
+	float Renderable::LodError(uint32_t lod) const
+	{
+		return lod_errors_[lod];
+	}
+
 	RenderLayout& Renderable::GetRenderLayout() const
 	{
 		return this->GetRenderLayout(active_lod_);
@@ -267,9 +278,8 @@ namespace KlayGE
 		int32_t lod;
 		if (active_lod_ < 0)
 		{
-			auto const& camera = *re.CurFrameBuffer()->Viewport()->Camera();
-			lod = MathLib::clamp(static_cast<int32_t>(this->CalcLod(camera.EyePos(), camera.ProjMatrix()(0, 0)) + 0.5f),
-				0, static_cast<int32_t>(this->NumLods() - 1));
+			auto const& viewport = *re.CurFrameBuffer()->Viewport();
+			lod = this->SelectLod(*viewport.Camera(), viewport.Height());
 		}
 		else
 		{
@@ -438,6 +448,34 @@ namespace KlayGE
 		return dist_sq / area / fov_scale;
 	}
 
+	int32_t Renderable::SelectLod(Camera const & camera, uint32_t viewport_height) const
+	{
+		int32_t const max_lod = static_cast<int32_t>(this->NumLods() - 1);
+		if (lod_errors_.empty() || !(lod_errors_.back() > 0))
+		{
+			return MathLib::clamp(static_cast<int32_t>(this->CalcLod(camera.EyePos(), camera.ProjMatrix()(0, 0)) + 0.5f),
+				0, max_lod);
+		}
+
+		// The coarsest LoD whose error covers at most this many pixels, measured at the nearest point of the bound
+		float constexpr MAX_LOD_SCREEN_ERROR = 1.0f;
+
+		auto const aabb_ws = MathLib::transform_aabb(this->PosBound(), model_mat_);
+		float const dist = std::max(MathLib::length(aabb_ws.Center() - camera.EyePos()) - MathLib::length(aabb_ws.HalfSize()),
+			camera.NearPlane());
+		float const scale_sq = std::max({MathLib::length_sq(float3(model_mat_(0, 0), model_mat_(0, 1), model_mat_(0, 2))),
+			MathLib::length_sq(float3(model_mat_(1, 0), model_mat_(1, 1), model_mat_(1, 2))),
+			MathLib::length_sq(float3(model_mat_(2, 0), model_mat_(2, 1), model_mat_(2, 2)))});
+		float const pixels_per_unit = camera.ProjMatrix()(1, 1) * viewport_height * 0.5f * std::sqrt(scale_sq) / dist;
+
+		int32_t lod = max_lod;
+		while ((lod > 0) && (lod_errors_[lod] * pixels_per_unit > MAX_LOD_SCREEN_ERROR))
+		{
+			-- lod;
+		}
+		return lod;
+	}
+
 	bool Renderable::AllHWResourceReady() const
 	{
 		bool ready = this->HWResourceReady();
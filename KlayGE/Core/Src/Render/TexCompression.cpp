@@ -32,9 +32,12 @@
 #include <KlayGE/Context.hpp>
 #include <KlayGE/RenderFactory.hpp>
 #include <KlayGE/Texture.hpp>
+#include <KFL/TaskScheduler.hpp>
 
-#include <vector>
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <vector>
 
 #include <KlayGE/TexCompression.hpp>
 
@@ -293,35 +296,37 @@ namespace KlayGE
 
 		uint8_t const * src = static_cast<uint8_t const *>(input);
 
-		std::vector<uint8_t> uncompressed(block_width * block_height * elem_size);
-		for (uint32_t y_base = 0; y_base < height; y_base += block_height)
-		{
-			uint8_t* dst = static_cast<uint8_t*>(output) + (y_base / block_height) * out_row_pitch;
-
-			for (uint32_t x_base = 0; x_base < width; x_base += block_width)
+		uint32_t const num_block_rows = (height + block_height - 1) / block_height;
+		this->ForEachBlockRow(num_block_rows, [=](TexCompression& codec, uint32_t block_row)
 			{
-				for (uint32_t y = 0; y < block_height; ++ y)
+				uint32_t const y_base = block_row * block_height;
+				uint8_t* dst = static_cast<uint8_t*>(output) + block_row * out_row_pitch;
+
+				std::vector<uint8_t> uncompressed(block_width * block_height * elem_size);
+				for (uint32_t x_base = 0; x_base < width; x_base += block_width)
 				{
-					for (uint32_t x = 0; x < block_width; ++ x)
+					for (uint32_t y = 0; y < block_height; ++ y)
 					{
-						if ((x_base + x < width) && (y_base + y < height))
+						for (uint32_t x = 0; x < block_width; ++ x)
 						{
-							memcpy(&uncompressed[(y * block_width + x) * elem_size],
-								&src[(y_base + y) * in_row_pitch + (x_base + x) * elem_size],
-								elem_size);
-						}
-						else
-						{
-							memset(&uncompressed[(y * block_width + x) * elem_size],
-								0, elem_size);
+							if ((x_base + x < width) && (y_base + y < height))
+							{
+								memcpy(&uncompressed[(y * block_width + x) * elem_size],
+									&src[(y_base + y) * in_row_pitch + (x_base + x) * elem_size],
+									elem_size);
+							}
+							else
+							{
+								memset(&uncompressed[(y * block_width + x) * elem_size],
+									0, elem_size);
+							}
 						}
 					}
-				}
 
-				this->EncodeBlock(dst, &uncompressed[0], method);
-				dst += block_bytes;
-			}
-		}
+					codec.EncodeBlock(dst, &uncompressed[0], method);
+					dst += block_bytes;
+				}
+			});
 	}
 
 	void TexCompression::DecodeMem(uint32_t width, uint32_t height,
@@ -338,28 +343,82 @@ namespace KlayGE
 
 		uint8_t * dst = static_cast<uint8_t*>(output);
 
-		std::vector<uint8_t> uncompressed(block_width * block_height * elem_size);
-		for (uint32_t y_base = 0; y_base < height; y_base += block_height)
-		{
-			uint8_t const * src = static_cast<uint8_t const *>(input) + in_row_pitch * (y_base / block_height);
-
-			uint32_t const block_h = std::min(block_height, height - y_base);
-			for (uint32_t x_base = 0; x_base < width; x_base += block_width)
+		uint32_t const num_block_rows = (height + block_height - 1) / block_height;
+		this->ForEachBlockRow(num_block_rows, [=](TexCompression& codec, uint32_t block_row)
 			{
-				uint32_t const block_w = std::min(block_width, width - x_base);
+				uint32_t const y_base = block_row * block_height;
+				uint8_t const * src = static_cast<uint8_t const *>(input) + in_row_pitch * block_row;
+
+				std::vector<uint8_t> uncompressed(block_width * block_height * elem_size);
+				uint32_t const block_h = std::min(block_height, height - y_base);
+				for (uint32_t x_base = 0; x_base < width; x_base += block_width)
+				{
+					uint32_t const block_w = std::min(block_width, width - x_base);
+
+					codec.DecodeBlock(&uncompressed[0], src);
+					src += block_bytes;
+
+					for (uint32_t y = 0; y < block_h; ++ y)
+					{
+						for (uint32_t x = 0; x < block_w; ++ x)
+						{
+							memcpy(&dst[(y_base + y) * out_row_pitch + (x_base + x) * elem_size],
+								&uncompressed[(y * block_width + x) * elem_size], elem_size);
+						}
+					}
+				}
+			});
+	}
+
+	void TexCompression::ForEachBlockRow(uint32_t num_block_rows,
+		std::function<void(TexCompression& codec, uint32_t block_row)> const & func)
+	{
+		auto& task_scheduler = Context::Instance().TaskSchedulerInstance();
 
-				this->DecodeBlock(&uncompressed[0], src);
-				src += block_bytes;
+		uint32_t num_threads = num_threads_;
+		if (0 == num_threads)
+		{
+			num_threads = task_scheduler.Concurrency();
+		}
+		num_threads = std::min(num_threads, num_block_rows);
 
-				for (uint32_t y = 0; y < block_h; ++ y)
+		if (num_threads <= 1)
+		{
+			for (uint32_t block_row = 0; block_row < num_block_rows; ++ block_row)
+			{
+				func(*this, block_row);
+			}
+		}
+		else
+		{
+			// Rows are handed out one at a time, so that expensive rows don't stall a fixed partition. Codecs keep states during
+			// encoding, so every extra thread works on its own clone.
+			std::atomic<uint32_t> next_block_row(0);
+			auto worker = [&next_block_row, num_block_rows, &func](TexCompression& codec)
+			{
+				for (;;)
 				{
-					for (uint32_t x = 0; x < block_w; ++ x)
+					uint32_t const block_row = next_block_row.fetch_add(1, std::memory_order_relaxed);
+					if (block_row >= num_block_rows)
 					{
-						memcpy(&dst[(y_base + y) * out_row_pitch + (x_base + x) * elem_size],
-							&uncompressed[(y * block_width + x) * elem_size], elem_size);
+						break;
 					}
+
+					func(codec, block_row);
 				}
+			};
+
+			std::vector<std::unique_ptr<TexCompression>> codecs(num_threads - 1);
+			TaskGroup group;
+			for (uint32_t i = 0; i < num_threads - 1; ++ i)
+			{
+				codecs[i] = this->Clone();
+				task_scheduler.Run(group, [&worker, &codec = *codecs[i]] { worker(codec); });
 			}
+
+			worker(*this);
+
+			task_scheduler.Wait(group);
 		}
 	}
 
@@ -30,6 +30,7 @@
 
 #include <KlayGE/KlayGE.hpp>
 #include <KFL/CXX20/bit.hpp>
+#include <KFL/CpuInfo.hpp>
 #include <KFL/ErrorHandling.hpp>
 #include <KlayGE/Context.hpp>
 #include <KlayGE/RenderFactory.hpp>
@@ -39,10 +40,15 @@
 
 #include <cstring>
 #include <iterator>
+#include <limits>
 #include <random>
 #include <vector>
 #include <boost/assert.hpp>
 
+#if defined(KLAYGE_SSE2_SUPPORT)
+#include <emmintrin.h>
+#endif
+
 #include <KlayGE/TexCompressionBC.hpp>
 #include "../Base/TableGen/Tables.hpp"
 
@@ -837,12 +843,265 @@ namespace
 		}
 	}
 
-	int IntRand()
+	std::mt19937& IntRandGenerator()
 	{
 		static thread_local std::mt19937 gen;
+		return gen;
+	}
+
+	int IntRand()
+	{
 		std::uniform_int_distribution<int> random_dis(0, RAND_MAX);
-		return random_dis(gen);
+		return random_dis(IntRandGenerator());
+	}
+
+	// Real-time BC1 endpoints. The bounding box is inset by 1/16 of its size, and the diagonal is flipped on the channels
+	// that are anti-correlated with green.
+	void FitBC1Box(std::array<int, 3>& min, std::array<int, 3>& max, int cov_bg, int cov_rg,
+		ARGBColor32& min_clr, ARGBColor32& max_clr)
+	{
+		for (int ch = 0; ch < 3; ++ ch)
+		{
+			int const inset = (max[ch] - min[ch]) >> 4;
+			min[ch] += inset;
+			max[ch] -= inset;
+		}
+		if (cov_bg < 0)
+		{
+			std::swap(min[ARGBColor32::BChannel], max[ARGBColor32::BChannel]);
+		}
+		if (cov_rg < 0)
+		{
+			std::swap(min[ARGBColor32::RChannel], max[ARGBColor32::RChannel]);
+		}
+
+		min_clr = ARGBColor32(255, static_cast<uint8_t>(min[ARGBColor32::RChannel]),
+			static_cast<uint8_t>(min[ARGBColor32::GChannel]), static_cast<uint8_t>(min[ARGBColor32::BChannel]));
+		max_clr = ARGBColor32(255, static_cast<uint8_t>(max[ARGBColor32::RChannel]),
+			static_cast<uint8_t>(max[ARGBColor32::GChannel]), static_cast<uint8_t>(max[ARGBColor32::BChannel]));
+	}
+
+	void SelectBC1BoxScalar(ARGBColor32 const * argb, ARGBColor32& min_clr, ARGBColor32& max_clr)
+	{
+		std::array<int, 3> min, max, center;
+		for (int ch = 0; ch < 3; ++ ch)
+		{
+			min[ch] = max[ch] = argb[0][ch];
+			for (int i = 1; i < 16; ++ i)
+			{
+				min[ch] = std::min<int>(min[ch], argb[i][ch]);
+				max[ch] = std::max<int>(max[ch], argb[i][ch]);
+			}
+			center[ch] = (min[ch] + max[ch] + 1) >> 1;
+		}
+
+		int cov_bg = 0;
+		int cov_rg = 0;
+		for (int i = 0; i < 16; ++ i)
+		{
+			int const g = argb[i].g() - center[ARGBColor32::GChannel];
+			cov_bg += (argb[i].b() - center[ARGBColor32::BChannel]) * g;
+			cov_rg += (argb[i].r() - center[ARGBColor32::RChannel]) * g;
+		}
+
+		FitBC1Box(min, max, cov_bg, cov_rg, min_clr, max_clr);
+	}
+
+	// Index of the closest palette entry by sum of absolute differences. Ties go to the lower index.
+	uint32_t MatchBC1ColorsScalar(ARGBColor32 const * argb, std::array<ARGBColor32, 4> const & palette)
+	{
+		uint32_t mask = 0;
+		for (int i = 15; i >= 0; -- i)
+		{
+			uint32_t best_index = 0;
+			int best_dist = std::numeric_limits<int>::max();
+			for (uint32_t j = 0; j < palette.size(); ++ j)
+			{
+				int const dist = std::abs(argb[i].r() - palette[j].r()) + std::abs(argb[i].g() - palette[j].g())
+					+ std::abs(argb[i].b() - palette[j].b());
+				if (dist < best_dist)
+				{
+					best_dist = dist;
+					best_index = j;
+				}
+			}
+
+			mask = (mask << 2) | best_index;
+		}
+
+		return mask;
+	}
+
+#if defined(KLAYGE_SSE2_SUPPORT)
+	bool SSE2KernelsSupported()
+	{
+		static bool const supported = CpuInfo().IsFeatureSupport(CpuInfo::CF_SSE2);
+		return supported;
+	}
+
+	// The same as SelectBC1BoxScalar, 4 pixels per register
+	void SelectBC1BoxSSE2(ARGBColor32 const * argb, ARGBColor32& min_clr, ARGBColor32& max_clr)
+	{
+		__m128i const * src = reinterpret_cast<__m128i const *>(argb);
+		__m128i const pixels[] =
+		{
+			_mm_loadu_si128(src + 0), _mm_loadu_si128(src + 1), _mm_loadu_si128(src + 2), _mm_loadu_si128(src + 3)
+		};
+
+		__m128i min_v = _mm_min_epu8(_mm_min_epu8(pixels[0], pixels[1]), _mm_min_epu8(pixels[2], pixels[3]));
+		__m128i max_v = _mm_max_epu8(_mm_max_epu8(pixels[0], pixels[1]), _mm_max_epu8(pixels[2], pixels[3]));
+		min_v = _mm_min_epu8(min_v, _mm_shuffle_epi32(min_v, _MM_SHUFFLE(1, 0, 3, 2)));
+		max_v = _mm_max_epu8(max_v, _mm_shuffle_epi32(max_v, _MM_SHUFFLE(1, 0, 3, 2)));
+		min_v = _mm_min_epu8(min_v, _mm_shuffle_epi32(min_v, _MM_SHUFFLE(2, 3, 0, 1)));
+		max_v = _mm_max_epu8(max_v, _mm_shuffle_epi32(max_v, _MM_SHUFFLE(2, 3, 0, 1)));
+
+		__m128i const zero = _mm_setzero_si128();
+		__m128i const center = _mm_unpacklo_epi8(_mm_avg_epu8(min_v, max_v), zero);
+		__m128i const br_mask = _mm_setr_epi16(-1, 0, -1, 0, -1, 0, -1, 0);
+		__m128i cov = zero;
+		for (auto const & p : pixels)
+		{
+			for (int half = 0; half < 2; ++ half)
+			{
+				__m128i const p16 = (0 == half) ? _mm_unpacklo_epi8(p, zero) : _mm_unpackhi_epi8(p, zero);
+				__m128i const d = _mm_sub_epi16(p16, center);
+				__m128i const g = _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, _MM_SHUFFLE(1, 1, 1, 1)), _MM_SHUFFLE(1, 1, 1, 1));
+				cov = _mm_add_epi32(cov, _mm_madd_epi16(_mm_and_si128(d, br_mask), g));
+			}
+		}
+		cov = _mm_add_epi32(cov, _mm_shuffle_epi32(cov, _MM_SHUFFLE(1, 0, 3, 2)));
+
+		ARGBColor32 const min32(static_cast<uint32_t>(_mm_cvtsi128_si32(min_v)));
+		ARGBColor32 const max32(static_cast<uint32_t>(_mm_cvtsi128_si32(max_v)));
+		std::array<int, 3> min, max;
+		for (int ch = 0; ch < 3; ++ ch)
+		{
+			min[ch] = min32[ch];
+			max[ch] = max32[ch];
+		}
+
+		FitBC1Box(min, max, _mm_cvtsi128_si32(cov), _mm_cvtsi128_si32(_mm_srli_si128(cov, 4)), min_clr, max_clr);
+	}
+
+	// Moves bit i to bit 2 * i
+	uint32_t SpreadBits16(uint32_t v)
+	{
+		v = (v | (v << 8)) & 0x00FF00FF;
+		v = (v | (v << 4)) & 0x0F0F0F0F;
+		v = (v | (v << 2)) & 0x33333333;
+		v = (v | (v << 1)) & 0x55555555;
+		return v;
+	}
+
+	// The same as MatchBC1ColorsScalar, 4 pixels per register
+	uint32_t MatchBC1ColorsSSE2(ARGBColor32 const * argb, std::array<ARGBColor32, 4> const & palette)
+	{
+		__m128i const rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+		__m128i const byte_mask = _mm_set1_epi32(0xFF);
+
+		__m128i clrs[4];
+		for (size_t j = 0; j < palette.size(); ++ j)
+		{
+			clrs[j] = _mm_set1_epi32(static_cast<int>(palette[j].ARGB()));
+		}
+
+		__m128i const * src = reinterpret_cast<__m128i const *>(argb);
+		__m128i indices[4];
+		for (size_t i = 0; i < std::size(indices); ++ i)
+		{
+			__m128i const p = _mm_loadu_si128(src + i);
+
+			__m128i best_dist;
+			__m128i best_index = _mm_setzero_si128();
+			for (size_t j = 0; j < std::size(clrs); ++ j)
+			{
+				__m128i const diff = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(p, clrs[j]), _mm_subs_epu8(clrs[j], p)), rgb_mask);
+				__m128i const dist = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(diff, byte_mask),
+					_mm_and_si128(_mm_srli_epi32(diff, 8), byte_mask)), _mm_srli_epi32(diff, 16));
+				if (0 == j)
+				{
+					best_dist = dist;
+				}
+				else
+				{
+					__m128i const closer = _mm_cmplt_epi32(dist, best_dist);
+					best_dist = _mm_or_si128(_mm_and_si128(closer, dist), _mm_andnot_si128(closer, best_dist));
+					best_index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(static_cast<int>(j))),
+						_mm_andnot_si128(closer, best_index));
+				}
+			}
+
+			indices[i] = best_index;
+		}
+
+		// 16 indices in bytes, then split them into the low and high bit planes
+		__m128i const indices8 = _mm_packus_epi16(_mm_packs_epi32(indices[0], indices[1]), _mm_packs_epi32(indices[2], indices[3]));
+		uint32_t const lo = static_cast<uint32_t>(_mm_movemask_epi8(_mm_slli_epi16(indices8, 7)));
+		uint32_t const hi = static_cast<uint32_t>(_mm_movemask_epi8(_mm_slli_epi16(indices8, 6)));
+		return SpreadBits16(lo) | (SpreadBits16(hi) << 1);
 	}
+
+	// The same as the scalar path of TexCompressionBC4::EncodeBlock, 8 pixels per register
+	void EncodeBC4SSE2(BC4Block& bc4, uint8_t const * r)
+	{
+		__m128i const pixels = _mm_loadu_si128(reinterpret_cast<__m128i const *>(r));
+
+		__m128i min_v = _mm_min_epu8(pixels, _mm_srli_si128(pixels, 8));
+		__m128i max_v = _mm_max_epu8(pixels, _mm_srli_si128(pixels, 8));
+		min_v = _mm_min_epu8(min_v, _mm_srli_si128(min_v, 4));
+		max_v = _mm_max_epu8(max_v, _mm_srli_si128(max_v, 4));
+		min_v = _mm_min_epu8(min_v, _mm_srli_si128(min_v, 2));
+		max_v = _mm_max_epu8(max_v, _mm_srli_si128(max_v, 2));
+		min_v = _mm_min_epu8(min_v, _mm_srli_si128(min_v, 1));
+		max_v = _mm_max_epu8(max_v, _mm_srli_si128(max_v, 1));
+		int const min = _mm_cvtsi128_si32(min_v) & 0xFF;
+		int const max = _mm_cvtsi128_si32(max_v) & 0xFF;
+
+		bc4.alpha_0 = static_cast<uint8_t>(max);
+		bc4.alpha_1 = static_cast<uint8_t>(min);
+
+		int const dist = max - min;
+		__m128i const dist1_v = _mm_set1_epi16(static_cast<int16_t>(dist));
+		__m128i const dist2_v = _mm_set1_epi16(static_cast<int16_t>(dist * 2));
+		__m128i const dist4_v = _mm_set1_epi16(static_cast<int16_t>(dist * 4));
+		__m128i const bias_v = _mm_set1_epi16(static_cast<int16_t>(min * 7 - (dist >> 1)));
+		__m128i const seven = _mm_set1_epi16(7);
+		__m128i const zero = _mm_setzero_si128();
+
+		__m128i indices[2];
+		for (size_t i = 0; i < std::size(indices); ++ i)
+		{
+			__m128i const p16 = (0 == i) ? _mm_unpacklo_epi8(pixels, zero) : _mm_unpackhi_epi8(pixels, zero);
+			__m128i a = _mm_sub_epi16(_mm_mullo_epi16(p16, seven), bias_v);
+
+			__m128i t = _mm_cmpgt_epi16(a, dist4_v);
+			__m128i ind = _mm_and_si128(t, _mm_set1_epi16(4));
+			a = _mm_sub_epi16(a, _mm_and_si128(dist4_v, t));
+			t = _mm_cmpgt_epi16(a, dist2_v);
+			ind = _mm_add_epi16(ind, _mm_and_si128(t, _mm_set1_epi16(2)));
+			a = _mm_sub_epi16(a, _mm_and_si128(dist2_v, t));
+			t = _mm_cmpgt_epi16(a, dist1_v);
+			ind = _mm_add_epi16(ind, _mm_and_si128(t, _mm_set1_epi16(1)));
+
+			ind = _mm_and_si128(_mm_sub_epi16(zero, ind), seven);
+			ind = _mm_xor_si128(ind, _mm_and_si128(_mm_cmpgt_epi16(_mm_set1_epi16(2), ind), _mm_set1_epi16(1)));
+			indices[i] = ind;
+		}
+
+		std::array<uint8_t, 16> ind8;
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(ind8.data()), _mm_packus_epi16(indices[0], indices[1]));
+
+		uint64_t bits = 0;
+		for (size_t i = 0; i < ind8.size(); ++ i)
+		{
+			bits |= static_cast<uint64_t>(ind8[i]) << (i * 3);
+		}
+		for (size_t i = 0; i < std::size(bc4.bitmap); ++ i)
+		{
+			bc4.bitmap[i] = static_cast<uint8_t>(bits >> (i * 8));
+		}
+	}
+#endif
 }
 
 namespace KlayGE
@@ -854,6 +1113,11 @@ namespace KlayGE
 		compression_format_ = EF_BC1;
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionBC1::Clone() const
+	{
+		return MakeUniquePtr<TexCompressionBC1>();
+	}
+
 	void TexCompressionBC1::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		BOOST_ASSERT(output);
@@ -1232,6 +1496,48 @@ namespace KlayGE
 		}
 	}
 
+	// Bounding box endpoints and nearest palette entries, no refinement. For runtime transcoding.
+	uint32_t TexCompressionBC1::RealtimeColorsBlock(ARGBColor32 const * argb, uint16_t& min16, uint16_t& max16) const
+	{
+		ARGBColor32 max_clr, min_clr;
+#if defined(KLAYGE_SSE2_SUPPORT)
+		bool const sse2 = SSE2KernelsSupported();
+		if (sse2)
+		{
+			SelectBC1BoxSSE2(argb, min_clr, max_clr);
+		}
+		else
+#endif
+		{
+			SelectBC1BoxScalar(argb, min_clr, max_clr);
+		}
+
+		max16 = this->RGB888To565(max_clr);
+		min16 = this->RGB888To565(min_clr);
+		if (max16 == min16)
+		{
+			return 0;
+		}
+
+		std::array<ARGBColor32, 4> palette;
+		palette[0] = this->RGB565To888(max16);
+		palette[1] = this->RGB565To888(min16);
+		for (int ch = 0; ch < 3; ++ ch)
+		{
+			palette[2][ch] = static_cast<uint8_t>((palette[0][ch] * 2 + palette[1][ch]) / 3);
+			palette[3][ch] = static_cast<uint8_t>((palette[0][ch] + palette[1][ch] * 2) / 3);
+		}
+		palette[2].a() = palette[3].a() = 255;
+
+#if defined(KLAYGE_SSE2_SUPPORT)
+		if (sse2)
+		{
+			return MatchBC1ColorsSSE2(argb, palette);
+		}
+#endif
+		return MatchBC1ColorsScalar(argb, palette);
+	}
+
 	void TexCompressionBC1::EncodeBC1Internal(BC1Block& bc1, ARGBColor32 const * argb,
 			bool alpha, TexCompressionMethod method) const
 	{
@@ -1248,7 +1554,11 @@ namespace KlayGE
 
 		uint32_t mask;
 		uint16_t max16, min16;
-		if (min32 != max32) // no constant color
+		if ((min32 != max32) && (TCM_Realtime == method) && !alpha)
+		{
+			mask = this->RealtimeColorsBlock(argb, min16, max16);
+		}
+		else if (min32 != max32) // no constant color
 		{
 			ARGBColor32 max_clr, min_clr;
 			this->OptimizeColorsBlock(argb, min_clr, max_clr, method);
@@ -1341,6 +1651,11 @@ namespace KlayGE
 		compression_format_ = EF_BC2;
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionBC2::Clone() const
+	{
+		return MakeUniquePtr<TexCompressionBC2>();
+	}
+
 	void TexCompressionBC2::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		BOOST_ASSERT(output);
@@ -1392,6 +1707,11 @@ namespace KlayGE
 		compression_format_ = EF_BC3;
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionBC3::Clone() const
+	{
+		return MakeUniquePtr<TexCompressionBC3>();
+	}
+
 	void TexCompressionBC3::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		BOOST_ASSERT(output);
@@ -1438,6 +1758,11 @@ namespace KlayGE
 		compression_format_ = EF_BC4;
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionBC4::Clone() const
+	{
+		return MakeUniquePtr<TexCompressionBC4>();
+	}
+
 	// Alpha block compression (this is easy for a change)
 	void TexCompressionBC4::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
@@ -1449,6 +1774,14 @@ namespace KlayGE
 		BC4Block& bc4 = *static_cast<BC4Block*>(output);
 		uint8_t const * r = static_cast<uint8_t const *>(input);
 
+#if defined(KLAYGE_SSE2_SUPPORT)
+		if (SSE2KernelsSupported())
+		{
+			EncodeBC4SSE2(bc4, r);
+			return;
+		}
+#endif
+
 		// find min/max color
 		int min, max;
 		min = max = r[0];
@@ -1544,6 +1877,11 @@ namespace KlayGE
 		compression_format_ = EF_BC5;
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionBC5::Clone() const
+	{
+		return MakeUniquePtr<TexCompressionBC5>();
+	}
+
 	void TexCompressionBC5::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		BOOST_ASSERT(output);
@@ -1844,6 +2182,11 @@ namespace KlayGE
 		compression_format_ = EF_BC6;
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionBC6U::Clone() const
+	{
+		return MakeUniquePtr<TexCompressionBC6U>();
+	}
+
 	void TexCompressionBC6U::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		KFL_UNUSED(output);
@@ -2095,6 +2438,11 @@ namespace KlayGE
 		compression_format_ = EF_SIGNED_BC6;
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionBC6S::Clone() const
+	{
+		return MakeUniquePtr<TexCompressionBC6S>();
+	}
+
 	void TexCompressionBC6S::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		KFL_UNUSED(output);
@@ -2137,6 +2485,11 @@ namespace KlayGE
 		compression_format_ = EF_BC7;
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionBC7::Clone() const
+	{
+		return MakeUniquePtr<TexCompressionBC7>();
+	}
+
 	void TexCompressionBC7::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		BOOST_ASSERT(output);
@@ -2161,6 +2514,9 @@ namespace KlayGE
 			return;
 		}
 
+		// Every block starts from the same random sequence. The result doesn't depend on which thread encodes the block, or in what order.
+		IntRandGenerator().seed(std::mt19937::default_seed);
+
 		TexCompressionErrorMetric metric = TCEM_Uniform;
 		int sa_steps;
 		switch (method)
@@ -2171,6 +2527,7 @@ namespace KlayGE
 		case TCM_Balanced:
 			sa_steps = 10;
 			break;
+		case TCM_Realtime:
 		case TCM_Speed:
 			sa_steps = 0;
 			break;
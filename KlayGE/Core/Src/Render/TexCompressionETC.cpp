@@ -34,6 +34,7 @@
 #include <KFL/Color.hpp>
 #include <KlayGE/Texture.hpp>
 
+#include <algorithm>
 #include <cstring>
 #include <iterator>
 #include <vector>
@@ -650,6 +651,11 @@ namespace KlayGE
 		sorted_luma_indices_ = nullptr;
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionETC1::Clone() const
+	{
+		return MakeUniquePtr<TexCompressionETC1>();
+	}
+
 	void TexCompressionETC1::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		BOOST_ASSERT(output);
@@ -686,7 +692,7 @@ namespace KlayGE
 		ARGBColor32 subblock_pixels[8];
 
 		Params params;
-		params.quality_ = method;
+		params.quality_ = std::max(method, TCM_Speed);
 		params.num_src_pixels_ = 8;
 		params.src_pixels_ = subblock_pixels;
 
@@ -1822,6 +1828,11 @@ namespace KlayGE
 		etc1_codec_ = MakeUniquePtr<TexCompressionETC1>();
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionETC2RGB8::Clone() const
+	{
+		return MakeUniquePtr<TexCompressionETC2RGB8>();
+	}
+
 	void TexCompressionETC2RGB8::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		KFL_UNUSED(output);
@@ -2043,6 +2054,11 @@ namespace KlayGE
 		etc2_rgb8_codec_ = MakeUniquePtr<TexCompressionETC2RGB8>();
 	}
 
+	std::unique_ptr<TexCompression> TexCompressionETC2RGB8A1::Clone() const
+	{
+		return MakeUniquePtr<TexCompressionETC2RGB8A1>();
+	}
+
 	void TexCompressionETC2RGB8A1::EncodeBlock(void* output, void const * input, TexCompressionMethod method)
 	{
 		KFL_UNUSED(output);
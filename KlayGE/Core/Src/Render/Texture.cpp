@@ -903,6 +903,9 @@ namespace
 			KFL_UNREACHABLE("Invalid compression format");
 		}
 
+		// TCM_Quality is expensive, use all the cores
+		codec->NumThreads(0);
+
 		uint8_t const * src = static_cast<uint8_t const *>(src_data);
 		uint8_t* dst = static_cast<uint8_t*>(dst_data);
 		for (uint32_t z = 0; z < src_depth; ++ z)
@@ -1317,6 +1320,14 @@ namespace
 			return false;
 		}
 
+		uint64_t Hash() const override
+		{
+			size_t seed = static_cast<size_t>(this->Type());
+			HashRange(seed, tex_desc_.res_name.begin(), tex_desc_.res_name.end());
+			HashCombine(seed, tex_desc_.access_hint);
+			return seed;
+		}
+
 		void CopyDataFrom(ResLoadingDesc const & rhs) override
 		{
 			BOOST_ASSERT(this->Type() == rhs.Type());
@@ -2342,9 +2353,9 @@ namespace KlayGE
 		return ResLoader::Instance().SyncQueryT<Texture>(MakeSharedPtr<TextureLoadingDesc>(tex_name, access_hint));
 	}
 
-	TexturePtr ASyncLoadTexture(std::string_view tex_name, uint32_t access_hint)
+	TexturePtr ASyncLoadTexture(std::string_view tex_name, uint32_t access_hint, float priority)
 	{
-		return ResLoader::Instance().ASyncQueryT<Texture>(MakeSharedPtr<TextureLoadingDesc>(tex_name, access_hint));
+		return ResLoader::Instance().ASyncQueryT<Texture>(MakeSharedPtr<TextureLoadingDesc>(tex_name, access_hint), priority);
 	}
 } // namespace KlayGE
 
@@ -43,6 +43,11 @@ namespace KlayGE
 	TransientBuffer::TransientBuffer(uint32_t size_in_byte, TransientBuffer::BindFlag bind_flag)
 		: bind_flag_(bind_flag)
 	{
+		if (BF_Constant == bind_flag_)
+		{
+			size_in_byte = (size_in_byte + CONSTANT_ALIGNMENT - 1) & ~(CONSTANT_ALIGNMENT - 1);
+		}
+
 		RenderFactory& rf = Context::Instance().RenderFactoryInstance();
 		RenderEngine const & re = rf.RenderEngineInstance();
 		RenderDeviceCaps const & caps = re.DeviceCaps();
@@ -81,6 +86,10 @@ namespace KlayGE
 			buffer = rf.MakeIndexBuffer(BU_Dynamic, EAH_CPU_Write | EAH_GPU_Read, size_in_byte, nullptr);
 			break;
 
+		case BF_Constant:
+			buffer = rf.MakeConstantBuffer(BU_Dynamic, EAH_CPU_Write | EAH_GPU_Read, size_in_byte, nullptr);
+			break;
+
 		default:
 			KFL_UNREACHABLE("Invalid bind flag");
 		}
@@ -89,6 +98,13 @@ namespace KlayGE
 
 	SubAlloc TransientBuffer::Alloc(uint32_t size_in_byte, void const * data)
 	{
+		uint32_t const data_size = size_in_byte;
+		if (BF_Constant == bind_flag_)
+		{
+			// Every alloc and the buffer size stay in whole alignments, so all offsets are aligned
+			size_in_byte = (size_in_byte + CONSTANT_ALIGNMENT - 1) & ~(CONSTANT_ALIGNMENT - 1);
+		}
+
 		SubAlloc ret;
 
 		// Use first fit method to find a free sub alloc
@@ -150,11 +166,11 @@ namespace KlayGE
 		{
 			GraphicsBuffer::Mapper mapper(*buffer_, BA_Write_No_Overwrite);
 			uint8_t* buffer_data = mapper.Pointer<uint8_t>();
-			memcpy(buffer_data + ret.offset_, data, ret.length_);
+			memcpy(buffer_data + ret.offset_, data, data_size);
 		}
 		else
 		{
-			memcpy(&simulate_buffer_[ret.offset_], data, ret.length_);
+			memcpy(&simulate_buffer_[ret.offset_], data, data_size);
 			valid_min_ = std::min(valid_min_, ret.offset_);
 			valid_max_ = std::max(valid_max_, ret.offset_ + ret.length_);
 		}
@@ -52,13 +52,59 @@
 #include <KlayGE/InputFactory.hpp>
 #include <KlayGE/FrameBuffer.hpp>
 #include <KlayGE/DeferredRenderingLayer.hpp>
+#include <KlayGE/PerfProfiler.hpp>
+#include <KFL/CXX20/bit.hpp>
 #include <KFL/Hash.hpp>
+#include <KFL/RadixSort.hpp>
+#include <KFL/TaskScheduler.hpp>
+#include <KFL/Timer.hpp>
 
 #include <map>
 #include <algorithm>
 
 #include <KlayGE/SceneManager.hpp>
 
+namespace
+{
+	using namespace KlayGE;
+
+	// Render queue sort keys, from the most significant bits: technique order (24 bits), material (16 bits) and depth (24 bits)
+	uint32_t constexpr SORT_KEY_TECH_SHIFT = 40;
+	uint32_t constexpr SORT_KEY_MTL_SHIFT = 24;
+	uint32_t constexpr SORT_KEY_MTL_MASK = 0xFFFF;
+
+	// The keys are built in tasks of at most this many items
+	size_t constexpr PARALLEL_KEY_GRAIN_SIZE = 2048;
+
+	// The nearest view space depth of all the instances. The minimum of a linear function on an AABB is at the corner
+	// opposite to the gradient, so the corners don't have to be transformed one by one.
+	float RenderableMinDepth(Renderable const & renderable, float4 const & view_mat_z)
+	{
+		AABBox const & box = renderable.PosBound();
+		float3 const center = box.Center();
+		float3 const extent = box.HalfSize();
+
+		float md = 1e10f;
+		for (uint32_t i = 0; i < renderable.NumInstances(); ++ i)
+		{
+			float4x4 const & mat = renderable.GetInstance(i)->TransformToWorld();
+			float4 const zvec(MathLib::dot(mat.Row(0), view_mat_z),
+				MathLib::dot(mat.Row(1), view_mat_z), MathLib::dot(mat.Row(2), view_mat_z),
+				MathLib::dot(mat.Row(3), view_mat_z));
+			md = std::min(md, center.x() * zvec.x() + center.y() * zvec.y() + center.z() * zvec.z() + zvec.w()
+				- (extent.x() * std::abs(zvec.x()) + extent.y() * std::abs(zvec.y()) + extent.z() * std::abs(zvec.z())));
+		}
+		return md;
+	}
+
+	// The top 24 bits of a float, flipped to sort as unsigned integers
+	uint64_t DepthSortKey(float depth)
+	{
+		uint32_t const bits = std::bit_cast<uint32_t>(depth);
+		return ((bits & 0x80000000U) ? ~bits : (bits | 0x80000000U)) >> 8;
+	}
+}
+
 namespace KlayGE
 {
 	// 캯
@@ -70,7 +116,7 @@ namespace KlayGE
 			update_elapse_(1.0f / 60),
 			num_objects_rendered_(0), num_renderables_rendered_(0),
 			num_primitives_rendered_(0), num_vertices_rendered_(0),
-			num_draw_calls_(0), num_dispatch_calls_(0),
+			num_draw_calls_(0), num_dispatch_calls_(0), num_constant_bytes_uploaded_(0),
 			quit_(false), deferred_mode_(false)
 	{
 		scene_root_.FillVisibleMark(BoundOverlap::Partial);
@@ -170,6 +216,187 @@ namespace KlayGE
 		}
 	}
 
+	void SceneManager::CullCameras(std::span<Camera const * const> cameras, float small_obj_threshold,
+		std::span<VisibilityBitset> visibilities)
+	{
+		BOOST_ASSERT(cameras.size() == visibilities.size());
+
+		std::lock_guard<std::mutex> lock(update_mutex_);
+
+		// Nodes in the same order as Flush collects them, each with the index of its parent
+		cull_nodes_.clear();
+		cull_parents_.clear();
+		std::vector<std::pair<SceneNode const *, int32_t>> ancestors;
+		scene_root_.Traverse([this, &ancestors](SceneNode& node)
+			{
+				while (!ancestors.empty() && (ancestors.back().first != node.Parent()))
+				{
+					ancestors.pop_back();
+				}
+
+				int32_t const index = static_cast<int32_t>(cull_nodes_.size());
+				cull_nodes_.push_back(&node);
+				cull_parents_.push_back(ancestors.empty() ? -1 : ancestors.back().second);
+				ancestors.emplace_back(&node, index);
+				return true;
+			});
+
+		this->PrepareCullCameras();
+
+		// The frustums and matrices are computed lazily. Do it here, before the cameras are shared by the jobs.
+		for (auto const * camera : cameras)
+		{
+			camera->ViewFrustum();
+			camera->ViewProjMatrix();
+		}
+
+		size_t const num_words = (cull_nodes_.size() + 63) / 64;
+		auto cull_job = [this, &cameras, small_obj_threshold, &visibilities, num_words](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++ i)
+			{
+				auto& visibility = visibilities[i];
+				visibility.assign(num_words, 0);
+				VisibilityBitset tested(num_words, 0);
+				this->CullCamera(*cameras[i], small_obj_threshold, visibility, tested);
+				this->ResolveCullHierarchy(*cameras[i], small_obj_threshold, visibility, tested);
+			}
+		};
+
+		// One task per camera
+		Context::Instance().TaskSchedulerInstance().ParallelFor(size_t(0), cameras.size(), size_t(1), cull_job);
+	}
+
+	void SceneManager::PrecullCameras(std::span<Camera const * const> cameras, float small_obj_threshold)
+	{
+		std::vector<VisibilityBitset> visibilities(cameras.size());
+		this->CullCameras(cameras, small_obj_threshold, visibilities);
+
+		precull_visibilities_.clear();
+		for (size_t i = 0; i < cameras.size(); ++ i)
+		{
+			precull_visibilities_[cameras[i]] = std::move(visibilities[i]);
+		}
+		precull_small_obj_threshold_ = small_obj_threshold;
+	}
+
+	void SceneManager::PrepareCullCameras()
+	{
+	}
+
+	void SceneManager::CullCamera(Camera const & camera, float small_obj_threshold, VisibilityBitset& visibility,
+		VisibilityBitset& tested) const
+	{
+		KFL_UNUSED(camera);
+		KFL_UNUSED(small_obj_threshold);
+		KFL_UNUSED(visibility);
+		KFL_UNUSED(tested);
+	}
+
+	// The same rules as ClipScene and VisibleTestFromParent
+	void SceneManager::ResolveCullHierarchy(Camera const & camera, float small_obj_threshold, VisibilityBitset& visibility,
+		VisibilityBitset const & tested) const
+	{
+		Frustum const & frustum = camera.ViewFrustum();
+		float4x4 const & view_proj = camera.ViewProjMatrix();
+		bool const omni_directional = camera.OmniDirectionalMode();
+
+		std::vector<BoundOverlap> overlaps(cull_nodes_.size());
+		for (size_t i = 0; i < cull_nodes_.size(); ++ i)
+		{
+			auto const & node = *cull_nodes_[i];
+			uint64_t const bit = 1ULL << (i & 63);
+			int32_t const parent = cull_parents_[i];
+
+			BoundOverlap visible;
+			if (!node.Visible())
+			{
+				visible = BoundOverlap::No;
+			}
+			else if (parent < 0)
+			{
+				visible = BoundOverlap::Partial;
+			}
+			else if (!node.Updated())
+			{
+				visible = BoundOverlap::Yes;
+			}
+			else if (BoundOverlap::No == overlaps[parent])
+			{
+				visible = BoundOverlap::No;
+			}
+			else if (node.Attrib() & SceneNode::SOA_Cullable)
+			{
+				if (tested[i / 64] & bit)
+				{
+					visible = (visibility[i / 64] & bit) ? BoundOverlap::Partial : BoundOverlap::No;
+				}
+				else
+				{
+					AABBox const & aabb_ws = node.PosBoundWS();
+					if ((small_obj_threshold > 0) && ((MathLib::ortho_area(camera.ForwardVec(), aabb_ws) <= small_obj_threshold)
+						|| (MathLib::perspective_area(camera.EyePos(), view_proj, aabb_ws) <= small_obj_threshold)))
+					{
+						visible = BoundOverlap::No;
+					}
+					else if (omni_directional || (BoundOverlap::Yes == overlaps[parent]))
+					{
+						visible = BoundOverlap::Yes;
+					}
+					else
+					{
+						visible = frustum.Intersect(aabb_ws);
+					}
+				}
+			}
+			else
+			{
+				visible = overlaps[parent];
+			}
+
+			overlaps[i] = visible;
+			if (visible != BoundOverlap::No)
+			{
+				visibility[i / 64] |= bit;
+			}
+			else
+			{
+				visibility[i / 64] &= ~bit;
+			}
+		}
+	}
+
+	bool SceneManager::ApplyPrecull(Viewport const & viewport, std::vector<SceneNode*> const & scene_nodes)
+	{
+		if (precull_visibilities_.empty() || (precull_small_obj_threshold_ != small_obj_threshold_) || (cull_nodes_ != scene_nodes))
+		{
+			return false;
+		}
+
+		uint32_t const num_cameras = viewport.NumCameras();
+		std::array<VisibilityBitset const *, RenderEngine::PredefinedCameraCBuffer::max_num_cameras> visibilities;
+		for (uint32_t i = 0; i < num_cameras; ++ i)
+		{
+			auto iter = precull_visibilities_.find(viewport.Camera(i).get());
+			if (iter == precull_visibilities_.end())
+			{
+				return false;
+			}
+			visibilities[i] = &iter->second;
+		}
+
+		for (size_t i = 0; i < scene_nodes.size(); ++ i)
+		{
+			uint64_t const bit = 1ULL << (i & 63);
+			for (uint32_t j = 0; j < num_cameras; ++ j)
+			{
+				scene_nodes[i]->VisibleMark(j, ((*visibilities[j])[i / 64] & bit) ? BoundOverlap::Yes : BoundOverlap::No);
+			}
+		}
+
+		return true;
+	}
+
 	uint32_t SceneManager::NumFrameCameras() const
 	{
 		return static_cast<uint32_t>(frame_cameras_.size());
@@ -254,20 +481,22 @@ namespace KlayGE
 			{
 				RenderTechnique const * obj_tech = obj->GetRenderTechnique();
 				BOOST_ASSERT(obj_tech);
-				bool found = false;
-				for (auto& items : render_queue_)
+				auto const tech_iter =
+					render_technique_ids_.try_emplace(obj_tech, static_cast<uint32_t>(render_techniques_.size())).first;
+				if (tech_iter->second == render_techniques_.size())
 				{
-					if (items.first == obj_tech)
-					{
-						items.second.push_back(obj);
-						found = true;
-						break;
-					}
+					render_techniques_.push_back(obj_tech);
 				}
-				if (!found)
+
+				// Materials only matter for the state changes between opaque objects. The order of transparent ones is kept.
+				uint32_t mtl_id = 0;
+				if (!obj_tech->Transparent())
 				{
-					render_queue_.emplace_back(obj_tech, std::vector<Renderable*>(1, obj));
+					mtl_id = render_material_ids_.try_emplace(obj->Material().get(), static_cast<uint32_t>(render_material_ids_.size()))
+						.first->second;
 				}
+
+				render_queue_.push_back({obj, tech_iter->second, mtl_id});
 			}
 		}
 	}
@@ -371,6 +600,8 @@ namespace KlayGE
 	/////////////////////////////////////////////////////////////////////////////////
 	void SceneManager::Update()
 	{
+		KLAYGE_PERF_ZONE("Scene update");
+
 		deferred_mode_ = !!Context::Instance().DeferredRenderingLayerInstance();
 
 		App3DFramework& app = Context::Instance().AppInstance();
@@ -434,6 +665,8 @@ namespace KlayGE
 	/////////////////////////////////////////////////////////////////////////////////
 	void SceneManager::Flush(uint32_t urt)
 	{
+		KLAYGE_PERF_ZONE("Scene flush");
+
 		std::lock_guard<std::mutex> lock(update_mutex_);
 
 		urt_ = urt;
@@ -531,7 +764,10 @@ namespace KlayGE
 					}
 				}
 
-				this->ClipScene();
+				if (!this->ApplyPrecull(viewport, scene_nodes))
+				{
+					this->ClipScene();
+				}
 
 				auto visible_marks =
 					MakeUniquePtr<std::array<BoundOverlap, RenderEngine::PredefinedCameraCBuffer::max_num_cameras>[]>(scene_nodes.size());
@@ -582,6 +818,8 @@ namespace KlayGE
 			}
 		}
 
+		Timer queue_build_timer;
+
 		for (size_t i = 0; i < scene_nodes.size(); ++i)
 		{
 			if (node_visible[i])
@@ -612,65 +850,20 @@ namespace KlayGE
 			}
 		}
 
-		std::sort(render_queue_.begin(), render_queue_.end(),
-			[](std::pair<RenderTechnique const *, std::vector<Renderable*>> const & lhs,
-				std::pair<RenderTechnique const *, std::vector<Renderable*>> const & rhs)
-			{
-				BOOST_ASSERT(lhs.first);
-				BOOST_ASSERT(rhs.first);
+		this->SortRenderQueue(viewport);
 
-				return lhs.first->Weight() < rhs.first->Weight();
-			});
+		frame_queue_build_time_ += static_cast<float>(queue_build_timer.elapsed());
 
-		float4 view_mat_z;
-		if (viewport.NumCameras() == 1)
+		for (auto const & key : render_keys_)
 		{
-			view_mat_z = viewport.Camera(0)->ViewMatrix().Col(2);
+			render_queue_[key.second].renderable->Render();
 		}
-		for (auto& items : render_queue_)
-		{
-			if ((viewport.NumCameras() == 1) && !items.first->Transparent() && !items.first->HasDiscard() && (items.second.size() > 1))
-			{
-				std::vector<std::pair<float, uint32_t>> min_depths(items.second.size());
-				for (size_t j = 0; j < min_depths.size(); ++ j)
-				{
-					Renderable const * renderable = items.second[j];
-					AABBox const & box = renderable->PosBound();
-					uint32_t const num = renderable->NumInstances();
-					float md = 1e10f;
-					for (uint32_t i = 0; i < num; ++ i)
-					{
-						float4x4 const & mat = renderable->GetInstance(i)->TransformToWorld();
-						float4 const zvec(MathLib::dot(mat.Row(0), view_mat_z),
-							MathLib::dot(mat.Row(1), view_mat_z), MathLib::dot(mat.Row(2), view_mat_z),
-							MathLib::dot(mat.Row(3), view_mat_z));
-						for (int k = 0; k < 8; ++ k)
-						{
-							float3 const v = box.Corner(k);
-							md = std::min(md, v.x() * zvec.x() + v.y() * zvec.y() + v.z() * zvec.z() + zvec.w());
-						}
-					}
+		num_renderables_rendered_ += static_cast<uint32_t>(render_queue_.size());
 
-					min_depths[j] = std::make_pair(md, static_cast<uint32_t>(j));
-				}
-
-				std::sort(min_depths.begin(), min_depths.end());
-
-				std::vector<Renderable*> sorted_items(min_depths.size());
-				for (size_t j = 0; j < min_depths.size(); ++ j)
-				{
-					sorted_items[j] = items.second[min_depths[j].second];
-				}
-				items.second.swap(sorted_items);
-			}
-
-			for (auto const & item : items.second)
-			{
-				item->Render();
-			}
-			num_renderables_rendered_ += static_cast<uint32_t>(items.second.size());
-		}
-		render_queue_.resize(0);
+		render_queue_.clear();
+		render_technique_ids_.clear();
+		render_techniques_.clear();
+		render_material_ids_.clear();
 
 		num_primitives_rendered_ += re.NumPrimitivesJustRendered();
 		num_vertices_rendered_ += re.NumVerticesJustRendered();
@@ -719,11 +912,74 @@ namespace KlayGE
 		return num_dispatch_calls_;
 	}
 
+	uint32_t SceneManager::NumConstantBytesUploaded() const
+	{
+		return num_constant_bytes_uploaded_;
+	}
+
+	float SceneManager::RenderQueueBuildTime() const
+	{
+		return queue_build_time_;
+	}
+
+	void SceneManager::SortRenderQueue(Viewport const & viewport)
+	{
+		// Techniques are ordered by weight, then by the order they are added
+		std::vector<uint32_t> tech_order(render_techniques_.size());
+		for (uint32_t i = 0; i < tech_order.size(); ++ i)
+		{
+			tech_order[i] = i;
+		}
+		std::stable_sort(tech_order.begin(), tech_order.end(), [this](uint32_t lhs, uint32_t rhs)
+			{
+				return render_techniques_[lhs]->Weight() < render_techniques_[rhs]->Weight();
+			});
+
+		// Opaque objects without discard are drawn front to back when there is only one camera
+		bool const single_camera = (viewport.NumCameras() == 1);
+		std::vector<uint64_t> tech_keys(render_techniques_.size());
+		for (uint32_t i = 0; i < tech_order.size(); ++ i)
+		{
+			RenderTechnique const & tech = *render_techniques_[tech_order[i]];
+			bool const depth_sort = single_camera && !tech.Transparent() && !tech.HasDiscard();
+			tech_keys[tech_order[i]] = (static_cast<uint64_t>(i) << SORT_KEY_TECH_SHIFT) | (depth_sort ? 1 : 0);
+		}
+
+		float4 view_mat_z;
+		if (single_camera)
+		{
+			view_mat_z = viewport.Camera(0)->ViewMatrix().Col(2);
+		}
+
+		auto build_keys = [this, &tech_keys, &view_mat_z](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++ i)
+			{
+				auto const & item = render_queue_[i];
+				uint64_t const tech_key = tech_keys[item.technique_id];
+				uint64_t key = (tech_key & ~1ULL)
+					| (static_cast<uint64_t>(std::min<uint32_t>(item.material_id, SORT_KEY_MTL_MASK)) << SORT_KEY_MTL_SHIFT);
+				if (tech_key & 1)
+				{
+					key |= DepthSortKey(RenderableMinDepth(*item.renderable, view_mat_z));
+				}
+				render_keys_[i] = std::make_pair(key, static_cast<uint32_t>(i));
+			}
+		};
+
+		size_t const num_items = render_queue_.size();
+		render_keys_.resize(num_items);
+		Context::Instance().TaskSchedulerInstance().ParallelFor(size_t(0), num_items, PARALLEL_KEY_GRAIN_SIZE, build_keys);
+
+		RadixSort(render_keys_, render_keys_tmp_);
+	}
+
 	void SceneManager::FlushScene()
 	{
 		RenderEngine& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
 
 		visible_marks_map_.clear();
+		precull_visibilities_.clear();
 
 		uint32_t urt;
 		App3DFramework& app = Context::Instance().AppInstance();
@@ -759,10 +1015,17 @@ namespace KlayGE
 
 		num_draw_calls_ = re.NumDrawsJustCalled();
 		num_dispatch_calls_ = re.NumDispatchesJustCalled();
+		num_constant_bytes_uploaded_ = re.NumConstantBytesJustUploaded();
+		queue_build_time_ = frame_queue_build_time_;
+		frame_queue_build_time_ = 0;
 	}
 
 	void SceneManager::UpdateThreadFunc()
 	{
+#ifndef KLAYGE_SHIP
+		PerfProfiler::Instance().ThreadName("Scene update");
+#endif
+
 		Timer timer;
 		float app_time = 0;
 		while (!quit_)
@@ -776,6 +1039,8 @@ namespace KlayGE
 				WindowPtr const & win = Context::Instance().AppInstance().MainWnd();
 				if (win && win->Active())
 				{
+					KLAYGE_PERF_ZONE("Sub thread update");
+
 					std::lock_guard<std::mutex> lock(update_mutex_);
 
 					auto updater = [app_time, frame_time](SceneNode& node) {
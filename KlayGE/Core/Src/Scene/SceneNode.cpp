@@ -191,25 +191,32 @@ namespace KlayGE
 		auto iter = std::find_if(children_.begin(), children_.end(), [node](SceneNodePtr const& child) { return child.get() == node; });
 		if (iter != children_.end())
 		{
+			// Before erasing, it could be the last reference of the node
+			if (auto* scene_mgr = this->OwnerSceneManager())
+			{
+				scene_mgr->OnNodeDetached(*node);
+			}
+
 			pos_aabb_dirty_ = true;
 			node->Parent(nullptr);
 			children_.erase(iter);
-
-			this->EmitSceneChanged();
 		}
 	}
 
 	void SceneNode::ClearChildren()
 	{
+		auto* scene_mgr = this->OwnerSceneManager();
 		for (auto const& child : children_)
 		{
+			if (scene_mgr != nullptr)
+			{
+				scene_mgr->OnNodeDetached(*child);
+			}
 			child->Parent(nullptr);
 		}
 
 		pos_aabb_dirty_ = true;
 		children_.clear();
-
-		this->EmitSceneChanged();
 	}
 
 	void SceneNode::Traverse(std::function<bool(SceneNode&)> const& callback)
@@ -466,7 +473,10 @@ namespace KlayGE
 
 		if (!updated_)
 		{
-			this->EmitSceneChanged();
+			if (auto* scene_mgr = this->OwnerSceneManager())
+			{
+				scene_mgr->OnNodeAttached(*this);
+			}
 
 			updated_ = true;
 		}
@@ -702,12 +712,12 @@ namespace KlayGE
 		}
 	}
 
-	void SceneNode::EmitSceneChanged()
+	SceneManager* SceneNode::OwnerSceneManager() const
 	{
 		auto& context = Context::Instance();
 		if (context.SceneManagerValid())
 		{
-			auto* node = this;
+			auto const * node = this;
 			while (node->Parent() != nullptr)
 			{
 				node = node->Parent();
@@ -716,8 +726,10 @@ namespace KlayGE
 			auto& scene_mgr = context.SceneManagerInstance();
 			if (node == &scene_mgr.SceneRootNode())
 			{
-				scene_mgr.OnSceneChanged();
+				return &scene_mgr;
 			}
 		}
+
+		return nullptr;
 	}
 }
@@ -105,7 +105,9 @@ namespace KlayGE
 		void SetShaderResources(
 			ShaderStage stage, std::span<std::tuple<void*, uint32_t, uint32_t> const> srvsrcs, std::span<ID3D11ShaderResourceView* const> srvs);
 		void SetSamplers(ShaderStage stage, std::span<ID3D11SamplerState* const> samplers);
-		void SetConstantBuffers(ShaderStage stage, std::span<ID3D11Buffer* const> cbs);
+		// first_constants and num_constants are in shader constants, and only used where constant buffers can be bound at offsets
+		void SetConstantBuffers(ShaderStage stage, std::span<ID3D11Buffer* const> cbs, std::span<UINT const> first_constants,
+			std::span<UINT const> num_constants);
 		void RSSetViewports(UINT NumViewports, D3D11_VIEWPORT const * pViewports);
 		void OMSetRenderTargets(UINT num_rtvs, ID3D11RenderTargetView* const * rtvs, ID3D11DepthStencilView* dsv);
 		void OMSetRenderTargetsAndUnorderedAccessViews(UINT num_rtvs, ID3D11RenderTargetView* const * rtvs,
@@ -214,6 +216,8 @@ namespace KlayGE
 		std::array<std::vector<ID3D11ShaderResourceView*>, NumShaderStages> shader_srv_ptr_cache_;
 		std::array<std::vector<ID3D11SamplerState*>, NumShaderStages> shader_sampler_ptr_cache_;
 		std::array<std::vector<ID3D11Buffer*>, NumShaderStages> shader_cb_ptr_cache_;
+		std::array<std::vector<UINT>, NumShaderStages> shader_cb_first_constant_cache_;
+		std::array<std::vector<UINT>, NumShaderStages> shader_cb_num_constants_cache_;
 		std::vector<ID3D11UnorderedAccessView*> render_uav_ptr_cache_;
 		std::vector<uint32_t> render_uav_init_count_cache_;
 		std::vector<ID3D11UnorderedAccessView*> compute_uav_ptr_cache_;
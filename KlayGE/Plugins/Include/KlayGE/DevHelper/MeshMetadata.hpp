@@ -46,6 +46,15 @@ namespace KlayGE
 {
 	class KLAYGE_DEV_HELPER_API MeshMetadata final
 	{
+	public:
+		// A LoD simplified from LoD 0. It stops at triangle_ratio of the triangles, or before the error exceeds max_error,
+		// relative to the diagonal of the mesh bound. 0 disables either limit.
+		struct AutoLod
+		{
+			float triangle_ratio = 0;
+			float max_error = 0;
+		};
+
 	public:
 		MeshMetadata();
 		explicit MeshMetadata(std::string_view name);
@@ -113,11 +122,26 @@ namespace KlayGE
 			flip_winding_order_ = flip_winding_order;
 		}
 
+		// Reorders triangles and vertices for the post-transform cache, overdraw and vertex fetch
+		bool OptimizeMesh() const
+		{
+			return optimize_mesh_;
+		}
+		void OptimizeMesh(bool optimize_mesh)
+		{
+			optimize_mesh_ = optimize_mesh;
+		}
+
 		uint32_t NumLods() const;
 		void NumLods(uint32_t lods);
 		std::string_view LodFileName(uint32_t lod) const;
 		void LodFileName(uint32_t lod, std::string_view lod_name);
 
+		uint32_t NumAutoLods() const;
+		void NumAutoLods(uint32_t lods);
+		AutoLod const & AutoLodSetting(uint32_t lod) const;
+		void AutoLodSetting(uint32_t lod, AutoLod const & setting);
+
 		uint32_t NumMaterials() const;
 		void NumMaterials(uint32_t materials);
 		std::string_view MaterialFileName(uint32_t mtl_index) const;
@@ -143,7 +167,9 @@ namespace KlayGE
 		float3 scale_ = float3(1, 1, 1);
 		uint8_t axis_mapping_[3] = { 0, 1, 2 };
 		bool flip_winding_order_ = false;
+		bool optimize_mesh_ = false;
 		std::vector<std::string> lod_file_names_;
+		std::vector<AutoLod> auto_lods_;
 		std::vector<std::string> material_file_names_;
 
 		float4x4 transform_ = float4x4::Identity();
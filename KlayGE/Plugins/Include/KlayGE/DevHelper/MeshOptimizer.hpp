@@ -0,0 +1,83 @@
+/**
+ * @file MeshOptimizer.hpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#ifndef KLAYGE_PLUGINS_MESH_OPTIMIZER_HPP
+#define KLAYGE_PLUGINS_MESH_OPTIMIZER_HPP
+
+#pragma once
+
+#include <KlayGE/PreDeclare.hpp>
+#include <KFL/CXX20/span.hpp>
+#include <KFL/Math.hpp>
+
+#include <vector>
+
+#include <KlayGE/DevHelper/DevHelper.hpp>
+
+namespace KlayGE
+{
+	// Size of the post-transform vertex cache the statistics are measured against. Most GPUs behave like a FIFO of about this size.
+	uint32_t constexpr DEFAULT_VERTEX_CACHE_SIZE = 16;
+
+	struct VertexCacheStatistics
+	{
+		// Average cache miss ratio, vertices transformed per triangle. 0.5 is the ideal for a large regular grid, 3 the worst.
+		float acmr;
+		// Average transform to vertex ratio, vertices transformed per vertex. 1 is the ideal.
+		float atvr;
+	};
+
+	// Simulates a FIFO post-transform cache running through a triangle list
+	KLAYGE_DEV_HELPER_API VertexCacheStatistics AnalyzeVertexCache(
+		std::span<uint32_t const> indices, uint32_t num_vertices, uint32_t cache_size = DEFAULT_VERTEX_CACHE_SIZE);
+
+	// Reorders the triangles so they reuse the vertices still in the post-transform cache (Forsyth, linear-speed vertex cache
+	// optimisation)
+	KLAYGE_DEV_HELPER_API void OptimizeVertexCache(std::span<uint32_t> indices, uint32_t num_vertices);
+
+	// Splits a cache optimized triangle list into clusters, and draws the clusters facing outwards first, so they occlude
+	// the others (Sander et al., fast triangle reordering for vertex locality and reduced overdraw). A cluster ends where the
+	// cache hit rate allows, threshold is how much worse than the original ACMR the result can be.
+	KLAYGE_DEV_HELPER_API void OptimizeOverdraw(std::span<uint32_t> indices, std::span<float3 const> positions, float threshold = 1.05f);
+
+	// Renumbers the vertices in the order of first use, so fetching them walks memory forwards. Returns the new index of
+	// every old vertex, the unused vertices go to the end.
+	KLAYGE_DEV_HELPER_API std::vector<uint32_t> OptimizeVertexFetch(std::span<uint32_t> indices, uint32_t num_vertices);
+
+	// Simplifies a triangle list by collapsing edges in the order of their quadric error (Garland and Heckbert). Vertices are
+	// only merged into other vertices, never moved or created, so their texture coordinates and skinning weights stay intact.
+	// Vertices sharing their position with others, like those on UV seams, are kept. Open borders only collapse along
+	// themselves. Stops at target_num_indices, or before the error exceeds target_error, in the units of positions.
+	// Returns the remaining triangles, and the largest error in result_error.
+	KLAYGE_DEV_HELPER_API std::vector<uint32_t> SimplifyMesh(std::span<uint32_t const> indices, std::span<float3 const> positions,
+		uint32_t target_num_indices, float target_error, float& result_error);
+}
+
+#endif		// KLAYGE_PLUGINS_MESH_OPTIMIZER_HPP
@@ -29,6 +29,8 @@
 #include <KlayGE/SceneManager.hpp>
 #include <KFL/AABBox.hpp>
 
+#include <array>
+#include <unordered_map>
 #include <vector>
 
 namespace KlayGE
@@ -50,15 +52,90 @@ namespace KlayGE
 
 		void ClearObject() override;
 
-		void OnSceneChanged() override;
+		void OnNodeAttached(SceneNode& node) override;
+		void OnNodeDetached(SceneNode& node) override;
+
+	protected:
+		void PrepareCullCameras() override;
+		void CullCamera(Camera const & camera, float small_obj_threshold, VisibilityBitset& visibility,
+			VisibilityBitset& tested) const override;
+
+	private:
+		// Objects are kept in the deepest node whose loose bound (the cell extended by half its size on each side) contains them.
+		// Internal nodes hold the objects that are too large for their children.
+		struct octree_node_t
+		{
+			int parent_index;		// -1 for the root, -2 for released nodes
+			int first_child_index;
+			uint32_t depth;
+			uint32_t num_subtree_objs;
+			BoundOverlap visible;
+
+			std::vector<SceneNode*> node_ptrs;
+			std::vector<uint32_t> cull_indices;	// Index in cull_nodes_ of each object in node_ptrs
+		};
+
+		struct octree_obj_t
+		{
+			int node_index;			// -1 while waiting to be inserted
+			uint32_t slot;			// Index in node_ptrs of the tree node
+			int moveable_slot;		// Index in moveable_objs_, -1 for the static objects
+			bool out_of_bound;		// Doesn't fit in the root, kept in the root anyway
+		};
+
+		// Loose bounding boxes of the tree nodes in structure-of-arrays. The 8 children of a node are contiguous,
+		// so they can be tested against the frustums together.
+		struct octree_bbs_t
+		{
+			std::vector<float> min_x, min_y, min_z;
+			std::vector<float> max_x, max_y, max_z;
+
+			void Resize(size_t size)
+			{
+				min_x.resize(size);
+				min_y.resize(size);
+				min_z.resize(size);
+				max_x.resize(size);
+				max_y.resize(size);
+				max_z.resize(size);
+			}
+
+			AABBox BB(size_t index) const
+			{
+				return AABBox(float3(min_x[index], min_y[index], min_z[index]), float3(max_x[index], max_y[index], max_z[index]));
+			}
+			void BB(size_t index, AABBox const & aabb)
+			{
+				min_x[index] = aabb.Min().x();
+				min_y[index] = aabb.Min().y();
+				min_z[index] = aabb.Min().z();
+				max_x[index] = aabb.Max().x();
+				max_y[index] = aabb.Max().y();
+				max_z[index] = aabb.Max().z();
+			}
+		};
 
 	private:
 		void DoSuspend() override;
 		void DoResume() override;
 
-		void DivideNode(size_t index, uint32_t curr_depth);
-		void NodeVisible(size_t index);
-		void MarkNodeObjs(size_t index, bool force);
+		void MaintainTree(std::vector<SceneNode*> const & scene_nodes);
+		void BuildTree(std::vector<SceneNode*> const & scene_nodes);
+		void UpdateTree();
+		void SplitNode(std::vector<octree_node_t>& tree, octree_bbs_t& bbs, size_t index, size_t first_child_index) const;
+		void DivideNode(std::vector<octree_node_t>& tree, octree_bbs_t& bbs, size_t index) const;
+		void IndexObjs(size_t index);
+		size_t FindInsertNode(AABBox const & aabb, bool& out_of_bound) const;
+		void InsertObj(SceneNode& node, octree_obj_t& obj);
+		void RemoveObj(SceneNode& node, octree_obj_t& obj);
+		size_t AllocChildren();
+		void MergeChildren(size_t index);
+		BoundOverlap NodeVisibleFromRoot(size_t index) const;
+		void NodeVisible(Viewport const & viewport);
+		void ChildrenVisible(Viewport const & viewport, size_t first_child_index, bool parallel);
+		void ChildrenBoundVisible(size_t first_child_index, std::array<BoundOverlap, 8>& visible) const;
+		bool LargeEnough(Viewport const & viewport, AABBox const & aabb) const;
+		void MarkNodeObjs(size_t index, uint32_t num_cameras, bool force);
 
 		BoundOverlap BoundVisible(size_t index, AABBox const & aabb) const;
 		BoundOverlap BoundVisible(size_t index, OBBox const & obb) const;
@@ -70,21 +147,30 @@ namespace KlayGE
 		OCTree& operator=(OCTree const & rhs);
 
 	private:
-		struct octree_node_t
-		{
-			AABBox bb;
-			int first_child_index;
-			BoundOverlap visible;
+		std::vector<octree_node_t> octree_;
+		octree_bbs_t octree_bbs_;
+		std::vector<size_t> free_children_;
 
-			std::vector<SceneNode*> node_ptrs;
-		};
+		std::unordered_map<SceneNode*, octree_obj_t> objs_;
+		std::vector<SceneNode*> pending_objs_;
+		std::vector<SceneNode*> moveable_objs_;
+		uint32_t num_out_of_bound_objs_ = 0;
 
-		std::vector<octree_node_t> octree_;
+		std::vector<size_t> split_candidates_;
+		std::vector<size_t> merge_candidates_;
 
 		uint32_t max_tree_depth_;
 
 		bool rebuild_tree_;
 
+#ifndef KLAYGE_SHIP
+		PerfRegion* build_perf_ = nullptr;
+		// One per cull in a frame, in order. Cameras come and go, but the passes of a frame are much the same.
+		std::vector<PerfRegion*> cull_perfs_;
+		uint32_t cull_frame_ = 0;
+		uint32_t num_culls_in_frame_ = 0;
+#endif
+
 #ifdef KLAYGE_DRAW_NODES
 		RenderablePtr node_renderable_;
 #endif
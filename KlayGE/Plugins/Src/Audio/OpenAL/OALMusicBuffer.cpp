@@ -31,6 +31,7 @@
 #include <KlayGE/KlayGE.hpp>
 #include <KFL/Util.hpp>
 #include <KlayGE/AudioDataSource.hpp>
+#include <KlayGE/PerfProfiler.hpp>
 
 #include <KlayGE/OpenAL/OALAudio.hpp>
 
@@ -67,6 +68,10 @@ namespace KlayGE
 
 	void OALMusicBuffer::LoopUpdateBuffer()
 	{
+#ifndef KLAYGE_SHIP
+		PerfProfiler::Instance().ThreadName("Music streaming");
+#endif
+
 		std::unique_lock<std::mutex> lock(play_mutex_);
 		while (!played_)
 		{
@@ -80,6 +85,8 @@ namespace KlayGE
 			alGetSourcei(source_, AL_BUFFERS_PROCESSED, &processed);
 			if (processed > 0)
 			{
+				KLAYGE_PERF_ZONE("Stream music");
+
 				while (processed > 0)
 				{
 					-- processed;
@@ -35,6 +35,7 @@
 #include <KlayGE/Context.hpp>
 #include <KlayGE/AudioFactory.hpp>
 #include <KlayGE/AudioDataSource.hpp>
+#include <KlayGE/PerfProfiler.hpp>
 
 #include <functional>
 #include <limits>
@@ -131,6 +132,10 @@ namespace KlayGE
 
 	void XAMusicBuffer::LoopUpdateBuffer()
 	{
+#ifndef KLAYGE_SHIP
+		PerfProfiler::Instance().ThreadName("Music streaming");
+#endif
+
 		std::unique_lock<std::mutex> lock(play_mutex_);
 		while (!played_)
 		{
@@ -152,7 +157,12 @@ namespace KlayGE
 				::WaitForSingleObjectEx(checked_cast<MusicVoiceContext&>(*voice_call_back_).GetBufferEndEvent(), INFINITE, FALSE);
 			}
 
-			if (this->FillData(buffer_size_))
+			bool end_of_data;
+			{
+				KLAYGE_PERF_ZONE("Stream music");
+				end_of_data = this->FillData(buffer_size_);
+			}
+			if (end_of_data)
 			{
 				if (loop_)
 				{
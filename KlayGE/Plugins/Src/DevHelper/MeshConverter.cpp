@@ -44,6 +44,7 @@
 #include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <vector>
 
@@ -61,6 +62,7 @@
 #include <assimp/pbrmaterial.h>
 
 #include <KlayGE/DevHelper/MeshConverter.hpp>
+#include <KlayGE/DevHelper/MeshOptimizer.hpp>
 
 using namespace std;
 using namespace KlayGE;
@@ -139,6 +141,9 @@ namespace
 		return MathLib::clamp((diff == 0) ? 0 : (time - vec[itime_lower].first) / diff, 0.0f, 1.0f);
 	}
 
+	// The largest error of a key frame in the animation clips, in radians and model units
+	float const KEY_FRAME_TOLERANCE = 1e-3f;
+
 	void MatrixToDQ(float4x4 const & mat, Quaternion& bind_real, Quaternion& bind_dual, float& bind_scale)
 	{
 		float4x4 tmp_mat = mat;
@@ -210,6 +215,24 @@ namespace
 		}
 	}
 
+	// Moves every vertex to its new index, those remapped past num_vertices are dropped
+	template <typename T>
+	void RemapVertexAttrib(std::vector<T>& attrib, std::vector<uint32_t> const & remap, uint32_t num_vertices)
+	{
+		if (!attrib.empty())
+		{
+			std::vector<T> new_attrib(num_vertices);
+			for (size_t i = 0; i < attrib.size(); ++ i)
+			{
+				if (remap[i] < num_vertices)
+				{
+					new_attrib[remap[i]] = std::move(attrib[i]);
+				}
+			}
+			attrib.swap(new_attrib);
+		}
+	}
+
 	class MeshLoader
 	{
 	public:
@@ -219,7 +242,8 @@ namespace
 	private:
 		void RemoveUnusedJoints();
 		void RemoveUnusedMaterials();
-		void CompressKeyFrameSet(KeyFrameSet& kf);
+		void GenerateLods(MeshMetadata const & metadata);
+		void OptimizeMeshes();
 
 		// From assimp
 		void BuildNodeData(uint32_t num_lods, uint32_t lod, int16_t parent_id, aiNode const * node);
@@ -270,6 +294,8 @@ namespace
 				std::vector<uint32_t> indices;
 			};
 			std::vector<Lod> lods;
+			// Only known for the generated LoDs
+			std::vector<float> lod_errors;
 
 			bool has_normal;
 			bool has_tangent_frame;
@@ -955,14 +981,12 @@ namespace
 					kf.bind_dual.push_back(frame.second.bind_dual[f]);
 					kf.bind_scale.push_back(frame.second.bind_scale[f]);
 				}
-
-				this->CompressKeyFrameSet(kf);
 			}
 
 			animation_frame_offset += anim.frame_num;
 		}
 
-		skinned_model.AttachKeyFrameSets(kfs);
+		skinned_model.AttachAnimationClip(MakeSharedPtr<AnimationClip>(*kfs, KEY_FRAME_TOLERANCE));
 		skinned_model.AttachAnimations(animations);
 
 		skinned_model.FrameRate(resample_fps);
@@ -2991,11 +3015,9 @@ namespace
 					}
 				}
 			}
-
-			this->CompressKeyFrameSet(kfs);
 		}
 
-		skinned_model.AttachKeyFrameSets(kfss);
+		skinned_model.AttachAnimationClip(MakeSharedPtr<AnimationClip>(*kfss, KEY_FRAME_TOLERANCE));
 	}
 
 	void MeshLoader::CompileBBKeyFramesChunk(XMLNode const* bb_kfs_chunk, uint32_t mesh_index)
@@ -3210,6 +3232,9 @@ namespace
 				}
 			}
 
+			// The clip is built from the key frames, so it has to be rebuilt after they change
+			skinned_model.AttachAnimationClip(MakeSharedPtr<AnimationClip>(kfs, KEY_FRAME_TOLERANCE));
+
 			XMLNode const* bb_kfs_chunk = root->FirstNode("bb_key_frames_chunk");
 			for (uint32_t mesh_index = 0; mesh_index < skinned_model.NumMeshes(); ++ mesh_index)
 			{
@@ -3283,6 +3308,7 @@ namespace
 		}
 		joints_.resize(new_joint_id);
 		kfs.resize(joints_.size());
+		skinned_model.AttachAnimationClip(MakeSharedPtr<AnimationClip>(kfs, KEY_FRAME_TOLERANCE));
 
 		for (auto& mesh : meshes_)
 		{
@@ -3332,59 +3358,103 @@ namespace
 		}
 	}
 
-	void MeshLoader::CompressKeyFrameSet(KeyFrameSet& kf)
-	{
-		float const THRESHOLD = 1e-3f;
 
-		BOOST_ASSERT((kf.bind_real.size() == kf.bind_dual.size())
-			&& (kf.frame_id.size() == kf.bind_scale.size())
-			&& (kf.frame_id.size() == kf.bind_real.size()));
+	void MeshLoader::GenerateLods(MeshMetadata const & metadata)
+	{
+		if (meshes_[0].lods.size() > 1)
+		{
+			LogWarn() << "Auto LoDs are ignored, the LoDs are already provided." << std::endl;
+			return;
+		}
 
-		int base = 0;
-		while (base < static_cast<int>(kf.frame_id.size() - 2))
+		for (auto& mesh : meshes_)
 		{
-			int const frame0 = kf.frame_id[base + 0];
-			int const frame1 = kf.frame_id[base + 1];
-			int const frame2 = kf.frame_id[base + 2];
-			float const factor = static_cast<float>(frame1 - frame0) / (frame2 - frame0);
-			Quaternion interpolate_real;
-			Quaternion interpolate_dual;
-			std::tie(interpolate_real, interpolate_dual) = MathLib::sclerp(kf.bind_real[base + 0], kf.bind_dual[base + 0],
-				kf.bind_real[base + 2], kf.bind_dual[base + 2], factor);
-			float const scale = MathLib::lerp(kf.bind_scale[base + 0], kf.bind_scale[base + 2], factor);
+			mesh.lods.reserve(metadata.NumAutoLods() + 1);
+			auto const & base_lod = mesh.lods[0];
+			uint32_t const num_vertices = static_cast<uint32_t>(base_lod.positions.size());
+
+			AABBox const bound = MathLib::compute_aabbox(base_lod.positions.begin(), base_lod.positions.end());
+			float const size = MathLib::length(bound.Max() - bound.Min());
 
-			if (MathLib::dot(kf.bind_real[base + 1], interpolate_real) < 0)
+			mesh.lod_errors.assign(1, 0.0f);
+			for (uint32_t i = 0; i < metadata.NumAutoLods(); ++ i)
 			{
-				interpolate_real = -interpolate_real;
-				interpolate_dual = -interpolate_dual;
-			}
+				auto const & setting = metadata.AutoLodSetting(i);
+				uint32_t const target_num_indices =
+					static_cast<uint32_t>(base_lod.indices.size() * std::clamp(setting.triangle_ratio, 0.0f, 1.0f)) / 3 * 3;
+				float const target_error = (setting.max_error > 0) ? setting.max_error * size : std::numeric_limits<float>::max();
+
+				// Every LoD comes from LoD 0, so the errors are against the original
+				float error;
+				auto indices = SimplifyMesh(base_lod.indices, base_lod.positions, target_num_indices, target_error, error);
+				if (indices.empty() || (indices.size() >= mesh.lods.back().indices.size()))
+				{
+					// Every mesh needs the same number of LoDs, and they can't get finer. Reuse the coarsest one.
+					mesh.lods.push_back(mesh.lods.back());
+					mesh.lod_errors.push_back(mesh.lod_errors.back());
+					continue;
+				}
 
-			Quaternion diff_real;
-			Quaternion diff_dual;
-			std::tie(diff_real, diff_dual) = MathLib::inverse(kf.bind_real[base + 1], kf.bind_dual[base + 1]);
-			diff_dual = MathLib::mul_dual(diff_real, diff_dual * scale, interpolate_real, interpolate_dual);
-			diff_real = MathLib::mul_real(diff_real, interpolate_real);
-			float diff_scale = scale * kf.bind_scale[base + 1];
+				auto const remap = OptimizeVertexFetch(indices, num_vertices);
+				uint32_t const num_used_vertices = *std::max_element(indices.begin(), indices.end()) + 1;
 
-			if ((MathLib::abs(diff_real.x()) < THRESHOLD) && (MathLib::abs(diff_real.y()) < THRESHOLD)
-				&& (MathLib::abs(diff_real.z()) < THRESHOLD) && (MathLib::abs(diff_real.w() - 1) < THRESHOLD)
-				&& (MathLib::abs(diff_dual.x()) < THRESHOLD) && (MathLib::abs(diff_dual.y()) < THRESHOLD)
-				&& (MathLib::abs(diff_dual.z()) < THRESHOLD) && (MathLib::abs(diff_dual.w()) < THRESHOLD)
-				&& (MathLib::abs(diff_scale - 1) < THRESHOLD))
-			{
-				kf.frame_id.erase(kf.frame_id.begin() + base + 1);
-				kf.bind_real.erase(kf.bind_real.begin() + base + 1);
-				kf.bind_dual.erase(kf.bind_dual.begin() + base + 1);
-				kf.bind_scale.erase(kf.bind_scale.begin() + base + 1);
+				Mesh::Lod lod = base_lod;
+				lod.indices = std::move(indices);
+				RemapVertexAttrib(lod.positions, remap, num_used_vertices);
+				RemapVertexAttrib(lod.tangents, remap, num_used_vertices);
+				RemapVertexAttrib(lod.binormals, remap, num_used_vertices);
+				RemapVertexAttrib(lod.normals, remap, num_used_vertices);
+				RemapVertexAttrib(lod.diffuses, remap, num_used_vertices);
+				RemapVertexAttrib(lod.speculars, remap, num_used_vertices);
+				for (auto& texcoords : lod.texcoords)
+				{
+					RemapVertexAttrib(texcoords, remap, num_used_vertices);
+				}
+				RemapVertexAttrib(lod.joint_bindings, remap, num_used_vertices);
+
+				LogInfo() << "Mesh " << mesh.name << " LoD " << mesh.lods.size() << ": " << lod.indices.size() / 3 << " of "
+					<< base_lod.indices.size() / 3 << " triangles, error " << error << std::endl;
+
+				mesh.lods.push_back(std::move(lod));
+				mesh.lod_errors.push_back(error);
 			}
-			else
+		}
+	}
+
+	void MeshLoader::OptimizeMeshes()
+	{
+		for (auto& mesh : meshes_)
+		{
+			for (size_t lod = 0; lod < mesh.lods.size(); ++ lod)
 			{
-				++ base;
+				auto& mesh_lod = mesh.lods[lod];
+				uint32_t const num_vertices = static_cast<uint32_t>(mesh_lod.positions.size());
+
+				auto const before = AnalyzeVertexCache(mesh_lod.indices, num_vertices);
+
+				OptimizeVertexCache(mesh_lod.indices, num_vertices);
+				OptimizeOverdraw(mesh_lod.indices, mesh_lod.positions);
+				auto const remap = OptimizeVertexFetch(mesh_lod.indices, num_vertices);
+
+				RemapVertexAttrib(mesh_lod.positions, remap, num_vertices);
+				RemapVertexAttrib(mesh_lod.tangents, remap, num_vertices);
+				RemapVertexAttrib(mesh_lod.binormals, remap, num_vertices);
+				RemapVertexAttrib(mesh_lod.normals, remap, num_vertices);
+				RemapVertexAttrib(mesh_lod.diffuses, remap, num_vertices);
+				RemapVertexAttrib(mesh_lod.speculars, remap, num_vertices);
+				for (auto& texcoords : mesh_lod.texcoords)
+				{
+					RemapVertexAttrib(texcoords, remap, num_vertices);
+				}
+				RemapVertexAttrib(mesh_lod.joint_bindings, remap, num_vertices);
+
+				auto const after = AnalyzeVertexCache(mesh_lod.indices, num_vertices);
+				LogInfo() << "Mesh " << mesh.name << " LoD " << lod << ": ACMR " << before.acmr << " -> " << after.acmr
+					<< ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
 			}
 		}
 	}
 
-
 	RenderModelPtr MeshLoader::Load(MeshMetadata const & metadata)
 	{
 		std::string_view const input_name = metadata.LodFileName(0);
@@ -3441,7 +3511,6 @@ namespace
 			}
 		}
 
-		uint32_t const num_lods = static_cast<uint32_t>(meshes_[0].lods.size());
 		bool const skinned = !joints_.empty();
 
 		if (skinned)
@@ -3449,6 +3518,15 @@ namespace
 			this->RemoveUnusedJoints();
 		}
 		this->RemoveUnusedMaterials();
+		if (metadata.NumAutoLods() > 0)
+		{
+			this->GenerateLods(metadata);
+		}
+		uint32_t const num_lods = static_cast<uint32_t>(meshes_[0].lods.size());
+		if (metadata.OptimizeMesh())
+		{
+			this->OptimizeMeshes();
+		}
 
 		auto global_transform = metadata.Transform();
 		if (metadata.AutoCenter())
@@ -3782,6 +3860,10 @@ namespace
 				render_mesh->NumIndices(lod, mesh_num_indices[mesh_lod_index]);
 				render_mesh->StartVertexLocation(lod, mesh_base_vertices[mesh_lod_index]);
 				render_mesh->StartIndexLocation(lod, mesh_start_indices[mesh_lod_index]);
+				if (lod < mesh.lod_errors.size())
+				{
+					render_mesh->LodError(lod, mesh.lod_errors[lod]);
+				}
 			}
 		}
 
@@ -130,6 +130,29 @@ namespace KlayGE
 				new_metadata.flip_winding_order_ = flip_winding_order_val->ValueBool();
 			}
 
+			if (auto const* optimize_mesh_val = root_value->Member("optimize_mesh"))
+			{
+				new_metadata.optimize_mesh_ = optimize_mesh_val->ValueBool();
+			}
+
+			if (auto const* auto_lods_val = root_value->Member("auto_lods"))
+			{
+				auto const& values = auto_lods_val->ValueArray();
+				new_metadata.auto_lods_.reserve(values.size());
+				for (auto const& value : values)
+				{
+					auto& auto_lod = new_metadata.auto_lods_.emplace_back();
+					if (auto const* triangle_ratio_val = value->Member("triangle_ratio"))
+					{
+						auto_lod.triangle_ratio = GetFloat(*triangle_ratio_val);
+					}
+					if (auto const* max_error_val = value->Member("max_error"))
+					{
+						auto_lod.max_error = GetFloat(*max_error_val);
+					}
+				}
+			}
+
 			if (auto const* materials_val = root_value->Member("materials"))
 			{
 				auto const& values = materials_val->ValueArray();
@@ -253,6 +276,30 @@ namespace KlayGE
 			root_value->AppendValue("flip_winding_order", doc.AllocValueBool(flip_winding_order_));
 		}
 
+		if (optimize_mesh_)
+		{
+			root_value->AppendValue("optimize_mesh", doc.AllocValueBool(optimize_mesh_));
+		}
+
+		if (!auto_lods_.empty())
+		{
+			auto auto_lods_val = doc.AllocValue(JsonValueType::Array);
+			for (auto const& auto_lod : auto_lods_)
+			{
+				auto auto_lod_val = doc.AllocValue(JsonValueType::Object);
+				if (auto_lod.triangle_ratio > 0)
+				{
+					auto_lod_val->AppendValue("triangle_ratio", doc.AllocValueFloat(auto_lod.triangle_ratio));
+				}
+				if (auto_lod.max_error > 0)
+				{
+					auto_lod_val->AppendValue("max_error", doc.AllocValueFloat(auto_lod.max_error));
+				}
+				auto_lods_val->AppendValue(std::move(auto_lod_val));
+			}
+			root_value->AppendValue("auto_lods", std::move(auto_lods_val));
+		}
+
 		if (!material_file_names_.empty())
 		{
 			auto material_file_names_val = doc.AllocValue(JsonValueType::Array);
@@ -306,6 +353,26 @@ namespace KlayGE
 		lod_file_names_[lod] = std::string(std::move(lod_name));
 	}
 
+	uint32_t MeshMetadata::NumAutoLods() const
+	{
+		return static_cast<uint32_t>(auto_lods_.size());
+	}
+
+	void MeshMetadata::NumAutoLods(uint32_t lods)
+	{
+		auto_lods_.resize(lods);
+	}
+
+	MeshMetadata::AutoLod const& MeshMetadata::AutoLodSetting(uint32_t lod) const
+	{
+		return auto_lods_[lod];
+	}
+
+	void MeshMetadata::AutoLodSetting(uint32_t lod, AutoLod const& setting)
+	{
+		auto_lods_[lod] = setting;
+	}
+
 	uint32_t MeshMetadata::NumMaterials() const
 	{
 		return static_cast<uint32_t>(material_file_names_.size());
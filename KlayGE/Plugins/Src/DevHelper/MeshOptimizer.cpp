@@ -0,0 +1,779 @@
+/**
+ * @file MeshOptimizer.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KlayGE/KlayGE.hpp>
+
+#include <KFL/ErrorHandling.hpp>
+#include <KFL/Math.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <unordered_set>
+
+#include <KlayGE/DevHelper/MeshOptimizer.hpp>
+
+namespace
+{
+	using namespace KlayGE;
+
+	// Tom Forsyth's scoring. The optimisation models a LRU cache, a bit larger than the FIFO the results are measured with.
+	uint32_t constexpr FORSYTH_CACHE_SIZE = 32;
+	float constexpr FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+	float constexpr FORSYTH_CACHE_DECAY_POWER = 1.5f;
+	float constexpr FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+	float constexpr FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+	float ForsythVertexScore(int32_t cache_position, uint32_t remaining_triangles)
+	{
+		if (remaining_triangles == 0)
+		{
+			return -1;
+		}
+
+		float score = 0;
+		if (cache_position >= 0)
+		{
+			if (cache_position < 3)
+			{
+				score = FORSYTH_LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				float const scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+				score = std::pow(1 - (cache_position - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+			}
+		}
+
+		return score + FORSYTH_VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining_triangles), -FORSYTH_VALENCE_BOOST_POWER);
+	}
+
+	// Misses of a FIFO cache, restarted at first_triangle
+	class VertexCacheSimulator
+	{
+	public:
+		VertexCacheSimulator(uint32_t num_vertices, uint32_t cache_size)
+			: timestamps_(num_vertices, 0), cache_size_(cache_size), time_(cache_size + 1)
+		{
+		}
+
+		void Reset()
+		{
+			time_ += cache_size_ + 1;
+		}
+
+		uint32_t Triangle(uint32_t const* triangle)
+		{
+			uint32_t misses = 0;
+			for (uint32_t i = 0; i < 3; ++ i)
+			{
+				uint32_t const vertex = triangle[i];
+				if (time_ - timestamps_[vertex] > cache_size_)
+				{
+					timestamps_[vertex] = time_;
+					++ time_;
+					++ misses;
+				}
+			}
+			return misses;
+		}
+
+	private:
+		std::vector<uint32_t> timestamps_;
+		uint32_t cache_size_;
+		uint32_t time_;
+	};
+
+	// Sum of squared distances to a set of weighted planes, as the symmetric matrix of the quadratic form
+	struct Quadric
+	{
+		double a2 = 0, ab = 0, ac = 0, ad = 0;
+		double b2 = 0, bc = 0, bd = 0;
+		double c2 = 0, cd = 0;
+		double d2 = 0;
+		double weight = 0;
+
+		Quadric() = default;
+
+		// The plane with the unit normal n passing through p
+		Quadric(float3 const & n, float3 const & p, double w)
+		{
+			double const a = n.x();
+			double const b = n.y();
+			double const c = n.z();
+			double const d = -(a * p.x() + b * p.y() + c * p.z());
+
+			a2 = a * a * w;
+			ab = a * b * w;
+			ac = a * c * w;
+			ad = a * d * w;
+			b2 = b * b * w;
+			bc = b * c * w;
+			bd = b * d * w;
+			c2 = c * c * w;
+			cd = c * d * w;
+			d2 = d * d * w;
+			weight = w;
+		}
+
+		Quadric& operator+=(Quadric const & rhs)
+		{
+			a2 += rhs.a2;
+			ab += rhs.ab;
+			ac += rhs.ac;
+			ad += rhs.ad;
+			b2 += rhs.b2;
+			bc += rhs.bc;
+			bd += rhs.bd;
+			c2 += rhs.c2;
+			cd += rhs.cd;
+			d2 += rhs.d2;
+			weight += rhs.weight;
+			return *this;
+		}
+
+		// Weighted mean of the squared distances
+		double Error(float3 const & p) const
+		{
+			double const x = p.x();
+			double const y = p.y();
+			double const z = p.z();
+			double const e = a2 * x * x + b2 * y * y + c2 * z * z + 2 * (ab * x * y + ac * x * z + bc * y * z)
+				+ 2 * (ad * x + bd * y + cd * z) + d2;
+			return (weight > 0) ? std::max(e / weight, 0.0) : 0;
+		}
+	};
+
+	enum class SimplifyVertexKind
+	{
+		Manifold,
+		Border,
+		Locked
+	};
+
+	// Open borders are held in place much harder than surfaces
+	float constexpr SIMPLIFY_BORDER_WEIGHT = 10;
+
+	uint64_t EdgeKey(uint32_t a, uint32_t b)
+	{
+		return (static_cast<uint64_t>(a) << 32) | b;
+	}
+
+	float3 TriangleNormal(float3 const & p0, float3 const & p1, float3 const & p2)
+	{
+		return MathLib::cross(p1 - p0, p2 - p0);
+	}
+}
+
+namespace KlayGE
+{
+	VertexCacheStatistics AnalyzeVertexCache(std::span<uint32_t const> indices, uint32_t num_vertices, uint32_t cache_size)
+	{
+		BOOST_ASSERT(indices.size() % 3 == 0);
+
+		VertexCacheStatistics ret{0, 0};
+		if (indices.empty() || (num_vertices == 0))
+		{
+			return ret;
+		}
+
+		VertexCacheSimulator cache(num_vertices, cache_size);
+		uint32_t misses = 0;
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			misses += cache.Triangle(&indices[i]);
+		}
+
+		ret.acmr = static_cast<float>(misses) / (indices.size() / 3);
+		ret.atvr = static_cast<float>(misses) / num_vertices;
+		return ret;
+	}
+
+	void OptimizeVertexCache(std::span<uint32_t> indices, uint32_t num_vertices)
+	{
+		BOOST_ASSERT(indices.size() % 3 == 0);
+
+		uint32_t const num_triangles = static_cast<uint32_t>(indices.size() / 3);
+		if (num_triangles == 0)
+		{
+			return;
+		}
+
+		// The live triangles of every vertex, packed. Emitted ones are swapped out past remaining_triangles.
+		std::vector<uint32_t> remaining_triangles(num_vertices, 0);
+		for (auto const index : indices)
+		{
+			++ remaining_triangles[index];
+		}
+		std::vector<uint32_t> adjacency_offsets(num_vertices + 1, 0);
+		std::partial_sum(remaining_triangles.begin(), remaining_triangles.end(), adjacency_offsets.begin() + 1);
+		std::vector<uint32_t> adjacency(indices.size());
+		{
+			std::vector<uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+			for (uint32_t i = 0; i < indices.size(); ++ i)
+			{
+				adjacency[fill[indices[i]]] = i / 3;
+				++ fill[indices[i]];
+			}
+		}
+
+		std::vector<int32_t> cache_positions(num_vertices, -1);
+		std::vector<float> vertex_scores(num_vertices);
+		for (uint32_t i = 0; i < num_vertices; ++ i)
+		{
+			vertex_scores[i] = ForsythVertexScore(-1, remaining_triangles[i]);
+		}
+
+		uint32_t best_triangle = 0;
+		float best_score = -1;
+		for (uint32_t i = 0; i < num_triangles; ++ i)
+		{
+			float const score = vertex_scores[indices[i * 3 + 0]] + vertex_scores[indices[i * 3 + 1]] + vertex_scores[indices[i * 3 + 2]];
+			if (score > best_score)
+			{
+				best_score = score;
+				best_triangle = i;
+			}
+		}
+
+		std::vector<bool> emitted(num_triangles, false);
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+		std::vector<uint32_t> cache;
+		std::vector<uint32_t> new_cache;
+		cache.reserve(FORSYTH_CACHE_SIZE + 3);
+		new_cache.reserve(FORSYTH_CACHE_SIZE + 3);
+		uint32_t dead_end_cursor = 0;
+		for (uint32_t emitted_triangles = 0; emitted_triangles < num_triangles; ++ emitted_triangles)
+		{
+			if (best_triangle == ~0U)
+			{
+				// Nothing in the cache connects to the rest, restart from the next triangle in the input order
+				while (emitted[dead_end_cursor])
+				{
+					++ dead_end_cursor;
+				}
+				best_triangle = dead_end_cursor;
+			}
+
+			uint32_t const* triangle = &indices[best_triangle * 3];
+			emitted[best_triangle] = true;
+			new_cache.clear();
+			for (uint32_t i = 0; i < 3; ++ i)
+			{
+				uint32_t const vertex = triangle[i];
+				output.push_back(vertex);
+				new_cache.push_back(vertex);
+
+				uint32_t* const first = &adjacency[adjacency_offsets[vertex]];
+				uint32_t* const last = first + remaining_triangles[vertex];
+				std::iter_swap(std::find(first, last, best_triangle), last - 1);
+				-- remaining_triangles[vertex];
+			}
+			for (auto const vertex : cache)
+			{
+				if ((vertex != triangle[0]) && (vertex != triangle[1]) && (vertex != triangle[2]))
+				{
+					new_cache.push_back(vertex);
+				}
+			}
+			cache.swap(new_cache);
+
+			for (uint32_t i = FORSYTH_CACHE_SIZE; i < cache.size(); ++ i)
+			{
+				cache_positions[cache[i]] = -1;
+				vertex_scores[cache[i]] = ForsythVertexScore(-1, remaining_triangles[cache[i]]);
+			}
+			uint32_t const cache_size = std::min(static_cast<uint32_t>(cache.size()), FORSYTH_CACHE_SIZE);
+			for (uint32_t i = 0; i < cache_size; ++ i)
+			{
+				cache_positions[cache[i]] = static_cast<int32_t>(i);
+				vertex_scores[cache[i]] = ForsythVertexScore(static_cast<int32_t>(i), remaining_triangles[cache[i]]);
+			}
+
+			// Only the triangles around the cached vertices change score, the next one is picked among them
+			best_triangle = ~0U;
+			best_score = -1;
+			for (auto const vertex : cache)
+			{
+				uint32_t const begin = adjacency_offsets[vertex];
+				uint32_t const end = begin + remaining_triangles[vertex];
+				for (uint32_t j = begin; j < end; ++ j)
+				{
+					uint32_t const tri = adjacency[j];
+					float const score = vertex_scores[indices[tri * 3 + 0]] + vertex_scores[indices[tri * 3 + 1]]
+						+ vertex_scores[indices[tri * 3 + 2]];
+					if (score > best_score)
+					{
+						best_score = score;
+						best_triangle = tri;
+					}
+				}
+			}
+			cache.resize(cache_size);
+		}
+
+		std::copy(output.begin(), output.end(), indices.begin());
+	}
+
+	void OptimizeOverdraw(std::span<uint32_t> indices, std::span<float3 const> positions, float threshold)
+	{
+		BOOST_ASSERT(indices.size() % 3 == 0);
+
+		uint32_t const num_triangles = static_cast<uint32_t>(indices.size() / 3);
+		uint32_t const num_vertices = static_cast<uint32_t>(positions.size());
+		if (num_triangles < 2)
+		{
+			return;
+		}
+
+		// Hard boundaries, where the cache has nothing left to share
+		std::vector<uint32_t> hard_clusters;
+		{
+			VertexCacheSimulator cache(num_vertices, DEFAULT_VERTEX_CACHE_SIZE);
+			for (uint32_t i = 0; i < num_triangles; ++ i)
+			{
+				if ((cache.Triangle(&indices[i * 3]) == 3) || (i == 0))
+				{
+					hard_clusters.push_back(i);
+				}
+			}
+		}
+		hard_clusters.push_back(num_triangles);
+
+		// Soft boundaries inside them, wherever restarting the cache still gives an ACMR close to the original one
+		std::vector<uint32_t> clusters;
+		{
+			VertexCacheSimulator cache(num_vertices, DEFAULT_VERTEX_CACHE_SIZE);
+			for (size_t c = 0; c + 1 < hard_clusters.size(); ++ c)
+			{
+				uint32_t const begin = hard_clusters[c];
+				uint32_t const end = hard_clusters[c + 1];
+
+				cache.Reset();
+				uint32_t misses = 0;
+				for (uint32_t i = begin; i < end; ++ i)
+				{
+					misses += cache.Triangle(&indices[i * 3]);
+				}
+				float const target_acmr = static_cast<float>(misses) / (end - begin) * threshold;
+
+				cache.Reset();
+				clusters.push_back(begin);
+				uint32_t cluster_begin = begin;
+				uint32_t cluster_misses = 0;
+				for (uint32_t i = begin; i < end; ++ i)
+				{
+					cluster_misses += cache.Triangle(&indices[i * 3]);
+					if ((i + 1 < end) && (static_cast<float>(cluster_misses) / (i + 1 - cluster_begin) <= target_acmr))
+					{
+						cache.Reset();
+						cluster_begin = i + 1;
+						cluster_misses = 0;
+						clusters.push_back(cluster_begin);
+					}
+				}
+			}
+		}
+		uint32_t const num_clusters = static_cast<uint32_t>(clusters.size());
+		clusters.push_back(num_triangles);
+		if (num_clusters < 2)
+		{
+			return;
+		}
+
+		float3 mesh_centroid(0, 0, 0);
+		for (uint32_t i = 0; i < num_triangles * 3; ++ i)
+		{
+			mesh_centroid += positions[indices[i]];
+		}
+		mesh_centroid /= static_cast<float>(num_triangles * 3);
+
+		// How much a cluster faces away from the centre. Those facing the most tend to be in front of the others.
+		std::vector<float> sort_keys(num_clusters);
+		for (uint32_t c = 0; c < num_clusters; ++ c)
+		{
+			float3 centroid(0, 0, 0);
+			float3 normal(0, 0, 0);
+			float area = 0;
+			for (uint32_t i = clusters[c]; i < clusters[c + 1]; ++ i)
+			{
+				float3 const& p0 = positions[indices[i * 3 + 0]];
+				float3 const& p1 = positions[indices[i * 3 + 1]];
+				float3 const& p2 = positions[indices[i * 3 + 2]];
+
+				float3 const tri_normal = MathLib::cross(p1 - p0, p2 - p0);
+				float const tri_area = MathLib::length(tri_normal);
+
+				centroid += (p0 + p1 + p2) * (tri_area / 3);
+				normal += tri_normal;
+				area += tri_area;
+			}
+
+			float const normal_length = MathLib::length(normal);
+			if ((area > 0) && (normal_length > 0))
+			{
+				sort_keys[c] = MathLib::dot(centroid / area - mesh_centroid, normal / normal_length);
+			}
+			else
+			{
+				sort_keys[c] = 0;
+			}
+		}
+
+		std::vector<uint32_t> order(num_clusters);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&sort_keys](uint32_t lhs, uint32_t rhs) { return sort_keys[lhs] > sort_keys[rhs]; });
+
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+		for (auto const c : order)
+		{
+			output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+		}
+		std::copy(output.begin(), output.end(), indices.begin());
+	}
+
+	std::vector<uint32_t> OptimizeVertexFetch(std::span<uint32_t> indices, uint32_t num_vertices)
+	{
+		std::vector<uint32_t> remap(num_vertices, ~0U);
+		uint32_t next_vertex = 0;
+		for (auto& index : indices)
+		{
+			if (remap[index] == ~0U)
+			{
+				remap[index] = next_vertex;
+				++ next_vertex;
+			}
+			index = remap[index];
+		}
+		for (auto& new_index : remap)
+		{
+			if (new_index == ~0U)
+			{
+				new_index = next_vertex;
+				++ next_vertex;
+			}
+		}
+
+		return remap;
+	}
+
+	std::vector<uint32_t> SimplifyMesh(std::span<uint32_t const> indices, std::span<float3 const> positions,
+		uint32_t target_num_indices, float target_error, float& result_error)
+	{
+		BOOST_ASSERT(indices.size() % 3 == 0);
+
+		uint32_t const num_vertices = static_cast<uint32_t>(positions.size());
+		std::vector<uint32_t> result(indices.begin(), indices.end());
+		result_error = 0;
+
+		// Vertices with the same position share an id, the topology is built on those
+		std::vector<uint32_t> position_ids(num_vertices);
+		std::vector<bool> shared_position(num_vertices, false);
+		{
+			std::vector<uint32_t> sorted(num_vertices);
+			std::iota(sorted.begin(), sorted.end(), 0);
+			auto less = [&positions](uint32_t lhs, uint32_t rhs) {
+				float3 const & l = positions[lhs];
+				float3 const & r = positions[rhs];
+				return std::tie(l.x(), l.y(), l.z()) < std::tie(r.x(), r.y(), r.z());
+			};
+			std::sort(sorted.begin(), sorted.end(), less);
+			for (uint32_t i = 0; i < num_vertices;)
+			{
+				uint32_t j = i + 1;
+				while ((j < num_vertices) && !less(sorted[i], sorted[j]))
+				{
+					++ j;
+				}
+				for (uint32_t k = i; k < j; ++ k)
+				{
+					position_ids[sorted[k]] = sorted[i];
+					shared_position[sorted[k]] = (j - i > 1);
+				}
+				i = j;
+			}
+		}
+
+		// Directed edges of the current triangles. An edge without its opposite is on the border.
+		std::unordered_set<uint64_t> position_edges;
+		auto build_position_edges = [&position_edges, &position_ids, &result] {
+			position_edges.clear();
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				for (uint32_t j = 0; j < 3; ++ j)
+				{
+					position_edges.insert(EdgeKey(position_ids[result[i + j]], position_ids[result[i + (j + 1) % 3]]));
+				}
+			}
+		};
+		build_position_edges();
+		auto is_border_edge = [&position_edges, &position_ids](uint32_t a, uint32_t b) {
+			return position_edges.find(EdgeKey(position_ids[b], position_ids[a])) == position_edges.end();
+		};
+
+		std::vector<SimplifyVertexKind> kinds(num_vertices, SimplifyVertexKind::Manifold);
+		std::vector<uint32_t> num_border_edges(num_vertices, 0);
+		std::vector<Quadric> quadrics(num_vertices);
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			uint32_t const* triangle = &result[i];
+			float3 const normal = TriangleNormal(positions[triangle[0]], positions[triangle[1]], positions[triangle[2]]);
+			float const length = MathLib::length(normal);
+			if (length <= 0)
+			{
+				continue;
+			}
+
+			float3 const unit_normal = normal / length;
+			Quadric const plane(unit_normal, positions[triangle[0]], length * 0.5f);
+			for (uint32_t j = 0; j < 3; ++ j)
+			{
+				quadrics[triangle[j]] += plane;
+			}
+
+			for (uint32_t j = 0; j < 3; ++ j)
+			{
+				uint32_t const a = triangle[j];
+				uint32_t const b = triangle[(j + 1) % 3];
+				if (is_border_edge(a, b))
+				{
+					++ num_border_edges[a];
+					++ num_border_edges[b];
+
+					float3 const edge = positions[b] - positions[a];
+					float3 const side = MathLib::cross(edge, unit_normal);
+					float const side_length = MathLib::length(side);
+					if (side_length > 0)
+					{
+						Quadric const border_plane(side / side_length, positions[a], MathLib::length_sq(edge) * SIMPLIFY_BORDER_WEIGHT);
+						quadrics[a] += border_plane;
+						quadrics[b] += border_plane;
+					}
+				}
+			}
+		}
+		for (uint32_t i = 0; i < num_vertices; ++ i)
+		{
+			if (shared_position[i] || (num_border_edges[i] > 2))
+			{
+				kinds[i] = SimplifyVertexKind::Locked;
+			}
+			else if (num_border_edges[i] > 0)
+			{
+				kinds[i] = SimplifyVertexKind::Border;
+			}
+		}
+
+		double const max_error_sq = static_cast<double>(target_error) * target_error;
+
+		struct Collapse
+		{
+			uint32_t from;
+			uint32_t to;
+			double error;
+		};
+		std::vector<Collapse> collapses;
+		std::vector<uint32_t> adjacency_offsets(num_vertices + 1);
+		std::vector<uint32_t> adjacency;
+		std::vector<uint32_t> remap(num_vertices);
+		std::vector<bool> touched(num_vertices);
+		bool first_pass = true;
+		while (result.size() > target_num_indices)
+		{
+			// Collapses create new edges, so the edges are rebuilt with the adjacency
+			if (!first_pass)
+			{
+				build_position_edges();
+			}
+			first_pass = false;
+
+			// Triangles around every vertex
+			std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+			for (auto const index : result)
+			{
+				++ adjacency_offsets[index + 1];
+			}
+			std::partial_sum(adjacency_offsets.begin(), adjacency_offsets.end(), adjacency_offsets.begin());
+			adjacency.resize(result.size());
+			{
+				std::vector<uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+				for (uint32_t i = 0; i < result.size(); ++ i)
+				{
+					adjacency[fill[result[i]]] = i / 3;
+					++ fill[result[i]];
+				}
+			}
+
+			auto can_collapse = [&kinds, &is_border_edge](uint32_t from, uint32_t to) {
+				switch (kinds[from])
+				{
+				case SimplifyVertexKind::Manifold:
+					return true;
+				case SimplifyVertexKind::Border:
+					return (kinds[to] != SimplifyVertexKind::Manifold) && is_border_edge(from, to);
+				default:
+					return false;
+				}
+			};
+
+			collapses.clear();
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				for (uint32_t j = 0; j < 3; ++ j)
+				{
+					uint32_t const a = result[i + j];
+					uint32_t const b = result[i + (j + 1) % 3];
+
+					// Interior edges are seen from both triangles, only one of them has to add it
+					if ((a > b) && !is_border_edge(a, b))
+					{
+						continue;
+					}
+
+					Collapse best{0, 0, std::numeric_limits<double>::max()};
+					for (auto const& [from, to] : {std::make_pair(a, b), std::make_pair(b, a)})
+					{
+						if (can_collapse(from, to))
+						{
+							Quadric q = quadrics[from];
+							q += quadrics[to];
+							double const error = q.Error(positions[to]);
+							if (error < best.error)
+							{
+								best = {from, to, error};
+							}
+						}
+					}
+					if ((best.error <= max_error_sq) && (best.from != best.to))
+					{
+						collapses.push_back(best);
+					}
+				}
+			}
+			if (collapses.empty())
+			{
+				break;
+			}
+			std::sort(collapses.begin(), collapses.end(), [](Collapse const & lhs, Collapse const & rhs) { return lhs.error < rhs.error; });
+
+			// Each collapse removes about 2 triangles. Collapses costlier than the last of those needed wait for the next pass,
+			// where they might have cheaper alternatives. A vertex changes at most once a pass, so the checks see the current mesh.
+			std::iota(remap.begin(), remap.end(), 0);
+			std::fill(touched.begin(), touched.end(), false);
+			uint32_t const triangles_to_remove = static_cast<uint32_t>(result.size() - target_num_indices) / 3;
+			double const pass_error_limit = collapses[std::min<size_t>(collapses.size(), (triangles_to_remove + 1) / 2) - 1].error;
+			uint32_t removed_triangles = 0;
+			double pass_error = 0;
+			for (auto const & collapse : collapses)
+			{
+				if ((removed_triangles >= triangles_to_remove) || (collapse.error > pass_error_limit))
+				{
+					break;
+				}
+
+				uint32_t const from = collapse.from;
+				uint32_t const to = collapse.to;
+				if (touched[from] || touched[to])
+				{
+					continue;
+				}
+
+				bool valid = true;
+				uint32_t degenerated = 0;
+				for (uint32_t j = adjacency_offsets[from]; valid && (j < adjacency_offsets[from + 1]); ++ j)
+				{
+					uint32_t const* triangle = &result[adjacency[j] * 3];
+					if ((triangle[0] == to) || (triangle[1] == to) || (triangle[2] == to))
+					{
+						++ degenerated;
+						continue;
+					}
+
+					// The triangles around it mustn't flip
+					float3 p[3];
+					float3 moved[3];
+					for (uint32_t k = 0; k < 3; ++ k)
+					{
+						p[k] = positions[triangle[k]];
+						moved[k] = (triangle[k] == from) ? positions[to] : p[k];
+					}
+					float3 const before = TriangleNormal(p[0], p[1], p[2]);
+					float3 const after = TriangleNormal(moved[0], moved[1], moved[2]);
+					valid = MathLib::dot(before, after) > 0;
+				}
+				if (!valid || (degenerated == 0))
+				{
+					continue;
+				}
+
+				for (uint32_t j = adjacency_offsets[from]; j < adjacency_offsets[from + 1]; ++ j)
+				{
+					uint32_t const* triangle = &result[adjacency[j] * 3];
+					for (uint32_t k = 0; k < 3; ++ k)
+					{
+						touched[triangle[k]] = true;
+					}
+				}
+
+				remap[from] = to;
+				quadrics[to] += quadrics[from];
+				removed_triangles += degenerated;
+				pass_error = std::max(pass_error, collapse.error);
+			}
+			if (removed_triangles == 0)
+			{
+				break;
+			}
+			result_error = std::max(result_error, static_cast<float>(std::sqrt(pass_error)));
+
+			size_t write = 0;
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				uint32_t const v0 = remap[result[i + 0]];
+				uint32_t const v1 = remap[result[i + 1]];
+				uint32_t const v2 = remap[result[i + 2]];
+				if ((v0 != v1) && (v1 != v2) && (v2 != v0))
+				{
+					result[write + 0] = v0;
+					result[write + 1] = v1;
+					result[write + 2] = v2;
+					write += 3;
+				}
+			}
+			result.resize(write);
+		}
+
+		return result;
+	}
+}
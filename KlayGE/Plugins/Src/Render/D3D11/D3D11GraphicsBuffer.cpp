@@ -341,9 +341,13 @@ namespace KlayGE
 
 	void D3D11GraphicsBuffer::UpdateSubresource(uint32_t offset, uint32_t size, void const * data)
 	{
+		auto const& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+
 		D3D11_BOX* p = nullptr;
 		D3D11_BOX box;
-		if (!(bind_flags_ & D3D11_BIND_CONSTANT_BUFFER))
+		// Constant buffers can only be updated partially with ConstantBufferPartialUpdate
+		if (!(bind_flags_ & D3D11_BIND_CONSTANT_BUFFER)
+			|| (re.DeviceCaps().constant_buffer_partial_update_support && ((offset > 0) || (size < size_in_byte_))))
 		{
 			p = &box;
 			box.left = offset;
@@ -353,6 +357,6 @@ namespace KlayGE
 			box.bottom = 1;
 			box.back = 1;
 		}
-		d3d_imm_ctx_->UpdateSubresource(d3d_buffer_.get(), 0, p, data, size, size);
+		d3d_imm_ctx_->UpdateSubresource1(d3d_buffer_.get(), 0, p, data, size, size, 0);
 	}
 }
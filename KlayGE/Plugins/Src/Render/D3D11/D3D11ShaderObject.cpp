@@ -1183,14 +1183,23 @@ namespace KlayGE
 				if (!cbuff_indices.empty())
 				{
 					ID3D11Buffer* d3d11_cbuffs[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+					UINT first_constants[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+					UINT num_constants[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
 					for (uint32_t i = 0; i < cbuff_indices.size(); ++i)
 					{
 						auto* cb = effect.CBufferByIndex(cbuff_indices[i]);
 						cb->Update();
 						d3d11_cbuffs[i] = checked_cast<D3D11GraphicsBuffer*>(cb->HWBuff().get())->D3DBuffer();
+
+						// A constant is 16 bytes, and ranges are in multiples of 16 constants. A range past the end of a buffer is
+						// clipped to the buffer.
+						first_constants[i] = cb->HWBuffOffset() / 16;
+						num_constants[i] = cb->Transient() ? ((cb->Size() + 255) & ~255U) / 16 : D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT;
 					}
 
-					re.SetConstantBuffers(stage, MakeSpan(d3d11_cbuffs, cbuff_indices.size()));
+					size_t const num_cbuffs = cbuff_indices.size();
+					re.SetConstantBuffers(stage, MakeSpan(d3d11_cbuffs, num_cbuffs), MakeSpan(first_constants, num_cbuffs),
+						MakeSpan(num_constants, num_cbuffs));
 				}
 			}
 		}
@@ -450,8 +450,9 @@ namespace KlayGE
 		auto& re = checked_cast<D3D12RenderEngine&>(Context::Instance().RenderFactoryInstance().RenderEngineInstance());
 		if ((0 == access_hint_) || (access_hint_ & EAH_CPU_Read) || (access_hint_ & EAH_CPU_Write))
 		{
-			uint8_t* old_mem = nullptr; 
-			if (offset > 0)
+			// The rest of the buffer is kept from the old block
+			uint8_t const * old_mem = nullptr;
+			if (gpu_mem_block_ && ((offset > 0) || (offset + size < size_in_byte_)))
 			{
 				old_mem = gpu_mem_block_.CpuAddress<uint8_t>();
 			}
@@ -459,9 +460,10 @@ namespace KlayGE
 			re.RenewUploadMemBlock(gpu_mem_block_, size_in_byte_, D3D12GpuMemoryAllocator::ConstantDataAligment);
 
 			uint8_t* dst = gpu_mem_block_.CpuAddress<uint8_t>();
-			if (offset > 0)
+			if (old_mem != nullptr)
 			{
 				memcpy(dst, old_mem, offset);
+				memcpy(dst + offset + size, old_mem + offset + size, size_in_byte_ - offset - size);
 			}
 			memcpy(dst + offset, data, size);
 
@@ -1115,6 +1115,9 @@ namespace KlayGE
 		caps_.independent_blend_support = true;
 		caps_.draw_indirect_support = true;
 		caps_.no_overwrite_support = true;
+		// Every update renews the whole upload block, so a partial one would read back from write-combined memory
+		caps_.constant_buffer_partial_update_support = false;
+		caps_.constant_buffer_offset_support = true;
 		caps_.full_npot_texture_support = true;
 		caps_.render_to_texture_array_support = true;
 		caps_.explicit_multi_sample_support = true;
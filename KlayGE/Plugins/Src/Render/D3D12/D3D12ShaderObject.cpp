@@ -1196,7 +1196,8 @@ namespace KlayGE
 		auto const* shader_stage = checked_cast<D3D12ShaderStageObject*>(this->Stage(static_cast<ShaderStage>(stage)).get());
 		if (shader_stage)
 		{
-			return checked_cast<D3D12GraphicsBuffer&>(*effect.CBufferByIndex(shader_stage->CBufferIndices()[index])->HWBuff()).GpuVirtualAddress();
+			auto const* cb = effect.CBufferByIndex(shader_stage->CBufferIndices()[index]);
+			return checked_cast<D3D12GraphicsBuffer&>(*cb->HWBuff()).GpuVirtualAddress() + cb->HWBuffOffset();
 		}
 		return 0;
 	}
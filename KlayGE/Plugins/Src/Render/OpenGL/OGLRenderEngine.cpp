@@ -1519,6 +1519,9 @@ namespace KlayGE
 		caps_.independent_blend_support = true;
 		caps_.draw_indirect_support = true;
 		caps_.no_overwrite_support = false;
+		caps_.constant_buffer_partial_update_support = true;
+		// The constant ring is written with no-overwrite maps
+		caps_.constant_buffer_offset_support = false;
 		caps_.full_npot_texture_support = true;
 		if (caps_.max_texture_array_length > 1)
 		{
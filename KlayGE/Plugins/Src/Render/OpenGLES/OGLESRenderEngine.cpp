@@ -1487,6 +1487,9 @@ namespace KlayGE
 			caps_.draw_indirect_support = false;
 		}
 		caps_.no_overwrite_support = false;
+		caps_.constant_buffer_partial_update_support = true;
+		// The constant ring is written with no-overwrite maps
+		caps_.constant_buffer_offset_support = false;
 		if (this->HackForAndroidEmulator())
 		{
 			caps_.full_npot_texture_support = false;
@@ -36,10 +36,19 @@
 #include <KlayGE/RenderEngine.hpp>
 #include <KlayGE/FrameBuffer.hpp>
 #include <KlayGE/DeferredRenderingLayer.hpp>
+#include <KlayGE/PerfProfiler.hpp>
+#include <KlayGE/Viewport.hpp>
+#include <KFL/TaskScheduler.hpp>
 
 #include <algorithm>
+#include <iterator>
+#include <string>
 #include <boost/assert.hpp>
 
+#if defined(KLAYGE_SSE_SUPPORT)
+#include <xmmintrin.h>
+#endif
+
 #ifdef KLAYGE_DRAW_NODES
 #include <KlayGE/RenderEffect.hpp>
 #endif
@@ -69,12 +78,13 @@ namespace
 
 			float4x4 const & view_proj = app.ActiveCamera().ViewProjMatrix();
 
-			*(technique_->Effect().ParameterByName("color")) = float4(1, 1, 1, 1);
+			*(effect_->ParameterByHandle(color_handle_)) = float4(1, 1, 1, 1);
+			auto* mvp_param = effect_->ParameterByHandle(mvp_handle_);
 			for (uint32_t i = 0; i < instances_.size(); ++ i)
 			{
-				*(technique_->Effect().ParameterByName("matViewProj")) = instances_[i] * view_proj;
+				*mvp_param = instances_[i] * view_proj;
 
-				re.Render(*technique_, *rl_);
+				re.Render(*effect_, *technique_, *rl_);
 			}
 
 			this->OnRenderEnd();
@@ -92,20 +102,125 @@ namespace
 
 	private:
 		std::vector<float4x4> instances_;
+
+		RenderEffectParameterHandle color_handle_{CT_HASH("color")};
+		RenderEffectParameterHandle mvp_handle_{CT_HASH("matViewProj")};
 	};
 }
 #endif
 
+namespace
+{
+	using namespace KlayGE;
+
+	// Below these sizes, the tree is built and culled on the calling thread only
+	size_t constexpr PARALLEL_BUILD_MIN_OBJS = 4096;
+	size_t constexpr PARALLEL_CULL_MIN_NODES = 4096;
+
+	// A leaf is split when it has more objects than this, a subtree is merged back to one node when it has no more than that
+	size_t constexpr SPLIT_MIN_OBJS = 8;
+	uint32_t constexpr MERGE_MAX_OBJS = 4;
+	// Objects out of the root bound are kept in the root. The tree is rebuilt when there are too many of them.
+	size_t constexpr MAX_OUT_OF_BOUND_OBJS = 64;
+
+	// The cells are cubes. A node's loose bound has the same center as its cell, and twice the size.
+	// An object fits in a cell if its center is in the cell and it's not larger than the cell, so it's inside the loose bound.
+	bool FitsInCell(AABBox const & loose_bb, AABBox const & aabb)
+	{
+		float3 const cell_center = loose_bb.Center();
+		float const cell_extent = loose_bb.HalfSize().x() / 2;
+		float3 const center = aabb.Center();
+		float3 const extent = aabb.HalfSize();
+		return (std::max(std::max(extent.x(), extent.y()), extent.z()) <= cell_extent)
+			&& (std::abs(center.x() - cell_center.x()) <= cell_extent)
+			&& (std::abs(center.y() - cell_center.y()) <= cell_extent)
+			&& (std::abs(center.z() - cell_center.z()) <= cell_extent);
+	}
+
+	// The child of an object that fits in the cell, or -1 if it's too large for the children
+	int ChildCell(AABBox const & loose_bb, AABBox const & aabb)
+	{
+		float const child_extent = loose_bb.HalfSize().x() / 4;
+		float3 const extent = aabb.HalfSize();
+		if (std::max(std::max(extent.x(), extent.y()), extent.z()) > child_extent)
+		{
+			return -1;
+		}
+
+		float3 const cell_center = loose_bb.Center();
+		float3 const center = aabb.Center();
+		return (center.x() >= cell_center.x() ? 1 : 0) + (center.y() >= cell_center.y() ? 2 : 0)
+			+ (center.z() >= cell_center.z() ? 4 : 0);
+	}
+
+	bool AnyFitsInChildren(AABBox const & loose_bb, std::vector<SceneNode*> const & node_ptrs)
+	{
+		return std::any_of(node_ptrs.begin(), node_ptrs.end(),
+			[&loose_bb](SceneNode const * node) { return ChildCell(loose_bb, node->PosBoundWS()) != -1; });
+	}
+
+	bool ContainsAABB(AABBox const & outer, AABBox const & inner)
+	{
+		return (inner.Min().x() >= outer.Min().x()) && (inner.Min().y() >= outer.Min().y()) && (inner.Min().z() >= outer.Min().z())
+			&& (inner.Max().x() <= outer.Max().x()) && (inner.Max().y() <= outer.Max().y()) && (inner.Max().z() <= outer.Max().z());
+	}
+
+#if defined(KLAYGE_SSE_SUPPORT)
+	// The same as MathLib::intersect_aabb_frustum, on 4 boxes at a time. Bit i of out_mask is set if box i is outside
+	// of the frustum, bit i of partial_mask is set if box i intersects a plane.
+	void IntersectAABB4Frustum(float const * min_x, float const * min_y, float const * min_z,
+		float const * max_x, float const * max_y, float const * max_z, Frustum const & frustum,
+		int& out_mask, int& partial_mask)
+	{
+		__m128 const bb_min_x = _mm_loadu_ps(min_x);
+		__m128 const bb_min_y = _mm_loadu_ps(min_y);
+		__m128 const bb_min_z = _mm_loadu_ps(min_z);
+		__m128 const bb_max_x = _mm_loadu_ps(max_x);
+		__m128 const bb_max_y = _mm_loadu_ps(max_y);
+		__m128 const bb_max_z = _mm_loadu_ps(max_z);
+		__m128 const zero = _mm_setzero_ps();
+
+		__m128 out = zero;
+		__m128 partial = zero;
+		for (uint32_t i = 0; i < 6; ++ i)
+		{
+			Plane const & plane = frustum.FrustumPlane(i);
+			__m128 const a = _mm_set1_ps(plane.a());
+			__m128 const b = _mm_set1_ps(plane.b());
+			__m128 const c = _mm_set1_ps(plane.c());
+			__m128 const d = _mm_set1_ps(plane.d());
+
+			// v1 is diagonally opposed to v0
+			__m128 const v0_x = (plane.a() < 0) ? bb_min_x : bb_max_x;
+			__m128 const v0_y = (plane.b() < 0) ? bb_min_y : bb_max_y;
+			__m128 const v0_z = (plane.c() < 0) ? bb_min_z : bb_max_z;
+			__m128 const v1_x = (plane.a() < 0) ? bb_max_x : bb_min_x;
+			__m128 const v1_y = (plane.b() < 0) ? bb_max_y : bb_min_y;
+			__m128 const v1_z = (plane.c() < 0) ? bb_max_z : bb_min_z;
+
+			__m128 const dot0 = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a, v0_x), _mm_mul_ps(b, v0_y)), _mm_mul_ps(c, v0_z)), d);
+			__m128 const dot1 = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a, v1_x), _mm_mul_ps(b, v1_y)), _mm_mul_ps(c, v1_z)), d);
+			out = _mm_or_ps(out, _mm_cmplt_ps(dot0, zero));
+			partial = _mm_or_ps(partial, _mm_cmplt_ps(dot1, zero));
+		}
+
+		out_mask = _mm_movemask_ps(out);
+		partial_mask = _mm_movemask_ps(partial);
+	}
+#endif
+}
+
 namespace KlayGE
 {
 	OCTree::OCTree()
-		: max_tree_depth_(4), rebuild_tree_(false)
+		: max_tree_depth_(4), rebuild_tree_(true)
 	{
 	}
 
 	void OCTree::MaxTreeDepth(uint32_t max_tree_depth)
 	{
 		max_tree_depth_ = std::min<uint32_t>(max_tree_depth, 16UL);
+		rebuild_tree_ = true;
 	}
 
 	uint32_t OCTree::MaxTreeDepth() const
@@ -115,32 +230,28 @@ namespace KlayGE
 
 	void OCTree::ClipScene()
 	{
-		if (rebuild_tree_)
-		{
-			octree_.resize(1);
-			AABBox bb_root(float3(0, 0, 0), float3(0, 0, 0));
-			octree_[0].first_child_index = -1;
-			octree_[0].visible = BoundOverlap::No;
-			for (auto* sn : all_scene_nodes_)
-			{
-				auto const & node = *sn;
-				uint32_t const attr = node.Attrib();
-				if (node.Updated() && (attr & SceneNode::SOA_Cullable) && !(attr & SceneNode::SOA_Moveable))
-				{
-					bb_root |= node.PosBoundWS();
-					octree_[0].node_ptrs.push_back(sn);
-				}
-			}
-			float3 const & center = bb_root.Center();
-			float3 const & extent = bb_root.HalfSize();
-			float longest_dim = std::max(std::max(extent.x(), extent.y()), extent.z());
-			float3 new_extent(longest_dim, longest_dim, longest_dim);
-			octree_[0].bb = AABBox(center - new_extent, center + new_extent);
+		auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+		auto const& viewport = *re.CurFrameBuffer()->Viewport();
+		uint32_t const num_cameras = viewport.NumCameras();
 
-			this->DivideNode(0, 1);
+		this->MaintainTree(all_scene_nodes_);
 
-			rebuild_tree_ = false;
+#ifndef KLAYGE_SHIP
+		uint32_t const frame = Context::Instance().AppInstance().TotalNumFrames();
+		if (cull_frame_ != frame)
+		{
+			cull_frame_ = frame;
+			num_culls_in_frame_ = 0;
 		}
+		if (num_culls_in_frame_ == cull_perfs_.size())
+		{
+			cull_perfs_.push_back(
+				PerfProfiler::Instance().CreatePerfRegion(0, "OCTree cull (pass " + std::to_string(num_culls_in_frame_) + ")"));
+		}
+		PerfRegion* cull_perf = cull_perfs_[num_culls_in_frame_];
+		++ num_culls_in_frame_;
+		cull_perf->Begin();
+#endif
 
 #ifdef KLAYGE_DRAW_NODES
 		if (!node_renderable_)
@@ -152,13 +263,9 @@ namespace KlayGE
 
 		if (!octree_.empty())
 		{
-			this->NodeVisible(0);
+			this->NodeVisible(viewport);
 		}
 
-		auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
-		auto const& viewport = *re.CurFrameBuffer()->Viewport();
-		uint32_t const num_cameras = viewport.NumCameras();
-
 		bool omni_directional = false;
 		for (uint32_t i = 0; i < num_cameras; ++i)
 		{
@@ -229,7 +336,7 @@ namespace KlayGE
 		{
 			if (!octree_.empty())
 			{
-				this->MarkNodeObjs(0, false);
+				this->MarkNodeObjs(0, num_cameras, false);
 			}
 
 			for (auto* sn : all_scene_nodes_)
@@ -238,17 +345,29 @@ namespace KlayGE
 				uint32_t const attr = node.Attrib();
 				if (node.Visible() && (attr & SceneNode::SOA_Cullable) && (attr & SceneNode::SOA_Moveable))
 				{
+					BoundOverlap cell_visible = BoundOverlap::Partial;
+					auto iter = objs_.find(sn);
+					if ((iter != objs_.end()) && (iter->second.node_index >= 0))
+					{
+						cell_visible = this->NodeVisibleFromRoot(iter->second.node_index);
+					}
+
 					for (uint32_t i = 0; i < num_cameras; ++i)
 					{
 						if (node.VisibleMark(i) == BoundOverlap::Partial)
 						{
-							node.VisibleMark(i, camera_frustums_[i]->Intersect(node.PosBoundWS()));
+							node.VisibleMark(i, (BoundOverlap::No == cell_visible)
+								? BoundOverlap::No : camera_frustums_[i]->Intersect(node.PosBoundWS()));
 						}
 					}
 				}
 			}
 		}
 
+#ifndef KLAYGE_SHIP
+		cull_perf->End();
+#endif
+
 #ifdef KLAYGE_DRAW_NODES
 		node_renderable_->Render();
 #endif
@@ -259,12 +378,202 @@ namespace KlayGE
 		SceneManager::ClearObject();
 
 		octree_.clear();
+		octree_bbs_.Resize(0);
+		free_children_.clear();
+		objs_.clear();
+		pending_objs_.clear();
+		moveable_objs_.clear();
+		num_out_of_bound_objs_ = 0;
+		split_candidates_.clear();
+		merge_candidates_.clear();
 		rebuild_tree_ = true;
 	}
 
-	void OCTree::OnSceneChanged()
+	void OCTree::OnNodeAttached(SceneNode& node)
 	{
-		rebuild_tree_ = true;
+		node.Traverse([this](SceneNode& sn)
+			{
+				if (objs_.emplace(&sn, octree_obj_t{-1, 0, -1, false}).second)
+				{
+					pending_objs_.push_back(&sn);
+				}
+				return true;
+			});
+	}
+
+	void OCTree::OnNodeDetached(SceneNode& node)
+	{
+		node.Traverse([this](SceneNode& sn)
+			{
+				auto iter = objs_.find(&sn);
+				if (iter != objs_.end())
+				{
+					auto& obj = iter->second;
+					if (obj.node_index >= 0)
+					{
+						this->RemoveObj(sn, obj);
+					}
+					if (obj.moveable_slot >= 0)
+					{
+						SceneNode* last = moveable_objs_.back();
+						moveable_objs_[obj.moveable_slot] = last;
+						moveable_objs_.pop_back();
+						if (last != &sn)
+						{
+							objs_[last].moveable_slot = obj.moveable_slot;
+						}
+					}
+					objs_.erase(iter);
+				}
+				return true;
+			});
+	}
+
+	void OCTree::PrepareCullCameras()
+	{
+		this->MaintainTree(cull_nodes_);
+
+		for (auto& octree_node : octree_)
+		{
+			octree_node.cull_indices.resize(octree_node.node_ptrs.size());
+		}
+		for (size_t i = 0; i < cull_nodes_.size(); ++ i)
+		{
+			auto iter = objs_.find(cull_nodes_[i]);
+			if ((iter != objs_.end()) && (iter->second.node_index >= 0))
+			{
+				octree_[iter->second.node_index].cull_indices[iter->second.slot] = static_cast<uint32_t>(i);
+			}
+		}
+	}
+
+	// Only reads the tree, so the cameras can be culled concurrently. The objects in the nodes that are entirely in or out of
+	// the frustum are resolved here, the others are left untested for SceneManager::ResolveCullHierarchy.
+	void OCTree::CullCamera(Camera const & camera, float small_obj_threshold, VisibilityBitset& visibility,
+		VisibilityBitset& tested) const
+	{
+		if (octree_.empty() || camera.OmniDirectionalMode())
+		{
+			return;
+		}
+
+		Frustum const & frustum = camera.ViewFrustum();
+		float4x4 const & view_proj = camera.ViewProjMatrix();
+		auto large_enough = [&camera, &view_proj, small_obj_threshold](AABBox const & aabb)
+		{
+			return (small_obj_threshold <= 0) || ((MathLib::ortho_area(camera.ForwardVec(), aabb) > small_obj_threshold)
+				&& (MathLib::perspective_area(camera.EyePos(), view_proj, aabb) > small_obj_threshold));
+		};
+
+		std::vector<std::pair<size_t, BoundOverlap>> stack;
+		{
+			AABBox const root_bb = octree_bbs_.BB(0);
+			BoundOverlap root_visible;
+			if (num_out_of_bound_objs_ > 0)
+			{
+				root_visible = BoundOverlap::Partial;
+			}
+			else if (large_enough(root_bb))
+			{
+				root_visible = frustum.Intersect(root_bb);
+			}
+			else
+			{
+				root_visible = BoundOverlap::No;
+			}
+			stack.emplace_back(0, root_visible);
+		}
+
+		while (!stack.empty())
+		{
+			auto const [index, visible] = stack.back();
+			stack.pop_back();
+
+			auto const & octree_node = octree_[index];
+			if (visible != BoundOverlap::Partial)
+			{
+				for (size_t i = 0; i < octree_node.cull_indices.size(); ++ i)
+				{
+					uint32_t const cull_index = octree_node.cull_indices[i];
+					uint64_t const bit = 1ULL << (cull_index & 63);
+					tested[cull_index / 64] |= bit;
+					if ((BoundOverlap::Yes == visible) && large_enough(octree_node.node_ptrs[i]->PosBoundWS()))
+					{
+						visibility[cull_index / 64] |= bit;
+					}
+				}
+			}
+
+			if (octree_node.first_child_index != -1)
+			{
+				size_t const first_child_index = octree_node.first_child_index;
+				std::array<BoundOverlap, 8> children_visible;
+				if (visible != BoundOverlap::Partial)
+				{
+					children_visible.fill(visible);
+				}
+				else
+				{
+#if defined(KLAYGE_SSE_SUPPORT)
+					for (size_t j = 0; j < 8; j += 4)
+					{
+						size_t const child_index = first_child_index + j;
+						int out_mask, partial_mask;
+						IntersectAABB4Frustum(&octree_bbs_.min_x[child_index], &octree_bbs_.min_y[child_index],
+							&octree_bbs_.min_z[child_index], &octree_bbs_.max_x[child_index], &octree_bbs_.max_y[child_index],
+							&octree_bbs_.max_z[child_index], frustum, out_mask, partial_mask);
+						for (size_t k = 0; k < 4; ++ k)
+						{
+							children_visible[j + k] = (out_mask & (1 << k)) ? BoundOverlap::No
+								: ((partial_mask & (1 << k)) ? BoundOverlap::Partial : BoundOverlap::Yes);
+						}
+					}
+#else
+					for (size_t j = 0; j < 8; ++ j)
+					{
+						children_visible[j] = frustum.Intersect(octree_bbs_.BB(first_child_index + j));
+					}
+#endif
+					for (size_t j = 0; j < 8; ++ j)
+					{
+						if ((children_visible[j] != BoundOverlap::No) && !large_enough(octree_bbs_.BB(first_child_index + j)))
+						{
+							children_visible[j] = BoundOverlap::No;
+						}
+					}
+				}
+
+				for (size_t j = 0; j < 8; ++ j)
+				{
+					stack.emplace_back(first_child_index + j, children_visible[j]);
+				}
+			}
+		}
+	}
+
+	void OCTree::MaintainTree(std::vector<SceneNode*> const & scene_nodes)
+	{
+#ifndef KLAYGE_SHIP
+		if (build_perf_ == nullptr)
+		{
+			build_perf_ = PerfProfiler::Instance().CreatePerfRegion(0, "OCTree build");
+		}
+		build_perf_->Begin();
+#endif
+
+		if (!rebuild_tree_)
+		{
+			this->UpdateTree();
+		}
+		if (rebuild_tree_)
+		{
+			this->BuildTree(scene_nodes);
+			rebuild_tree_ = false;
+		}
+
+#ifndef KLAYGE_SHIP
+		build_perf_->End();
+#endif
 	}
 
 	void OCTree::DoSuspend()
@@ -277,131 +586,604 @@ namespace KlayGE
 		// TODO
 	}
 
-	void OCTree::DivideNode(size_t index, uint32_t curr_depth)
+	void OCTree::BuildTree(std::vector<SceneNode*> const & scene_nodes)
 	{
-		if (octree_[index].node_ptrs.size() > 1)
+		objs_.clear();
+		pending_objs_.clear();
+		moveable_objs_.clear();
+		free_children_.clear();
+		split_candidates_.clear();
+		merge_candidates_.clear();
+		num_out_of_bound_objs_ = 0;
+
+		octree_.resize(1);
+		octree_bbs_.Resize(1);
+		AABBox bb_root(float3(0, 0, 0), float3(0, 0, 0));
+		octree_[0].parent_index = -1;
+		octree_[0].first_child_index = -1;
+		octree_[0].depth = 0;
+		octree_[0].visible = BoundOverlap::No;
+		octree_[0].node_ptrs.clear();
+		for (auto* sn : scene_nodes)
 		{
-			size_t const this_size = octree_.size();
-			AABBox const parent_bb = octree_[index].bb;
-			float3 const parent_center = parent_bb.Center();
-			octree_[index].first_child_index = static_cast<int>(this_size);
-			octree_[index].visible = BoundOverlap::No;
+			auto const & node = *sn;
+			uint32_t const attr = node.Attrib();
+			if (attr & SceneNode::SOA_Cullable)
+			{
+				auto& obj = objs_.emplace(sn, octree_obj_t{-1, 0, -1, false}).first->second;
+				if (attr & SceneNode::SOA_Moveable)
+				{
+					obj.moveable_slot = static_cast<int>(moveable_objs_.size());
+					moveable_objs_.push_back(sn);
+				}
+
+				if (node.Updated())
+				{
+					bb_root |= node.PosBoundWS();
+					octree_[0].node_ptrs.push_back(sn);
+				}
+				else
+				{
+					pending_objs_.push_back(sn);
+				}
+			}
+		}
+		octree_[0].num_subtree_objs = static_cast<uint32_t>(octree_[0].node_ptrs.size());
 
-			octree_.resize(this_size + 8);
-			for (auto* node : octree_[index].node_ptrs)
+		float3 const & center = bb_root.Center();
+		float3 const & extent = bb_root.HalfSize();
+		float longest_dim = std::max(std::max(extent.x(), extent.y()), extent.z());
+		float3 new_extent(longest_dim, longest_dim, longest_dim);
+		octree_bbs_.BB(0, AABBox(center - new_extent * 2, center + new_extent * 2));
+
+		if ((octree_[0].node_ptrs.size() < PARALLEL_BUILD_MIN_OBJS) || (max_tree_depth_ <= 1)
+			|| !AnyFitsInChildren(octree_bbs_.BB(0), octree_[0].node_ptrs))
+		{
+			this->DivideNode(octree_, octree_bbs_, 0);
+		}
+		else
+		{
+			// Build the subtrees of the 8 children separately, then append them to the tree
+
+			octree_.resize(9);
+			octree_bbs_.Resize(9);
+			this->SplitNode(octree_, octree_bbs_, 0, 1);
+
+			std::array<std::vector<octree_node_t>, 8> sub_trees;
+			std::array<octree_bbs_t, 8> sub_bbs;
+			auto build_sub_tree = [this, &sub_trees, &sub_bbs](uint32_t j)
+			{
+				auto& tree = sub_trees[j];
+				auto& bbs = sub_bbs[j];
+				tree.resize(1);
+				tree[0] = std::move(octree_[1 + j]);
+				bbs.Resize(1);
+				bbs.BB(0, octree_bbs_.BB(1 + j));
+
+				this->DivideNode(tree, bbs, 0);
+			};
+
+			Context::Instance().TaskSchedulerInstance().ParallelFor(0U, 8U, 1U, [&build_sub_tree](uint32_t begin, uint32_t end) {
+				for (uint32_t j = begin; j < end; ++ j)
+				{
+					build_sub_tree(j);
+				}
+			});
+
+			for (uint32_t j = 0; j < 8; ++ j)
 			{
-				AABBox const & aabb = node->PosBoundWS();
-				int mark[6];
-				mark[0] = aabb.Min().x() >= parent_center.x() ? 1 : 0;
-				mark[1] = aabb.Min().y() >= parent_center.y() ? 2 : 0;
-				mark[2] = aabb.Min().z() >= parent_center.z() ? 4 : 0;
-				mark[3] = aabb.Max().x() >= parent_center.x() ? 1 : 0;
-				mark[4] = aabb.Max().y() >= parent_center.y() ? 2 : 0;
-				mark[5] = aabb.Max().z() >= parent_center.z() ? 4 : 0;
-				for (int j = 0; j < 8; ++ j)
+				auto& tree = sub_trees[j];
+				auto const & bbs = sub_bbs[j];
+
+				// Local node 0 is the child 1 + j, local node k > 0 goes to base + k - 1
+				int const base = static_cast<int>(octree_.size());
+				for (size_t k = 1; k < tree.size(); ++ k)
 				{
-					if (j == ((j & 1) ? mark[3] : mark[0])
-						+ ((j & 2) ? mark[4] : mark[1])
-						+ ((j & 4) ? mark[5] : mark[2]))
+					tree[k].parent_index = (0 == tree[k].parent_index) ? static_cast<int>(1 + j) : tree[k].parent_index + base - 1;
+				}
+				for (auto& node : tree)
+				{
+					if (node.first_child_index != -1)
 					{
-						octree_[this_size + j].node_ptrs.push_back(node);
+						node.first_child_index += base - 1;
 					}
 				}
+
+				octree_[1 + j] = std::move(tree[0]);
+				octree_.insert(octree_.end(), std::make_move_iterator(tree.begin() + 1), std::make_move_iterator(tree.end()));
+
+				octree_bbs_.min_x.insert(octree_bbs_.min_x.end(), bbs.min_x.begin() + 1, bbs.min_x.end());
+				octree_bbs_.min_y.insert(octree_bbs_.min_y.end(), bbs.min_y.begin() + 1, bbs.min_y.end());
+				octree_bbs_.min_z.insert(octree_bbs_.min_z.end(), bbs.min_z.begin() + 1, bbs.min_z.end());
+				octree_bbs_.max_x.insert(octree_bbs_.max_x.end(), bbs.max_x.begin() + 1, bbs.max_x.end());
+				octree_bbs_.max_y.insert(octree_bbs_.max_y.end(), bbs.max_y.begin() + 1, bbs.max_y.end());
+				octree_bbs_.max_z.insert(octree_bbs_.max_z.end(), bbs.max_z.begin() + 1, bbs.max_z.end());
 			}
+		}
 
-			for (size_t j = 0; j < 8; ++ j)
+		for (size_t i = 0; i < octree_.size(); ++ i)
+		{
+			this->IndexObjs(i);
+		}
+	}
+
+	void OCTree::UpdateTree()
+	{
+		// Inserting a lot of objects one by one is slower than building the tree from scratch
+		if (octree_.empty() || (pending_objs_.size() > std::max<size_t>(octree_[0].num_subtree_objs, PARALLEL_BUILD_MIN_OBJS)))
+		{
+			rebuild_tree_ = true;
+			return;
+		}
+
+		std::vector<SceneNode*> not_updated_objs;
+		for (auto* sn : pending_objs_)
+		{
+			auto iter = objs_.find(sn);
+			if ((iter == objs_.end()) || (iter->second.node_index != -1))
+			{
+				// Detached, or already inserted
+				continue;
+			}
+
+			auto& obj = iter->second;
+			uint32_t const attr = sn->Attrib();
+			if (!(attr & SceneNode::SOA_Cullable))
+			{
+				objs_.erase(iter);
+			}
+			else if (!sn->Updated())
+			{
+				not_updated_objs.push_back(sn);
+			}
+			else
+			{
+				if ((attr & SceneNode::SOA_Moveable) && (obj.moveable_slot < 0))
+				{
+					obj.moveable_slot = static_cast<int>(moveable_objs_.size());
+					moveable_objs_.push_back(sn);
+				}
+				this->InsertObj(*sn, obj);
+			}
+		}
+		pending_objs_.swap(not_updated_objs);
+
+		// A moveable object is relocated only when it leaves the loose bound of its node
+		for (auto* sn : moveable_objs_)
+		{
+			auto& obj = objs_.find(sn)->second;
+			if (obj.node_index >= 0)
 			{
-				octree_node_t& new_node = octree_[this_size + j];
-				new_node.first_child_index = -1;
-				new_node.bb = AABBox(float3((j & 1) ? parent_center.x() : parent_bb.Min().x(),
-						(j & 2) ? parent_center.y() : parent_bb.Min().y(),
-						(j & 4) ? parent_center.z() : parent_bb.Min().z()),
-					float3((j & 1) ? parent_bb.Max().x() : parent_center.x(),
-						(j & 2) ? parent_bb.Max().y() : parent_center.y(),
-						(j & 4) ? parent_bb.Max().z() : parent_center.z()));
+				AABBox const & aabb = sn->PosBoundWS();
+				bool const relocate = obj.out_of_bound ? FitsInCell(octree_bbs_.BB(0), aabb)
+					: !ContainsAABB(octree_bbs_.BB(obj.node_index), aabb);
+				if (relocate)
+				{
+					this->RemoveObj(*sn, obj);
+					this->InsertObj(*sn, obj);
+				}
+			}
+		}
+
+		if (num_out_of_bound_objs_ > std::max<size_t>(MAX_OUT_OF_BOUND_OBJS, objs_.size() / 8))
+		{
+			rebuild_tree_ = true;
+			return;
+		}
+
+		while (!split_candidates_.empty())
+		{
+			size_t const index = split_candidates_.back();
+			split_candidates_.pop_back();
 
-				if (curr_depth < max_tree_depth_)
+			auto const & node = octree_[index];
+			if ((node.parent_index != -2) && (-1 == node.first_child_index) && (node.node_ptrs.size() > SPLIT_MIN_OBJS)
+				&& (node.depth < max_tree_depth_) && AnyFitsInChildren(octree_bbs_.BB(index), node.node_ptrs))
+			{
+				size_t const first_child_index = this->AllocChildren();
+				this->SplitNode(octree_, octree_bbs_, index, first_child_index);
+				this->IndexObjs(index);
+				for (size_t j = 0; j < 8; ++ j)
 				{
-					this->DivideNode(this_size + j, curr_depth + 1);
+					this->IndexObjs(first_child_index + j);
+					split_candidates_.push_back(first_child_index + j);
 				}
 			}
+		}
 
-			octree_[index].node_ptrs.clear();
-			octree_[index].node_ptrs.shrink_to_fit();
+		for (size_t const index : merge_candidates_)
+		{
+			if (octree_[index].parent_index != -2)
+			{
+				// Collapse the topmost subtree that is small enough
+				int merge_index = -1;
+				for (int i = static_cast<int>(index); (i >= 0) && (octree_[i].num_subtree_objs <= MERGE_MAX_OBJS);
+					i = octree_[i].parent_index)
+				{
+					if (octree_[i].first_child_index != -1)
+					{
+						merge_index = i;
+					}
+				}
+				if (merge_index != -1)
+				{
+					this->MergeChildren(merge_index);
+				}
+			}
 		}
+		merge_candidates_.clear();
 	}
 
-	void OCTree::NodeVisible(size_t index)
+	void OCTree::SplitNode(std::vector<octree_node_t>& tree, octree_bbs_t& bbs, size_t index, size_t first_child_index) const
 	{
-		BOOST_ASSERT(index < octree_.size());
+		BOOST_ASSERT(first_child_index + 8 <= tree.size());
 
-		auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
-		auto const& viewport = *re.CurFrameBuffer()->Viewport();
-		uint32_t const num_cameras = viewport.NumCameras();
+		AABBox const parent_bb = bbs.BB(index);
+		float3 const parent_center = parent_bb.Center();
+		float3 const child_extent = parent_bb.HalfSize() / 2;
+		tree[index].first_child_index = static_cast<int>(first_child_index);
 
-		auto& octree_node = octree_[index];
-		bool large_enough;
-		if (small_obj_threshold_ <= 0)
+		for (size_t j = 0; j < 8; ++ j)
 		{
-			large_enough = true;
+			octree_node_t& new_node = tree[first_child_index + j];
+			new_node.parent_index = static_cast<int>(index);
+			new_node.first_child_index = -1;
+			new_node.depth = tree[index].depth + 1;
+			new_node.num_subtree_objs = 0;
+			new_node.visible = BoundOverlap::No;
+			new_node.node_ptrs.clear();
+
+			float3 const child_center = parent_center + float3((j & 1) ? child_extent.x() / 2 : -child_extent.x() / 2,
+				(j & 2) ? child_extent.y() / 2 : -child_extent.y() / 2, (j & 4) ? child_extent.z() / 2 : -child_extent.z() / 2);
+			bbs.BB(first_child_index + j, AABBox(child_center - child_extent, child_center + child_extent));
 		}
-		else
+
+		auto& parent_node_ptrs = tree[index].node_ptrs;
+		auto last = parent_node_ptrs.begin();
+		for (auto* node : parent_node_ptrs)
 		{
-			large_enough = false;
-			for (uint32_t i = 0; i < num_cameras; ++i)
+			int const child = ChildCell(parent_bb, node->PosBoundWS());
+			if (child != -1)
 			{
-				auto const& camera = *viewport.Camera(i);
-				float4x4 const& view_proj = camera_view_projs_[i];
-				if (((MathLib::ortho_area(camera.ForwardVec(), octree_node.bb) > small_obj_threshold_)
-					&& (MathLib::perspective_area(camera.EyePos(), view_proj, octree_node.bb) > small_obj_threshold_)))
+				auto& child_node = tree[first_child_index + child];
+				child_node.node_ptrs.push_back(node);
+				++ child_node.num_subtree_objs;
+			}
+			else
+			{
+				*last = node;
+				++ last;
+			}
+		}
+		parent_node_ptrs.erase(last, parent_node_ptrs.end());
+	}
+
+	void OCTree::DivideNode(std::vector<octree_node_t>& tree, octree_bbs_t& bbs, size_t index) const
+	{
+		if ((tree[index].depth < max_tree_depth_) && (tree[index].node_ptrs.size() > SPLIT_MIN_OBJS)
+			&& AnyFitsInChildren(bbs.BB(index), tree[index].node_ptrs))
+		{
+			size_t const first_child_index = tree.size();
+			tree.resize(first_child_index + 8);
+			bbs.Resize(first_child_index + 8);
+			this->SplitNode(tree, bbs, index, first_child_index);
+			for (size_t j = 0; j < 8; ++ j)
+			{
+				this->DivideNode(tree, bbs, first_child_index + j);
+			}
+		}
+	}
+
+	void OCTree::IndexObjs(size_t index)
+	{
+		auto const & node_ptrs = octree_[index].node_ptrs;
+		for (uint32_t i = 0; i < node_ptrs.size(); ++ i)
+		{
+			auto& obj = objs_[node_ptrs[i]];
+			obj.node_index = static_cast<int>(index);
+			obj.slot = i;
+		}
+	}
+
+	size_t OCTree::FindInsertNode(AABBox const & aabb, bool& out_of_bound) const
+	{
+		size_t index = 0;
+		out_of_bound = !FitsInCell(octree_bbs_.BB(0), aabb);
+		if (!out_of_bound)
+		{
+			while (octree_[index].first_child_index != -1)
+			{
+				int const child = ChildCell(octree_bbs_.BB(index), aabb);
+				if (-1 == child)
 				{
-					large_enough = true;
 					break;
 				}
+				index = octree_[index].first_child_index + child;
 			}
 		}
+		return index;
+	}
+
+	void OCTree::InsertObj(SceneNode& node, octree_obj_t& obj)
+	{
+		size_t const index = this->FindInsertNode(node.PosBoundWS(), obj.out_of_bound);
+		auto& tree_node = octree_[index];
+		obj.node_index = static_cast<int>(index);
+		obj.slot = static_cast<uint32_t>(tree_node.node_ptrs.size());
+		tree_node.node_ptrs.push_back(&node);
+		for (int i = obj.node_index; i >= 0; i = octree_[i].parent_index)
+		{
+			++ octree_[i].num_subtree_objs;
+		}
+		if (obj.out_of_bound)
+		{
+			++ num_out_of_bound_objs_;
+		}
+
+		if ((-1 == tree_node.first_child_index) && (tree_node.node_ptrs.size() > SPLIT_MIN_OBJS) && (tree_node.depth < max_tree_depth_))
+		{
+			split_candidates_.push_back(index);
+		}
+	}
+
+	void OCTree::RemoveObj(SceneNode& node, octree_obj_t& obj)
+	{
+		auto& node_ptrs = octree_[obj.node_index].node_ptrs;
+		BOOST_ASSERT(node_ptrs[obj.slot] == &node);
+
+		SceneNode* last = node_ptrs.back();
+		node_ptrs[obj.slot] = last;
+		node_ptrs.pop_back();
+		if (last != &node)
+		{
+			objs_[last].slot = obj.slot;
+		}
+
+		for (int i = obj.node_index; i >= 0; i = octree_[i].parent_index)
+		{
+			-- octree_[i].num_subtree_objs;
+		}
+		if (obj.out_of_bound)
+		{
+			-- num_out_of_bound_objs_;
+		}
+
+		merge_candidates_.push_back(obj.node_index);
+		obj.node_index = -1;
+		obj.out_of_bound = false;
+	}
+
+	size_t OCTree::AllocChildren()
+	{
+		size_t first_child_index;
+		if (free_children_.empty())
+		{
+			first_child_index = octree_.size();
+			octree_.resize(first_child_index + 8);
+			octree_bbs_.Resize(first_child_index + 8);
+		}
+		else
+		{
+			first_child_index = free_children_.back();
+			free_children_.pop_back();
+		}
+		return first_child_index;
+	}
+
+	void OCTree::MergeChildren(size_t index)
+	{
+		auto& node_ptrs = octree_[index].node_ptrs;
 
-		if (large_enough)
+		std::vector<size_t> first_children(1, octree_[index].first_child_index);
+		while (!first_children.empty())
 		{
-			octree_node.visible = SceneManager::AABBVisible(octree_node.bb);
-			if (BoundOverlap::Partial == octree_node.visible)
+			size_t const first_child_index = first_children.back();
+			first_children.pop_back();
+			free_children_.push_back(first_child_index);
+
+			for (size_t j = 0; j < 8; ++ j)
 			{
-				if (octree_node.first_child_index != -1)
+				auto& child = octree_[first_child_index + j];
+				node_ptrs.insert(node_ptrs.end(), child.node_ptrs.begin(), child.node_ptrs.end());
+				if (child.first_child_index != -1)
 				{
-					for (int i = 0; i < 8; ++ i)
-					{
-						this->NodeVisible(octree_node.first_child_index + i);
-					}
+					first_children.push_back(child.first_child_index);
 				}
+
+				child.parent_index = -2;
+				child.first_child_index = -1;
+				child.num_subtree_objs = 0;
+				child.node_ptrs.clear();
+			}
+		}
+
+		octree_[index].first_child_index = -1;
+		this->IndexObjs(index);
+	}
+
+	// Nodes below a fully visible or invisible node are not updated during culling
+	BoundOverlap OCTree::NodeVisibleFromRoot(size_t index) const
+	{
+		BoundOverlap visible = octree_[index].visible;
+		for (int i = octree_[index].parent_index; i >= 0; i = octree_[i].parent_index)
+		{
+			if (octree_[i].visible != BoundOverlap::Partial)
+			{
+				visible = octree_[i].visible;
 			}
 		}
+		return visible;
+	}
+
+	void OCTree::NodeVisible(Viewport const & viewport)
+	{
+		auto& root = octree_[0];
+		AABBox const root_bb = octree_bbs_.BB(0);
+		if (num_out_of_bound_objs_ > 0)
+		{
+			// The objects in the root are not all inside its bound
+			root.visible = BoundOverlap::Partial;
+		}
+		else if ((small_obj_threshold_ <= 0) || this->LargeEnough(viewport, root_bb))
+		{
+			root.visible = SceneManager::AABBVisible(root_bb);
+		}
 		else
 		{
-			octree_node.visible = BoundOverlap::No;
+			root.visible = BoundOverlap::No;
+		}
+		if ((BoundOverlap::Partial == root.visible) && (root.first_child_index != -1))
+		{
+#ifdef KLAYGE_DRAW_NODES
+			// NodeRenderable::AddInstance isn't thread safe
+			bool const parallel = false;
+#else
+			bool const parallel = octree_.size() >= PARALLEL_CULL_MIN_NODES;
+#endif
+			this->ChildrenVisible(viewport, root.first_child_index, parallel);
 		}
 
 #ifdef KLAYGE_DRAW_NODES
-		if ((vis != BoundOverlap::No) && (-1 == node.first_child_index))
+		if ((root.visible != BoundOverlap::No) && (-1 == root.first_child_index))
 		{
 			checked_pointer_cast<NodeRenderable>(node_renderable_)
-				->AddInstance(MathLib::scaling(node.bb.HalfSize()) * MathLib::translation(node.bb.Center()));
+				->AddInstance(MathLib::scaling(root_bb.HalfSize()) * MathLib::translation(root_bb.Center()));
 		}
 #endif
 	}
 
-	void OCTree::MarkNodeObjs(size_t index, bool force)
+	void OCTree::ChildrenVisible(Viewport const & viewport, size_t first_child_index, bool parallel)
 	{
-		BOOST_ASSERT(index < octree_.size());
+		BOOST_ASSERT(first_child_index + 8 <= octree_.size());
 
-		auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
-		auto const& viewport = *re.CurFrameBuffer()->Viewport();
-		uint32_t const num_cameras = viewport.NumCameras();
+		std::array<BoundOverlap, 8> visible;
+		this->ChildrenBoundVisible(first_child_index, visible);
+
+		std::array<int, 8> partial_children;
+		uint32_t num_partial_children = 0;
+		for (size_t j = 0; j < 8; ++ j)
+		{
+			size_t const index = first_child_index + j;
+			auto& octree_node = octree_[index];
+			octree_node.visible = visible[j];
+			if ((octree_node.visible != BoundOverlap::No) && (small_obj_threshold_ > 0)
+				&& !this->LargeEnough(viewport, octree_bbs_.BB(index)))
+			{
+				octree_node.visible = BoundOverlap::No;
+			}
+
+			if ((BoundOverlap::Partial == octree_node.visible) && (octree_node.first_child_index != -1))
+			{
+				partial_children[num_partial_children] = octree_node.first_child_index;
+				++ num_partial_children;
+			}
+
+#ifdef KLAYGE_DRAW_NODES
+			if ((octree_node.visible != BoundOverlap::No) && (-1 == octree_node.first_child_index))
+			{
+				AABBox const bb = octree_bbs_.BB(index);
+				checked_pointer_cast<NodeRenderable>(node_renderable_)
+					->AddInstance(MathLib::scaling(bb.HalfSize()) * MathLib::translation(bb.Center()));
+			}
+#endif
+		}
+
+		if (parallel && (num_partial_children > 1))
+		{
+			// Each subtree only writes its own nodes
+			auto& task_scheduler = Context::Instance().TaskSchedulerInstance();
+			TaskGroup group;
+			for (uint32_t i = 1; i < num_partial_children; ++ i)
+			{
+				int const child_index = partial_children[i];
+				task_scheduler.Run(group, [this, &viewport, child_index] { this->ChildrenVisible(viewport, child_index, false); });
+			}
+			this->ChildrenVisible(viewport, partial_children[0], false);
+			task_scheduler.Wait(group);
+		}
+		else
+		{
+			for (uint32_t i = 0; i < num_partial_children; ++ i)
+			{
+				this->ChildrenVisible(viewport, partial_children[i], false);
+			}
+		}
+	}
+
+	// The same as SceneManager::AABBVisible on 8 sibling nodes
+	void OCTree::ChildrenBoundVisible(size_t first_child_index, std::array<BoundOverlap, 8>& visible) const
+	{
+#if defined(KLAYGE_SSE_SUPPORT)
+		if (camera_frustums_.empty())
+		{
+			visible.fill(BoundOverlap::Yes);
+		}
+		else
+		{
+			visible.fill(BoundOverlap::No);
+			for (size_t i = 0; i < visible.size(); i += 4)
+			{
+				size_t const index = first_child_index + i;
+				for (auto const* camera_frustum : camera_frustums_)
+				{
+					int out_mask, partial_mask;
+					IntersectAABB4Frustum(&octree_bbs_.min_x[index], &octree_bbs_.min_y[index], &octree_bbs_.min_z[index],
+						&octree_bbs_.max_x[index], &octree_bbs_.max_y[index], &octree_bbs_.max_z[index], *camera_frustum,
+						out_mask, partial_mask);
+
+					bool all_yes = true;
+					for (size_t j = 0; j < 4; ++ j)
+					{
+						BoundOverlap const bo = (out_mask & (1 << j)) ? BoundOverlap::No
+							: ((partial_mask & (1 << j)) ? BoundOverlap::Partial : BoundOverlap::Yes);
+						visible[i + j] = std::max(visible[i + j], bo);
+						all_yes &= (BoundOverlap::Yes == visible[i + j]);
+					}
+					if (all_yes)
+					{
+						break;
+					}
+				}
+			}
+		}
+#else
+		for (size_t j = 0; j < visible.size(); ++ j)
+		{
+			visible[j] = SceneManager::AABBVisible(octree_bbs_.BB(first_child_index + j));
+		}
+#endif
+	}
+
+	bool OCTree::LargeEnough(Viewport const & viewport, AABBox const & aabb) const
+	{
+		for (uint32_t i = 0; i < viewport.NumCameras(); ++i)
+		{
+			auto const& camera = *viewport.Camera(i);
+			float4x4 const& view_proj = camera_view_projs_[i];
+			if (((MathLib::ortho_area(camera.ForwardVec(), aabb) > small_obj_threshold_)
+				&& (MathLib::perspective_area(camera.EyePos(), view_proj, aabb) > small_obj_threshold_)))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void OCTree::MarkNodeObjs(size_t index, uint32_t num_cameras, bool force)
+	{
+		BOOST_ASSERT(index < octree_.size());
 
 		auto const & octree_node = octree_[index];
-		if ((octree_node.visible != BoundOverlap::No) || force)
+		if (((octree_node.visible != BoundOverlap::No) || force) && (octree_node.num_subtree_objs > 0))
 		{
 			for (auto* node : octree_node.node_ptrs)
 			{
+				// Moveable objects are tested after the tree is traversed
+				if (node->Attrib() & SceneNode::SOA_Moveable)
+				{
+					continue;
+				}
+
 				if (node->Visible())
 				{
 					if (node->Updated())
@@ -461,7 +1243,7 @@ namespace KlayGE
 			{
 				for (int i = 0; i < 8; ++ i)
 				{
-					this->MarkNodeObjs(octree_node.first_child_index + i, (BoundOverlap::Yes == octree_node.visible) || force);
+					this->MarkNodeObjs(octree_node.first_child_index + i, num_cameras, (BoundOverlap::Yes == octree_node.visible) || force);
 				}
 			}
 		}
@@ -473,7 +1255,7 @@ namespace KlayGE
 		BoundOverlap visible = BoundOverlap::Yes;
 		if (!octree_.empty())
 		{
-			if (MathLib::intersect_aabb_aabb(octree_[0].bb, aabb))
+			if (MathLib::intersect_aabb_aabb(octree_bbs_.BB(0), aabb))
 			{
 				visible = this->BoundVisible(0, aabb);
 			}
@@ -497,7 +1279,7 @@ namespace KlayGE
 		BoundOverlap visible = BoundOverlap::Yes;
 		if (!octree_.empty())
 		{
-			if (MathLib::intersect_aabb_obb(octree_[0].bb, obb))
+			if (MathLib::intersect_aabb_obb(octree_bbs_.BB(0), obb))
 			{
 				visible = this->BoundVisible(0, obb);
 			}
@@ -521,7 +1303,7 @@ namespace KlayGE
 		BoundOverlap visible = BoundOverlap::Yes;
 		if (!octree_.empty())
 		{
-			if (MathLib::intersect_aabb_sphere(octree_[0].bb, sphere))
+			if (MathLib::intersect_aabb_sphere(octree_bbs_.BB(0), sphere))
 			{
 				visible = this->BoundVisible(0, sphere);
 			}
@@ -545,7 +1327,7 @@ namespace KlayGE
 		BoundOverlap visible = BoundOverlap::Yes;
 		if (!octree_.empty())
 		{
-			if (MathLib::intersect_aabb_frustum(octree_[0].bb, frustum) != BoundOverlap::No)
+			if (MathLib::intersect_aabb_frustum(octree_bbs_.BB(0), frustum) != BoundOverlap::No)
 			{
 				visible = this->BoundVisible(0, frustum);
 			}
@@ -568,7 +1350,7 @@ namespace KlayGE
 		BOOST_ASSERT(index < octree_.size());
 
 		octree_node_t const & node = octree_[index];
-		if ((node.visible != BoundOverlap::No) && MathLib::intersect_aabb_aabb(node.bb, aabb))
+		if ((node.visible != BoundOverlap::No) && MathLib::intersect_aabb_aabb(octree_bbs_.BB(index), aabb))
 		{
 			if (BoundOverlap::Yes == node.visible)
 			{
@@ -580,25 +1362,13 @@ namespace KlayGE
 
 				if (node.first_child_index != -1)
 				{
-					float3 const center = node.bb.Center();
-					int mark[6];
-					mark[0] = aabb.Min().x() >= center.x() ? 1 : 0;
-					mark[1] = aabb.Min().y() >= center.y() ? 2 : 0;
-					mark[2] = aabb.Min().z() >= center.z() ? 4 : 0;
-					mark[3] = aabb.Max().x() >= center.x() ? 1 : 0;
-					mark[4] = aabb.Max().y() >= center.y() ? 2 : 0;
-					mark[5] = aabb.Max().z() >= center.z() ? 4 : 0;
-					for (int j = 0; j < 8; ++ j)
+					// The loose bounds of the children overlap
+					for (int i = 0; i < 8; ++ i)
 					{
-						if (j == ((j & 1) ? mark[3] : mark[0])
-							+ ((j & 2) ? mark[4] : mark[1])
-							+ ((j & 4) ? mark[5] : mark[2]))
+						BoundOverlap const bo = this->BoundVisible(node.first_child_index + i, aabb);
+						if (bo != BoundOverlap::No)
 						{
-							BoundOverlap const bo = this->BoundVisible(node.first_child_index + j, aabb);
-							if (bo != BoundOverlap::No)
-							{
-								return bo;
-							}
+							return bo;
 						}
 					}
 
@@ -621,7 +1391,7 @@ namespace KlayGE
 		BOOST_ASSERT(index < octree_.size());
 
 		octree_node_t const & node = octree_[index];
-		if ((node.visible != BoundOverlap::No) && MathLib::intersect_aabb_obb(node.bb, obb))
+		if ((node.visible != BoundOverlap::No) && MathLib::intersect_aabb_obb(octree_bbs_.BB(index), obb))
 		{
 			if (BoundOverlap::Yes == node.visible)
 			{
@@ -661,7 +1431,7 @@ namespace KlayGE
 		BOOST_ASSERT(index < octree_.size());
 
 		octree_node_t const & node = octree_[index];
-		if ((node.visible != BoundOverlap::No) && MathLib::intersect_aabb_sphere(node.bb, sphere))
+		if ((node.visible != BoundOverlap::No) && MathLib::intersect_aabb_sphere(octree_bbs_.BB(index), sphere))
 		{
 			if (BoundOverlap::Yes == node.visible)
 			{
@@ -701,7 +1471,7 @@ namespace KlayGE
 		BOOST_ASSERT(index < octree_.size());
 
 		octree_node_t const & node = octree_[index];
-		if ((node.visible != BoundOverlap::No) && (MathLib::intersect_aabb_frustum(node.bb, frustum) != BoundOverlap::No))
+		if ((node.visible != BoundOverlap::No) && (MathLib::intersect_aabb_frustum(octree_bbs_.BB(index), frustum) != BoundOverlap::No))
 		{
 			if (BoundOverlap::Yes == node.visible)
 			{
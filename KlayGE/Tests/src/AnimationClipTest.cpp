@@ -0,0 +1,122 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/Math.hpp>
+#include <KlayGE/Mesh.hpp>
+
+#include <random>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	// A joint swinging around a moving pivot, sampled at every frame
+	KeyFrameSet CreateSwingingKeyFrames(uint32_t num_frames, float3 const & pivot_speed, float scale)
+	{
+		KeyFrameSet kf;
+		for (uint32_t i = 0; i < num_frames; ++ i)
+		{
+			float const t = static_cast<float>(i) / num_frames;
+			Quaternion const rot = MathLib::rotation_axis(MathLib::normalize(float3(1, 2, 3)), std::sin(t * 2 * PI) * PI / 3);
+
+			kf.frame_id.push_back(i);
+			kf.bind_real.push_back(rot);
+			kf.bind_dual.push_back(MathLib::quat_trans_to_udq(rot, pivot_speed * t + float3(0, 1, 0)));
+			kf.bind_scale.push_back(scale);
+		}
+		return kf;
+	}
+
+	float RotationError(Quaternion const & lhs, Quaternion const & rhs)
+	{
+		Quaternion const diff = (MathLib::dot(lhs, rhs) < 0) ? lhs + rhs : lhs - rhs;
+		return 4 * std::asin(std::min(MathLib::length(diff) / 2, 1.0f));
+	}
+}
+
+TEST(AnimationClipTest, ErrorBound)
+{
+	float const tolerance = 1e-3f;
+
+	std::vector<KeyFrameSet> kfs;
+	kfs.push_back(CreateSwingingKeyFrames(200, float3(3, 0, -2), 1));
+	kfs.push_back(CreateSwingingKeyFrames(200, float3(0, 0, 0), 1));
+	AnimationClip const clip(kfs, tolerance);
+
+	for (uint32_t joint = 0; joint < kfs.size(); ++ joint)
+	{
+		auto const & kf = kfs[joint];
+		EXPECT_LT(clip.tracks[joint].num_keys, kf.frame_id.size());
+
+		uint32_t cursor = 0;
+		for (uint32_t i = 0; i < kf.frame_id.size(); ++ i)
+		{
+			auto const [real, dual, scale] = clip.Frame(joint, static_cast<float>(kf.frame_id[i]), cursor);
+			EXPECT_LE(RotationError(real, kf.bind_real[i]), tolerance);
+			EXPECT_LE(MathLib::length(MathLib::udq_to_trans(real, dual) - MathLib::udq_to_trans(kf.bind_real[i], kf.bind_dual[i])),
+				tolerance);
+			EXPECT_LE(std::abs(scale - kf.bind_scale[i]), tolerance);
+		}
+	}
+
+	EXPECT_FALSE(clip.tracks[0].flags & AnimationClip::TF_ConstantTranslation);
+	EXPECT_TRUE(clip.tracks[1].flags & AnimationClip::TF_ConstantTranslation);
+	EXPECT_TRUE(clip.tracks[1].flags & AnimationClip::TF_ConstantScale);
+}
+
+TEST(AnimationClipTest, ConstantTrack)
+{
+	std::vector<KeyFrameSet> kfs(1);
+	Quaternion const rot = MathLib::rotation_axis(float3(0, 1, 0), 0.5f);
+	for (uint32_t i = 0; i < 100; ++ i)
+	{
+		kfs[0].frame_id.push_back(i);
+		kfs[0].bind_real.push_back(rot);
+		kfs[0].bind_dual.push_back(MathLib::quat_trans_to_udq(rot, float3(1, 2, 3)));
+		kfs[0].bind_scale.push_back(2);
+	}
+	AnimationClip const clip(kfs, 0);
+
+	EXPECT_EQ(clip.tracks[0].num_keys, 1U);
+	EXPECT_EQ(clip.tracks[0].flags,
+		static_cast<uint32_t>(AnimationClip::TF_ConstantRotation | AnimationClip::TF_ConstantTranslation | AnimationClip::TF_ConstantScale));
+	EXPECT_TRUE(clip.translations.empty());
+	EXPECT_TRUE(clip.scales.empty());
+
+	KeyFrameSet const kf = clip.Decompress(0);
+	ASSERT_EQ(kf.frame_id.size(), 1U);
+	EXPECT_LT(RotationError(kf.bind_real[0], rot), 1e-4f);
+	EXPECT_LT(MathLib::length(MathLib::udq_to_trans(kf.bind_real[0], kf.bind_dual[0]) - float3(1, 2, 3)), 1e-4f);
+	EXPECT_FLOAT_EQ(kf.bind_scale[0], 2);
+}
+
+TEST(AnimationClipTest, Cursor)
+{
+	std::vector<KeyFrameSet> kfs;
+	kfs.push_back(CreateSwingingKeyFrames(300, float3(5, 1, 0), 1));
+	AnimationClip const clip(kfs, 1e-3f);
+
+	// Sequential, looping and random access all have to find the same keys as a search from scratch
+	std::ranlux24_base gen;
+	std::uniform_real_distribution<float> frame_dist(0, 600);
+	uint32_t cursor = 0;
+	for (uint32_t i = 0; i < 2000; ++ i)
+	{
+		float const frame = (i < 1000) ? i * 0.6f : frame_dist(gen);
+
+		uint32_t key0, key1;
+		float factor;
+		clip.LocateKeys(0, frame, cursor, key0, key1, factor);
+
+		uint32_t fresh_cursor = 0;
+		uint32_t fresh_key0, fresh_key1;
+		float fresh_factor;
+		clip.LocateKeys(0, frame, fresh_cursor, fresh_key0, fresh_key1, fresh_factor);
+
+		EXPECT_EQ(key0, fresh_key0);
+		EXPECT_EQ(key1, fresh_key1);
+		EXPECT_FLOAT_EQ(factor, fresh_factor);
+	}
+}
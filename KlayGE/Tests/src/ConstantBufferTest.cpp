@@ -0,0 +1,186 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/Math.hpp>
+#include <KlayGE/Context.hpp>
+#include <KlayGE/RenderDeviceCaps.hpp>
+#include <KlayGE/RenderEffect.hpp>
+#include <KlayGE/RenderEngine.hpp>
+#include <KlayGE/RenderFactory.hpp>
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	// Forces constant_buffer_partial_update_support while in scope. Only devices that take DEVICE_CAPS, such as NullRender,
+	// can be forced.
+	class ScopedPartialUpdateCap final : boost::noncopyable
+	{
+	public:
+		explicit ScopedPartialUpdateCap(bool support)
+			: re_(Context::Instance().RenderFactoryInstance().RenderEngineInstance()), old_caps_(re_.DeviceCaps())
+		{
+			RenderDeviceCaps caps = old_caps_;
+			caps.constant_buffer_partial_update_support = support;
+			re_.SetCustomAttrib("DEVICE_CAPS", &caps);
+
+			forced_ = (re_.DeviceCaps().constant_buffer_partial_update_support == support);
+		}
+		~ScopedPartialUpdateCap()
+		{
+			re_.SetCustomAttrib("DEVICE_CAPS", &old_caps_);
+		}
+
+		bool Forced() const
+		{
+			return forced_;
+		}
+
+	private:
+		RenderEngine& re_;
+		RenderDeviceCaps old_caps_;
+		bool forced_;
+	};
+
+	// Changes color1, then color0 and mat, then colors, and returns the bytes uploaded for each change
+	std::vector<uint32_t> UploadChanges(RenderEffect& effect)
+	{
+		auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+
+		auto* cbuff = effect.CBufferByName("per_draw");
+		auto* color0 = effect.ParameterByName("color0");
+		auto* color1 = effect.ParameterByName("color1");
+		auto* mat = effect.ParameterByName("mat");
+		auto* colors = effect.ParameterByName("colors");
+
+		std::vector<uint32_t> ret;
+
+		cbuff->Update();
+		re.NumConstantBytesJustUploaded();
+
+		*color1 = float4(9, 10, 11, 12);
+		cbuff->Update();
+		ret.push_back(re.NumConstantBytesJustUploaded());
+
+		*color0 = float4(13, 14, 15, 16);
+		*mat = MathLib::translation(4.0f, 5.0f, 6.0f);
+		cbuff->Update();
+		ret.push_back(re.NumConstantBytesJustUploaded());
+
+		*colors = std::vector<float4>(4, float4(2, 2, 2, 2));
+		cbuff->Update();
+		ret.push_back(re.NumConstantBytesJustUploaded());
+
+		return ret;
+	}
+}
+
+TEST(ConstantBufferTest, DirtyRange)
+{
+	auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+
+	auto effect = SyncLoadRenderEffect("ConstantBuffer/ConstantBufferTest.fxml");
+	auto* cbuff = effect->CBufferByName("per_draw");
+	ASSERT_NE(cbuff, nullptr);
+
+	auto* color0 = effect->ParameterByName("color0");
+	auto* color1 = effect->ParameterByName("color1");
+
+	// A new cbuffer is uploaded as a whole
+	EXPECT_TRUE(cbuff->Dirty());
+	re.NumConstantBytesJustUploaded();
+	cbuff->Update();
+	EXPECT_FALSE(cbuff->Dirty());
+	EXPECT_EQ(re.NumConstantBytesJustUploaded(), cbuff->Size());
+
+	cbuff->Update();
+	EXPECT_EQ(re.NumConstantBytesJustUploaded(), 0U);
+
+	*color1 = float4(1, 2, 3, 4);
+	EXPECT_TRUE(cbuff->Dirty());
+	cbuff->Update();
+	EXPECT_FALSE(cbuff->Dirty());
+
+	// The same value doesn't dirty the cbuffer
+	*color1 = float4(1, 2, 3, 4);
+	EXPECT_FALSE(cbuff->Dirty());
+
+	*color0 = float4(5, 6, 7, 8);
+	cbuff->Update();
+
+	float4 value;
+	color0->Value(value);
+	EXPECT_EQ(value, float4(5, 6, 7, 8));
+	EXPECT_EQ(*cbuff->VariableInBuff<float4>(color1->CBufferOffset()), float4(1, 2, 3, 4));
+}
+
+TEST(ConstantBufferTest, PartialUpload)
+{
+	ScopedPartialUpdateCap cap(true);
+	if (!cap.Forced())
+	{
+		GTEST_SKIP() << "The device doesn't take DEVICE_CAPS";
+	}
+
+	auto effect = SyncLoadRenderEffect("ConstantBuffer/ConstantBufferTest.fxml");
+	ASSERT_EQ(effect->CBufferByName("per_draw")->Size(), 160U);
+
+	// color1 alone, then color0 to mat merged into one range, then the colors array
+	std::vector<uint32_t> const expected = {16, 96, 64};
+	EXPECT_EQ(UploadChanges(*effect), expected);
+}
+
+TEST(ConstantBufferTest, WholeUpload)
+{
+	ScopedPartialUpdateCap cap(false);
+	if (!cap.Forced())
+	{
+		GTEST_SKIP() << "The device doesn't take DEVICE_CAPS";
+	}
+
+	auto effect = SyncLoadRenderEffect("ConstantBuffer/ConstantBufferTest.fxml");
+	ASSERT_EQ(effect->CBufferByName("per_draw")->Size(), 160U);
+
+	std::vector<uint32_t> const expected = {160, 160, 160};
+	EXPECT_EQ(UploadChanges(*effect), expected);
+}
+
+TEST(ConstantBufferTest, TransientRing)
+{
+	auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+	if (!re.DeviceCaps().constant_buffer_offset_support)
+	{
+		GTEST_SKIP() << "The device can't bind constant buffers at offsets";
+	}
+
+	auto effect = SyncLoadRenderEffect("ConstantBuffer/ConstantBufferTest.fxml");
+	auto* cbuff = effect->CBufferByName("per_draw");
+	cbuff->Transient(true);
+	auto other = cbuff->Clone(*effect);
+	EXPECT_TRUE(other->Transient());
+
+	// Both are written to the ring, at different offsets
+	re.NumConstantBytesJustUploaded();
+	cbuff->Update();
+	other->Update();
+	EXPECT_EQ(cbuff->HWBuff(), other->HWBuff());
+	EXPECT_EQ(cbuff->HWBuffOffset() % 256, 0U);
+	EXPECT_EQ(other->HWBuffOffset() % 256, 0U);
+	EXPECT_NE(cbuff->HWBuffOffset(), other->HWBuffOffset());
+	EXPECT_EQ(re.NumConstantBytesJustUploaded(), 2 * cbuff->Size());
+
+	cbuff->Update();
+	EXPECT_EQ(re.NumConstantBytesJustUploaded(), 0U);
+
+	// A change is written to a new place, so the draws before it keep their constants
+	uint32_t const old_offset = cbuff->HWBuffOffset();
+	*effect->ParameterByName("color0") = float4(1, 2, 3, 4);
+	cbuff->Update();
+	EXPECT_NE(cbuff->HWBuffOffset(), old_offset);
+	EXPECT_EQ(re.NumConstantBytesJustUploaded(), cbuff->Size());
+}
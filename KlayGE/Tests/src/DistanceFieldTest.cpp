@@ -0,0 +1,124 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/Math.hpp>
+#include <KlayGE/DistanceField.hpp>
+
+#include <random>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	uint32_t const SUB_SAMPLES = 4;
+
+	// Anti-aliased coverage of a shape at 2x resolution, the input of ComputeDistance
+	template <typename InsideFunc>
+	std::vector<float> Rasterize(uint32_t size_2x, InsideFunc&& inside)
+	{
+		std::vector<float> ret(size_2x * size_2x);
+		for (uint32_t y = 0; y < size_2x; ++ y)
+		{
+			for (uint32_t x = 0; x < size_2x; ++ x)
+			{
+				uint32_t covered = 0;
+				for (uint32_t sy = 0; sy < SUB_SAMPLES; ++ sy)
+				{
+					for (uint32_t sx = 0; sx < SUB_SAMPLES; ++ sx)
+					{
+						float const px = (x + (sx + 0.5f) / SUB_SAMPLES) / size_2x;
+						float const py = (y + (sy + 0.5f) / SUB_SAMPLES) / size_2x;
+						covered += inside(px, py) ? 1 : 0;
+					}
+				}
+				ret[y * size_2x + x] = static_cast<float>(covered) / (SUB_SAMPLES * SUB_SAMPLES);
+			}
+		}
+		return ret;
+	}
+
+	// A disc with a bar through it
+	std::vector<float> CreateDiscBar(uint32_t size_2x)
+	{
+		return Rasterize(size_2x, [](float x, float y) {
+			return (MathLib::length(float2(x - 0.45f, y - 0.5f)) < 0.3f) || ((std::abs(x - 0.7f) < 0.05f) && (y > 0.1f) && (y < 0.9f));
+		});
+	}
+
+	// Random horizontal and vertical strokes, like a complex glyph
+	std::vector<float> CreateStrokes(uint32_t size_2x, uint32_t seed)
+	{
+		std::ranlux24_base gen(seed);
+		std::uniform_real_distribution<float> pos_dist(0.1f, 0.9f);
+
+		float const half_width = 0.025f;
+		std::vector<float4> strokes;
+		for (uint32_t i = 0; i < 12; ++ i)
+		{
+			float const a = pos_dist(gen);
+			float const b = pos_dist(gen);
+			float const c = pos_dist(gen);
+			float4 const stroke = (i & 1) ? float4(std::min(a, c), b, std::max(a, c), b) : float4(a, std::min(b, c), a, std::max(b, c));
+			strokes.push_back(stroke + float4(-half_width, -half_width, half_width, half_width));
+		}
+
+		return Rasterize(size_2x, [&strokes](float x, float y) {
+			for (auto const & stroke : strokes)
+			{
+				if ((x >= stroke.x()) && (x <= stroke.z()) && (y >= stroke.y()) && (y <= stroke.w()))
+				{
+					return true;
+				}
+			}
+			return false;
+		});
+	}
+
+	void CompareAlgorithms(std::vector<float> const & aa_2x_data, uint32_t size_2x)
+	{
+		std::vector<float> aa_dist;
+		std::vector<float> exact_dist;
+		ComputeDistance(aa_2x_data, size_2x, size_2x, aa_dist, DistanceFieldAlgorithm::AAEuclidean);
+		ComputeDistance(aa_2x_data, size_2x, size_2x, exact_dist, DistanceFieldAlgorithm::ExactEuclidean);
+
+		ASSERT_EQ(aa_dist.size(), size_2x * size_2x / 4);
+		ASSERT_EQ(exact_dist.size(), aa_dist.size());
+
+		float sum_diff = 0;
+		float max_diff = 0;
+		for (size_t i = 0; i < aa_dist.size(); ++ i)
+		{
+			float const diff = std::abs(aa_dist[i] - exact_dist[i]);
+			sum_diff += diff;
+			max_diff = std::max(max_diff, diff);
+
+			// Both have to agree on which side of the edge a pixel is
+			if (std::abs(aa_dist[i]) > 1)
+			{
+				EXPECT_EQ(aa_dist[i] > 0, exact_dist[i] > 0);
+			}
+		}
+
+		// Only differ by a fraction of a pixel
+		EXPECT_LT(sum_diff / aa_dist.size(), 0.05f);
+		EXPECT_LT(max_diff, 1.5f);
+	}
+}
+
+TEST(DistanceFieldTest, DiscBar)
+{
+	for (uint32_t const size : {32U, 64U, 128U})
+	{
+		CompareAlgorithms(CreateDiscBar(size * 2), size * 2);
+	}
+}
+
+TEST(DistanceFieldTest, Strokes)
+{
+	for (uint32_t seed = 0; seed < 8; ++ seed)
+	{
+		CompareAlgorithms(CreateStrokes(64, seed), 64);
+	}
+}
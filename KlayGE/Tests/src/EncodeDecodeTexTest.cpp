@@ -5,10 +5,12 @@
 #include <KlayGE/Texture.hpp>
 #include <KlayGE/ResLoader.hpp>
 #include <KFL/Half.hpp>
+#include <KFL/Timer.hpp>
 
 #include <vector>
 #include <string>
 #include <iostream>
+#include <thread>
 
 #include "KlayGETests.hpp"
 
@@ -16,7 +18,7 @@ using namespace std;
 using namespace KlayGE;
 
 void TestEncodeDecodeTex(std::string_view input_name, std::string_view tc_name,
-		ElementFormat bc_fmt, float threshold)
+		ElementFormat bc_fmt, float threshold, TexCompressionMethod method = TCM_Balanced)
 {
 	ResLoader::Instance().AddPath("../../Tests/media/EncodeDecodeTex");
 
@@ -131,7 +133,7 @@ void TestEncodeDecodeTex(std::string_view input_name, std::string_view tc_name,
 				}
 
 				uint32_t index = ((y_base / block_height) * ((width + block_width - 1) / block_width) + (x_base / block_width)) * block_bytes;
-				codec->EncodeBlock(&bc_blocks[index], &uncompressed[0], TCM_Balanced);
+				codec->EncodeBlock(&bc_blocks[index], &uncompressed[0], method);
 			}
 		}
 	}
@@ -289,7 +291,144 @@ TEST(EncodeDecodeTexTest, EncodeDecodeBC7ARGB)
 	TestEncodeDecodeTex("leaf_v3_green_tex.dds", "", EF_BC7, 11.0f);
 }
 
+TEST(EncodeDecodeTexTest, EncodeDecodeBC1Realtime)
+{
+	TestEncodeDecodeTex("Lenna.dds", "", EF_BC1, 5.5f, TCM_Realtime);
+}
+
+TEST(EncodeDecodeTexTest, EncodeDecodeBC3Realtime)
+{
+	TestEncodeDecodeTex("leaf_v3_green_tex.dds", "", EF_BC3, 10.0f, TCM_Realtime);
+}
+
 TEST(EncodeDecodeTexTest, EncodeDecodeETC1)
 {
 	TestEncodeDecodeTex("Lenna.dds", "", EF_ETC1, 4.8f);
 }
+
+void TestParallelEncodeDecodeTex(std::string_view input_name, std::unique_ptr<TexCompression> codec, ElementFormat bc_fmt,
+	TexCompressionMethod method)
+{
+	ResLoader::Instance().AddPath("../../Tests/media/EncodeDecodeTex");
+
+	TexturePtr in_tex = LoadSoftwareTexture(input_name);
+	uint32_t const width = in_tex->Width(0);
+	uint32_t const height = in_tex->Height(0);
+	auto const & init_data = checked_cast<SoftwareTexture&>(*in_tex).SubresourceData();
+
+	uint32_t const block_width = BlockWidth(bc_fmt);
+	uint32_t const block_height = BlockHeight(bc_fmt);
+	uint32_t const block_bytes = BlockBytes(bc_fmt);
+	uint32_t const bc_row_pitch = (width + block_width - 1) / block_width * block_bytes;
+	uint32_t const bc_slice_pitch = (height + block_height - 1) / block_height * bc_row_pitch;
+	uint32_t const decoded_row_pitch = width * NumFormatBytes(DecodedFormat(bc_fmt));
+
+	std::vector<uint8_t> serial_blocks(bc_slice_pitch);
+	std::vector<uint8_t> serial_decoded(decoded_row_pitch * height);
+	codec->NumThreads(1);
+	Timer timer;
+	codec->EncodeMem(width, height, serial_blocks.data(), bc_row_pitch, bc_slice_pitch,
+		init_data[0].data, init_data[0].row_pitch, init_data[0].slice_pitch, method);
+	double const serial_encode_time = timer.elapsed();
+	timer.restart();
+	codec->DecodeMem(width, height, serial_decoded.data(), decoded_row_pitch, decoded_row_pitch * height,
+		serial_blocks.data(), bc_row_pitch, bc_slice_pitch);
+	double const serial_decode_time = timer.elapsed();
+
+	uint32_t const max_threads = std::max(std::thread::hardware_concurrency(), 2U);
+	for (uint32_t num_threads = 2; num_threads <= max_threads; num_threads *= 2)
+	{
+		std::vector<uint8_t> blocks(bc_slice_pitch);
+		std::vector<uint8_t> decoded(decoded_row_pitch * height);
+		codec->NumThreads(num_threads);
+		timer.restart();
+		codec->EncodeMem(width, height, blocks.data(), bc_row_pitch, bc_slice_pitch,
+			init_data[0].data, init_data[0].row_pitch, init_data[0].slice_pitch, method);
+		double const encode_time = timer.elapsed();
+		timer.restart();
+		codec->DecodeMem(width, height, decoded.data(), decoded_row_pitch, decoded_row_pitch * height,
+			blocks.data(), bc_row_pitch, bc_slice_pitch);
+		double const decode_time = timer.elapsed();
+
+		EXPECT_TRUE(blocks == serial_blocks);
+		EXPECT_TRUE(decoded == serial_decoded);
+
+		cout << input_name << ' ' << num_threads << " threads: encoding " << serial_encode_time / encode_time
+			<< "x, decoding " << serial_decode_time / decode_time << "x of serial" << endl;
+	}
+}
+
+TEST(EncodeDecodeTexTest, ParallelEncodeDecodeBC1)
+{
+	TestParallelEncodeDecodeTex("Lenna.dds", MakeUniquePtr<TexCompressionBC1>(), EF_BC1, TCM_Quality);
+}
+
+TEST(EncodeDecodeTexTest, ParallelEncodeDecodeBC3)
+{
+	TestParallelEncodeDecodeTex("leaf_v3_green_tex.dds", MakeUniquePtr<TexCompressionBC3>(), EF_BC3, TCM_Quality);
+}
+
+TEST(EncodeDecodeTexTest, ParallelEncodeDecodeBC7)
+{
+	TestParallelEncodeDecodeTex("Lenna.dds", MakeUniquePtr<TexCompressionBC7>(), EF_BC7, TCM_Balanced);
+}
+
+TEST(EncodeDecodeTexTest, ParallelEncodeDecodeETC1)
+{
+	TestParallelEncodeDecodeTex("Lenna.dds", MakeUniquePtr<TexCompressionETC1>(), EF_ETC1, TCM_Balanced);
+}
+
+void TestEncodeSpeed(std::string_view name, std::unique_ptr<TexCompression> codec, ElementFormat bc_fmt)
+{
+	uint32_t const width = 1024;
+	uint32_t const height = 1024;
+	uint32_t const pixel_size = NumFormatBytes(DecodedFormat(bc_fmt));
+
+	std::vector<uint8_t> input(width * height * pixel_size);
+	for (uint32_t y = 0; y < height; ++ y)
+	{
+		for (uint32_t x = 0; x < width; ++ x)
+		{
+			for (uint32_t ch = 0; ch < pixel_size; ++ ch)
+			{
+				input[(y * width + x) * pixel_size + ch] = static_cast<uint8_t>((x * (ch + 1) + y * (3 - ch) + ((x * y) >> 7)) & 0xFF);
+			}
+		}
+	}
+
+	uint32_t const block_bytes = BlockBytes(bc_fmt);
+	uint32_t const bc_row_pitch = width / BlockWidth(bc_fmt) * block_bytes;
+	uint32_t const bc_slice_pitch = height / BlockHeight(bc_fmt) * bc_row_pitch;
+	std::vector<uint8_t> bc_blocks(bc_slice_pitch);
+
+	codec->NumThreads(1);
+	for (auto method : { TCM_Realtime, TCM_Speed })
+	{
+		Timer timer;
+		codec->EncodeMem(width, height, bc_blocks.data(), bc_row_pitch, bc_slice_pitch,
+			input.data(), width * pixel_size, width * height * pixel_size, method);
+		double const mpixels = width * height / timer.elapsed() / 1e6;
+
+		cout << name << ' ' << (TCM_Realtime == method ? "realtime" : "speed") << ": " << mpixels << " MPixel/s" << endl;
+	}
+}
+
+TEST(EncodeDecodeTexTest, RealtimeEncodeSpeedBC1)
+{
+	TestEncodeSpeed("BC1", MakeUniquePtr<TexCompressionBC1>(), EF_BC1);
+}
+
+TEST(EncodeDecodeTexTest, RealtimeEncodeSpeedBC3)
+{
+	TestEncodeSpeed("BC3", MakeUniquePtr<TexCompressionBC3>(), EF_BC3);
+}
+
+TEST(EncodeDecodeTexTest, RealtimeEncodeSpeedBC4)
+{
+	TestEncodeSpeed("BC4", MakeUniquePtr<TexCompressionBC4>(), EF_BC4);
+}
+
+TEST(EncodeDecodeTexTest, RealtimeEncodeSpeedBC5)
+{
+	TestEncodeSpeed("BC5", MakeUniquePtr<TexCompressionBC5>(), EF_BC5);
+}
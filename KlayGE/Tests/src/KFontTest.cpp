@@ -0,0 +1,266 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/CXX17/filesystem.hpp>
+#include <KFL/Math.hpp>
+#include <KFL/ResIdentifier.hpp>
+#include <kfont/kfont.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	uint32_t const CHAR_SIZE = 32;
+
+	// A disc with a bar through it, roughly what a glyph's distance field looks like
+	std::vector<uint8_t> CreateDistanceData(uint32_t seed)
+	{
+		float const center_x = CHAR_SIZE / 2 + std::sin(seed * 0.7f) * 6;
+		float const center_y = CHAR_SIZE / 2 + std::cos(seed * 0.3f) * 6;
+		float const radius = 6.0f + seed % 5;
+		float const bar_x = 8.0f + seed % 13;
+
+		std::vector<uint8_t> ret(CHAR_SIZE * CHAR_SIZE);
+		for (uint32_t y = 0; y < CHAR_SIZE; ++ y)
+		{
+			for (uint32_t x = 0; x < CHAR_SIZE; ++ x)
+			{
+				float const disc = MathLib::length(float2(x - center_x, y - center_y)) - radius;
+				float const bar = std::abs(x - bar_x) - 2;
+				ret[y * CHAR_SIZE + x] = static_cast<uint8_t>(MathLib::clamp(128 - 8 * std::min(disc, bar), 0.0f, 255.0f));
+			}
+		}
+		return ret;
+	}
+
+	wchar_t TestChar(uint32_t i)
+	{
+		// Not in order, so the font has to sort them
+		return static_cast<wchar_t>(0x4E00 + i * 7919 % 20000);
+	}
+
+	void CreateFont(KFont& kfont, uint32_t num_chars)
+	{
+		kfont.CharSize(CHAR_SIZE);
+		kfont.DistBase(-1234);
+		kfont.DistScale(5678);
+
+		for (uint32_t i = 0; i < num_chars; ++ i)
+		{
+			KFont::font_info const fi{static_cast<int16_t>(i % 7), static_cast<int16_t>(i % 3), static_cast<uint16_t>(i % 32), 20};
+			if (i % 10 == 0)
+			{
+				// Spaces have no distance data
+				kfont.SetLZMADistanceData(TestChar(i), nullptr, 0, i, fi);
+			}
+			else
+			{
+				auto const data = CreateDistanceData(i);
+				kfont.SetDistanceData(TestChar(i), data.data(), i, fi);
+			}
+		}
+	}
+
+	void CheckFont(KFont const & kfont, uint32_t num_chars)
+	{
+		EXPECT_EQ(kfont.CharSize(), CHAR_SIZE);
+		EXPECT_EQ(kfont.DistBase(), -1234);
+		EXPECT_EQ(kfont.DistScale(), 5678);
+
+		// The pitch is larger than the char, as in the texture of Font
+		uint32_t const pitch = CHAR_SIZE * 2;
+		std::vector<uint8_t> decoded(CHAR_SIZE * pitch);
+		for (uint32_t i = 0; i < num_chars; ++ i)
+		{
+			auto const [index, advance] = kfont.CharIndexAdvance(TestChar(i));
+			EXPECT_EQ(advance, i);
+			if (i % 10 == 0)
+			{
+				EXPECT_EQ(index, -1);
+				continue;
+			}
+
+			ASSERT_GE(index, 0);
+			EXPECT_EQ(kfont.CharInfo(index).top, static_cast<int16_t>(i % 7));
+			EXPECT_EQ(kfont.CharInfo(index).width, static_cast<uint16_t>(i % 32));
+
+			kfont.GetDistanceData(decoded.data(), pitch, index);
+			auto const expected = CreateDistanceData(i);
+			for (uint32_t y = 0; y < CHAR_SIZE; ++ y)
+			{
+				EXPECT_TRUE(std::equal(&decoded[y * pitch], &decoded[y * pitch + CHAR_SIZE], &expected[y * CHAR_SIZE]));
+			}
+		}
+
+		EXPECT_EQ(kfont.CharIndex(L'B'), -1);
+		EXPECT_EQ(kfont.CharAdvance(L'B'), 0U);
+	}
+
+	void TestRoundTrip(KFont::DistanceCodec codec, std::string const & file_name)
+	{
+		uint32_t const num_chars = 500;
+
+		KFont kfont;
+		CreateFont(kfont, num_chars);
+		CheckFont(kfont, num_chars);
+
+		std::string const kfont_name = (FILESYSTEM_NS::temp_directory_path() / file_name).string();
+		ASSERT_TRUE(kfont.Save(kfont_name, codec));
+		CheckFont(kfont, num_chars);
+
+		{
+			KFont mapped_kfont;
+			ASSERT_TRUE(mapped_kfont.Load(kfont_name));
+			CheckFont(mapped_kfont, num_chars);
+
+			KFont streamed_kfont;
+			ASSERT_TRUE(streamed_kfont.Load(MakeSharedPtr<ResIdentifier>(kfont_name, 0,
+				MakeSharedPtr<std::ifstream>(kfont_name.c_str(), std::ios_base::binary | std::ios_base::in))));
+			CheckFont(streamed_kfont, num_chars);
+
+			// Adding a char to a mapped font has to keep the old ones
+			auto const data = CreateDistanceData(1);
+			mapped_kfont.SetDistanceData(L'A', data.data(), 42, KFont::font_info{});
+			CheckFont(mapped_kfont, num_chars);
+			EXPECT_EQ(mapped_kfont.CharAdvance(L'A'), 42U);
+		}
+
+		std::error_code ec;
+		FILESYSTEM_NS::remove(kfont_name, ec);
+	}
+}
+
+TEST(KFontTest, RoundTripRaw)
+{
+	TestRoundTrip(KFont::DistanceCodec::Raw, "KFontTestRaw.kfont");
+}
+
+TEST(KFontTest, RoundTripLzma)
+{
+	TestRoundTrip(KFont::DistanceCodec::Lzma, "KFontTestLzma.kfont");
+}
+
+TEST(KFontTest, RoundTripDeltaLz)
+{
+	TestRoundTrip(KFont::DistanceCodec::DeltaLz, "KFontTestDeltaLz.kfont");
+}
+
+TEST(KFontTest, DeltaLzIsSmaller)
+{
+	KFont kfont;
+	CreateFont(kfont, 200);
+
+	std::string const raw_name = (FILESYSTEM_NS::temp_directory_path() / "KFontTestSizeRaw.kfont").string();
+	std::string const delta_lz_name = (FILESYSTEM_NS::temp_directory_path() / "KFontTestSizeDeltaLz.kfont").string();
+	ASSERT_TRUE(kfont.Save(raw_name, KFont::DistanceCodec::Raw));
+	ASSERT_TRUE(kfont.Save(delta_lz_name, KFont::DistanceCodec::DeltaLz));
+
+	EXPECT_LT(FILESYSTEM_NS::file_size(delta_lz_name), FILESYSTEM_NS::file_size(raw_name));
+
+	std::error_code ec;
+	FILESYSTEM_NS::remove(raw_name, ec);
+	FILESYSTEM_NS::remove(delta_lz_name, ec);
+}
+
+TEST(KFontTest, RejectsCorruptFile)
+{
+	KFont kfont;
+	CreateFont(kfont, 50);
+
+	std::string const kfont_name = (FILESYSTEM_NS::temp_directory_path() / "KFontTestCorrupt.kfont").string();
+	ASSERT_TRUE(kfont.Save(kfont_name, KFont::DistanceCodec::Raw));
+
+	std::vector<char> data(static_cast<size_t>(FILESYSTEM_NS::file_size(kfont_name)));
+	{
+		std::ifstream ifs(kfont_name.c_str(), std::ios_base::binary | std::ios_base::in);
+		ifs.read(data.data(), static_cast<std::streamsize>(data.size()));
+	}
+
+	kfont_header header;
+	std::memcpy(&header, data.data(), sizeof(header));
+	size_t const offsets_start = LE2Native(header.start_ptr);
+	uint32_t const non_empty_chars = LE2Native(header.non_empty_chars);
+	ASSERT_GE(non_empty_chars, 2U);
+
+	auto load = [&kfont_name](std::vector<char> const & kfont_data) {
+		{
+			std::ofstream ofs(kfont_name.c_str(), std::ios_base::binary | std::ios_base::out);
+			ofs.write(kfont_data.data(), static_cast<std::streamsize>(kfont_data.size()));
+		}
+
+		KFont loaded_kfont;
+		return loaded_kfont.Load(kfont_name);
+	};
+
+	EXPECT_TRUE(load(data));
+
+	// Cut off in the distance data
+	EXPECT_FALSE(load(std::vector<char>(data.begin(), data.end() - 1)));
+
+	// Block offsets out of order
+	{
+		auto corrupted = data;
+		std::swap_ranges(&corrupted[offsets_start + 1 * sizeof(uint64_t)], &corrupted[offsets_start + 2 * sizeof(uint64_t)],
+			&corrupted[offsets_start + 2 * sizeof(uint64_t)]);
+		EXPECT_FALSE(load(corrupted));
+	}
+
+	// The index of the first char points past the distance data. It's the second field of char_index_advance.
+	{
+		auto corrupted = data;
+		int32_t const index = Native2LE(static_cast<int32_t>(non_empty_chars));
+		std::memcpy(&corrupted[offsets_start + (non_empty_chars + 1) * sizeof(uint64_t) + sizeof(int32_t)], &index, sizeof(index));
+		EXPECT_FALSE(load(corrupted));
+	}
+
+	std::error_code ec;
+	FILESYSTEM_NS::remove(kfont_name, ec);
+}
+
+TEST(KFontTest, RejectsCorruptDeltaLzBlock)
+{
+	KFont kfont;
+	CreateFont(kfont, 50);
+
+	std::string const kfont_name = (FILESYSTEM_NS::temp_directory_path() / "KFontTestCorruptDeltaLz.kfont").string();
+	ASSERT_TRUE(kfont.Save(kfont_name, KFont::DistanceCodec::DeltaLz));
+
+	std::vector<char> data(static_cast<size_t>(FILESYSTEM_NS::file_size(kfont_name)));
+	{
+		std::ifstream ifs(kfont_name.c_str(), std::ios_base::binary | std::ios_base::in);
+		ifs.read(data.data(), static_cast<std::streamsize>(data.size()));
+	}
+
+	kfont_header header;
+	std::memcpy(&header, data.data(), sizeof(header));
+	size_t const offsets_start = LE2Native(header.start_ptr);
+	uint32_t const non_empty_chars = LE2Native(header.non_empty_chars);
+
+	// The blocks are at the end of the file. A first token with no literals and no offset can't be decoded.
+	uint64_t blocks_size;
+	std::memcpy(&blocks_size, &data[offsets_start + non_empty_chars * sizeof(uint64_t)], sizeof(blocks_size));
+	size_t const blocks_start = data.size() - static_cast<size_t>(LE2Native(blocks_size));
+	ASSERT_EQ(static_cast<KFont::DistanceCodec>(data[blocks_start]), KFont::DistanceCodec::DeltaLz);
+	data[blocks_start + 1] = 0;
+	{
+		std::ofstream ofs(kfont_name.c_str(), std::ios_base::binary | std::ios_base::out);
+		ofs.write(data.data(), static_cast<std::streamsize>(data.size()));
+	}
+
+	{
+		KFont loaded_kfont;
+		ASSERT_TRUE(loaded_kfont.Load(kfont_name));
+
+		std::vector<uint8_t> decoded(CHAR_SIZE * CHAR_SIZE);
+		EXPECT_THROW(loaded_kfont.GetDistanceData(decoded.data(), CHAR_SIZE, 0), std::system_error);
+	}
+
+	std::error_code ec;
+	FILESYSTEM_NS::remove(kfont_name, ec);
+}
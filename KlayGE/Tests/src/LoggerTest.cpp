@@ -0,0 +1,185 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/CXX17/filesystem.hpp>
+#include <KFL/Logger.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	class LoggerTest : public testing::Test
+	{
+	public:
+		void SetUp() override
+		{
+			log_name_ = (FILESYSTEM_NS::temp_directory_path() / "LoggerTest.log").string();
+			Logger::Instance().ConsoleEnabled(false);
+			Logger::Instance().LogFile(log_name_);
+		}
+
+		void TearDown() override
+		{
+			Logger::Instance().LogFile("");
+			Logger::Instance().ConsoleEnabled(true);
+
+			std::error_code ec;
+			FILESYSTEM_NS::remove(log_name_, ec);
+			for (uint32_t i = 1; i <= 3; ++ i)
+			{
+				FILESYSTEM_NS::remove(log_name_ + "." + std::to_string(i), ec);
+			}
+		}
+
+		std::vector<std::string> ReadLines(std::string const & file_name) const
+		{
+			Logger::Instance().Flush();
+
+			std::vector<std::string> ret;
+			std::ifstream ifs(file_name.c_str());
+			std::string line;
+			while (std::getline(ifs, line))
+			{
+				ret.push_back(line);
+			}
+			return ret;
+		}
+
+	protected:
+		std::string log_name_;
+	};
+
+	uint32_t num_evaluations = 0;
+
+	uint32_t CountEvaluation()
+	{
+		++ num_evaluations;
+		return num_evaluations;
+	}
+}
+
+TEST_F(LoggerTest, LinesFromThreads)
+{
+	uint32_t const num_threads = 4;
+	uint32_t const num_records = 2000;
+
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < num_threads; ++ t)
+	{
+		threads.emplace_back([t] {
+			for (uint32_t i = 0; i < num_records; ++ i)
+			{
+				if (i % 2 == 0)
+				{
+					KLAYGE_LOG_INFO(Tool, "thread {} record {} {}", t, i, std::string(i % 50, 'x'));
+				}
+				else
+				{
+					LogInfo() << "thread " << t << " record " << i << ' ' << std::string(i % 50, 'x') << std::endl;
+				}
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	auto const lines = this->ReadLines(log_name_);
+	ASSERT_EQ(lines.size(), num_threads * num_records);
+
+	std::vector<uint32_t> next_records(num_threads, 0);
+	for (auto const & line : lines)
+	{
+		auto const pos = line.find("(INFO) ");
+		ASSERT_NE(pos, std::string::npos) << line;
+
+		auto const message = line.substr(line.find(": ", pos) + 2);
+		uint32_t t;
+		uint32_t i;
+		ASSERT_EQ(std::sscanf(message.c_str(), "thread %u record %u", &t, &i), 2) << line;
+		ASSERT_LT(t, num_threads);
+
+		// Each thread's records are in order, and not torn by others
+		EXPECT_EQ(i, next_records[t]);
+		next_records[t] = i + 1;
+		EXPECT_EQ(message, "thread " + std::to_string(t) + " record " + std::to_string(i) + ' ' + std::string(i % 50, 'x'));
+		EXPECT_NE(line.find((i % 2 == 0) ? "Tool: " : "KlayGE: "), std::string::npos) << line;
+	}
+}
+
+TEST_F(LoggerTest, Filtering)
+{
+	num_evaluations = 0;
+
+	Logger::Instance().CategoryEnabled(LogCategory::Tool, false);
+	KLAYGE_LOG_INFO(Tool, "disabled category {}", CountEvaluation());
+	KLAYGE_LOG_INFO(Render, "enabled category {}", CountEvaluation());
+	Logger::Instance().CategoryEnabled(LogCategory::Tool, true);
+
+	Logger::Instance().MinSeverity(LogSeverity::Warn);
+	KLAYGE_LOG_INFO(Tool, "disabled severity {}", CountEvaluation());
+	LogInfo() << "disabled stream" << std::endl;
+	KLAYGE_LOG_WARN(Tool, "enabled severity {}", CountEvaluation());
+	Logger::Instance().MinSeverity(LogSeverity::Info);
+
+	EXPECT_EQ(num_evaluations, 2U);
+
+	auto const lines = this->ReadLines(log_name_);
+	ASSERT_EQ(lines.size(), 2U);
+	EXPECT_NE(lines[0].find("(INFO) Render: enabled category 1"), std::string::npos) << lines[0];
+	EXPECT_NE(lines[1].find("(WARN) Tool: enabled severity 2"), std::string::npos) << lines[1];
+}
+
+TEST_F(LoggerTest, Rotation)
+{
+	uint64_t const max_size = 4096;
+	Logger::Instance().LogFile(log_name_, max_size, 2);
+
+	for (uint32_t i = 0; i < 1000; ++ i)
+	{
+		KLAYGE_LOG_INFO(Tool, "rotated record {}", i);
+	}
+	Logger::Instance().Flush();
+
+	EXPECT_TRUE(FILESYSTEM_NS::exists(log_name_));
+	EXPECT_TRUE(FILESYSTEM_NS::exists(log_name_ + ".1"));
+	EXPECT_TRUE(FILESYSTEM_NS::exists(log_name_ + ".2"));
+	EXPECT_FALSE(FILESYSTEM_NS::exists(log_name_ + ".3"));
+	EXPECT_LE(FILESYSTEM_NS::file_size(log_name_), max_size);
+	EXPECT_LE(FILESYSTEM_NS::file_size(log_name_ + ".1"), max_size);
+
+	// The newest records are in the current file, and continue from the backup
+	auto const backup_lines = this->ReadLines(log_name_ + ".1");
+	auto const lines = this->ReadLines(log_name_);
+	ASSERT_FALSE(lines.empty());
+	ASSERT_FALSE(backup_lines.empty());
+	EXPECT_NE(lines.back().find("rotated record 999"), std::string::npos);
+
+	uint32_t last_backup_record;
+	uint32_t first_record;
+	ASSERT_EQ(std::sscanf(backup_lines.back().substr(backup_lines.back().find("rotated")).c_str(), "rotated record %u",
+		&last_backup_record), 1);
+	ASSERT_EQ(std::sscanf(lines.front().substr(lines.front().find("rotated")).c_str(), "rotated record %u", &first_record), 1);
+	EXPECT_EQ(first_record, last_backup_record + 1);
+}
+
+TEST_F(LoggerTest, LargeArguments)
+{
+	// Larger than the queue of a thread
+	std::string const large(200 * 1024, 'L');
+	KLAYGE_LOG_INFO(Tool, "{} {}", large, 42);
+	KLAYGE_LOG_INFO(Tool, "after");
+
+	auto const lines = this->ReadLines(log_name_);
+	ASSERT_EQ(lines.size(), 2U);
+	EXPECT_NE(lines[0].find(large + " 42"), std::string::npos);
+	EXPECT_NE(lines[1].find("after"), std::string::npos);
+}
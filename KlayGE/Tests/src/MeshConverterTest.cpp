@@ -37,6 +37,12 @@
 #include <KlayGE/Mesh.hpp>
 #include <KlayGE/DevHelper/MeshConverter.hpp>
 #include <KlayGE/DevHelper/MeshMetadata.hpp>
+#include <KlayGE/DevHelper/MeshOptimizer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <random>
 
 #include "KlayGETests.hpp"
 
@@ -797,3 +803,228 @@ TEST_F(MeshConverterTest, StaticMeshML)
 {
 	RunTest("tree2a.lod.meshml", "", "tree2a.lod.meshml");
 }
+
+TEST_F(MeshConverterTest, OptimizeMeshGrid)
+{
+	uint32_t constexpr GRID_SIZE = 64;
+
+	std::vector<float3> positions;
+	for (uint32_t y = 0; y <= GRID_SIZE; ++ y)
+	{
+		for (uint32_t x = 0; x <= GRID_SIZE; ++ x)
+		{
+			positions.emplace_back(static_cast<float>(x), static_cast<float>(y), 0.0f);
+		}
+	}
+	uint32_t const num_vertices = static_cast<uint32_t>(positions.size());
+
+	std::vector<std::array<uint32_t, 3>> triangles;
+	for (uint32_t y = 0; y < GRID_SIZE; ++ y)
+	{
+		for (uint32_t x = 0; x < GRID_SIZE; ++ x)
+		{
+			uint32_t const v0 = y * (GRID_SIZE + 1) + x;
+			uint32_t const v1 = v0 + GRID_SIZE + 1;
+			triangles.push_back({v0, v1, v0 + 1});
+			triangles.push_back({v0 + 1, v1, v1 + 1});
+		}
+	}
+	std::shuffle(triangles.begin(), triangles.end(), std::ranlux24_base());
+
+	std::vector<uint32_t> indices;
+	for (auto const& triangle : triangles)
+	{
+		indices.insert(indices.end(), triangle.begin(), triangle.end());
+	}
+
+	auto const before = AnalyzeVertexCache(indices, num_vertices);
+
+	OptimizeVertexCache(indices, num_vertices);
+	OptimizeOverdraw(indices, positions);
+	auto const remap = OptimizeVertexFetch(indices, num_vertices);
+
+	auto const after = AnalyzeVertexCache(indices, num_vertices);
+	EXPECT_GT(before.acmr, 2.5f);
+	EXPECT_LT(after.acmr, 0.8f);
+	EXPECT_LT(after.atvr, before.atvr);
+
+	// Vertices are numbered by first use
+	uint32_t max_index = 0;
+	for (auto const index : indices)
+	{
+		EXPECT_LE(index, max_index + 1);
+		max_index = std::max(max_index, index);
+	}
+
+	// Same triangles, with the same winding
+	auto canonical = [](std::array<uint32_t, 3> triangle) {
+		std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+		return triangle;
+	};
+	std::vector<std::array<uint32_t, 3>> optimized_triangles;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		std::array<uint32_t, 3> triangle;
+		for (uint32_t j = 0; j < 3; ++ j)
+		{
+			triangle[j] = static_cast<uint32_t>(std::find(remap.begin(), remap.end(), indices[i + j]) - remap.begin());
+		}
+		optimized_triangles.push_back(canonical(triangle));
+	}
+	for (auto& triangle : triangles)
+	{
+		triangle = canonical(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	std::sort(optimized_triangles.begin(), optimized_triangles.end());
+	EXPECT_EQ(triangles, optimized_triangles);
+}
+
+TEST_F(MeshConverterTest, OptimizeMesh)
+{
+	MeshConverter mc;
+	auto original = mc.Load(MeshMetadata("tree2a.nolod.kmeta"));
+	auto optimized = mc.Load(MeshMetadata("tree2a.nolod_optimize.kmeta"));
+	ASSERT_TRUE(original);
+	ASSERT_TRUE(optimized);
+	ASSERT_EQ(original->NumMeshes(), optimized->NumMeshes());
+
+	// Positions of the triangles of a mesh, each rotated to start with its smallest vertex
+	auto read_triangles = [](StaticMesh const& mesh, std::vector<uint32_t>& indices) {
+		auto const& rl = mesh.GetRenderLayout();
+
+		GraphicsBuffer::Mapper index_mapper(*rl.GetIndexStream(), BA_Read_Only);
+		for (uint32_t i = 0; i < mesh.NumIndices(0); ++ i)
+		{
+			uint32_t const offset = mesh.StartIndexLocation(0) + i;
+			indices.push_back((rl.IndexStreamFormat() == EF_R16UI) ? index_mapper.Pointer<uint16_t>()[offset]
+																	: index_mapper.Pointer<uint32_t>()[offset]);
+		}
+
+		GraphicsBuffer::Mapper position_mapper(*rl.GetVertexStream(0), BA_Read_Only);
+		auto const* position_buff = position_mapper.Pointer<int16_t>() + mesh.StartVertexLocation(0) * 4;
+		std::vector<std::array<int16_t, 9>> triangles;
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			std::array<std::array<int16_t, 3>, 3> triangle;
+			for (uint32_t j = 0; j < 3; ++ j)
+			{
+				std::copy(&position_buff[indices[i + j] * 4], &position_buff[indices[i + j] * 4 + 3], triangle[j].begin());
+			}
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+
+			auto& flat = triangles.emplace_back();
+			for (uint32_t j = 0; j < 3; ++ j)
+			{
+				std::copy(triangle[j].begin(), triangle[j].end(), flat.begin() + j * 3);
+			}
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	};
+
+	for (uint32_t i = 0; i < original->NumMeshes(); ++ i)
+	{
+		auto const& original_mesh = checked_cast<StaticMesh&>(*original->Mesh(i));
+		auto const& optimized_mesh = checked_cast<StaticMesh&>(*optimized->Mesh(i));
+		ASSERT_EQ(original_mesh.NumVertices(0), optimized_mesh.NumVertices(0));
+		ASSERT_EQ(original_mesh.NumIndices(0), optimized_mesh.NumIndices(0));
+
+		std::vector<uint32_t> original_indices;
+		std::vector<uint32_t> optimized_indices;
+		EXPECT_EQ(read_triangles(original_mesh, original_indices), read_triangles(optimized_mesh, optimized_indices));
+
+		uint32_t const num_vertices = original_mesh.NumVertices(0);
+		EXPECT_LE(AnalyzeVertexCache(optimized_indices, num_vertices).acmr, AnalyzeVertexCache(original_indices, num_vertices).acmr);
+	}
+}
+
+TEST_F(MeshConverterTest, SimplifyMesh)
+{
+	uint32_t constexpr NUM_SEGMENTS = 128;
+	uint32_t constexpr NUM_RINGS = 64;
+
+	// UV sphere, the vertices on the seam are duplicated for the texture coordinates
+	std::vector<float3> positions;
+	for (uint32_t r = 0; r <= NUM_RINGS; ++ r)
+	{
+		for (uint32_t s = 0; s <= NUM_SEGMENTS; ++ s)
+		{
+			float const theta = PI * r / NUM_RINGS;
+			float const phi = 2 * PI * (s % NUM_SEGMENTS) / NUM_SEGMENTS;
+			positions.emplace_back(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+		}
+	}
+	std::vector<uint32_t> indices;
+	for (uint32_t r = 0; r < NUM_RINGS; ++ r)
+	{
+		for (uint32_t s = 0; s < NUM_SEGMENTS; ++ s)
+		{
+			uint32_t const v0 = r * (NUM_SEGMENTS + 1) + s;
+			uint32_t const v1 = v0 + NUM_SEGMENTS + 1;
+			if (r != 0)
+			{
+				indices.insert(indices.end(), {v0, v0 + 1, v1});
+			}
+			if (r != NUM_RINGS - 1)
+			{
+				indices.insert(indices.end(), {v0 + 1, v1 + 1, v1});
+			}
+		}
+	}
+
+	auto check_seam = [&positions](std::vector<uint32_t> const& simplified) {
+		std::vector<bool> used(positions.size(), false);
+		for (auto const index : simplified)
+		{
+			used[index] = true;
+		}
+		for (uint32_t r = 1; r < NUM_RINGS; ++ r)
+		{
+			EXPECT_TRUE(used[r * (NUM_SEGMENTS + 1)]);
+			EXPECT_TRUE(used[r * (NUM_SEGMENTS + 1) + NUM_SEGMENTS]);
+		}
+	};
+
+	float error;
+	uint32_t const target_num_indices = static_cast<uint32_t>(indices.size() / 4) / 3 * 3;
+	auto simplified = SimplifyMesh(indices, positions, target_num_indices, std::numeric_limits<float>::max(), error);
+	EXPECT_LE(simplified.size(), target_num_indices);
+	EXPECT_GT(simplified.size(), target_num_indices * 9 / 10);
+	EXPECT_LT(error, 0.01f);
+	check_seam(simplified);
+
+	for (size_t i = 0; i < simplified.size(); i += 3)
+	{
+		EXPECT_NE(simplified[i + 0], simplified[i + 1]);
+		EXPECT_NE(simplified[i + 1], simplified[i + 2]);
+		EXPECT_NE(simplified[i + 2], simplified[i + 0]);
+	}
+
+	float constexpr TARGET_ERROR = 0.01f;
+	simplified = SimplifyMesh(indices, positions, 0, TARGET_ERROR, error);
+	EXPECT_LE(error, TARGET_ERROR);
+	EXPECT_LT(simplified.size(), target_num_indices);
+	check_seam(simplified);
+}
+
+TEST_F(MeshConverterTest, AutoLod)
+{
+	MeshConverter mc;
+	auto model = mc.Load(MeshMetadata("tree2a.nolod_autolod.kmeta"));
+	ASSERT_TRUE(model);
+
+	for (uint32_t i = 0; i < model->NumMeshes(); ++ i)
+	{
+		auto const& mesh = checked_cast<StaticMesh&>(*model->Mesh(i));
+		ASSERT_EQ(mesh.NumLods(), 3U);
+		EXPECT_EQ(mesh.LodError(0), 0);
+		for (uint32_t lod = 1; lod < mesh.NumLods(); ++ lod)
+		{
+			EXPECT_LE(mesh.NumIndices(lod), mesh.NumIndices(lod - 1));
+			EXPECT_LE(mesh.NumVertices(lod), mesh.NumVertices(lod - 1));
+			EXPECT_GE(mesh.LodError(lod), mesh.LodError(lod - 1));
+		}
+		EXPECT_LE(mesh.NumIndices(1), mesh.NumIndices(0) / 2);
+	}
+}
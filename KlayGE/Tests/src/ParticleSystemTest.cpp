@@ -0,0 +1,190 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/Math.hpp>
+#include <KlayGE/Camera.hpp>
+#include <KlayGE/Context.hpp>
+#include <KlayGE/FrameBuffer.hpp>
+#include <KlayGE/ParticleSystem.hpp>
+#include <KlayGE/RenderEngine.hpp>
+#include <KlayGE/RenderFactory.hpp>
+#include <KlayGE/SceneNode.hpp>
+
+#include <limits>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	float EvaluatePolyline(std::vector<float2> const & polyline, float x)
+	{
+		for (size_t i = 1; i < polyline.size(); ++ i)
+		{
+			if (polyline[i].x() >= x)
+			{
+				float const s = (x - polyline[i - 1].x()) / (polyline[i].x() - polyline[i - 1].x());
+				return MathLib::lerp(polyline[i - 1].y(), polyline[i].y(), s);
+			}
+		}
+		return polyline.back().y();
+	}
+
+	std::shared_ptr<PolylineParticleUpdater> CreatePolylineUpdater(ParticleSystemPtr const & ps)
+	{
+		auto updater = checked_pointer_cast<PolylineParticleUpdater>(ps->MakeUpdater("polyline"));
+		updater->SizeOverLife({float2(0, 1), float2(0.5f, 3), float2(1, 2)});
+		updater->MassOverLife({float2(0, 1), float2(1, 2)});
+		updater->OpacityOverLife({float2(0, 1), float2(0.25f, 0.5f), float2(1, 0)});
+		return updater;
+	}
+}
+
+TEST(ParticleSystemTest, PolylineUpdater)
+{
+	auto ps = MakeSharedPtr<ParticleSystem>(1);
+	auto updater = CreatePolylineUpdater(ps);
+	updater->SnapParams();
+
+	uint32_t constexpr NUM_PARTICLES = 1000;
+	std::vector<float3> pos(NUM_PARTICLES, float3(0, 0, 0));
+	std::vector<float3> vel(NUM_PARTICLES, float3(0, 0, 0));
+	std::vector<float> life(NUM_PARTICLES);
+	std::vector<float> spin(NUM_PARTICLES, 0.0f);
+	std::vector<float> size(NUM_PARTICLES, 0.0f);
+	std::vector<float> alpha(NUM_PARTICLES, 0.0f);
+	std::vector<float> init_life(NUM_PARTICLES, 2.0f);
+	for (uint32_t i = 0; i < NUM_PARTICLES; ++ i)
+	{
+		life[i] = 2.0f * (NUM_PARTICLES - i) / NUM_PARTICLES;
+	}
+	std::vector<float> const orig_life = life;
+
+	ParticleBatch batch;
+	batch.pos = pos;
+	batch.vel = vel;
+	batch.life = life;
+	batch.spin = spin;
+	batch.size = size;
+	batch.alpha = alpha;
+	batch.init_life = init_life;
+	updater->Update(batch, 0);
+
+	for (uint32_t i = 0; i < NUM_PARTICLES; ++ i)
+	{
+		float const life_pos = (init_life[i] - orig_life[i]) / init_life[i];
+		EXPECT_NEAR(size[i], EvaluatePolyline(updater->SizeOverLife(), life_pos), 1e-4f);
+		EXPECT_NEAR(alpha[i], EvaluatePolyline(updater->OpacityOverLife(), life_pos), 1e-4f);
+		EXPECT_FLOAT_EQ(life[i], orig_life[i]);
+	}
+}
+
+TEST(ParticleSystemTest, PolylineUpdaterBatchMatchesSingle)
+{
+	auto ps = MakeSharedPtr<ParticleSystem>(1);
+	ps->Force(float3(0.5f, 1, -0.25f));
+	auto updater = CreatePolylineUpdater(ps);
+	updater->SnapParams();
+
+	// Not a multiple of 4, so the batch update runs both the SIMD loop and the tail
+	uint32_t constexpr NUM_PARTICLES = 1003;
+	std::vector<float3> pos[2];
+	std::vector<float3> vel[2];
+	std::vector<float> life[2];
+	std::vector<float> spin[2];
+	std::vector<float> size[2];
+	std::vector<float> alpha[2];
+	std::vector<float> init_life(NUM_PARTICLES, 2.0f);
+	for (uint32_t j = 0; j < 2; ++ j)
+	{
+		pos[j].resize(NUM_PARTICLES);
+		vel[j].resize(NUM_PARTICLES);
+		life[j].resize(NUM_PARTICLES);
+		spin[j].resize(NUM_PARTICLES);
+		size[j].resize(NUM_PARTICLES);
+		alpha[j].resize(NUM_PARTICLES);
+		for (uint32_t i = 0; i < NUM_PARTICLES; ++ i)
+		{
+			pos[j][i] = float3(static_cast<float>(i), -static_cast<float>(i), 0.5f * i);
+			vel[j][i] = float3(1, 2, 3);
+			life[j][i] = 2.0f * (NUM_PARTICLES - i) / NUM_PARTICLES;
+			spin[j][i] = static_cast<float>(i);
+		}
+	}
+
+	ParticleBatch batch;
+	batch.pos = pos[0];
+	batch.vel = vel[0];
+	batch.life = life[0];
+	batch.spin = spin[0];
+	batch.size = size[0];
+	batch.alpha = alpha[0];
+	batch.init_life = init_life;
+	updater->Update(batch, 0.016f);
+
+	for (uint32_t i = 0; i < NUM_PARTICLES; ++ i)
+	{
+		ParticleBatch single;
+		single.pos = std::span(&pos[1][i], 1);
+		single.vel = std::span(&vel[1][i], 1);
+		single.life = std::span(&life[1][i], 1);
+		single.spin = std::span(&spin[1][i], 1);
+		single.size = std::span(&size[1][i], 1);
+		single.alpha = std::span(&alpha[1][i], 1);
+		single.init_life = std::span<float const>(&init_life[i], 1);
+		updater->Update(single, 0.016f);
+	}
+
+	for (uint32_t i = 0; i < NUM_PARTICLES; ++ i)
+	{
+		for (uint32_t c = 0; c < 3; ++ c)
+		{
+			EXPECT_NEAR(pos[0][i][c], pos[1][i][c], 1e-4f);
+			EXPECT_NEAR(vel[0][i][c], vel[1][i][c], 1e-4f);
+		}
+		EXPECT_FLOAT_EQ(life[0][i], life[1][i]);
+		EXPECT_FLOAT_EQ(spin[0][i], spin[1][i]);
+		EXPECT_NEAR(size[0][i], size[1][i], 1e-5f);
+		EXPECT_NEAR(alpha[0][i], alpha[1][i], 1e-5f);
+	}
+}
+
+TEST(ParticleSystemTest, BackToFront)
+{
+	uint32_t constexpr MAX_NUM_PARTICLES = 20000;
+
+	auto ps = MakeSharedPtr<ParticleSystem>(MAX_NUM_PARTICLES, true);
+	auto emitter = ps->MakeEmitter("point");
+	emitter->Frequency(1000000);
+	emitter->EmitAngle(PI / 3);
+	emitter->MinPosition(float3(-10, -10, -10));
+	emitter->MaxPosition(float3(+10, +10, +10));
+	emitter->MinVelocity(0.5f);
+	emitter->MaxVelocity(1.5f);
+	emitter->MinLife(1);
+	emitter->MaxLife(2);
+	emitter->MinSize(0.1f);
+	emitter->MaxSize(0.2f);
+	ps->AddEmitter(emitter);
+	ps->AddUpdater(CreatePolylineUpdater(ps));
+
+	for (uint32_t i = 0; i < 3; ++ i)
+	{
+		ps->RootNode()->SubThreadUpdate(i * 0.01f, 0.01f);
+	}
+	ASSERT_EQ(ps->NumActiveParticles(), MAX_NUM_PARTICLES);
+
+	auto& re = Context::Instance().RenderFactoryInstance().RenderEngineInstance();
+	float4x4 const & view_mat = re.DefaultFrameBuffer()->Viewport()->Camera()->ViewMatrix();
+	float last_depth = std::numeric_limits<float>::max();
+	for (uint32_t i = 0; i < ps->NumActiveParticles(); ++ i)
+	{
+		Particle const par = ps->GetParticle(ps->GetActiveParticleIndex(i));
+		EXPECT_GT(par.life, 0);
+
+		float const depth = MathLib::transform_coord(par.pos, view_mat).z();
+		EXPECT_LE(depth, last_depth + 1e-4f);
+		last_depth = depth;
+	}
+}
@@ -0,0 +1,196 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/CXX17/filesystem.hpp>
+#include <KlayGE/PerfProfiler.hpp>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	struct TraceEvent
+	{
+		std::string phase;
+		uint32_t tid;
+		double ts;
+		std::string name;
+	};
+
+	std::string FieldValue(std::string const & line, std::string const & field)
+	{
+		auto const pos = line.find("\"" + field + "\":");
+		if (pos == std::string::npos)
+		{
+			return {};
+		}
+
+		auto begin = pos + field.size() + 3;
+		if (line[begin] == '"')
+		{
+			++ begin;
+			return line.substr(begin, line.find('"', begin) - begin);
+		}
+		return line.substr(begin, line.find_first_of(",}", begin) - begin);
+	}
+
+	// The exporter writes one event per line
+	std::vector<TraceEvent> ExportAndParse(std::string const & file_name)
+	{
+		std::string const trace_name = (FILESYSTEM_NS::temp_directory_path() / file_name).string();
+		PerfProfiler::Instance().ExportToChromeTrace(trace_name);
+
+		std::vector<TraceEvent> ret;
+		std::ifstream ifs(trace_name.c_str());
+		std::string line;
+		std::getline(ifs, line);
+		EXPECT_EQ(line, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+		while (std::getline(ifs, line))
+		{
+			if (line.empty() || (line[0] != '{'))
+			{
+				continue;
+			}
+
+			TraceEvent event;
+			event.phase = FieldValue(line, "ph");
+			event.tid = std::stoul(FieldValue(line, "tid"));
+			event.ts = std::stod(FieldValue(line, "ts"));
+			event.name = (event.phase == "M") ? FieldValue(line.substr(line.find("\"args\"")), "name") : FieldValue(line, "name");
+			ret.push_back(event);
+		}
+		ifs.close();
+
+		std::error_code ec;
+		FILESYSTEM_NS::remove(trace_name, ec);
+		return ret;
+	}
+
+	void Work(uint32_t depth)
+	{
+		KLAYGE_PERF_ZONE(depth == 0 ? "Leaf" : "Node");
+		if (depth > 0)
+		{
+			Work(depth - 1);
+			Work(depth - 1);
+		}
+	}
+}
+
+TEST(PerfProfilerTest, NestedZonesOnThreads)
+{
+	uint32_t const num_threads = 4;
+
+	PerfProfiler::Instance().StartCapture();
+
+	std::vector<std::thread> threads;
+	for (uint32_t i = 0; i < num_threads; ++ i)
+	{
+		threads.emplace_back([i] {
+			PerfProfiler::Instance().ThreadName("Worker " + std::to_string(i));
+			Work(4);
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	PerfProfiler::Instance().StopCapture();
+
+	auto const events = ExportAndParse("PerfProfilerTestNested.json");
+
+	std::map<uint32_t, std::string> thread_names;
+	std::map<uint32_t, int> depths;
+	std::map<uint32_t, double> last_ts;
+	uint32_t num_leaves = 0;
+	for (auto const & event : events)
+	{
+		if (event.phase == "M")
+		{
+			thread_names[event.tid] = event.name;
+			continue;
+		}
+
+		EXPECT_GE(event.ts, last_ts[event.tid]);
+		last_ts[event.tid] = event.ts;
+
+		if (event.phase == "B")
+		{
+			++ depths[event.tid];
+			EXPECT_LE(depths[event.tid], 5);
+			num_leaves += (event.name == "Leaf");
+		}
+		else
+		{
+			ASSERT_EQ(event.phase, "E");
+			-- depths[event.tid];
+			EXPECT_GE(depths[event.tid], 0);
+		}
+	}
+
+	EXPECT_EQ(thread_names.size(), num_threads);
+	EXPECT_EQ(depths.size(), num_threads);
+	for (auto const & depth : depths)
+	{
+		EXPECT_EQ(depth.second, 0);
+		EXPECT_EQ(thread_names[depth.first].substr(0, 7), "Worker ");
+	}
+	EXPECT_EQ(num_leaves, num_threads * 16);
+
+	PerfProfiler::Destroy();
+}
+
+TEST(PerfProfilerTest, NothingRecordedWhenNotCapturing)
+{
+	Work(3);
+	PerfProfiler::Instance().Counter("Counter", 1);
+	PerfProfiler::Instance().FrameMarker();
+
+	// Zones that were open when the capture started are not recorded either
+	{
+		KLAYGE_PERF_ZONE("Outer");
+		PerfProfiler::Instance().StartCapture();
+	}
+	PerfProfiler::Instance().StopCapture();
+
+	for (auto const & event : ExportAndParse("PerfProfilerTestDisabled.json"))
+	{
+		EXPECT_EQ(event.phase, "M");
+	}
+
+	PerfProfiler::Destroy();
+}
+
+TEST(PerfProfilerTest, FrameMarkersAndCounters)
+{
+	PerfProfiler::Instance().StartCapture();
+	for (uint32_t i = 0; i < 3; ++ i)
+	{
+		KLAYGE_PERF_ZONE("Frame \"quoted\"");
+		PerfProfiler::Instance().FrameMarker();
+		PerfProfiler::Instance().Counter("Draw calls", i * 10);
+	}
+	PerfProfiler::Instance().StopCapture();
+
+	uint32_t num_frames = 0;
+	uint32_t num_counters = 0;
+	uint32_t num_zones = 0;
+	for (auto const & event : ExportAndParse("PerfProfilerTestCounters.json"))
+	{
+		num_frames += (event.phase == "i") && (event.name == "Frame");
+		num_counters += (event.phase == "C") && (event.name == "Draw calls");
+		num_zones += (event.phase == "B") && (event.name == "Frame \\");
+	}
+	EXPECT_EQ(num_frames, 3U);
+	EXPECT_EQ(num_counters, 3U);
+	EXPECT_EQ(num_zones, 3U);
+
+	PerfProfiler::Destroy();
+}
@@ -0,0 +1,51 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/RadixSort.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	template <typename Key>
+	void TestRadixSort(std::vector<std::pair<Key, uint32_t>> items)
+	{
+		auto expected = items;
+		std::stable_sort(expected.begin(), expected.end(),
+			[](std::pair<Key, uint32_t> const & lhs, std::pair<Key, uint32_t> const & rhs) { return lhs.first < rhs.first; });
+
+		std::vector<std::pair<Key, uint32_t>> tmp;
+		RadixSort(items, tmp);
+		EXPECT_TRUE(items == expected);
+	}
+}
+
+TEST(RadixSortTest, Key64)
+{
+	std::ranlux24_base gen;
+	std::vector<std::pair<uint64_t, uint32_t>> items(10000);
+	for (uint32_t i = 0; i < items.size(); ++ i)
+	{
+		items[i] = std::make_pair((static_cast<uint64_t>(gen()) << 40) | gen(), i);
+	}
+
+	TestRadixSort(items);
+}
+
+TEST(RadixSortTest, Stable)
+{
+	std::ranlux24_base gen;
+	std::vector<std::pair<uint32_t, uint32_t>> items(10000);
+	for (uint32_t i = 0; i < items.size(); ++ i)
+	{
+		// Only the middle bytes are different, and there are lots of duplicates
+		items[i] = std::make_pair(0xAB0000CDU | ((gen() & 0x3F) << 12), i);
+	}
+
+	TestRadixSort(items);
+}
@@ -0,0 +1,66 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/Hash.hpp>
+#include <KlayGE/RenderEffect.hpp>
+
+#include <string_view>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+TEST(RenderEffectTest, ParameterByName)
+{
+	auto effect = SyncLoadRenderEffect("ConstantBuffer/ConstantBufferTest.fxml");
+	ASSERT_GT(effect->NumParameters(), 0U);
+
+	for (uint32_t i = 0; i < effect->NumParameters(); ++ i)
+	{
+		auto* param = effect->ParameterByIndex(i);
+		EXPECT_EQ(effect->ParameterByName(param->Name()), param);
+	}
+	EXPECT_EQ(effect->ParameterByName("not_a_parameter"), nullptr);
+
+	for (uint32_t i = 0; i < effect->NumTechniques(); ++ i)
+	{
+		auto* tech = effect->TechniqueByIndex(i);
+		EXPECT_EQ(effect->TechniqueByName(tech->Name()), tech);
+	}
+	EXPECT_EQ(effect->TechniqueByName("NotATechnique"), nullptr);
+}
+
+TEST(RenderEffectTest, Handles)
+{
+	EXPECT_EQ(CT_HASH("color0"), HashValue(std::string_view("color0")));
+
+	auto effect = SyncLoadRenderEffect("ConstantBuffer/ConstantBufferTest.fxml");
+	auto cloned_effect = effect->Clone();
+
+	RenderEffectParameterHandle const color0_handle(CT_HASH("color0"));
+	RenderEffectParameterHandle const missing_handle(CT_HASH("not_a_parameter"));
+	RenderTechniqueHandle const tech_handle(CT_HASH("ConstantBuffer"));
+
+	// Resolving again, and on a clone, gives the same answers as by name
+	for (uint32_t i = 0; i < 2; ++ i)
+	{
+		EXPECT_EQ(effect->ParameterByHandle(color0_handle), effect->ParameterByName("color0"));
+		EXPECT_EQ(cloned_effect->ParameterByHandle(color0_handle), cloned_effect->ParameterByName("color0"));
+		EXPECT_NE(effect->ParameterByHandle(color0_handle), cloned_effect->ParameterByHandle(color0_handle));
+
+		EXPECT_EQ(effect->ParameterByHandle(missing_handle), nullptr);
+
+		EXPECT_EQ(effect->TechniqueByHandle(tech_handle), effect->TechniqueByName("ConstantBuffer"));
+		EXPECT_NE(effect->TechniqueByHandle(tech_handle), nullptr);
+	}
+
+	// Switching between effects with different layouts
+	auto other_effect = SyncLoadRenderEffect("UavOutput/UavOutputTest.fxml");
+	RenderEffectParameterHandle const frame_width_handle(CT_HASH("frame_width"));
+	for (uint32_t i = 0; i < 2; ++ i)
+	{
+		EXPECT_EQ(effect->ParameterByHandle(frame_width_handle), nullptr);
+		EXPECT_EQ(other_effect->ParameterByHandle(frame_width_handle), other_effect->ParameterByName("frame_width"));
+		EXPECT_NE(other_effect->ParameterByHandle(frame_width_handle), nullptr);
+		EXPECT_EQ(other_effect->ParameterByHandle(color0_handle), nullptr);
+	}
+}
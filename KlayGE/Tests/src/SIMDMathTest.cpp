@@ -1,4 +1,6 @@
 #include <KlayGE/KlayGE.hpp>
+#include <KFL/AABBox.hpp>
+#include <KFL/Frustum.hpp>
 #include <KFL/Math.hpp>
 #include <KFL/SIMDMath.hpp>
 
@@ -31,3 +33,117 @@ TEST(SIMDMathTest, NormalizeVector4)
 	v = SIMDMathLib::NormalizeVector4(v);
 	EXPECT_LT(MathLib::abs(SIMDMathLib::GetX(SIMDMathLib::LengthVector4(v)) - 1.0f), 1e-3f);
 }
+
+TEST(SIMDMathTest, MultiplyQuat)
+{
+	Quaternion const q1 = MathLib::rotation_quat_yaw_pitch_roll(0.3f, -1.2f, 2.1f);
+	Quaternion const q2 = MathLib::rotation_quat_yaw_pitch_roll(-2.5f, 0.7f, 0.4f);
+	Quaternion const expected = q1 * q2;
+
+	SIMDVectorF4 const v = SIMDMathLib::MultiplyQuat(SIMDMathLib::SetVector(q1.x(), q1.y(), q1.z(), q1.w()),
+		SIMDMathLib::SetVector(q2.x(), q2.y(), q2.z(), q2.w()));
+	EXPECT_LT(MathLib::abs(SIMDMathLib::GetX(v) - expected.x()), 1e-5f);
+	EXPECT_LT(MathLib::abs(SIMDMathLib::GetY(v) - expected.y()), 1e-5f);
+	EXPECT_LT(MathLib::abs(SIMDMathLib::GetZ(v) - expected.z()), 1e-5f);
+	EXPECT_LT(MathLib::abs(SIMDMathLib::GetW(v) - expected.w()), 1e-5f);
+}
+
+TEST(SIMDMathTest, InverseMatrix)
+{
+	float4x4 const m = MathLib::scaling(2.0f, 0.5f, 3.0f) * MathLib::rotation_matrix_yaw_pitch_roll(0.3f, -1.2f, 2.1f)
+		* MathLib::translation(10.0f, -4.0f, 7.0f);
+	float4x4 inv_m;
+	SIMDMathLib::StoreMatrix(inv_m, SIMDMathLib::Inverse(SIMDMathLib::LoadMatrix(m)));
+
+	float4x4 const identity = m * inv_m;
+	for (int r = 0; r < 4; ++ r)
+	{
+		for (int c = 0; c < 4; ++ c)
+		{
+			EXPECT_LT(MathLib::abs(identity(r, c) - ((r == c) ? 1.0f : 0.0f)), 1e-4f);
+		}
+	}
+}
+
+TEST(SIMDMathTest, TransformAABB)
+{
+	AABBox const aabb(float3(-1, -2, -3), float3(4, 5, 6));
+	float4x4 const m = MathLib::rotation_matrix_yaw_pitch_roll(0.3f, -1.2f, 2.1f) * MathLib::translation(10.0f, -4.0f, 7.0f);
+
+	float3 expected_min = MathLib::transform_coord(aabb.Corner(0), m);
+	float3 expected_max = expected_min;
+	for (uint32_t i = 1; i < 8; ++ i)
+	{
+		float3 const corner = MathLib::transform_coord(aabb.Corner(i), m);
+		expected_min = MathLib::minimize(expected_min, corner);
+		expected_max = MathLib::maximize(expected_max, corner);
+	}
+
+	AABBox const transformed = SIMDMathLib::TransformAABB(aabb, SIMDMathLib::LoadMatrix(m));
+	for (uint32_t i = 0; i < 3; ++ i)
+	{
+		EXPECT_LT(MathLib::abs(transformed.Min()[i] - expected_min[i]), 1e-4f);
+		EXPECT_LT(MathLib::abs(transformed.Max()[i] - expected_max[i]), 1e-4f);
+	}
+}
+
+TEST(SIMDMathTest, IntersectAABBFrustum)
+{
+	float4x4 const view_proj = MathLib::look_at_lh(float3(0, 0, -10), float3(0, 0, 0), float3(0, 1, 0))
+		* MathLib::perspective_fov_lh(PI / 4, 1.0f, 1.0f, 100.0f);
+	Frustum frustum;
+	frustum.ClipMatrix(view_proj, MathLib::inverse(view_proj));
+
+	EXPECT_EQ(SIMDMathLib::IntersectAABBFrustum(AABBox(float3(-1, -1, -1), float3(1, 1, 1)), frustum), BoundOverlap::Yes);
+	EXPECT_EQ(SIMDMathLib::IntersectAABBFrustum(AABBox(float3(-1, -1, 85), float3(1, 1, 95)), frustum), BoundOverlap::Partial);
+	EXPECT_EQ(SIMDMathLib::IntersectAABBFrustum(AABBox(float3(-1, -1, -30), float3(1, 1, -20)), frustum), BoundOverlap::No);
+	EXPECT_EQ(SIMDMathLib::IntersectAABBFrustum(AABBox(float3(50, -1, -1), float3(52, 1, 1)), frustum), BoundOverlap::No);
+}
+
+TEST(SIMDMathTest, BatchTransformVector4)
+{
+	SIMDMatrixF4 const m = SIMDMathLib::LoadMatrix(MathLib::rotation_matrix_yaw_pitch_roll(0.3f, -1.2f, 2.1f)
+		* MathLib::translation(10.0f, -4.0f, 7.0f));
+
+	// Odd count covers the tail that doesn't fill a pair
+	std::vector<SIMDVectorF4> vs(7);
+	for (size_t i = 0; i < vs.size(); ++ i)
+	{
+		float const f = static_cast<float>(i);
+		vs[i] = SIMDMathLib::SetVector(f * 1.5f - 3, 2 - f, f * f * 0.25f, 1);
+	}
+
+	std::vector<SIMDVectorF4> transformed(vs.size());
+	SIMDMathLib::TransformVector4(transformed, vs, m);
+	for (size_t i = 0; i < vs.size(); ++ i)
+	{
+		float4 expected;
+		float4 actual;
+		SIMDMathLib::StoreVector4(expected, SIMDMathLib::TransformVector4(vs[i], m));
+		SIMDMathLib::StoreVector4(actual, transformed[i]);
+		EXPECT_EQ(actual, expected);
+	}
+}
+
+TEST(SIMDMathTest, BatchMultiplyMatrix)
+{
+	std::vector<SIMDMatrixF4> lhs(3);
+	std::vector<SIMDMatrixF4> rhs(3);
+	for (size_t i = 0; i < lhs.size(); ++ i)
+	{
+		float const f = static_cast<float>(i);
+		lhs[i] = SIMDMathLib::LoadMatrix(MathLib::scaling(2.0f + f, 0.5f, 3.0f) * MathLib::translation(f, -4.0f, 7.0f));
+		rhs[i] = SIMDMathLib::LoadMatrix(MathLib::rotation_matrix_yaw_pitch_roll(0.3f * f, -1.2f, 2.1f - f));
+	}
+
+	std::vector<SIMDMatrixF4> products(lhs.size());
+	SIMDMathLib::Multiply(products, lhs, rhs);
+	for (size_t i = 0; i < lhs.size(); ++ i)
+	{
+		float4x4 expected;
+		float4x4 actual;
+		SIMDMathLib::StoreMatrix(expected, SIMDMathLib::Multiply(lhs[i], rhs[i]));
+		SIMDMathLib::StoreMatrix(actual, products[i]);
+		EXPECT_EQ(actual, expected);
+	}
+}
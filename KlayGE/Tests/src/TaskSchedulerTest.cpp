@@ -0,0 +1,175 @@
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/TaskScheduler.hpp>
+
+#include <array>
+#include <atomic>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "KlayGETests.hpp"
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	uint64_t Fibonacci(TaskScheduler& scheduler, uint32_t n)
+	{
+		if (n < 2)
+		{
+			return n;
+		}
+
+		uint64_t a;
+		uint64_t b;
+		TaskGroup group;
+		scheduler.Run(group, [&scheduler, &a, n] { a = Fibonacci(scheduler, n - 1); });
+		b = Fibonacci(scheduler, n - 2);
+		scheduler.Wait(group);
+		return a + b;
+	}
+}
+
+TEST(TaskSchedulerTest, ParallelFor)
+{
+	TaskScheduler scheduler(4);
+
+	for (uint32_t const grain_size : {1U, 7U, 1000U, 100000U})
+	{
+		std::vector<uint32_t> visits(10000, 0);
+		scheduler.ParallelFor(0U, static_cast<uint32_t>(visits.size()), grain_size, [&visits, grain_size](uint32_t begin, uint32_t end) {
+			EXPECT_LT(begin, end);
+			EXPECT_LE(end - begin, grain_size);
+			for (uint32_t i = begin; i < end; ++ i)
+			{
+				++ visits[i];
+			}
+		});
+
+		for (auto const visit : visits)
+		{
+			EXPECT_EQ(visit, 1U);
+		}
+	}
+
+	bool called = false;
+	scheduler.ParallelFor(5, 5, 1, [&called](int, int) { called = true; });
+	EXPECT_FALSE(called);
+}
+
+TEST(TaskSchedulerTest, ParallelReduce)
+{
+	TaskScheduler scheduler(3);
+
+	std::vector<uint64_t> values(100001);
+	std::iota(values.begin(), values.end(), 0);
+	uint64_t const sum = scheduler.ParallelReduce(size_t(0), values.size(), 1000, uint64_t(0),
+		[&values](size_t begin, size_t end) { return std::accumulate(values.begin() + begin, values.begin() + end, uint64_t(0)); },
+		[](uint64_t lhs, uint64_t rhs) { return lhs + rhs; });
+	EXPECT_EQ(sum, 100000ULL * 100001 / 2);
+
+	// The subranges are reduced in order
+	std::string const str = scheduler.ParallelReduce(0, 26, 3, std::string(),
+		[](int begin, int end) {
+			std::string ret;
+			for (int i = begin; i < end; ++ i)
+			{
+				ret += static_cast<char>('a' + i);
+			}
+			return ret;
+		},
+		[](std::string const & lhs, std::string const & rhs) { return lhs + rhs; });
+	EXPECT_EQ(str, "abcdefghijklmnopqrstuvwxyz");
+}
+
+TEST(TaskSchedulerTest, Nested)
+{
+	TaskScheduler scheduler(4);
+	EXPECT_EQ(Fibonacci(scheduler, 24), 46368U);
+
+	std::atomic<uint32_t> count(0);
+	scheduler.ParallelFor(0U, 64U, 1U, [&scheduler, &count](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; ++ i)
+		{
+			scheduler.ParallelFor(0U, 100U, 10U, [&count](uint32_t sub_begin, uint32_t sub_end) { count += sub_end - sub_begin; });
+		}
+	});
+	EXPECT_EQ(count, 6400U);
+}
+
+TEST(TaskSchedulerTest, Continuation)
+{
+	TaskScheduler scheduler(2);
+
+	// Stages of a pipeline, each one runs after the previous one has finished
+	std::array<std::atomic<uint32_t>, 3> counts{};
+	std::atomic<bool> in_order(true);
+	TaskGroup stage0;
+	TaskGroup stage1;
+	TaskGroup stage2;
+	for (uint32_t i = 0; i < 100; ++ i)
+	{
+		scheduler.Run(stage0, [&counts] { ++ counts[0]; });
+	}
+	scheduler.Continue(stage0, stage1, [&scheduler, &stage1, &counts, &in_order] {
+		in_order = in_order && (counts[0] == 100);
+		for (uint32_t i = 0; i < 50; ++ i)
+		{
+			scheduler.Run(stage1, [&counts] { ++ counts[1]; });
+		}
+	});
+	scheduler.Continue(stage1, stage2, [&counts, &in_order] {
+		in_order = in_order && (counts[1] == 50);
+		++ counts[2];
+	});
+	scheduler.Wait(stage2);
+
+	EXPECT_TRUE(in_order);
+	EXPECT_EQ(counts[2], 1U);
+	EXPECT_TRUE(stage0.Done());
+	EXPECT_TRUE(stage1.Done());
+
+	// A continuation of a group that has already finished runs right away
+	TaskGroup done_group;
+	TaskGroup next_group;
+	bool continued = false;
+	scheduler.Continue(done_group, next_group, [&continued] { continued = true; });
+	scheduler.Wait(next_group);
+	EXPECT_TRUE(continued);
+}
+
+TEST(TaskSchedulerTest, LargeFunctor)
+{
+	TaskScheduler scheduler(2);
+
+	// Doesn't fit in a task, or isn't trivially copyable
+	std::array<uint64_t, 32> large{};
+	large[31] = 42;
+	std::vector<uint32_t> non_trivial(10, 1);
+	std::atomic<uint64_t> sum(0);
+
+	TaskGroup group;
+	for (uint32_t i = 0; i < 100; ++ i)
+	{
+		scheduler.Run(group, [large, &sum] { sum += large[31]; });
+		scheduler.Run(group, [non_trivial, &sum] { sum += std::accumulate(non_trivial.begin(), non_trivial.end(), 0U); });
+	}
+	scheduler.Wait(group);
+	EXPECT_EQ(sum, 100U * (42 + 10));
+}
+
+TEST(TaskSchedulerTest, ManyTasks)
+{
+	TaskScheduler scheduler(4);
+
+	// More than a queue holds
+	std::atomic<uint32_t> count(0);
+	TaskGroup group;
+	for (uint32_t i = 0; i < 100000; ++ i)
+	{
+		scheduler.Run(group, [&count] { ++ count; });
+	}
+	scheduler.Wait(group);
+	EXPECT_EQ(count, 100000U);
+}
@@ -0,0 +1,207 @@
+/**
+ * @file CullingBenchmark.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/CXX20/bit.hpp>
+#include <KFL/Math.hpp>
+#include <KFL/Timer.hpp>
+#include <KlayGE/Camera.hpp>
+#include <KlayGE/Context.hpp>
+#include <KlayGE/Renderable.hpp>
+#include <KlayGE/SceneManager.hpp>
+#include <KlayGE/SceneNode.hpp>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <nonstd/scope.hpp>
+
+#ifndef KLAYGE_DEBUG
+#define CXXOPTS_NO_RTTI
+#endif
+#include <cxxopts.hpp>
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	// Only provides a bound, never rendered
+	class BoxRenderable : public Renderable
+	{
+	public:
+		BoxRenderable()
+			: Renderable(L"Box")
+		{
+			pos_aabb_ = AABBox(float3(-1, -1, -1), float3(1, 1, 1));
+		}
+	};
+
+	uint32_t CountVisible(SceneManager::VisibilityBitset const & visibility)
+	{
+		uint32_t ret = 0;
+		for (auto const word : visibility)
+		{
+			ret += std::popcount(word);
+		}
+		return ret;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	auto on_exit = nonstd::make_scope_exit([] { Context::Destroy(); });
+
+	uint32_t num_nodes;
+	uint32_t num_cameras;
+	uint32_t num_iterations;
+	float small_obj_threshold;
+
+	cxxopts::Options options("CullingBenchmark", "KlayGE multi-camera culling benchmark");
+	// clang-format off
+	options.add_options()
+		("H,help", "Produce help message.")
+		("n,nodes", "Number of scene nodes.", cxxopts::value<uint32_t>(num_nodes)->default_value("100000"))
+		("c,cameras", "Number of cameras.", cxxopts::value<uint32_t>(num_cameras)->default_value("8"))
+		("i,iterations", "Number of iterations.", cxxopts::value<uint32_t>(num_iterations)->default_value("20"))
+		("t,threshold", "Small object threshold.", cxxopts::value<float>(small_obj_threshold)->default_value("0.002"))
+		("v,version", "Version.");
+	// clang-format on
+
+	auto vm = options.parse(argc, argv);
+
+	if (vm.count("help") > 0)
+	{
+		cout << options.help() << endl;
+		return 1;
+	}
+	if (vm.count("version") > 0)
+	{
+		cout << "KlayGE multi-camera culling benchmark, Version 1.0.0" << endl;
+		return 1;
+	}
+	if ((num_cameras == 0) || (num_iterations == 0))
+	{
+		cout << "Need at least one camera and one iteration." << endl;
+		return 1;
+	}
+
+	Context::Instance().LoadCfg("KlayGE.cfg");
+	ContextCfg context_cfg = Context::Instance().Config();
+	context_cfg.render_factory_name = "NullRender";
+	context_cfg.scene_manager_name = "OCTree";
+	context_cfg.graphics_cfg.hide_win = true;
+	context_cfg.graphics_cfg.hdr = false;
+	context_cfg.graphics_cfg.ppaa = false;
+	context_cfg.graphics_cfg.gamma = false;
+	context_cfg.graphics_cfg.color_grading = false;
+	Context::Instance().Config(context_cfg);
+
+	SceneManager& scene_mgr = Context::Instance().SceneManagerInstance();
+	SceneNode& root_node = scene_mgr.SceneRootNode();
+
+	std::ranlux24_base gen(0);
+	std::uniform_real_distribution<float> pos_dist(-1000, 1000);
+	std::uniform_real_distribution<float> size_dist(0.5f, 10);
+
+	auto renderable = MakeSharedPtr<BoxRenderable>();
+	for (uint32_t i = 0; i < num_nodes; ++ i)
+	{
+		auto node = MakeSharedPtr<SceneNode>(MakeSharedPtr<RenderableComponent>(renderable), SceneNode::SOA_Cullable);
+		node->TransformToParent(MathLib::scaling(float3(size_dist(gen), size_dist(gen), size_dist(gen)))
+			* MathLib::translation(pos_dist(gen), pos_dist(gen), pos_dist(gen)));
+		root_node.AddChild(node);
+	}
+
+	std::vector<Camera const *> cameras;
+	for (uint32_t i = 0; i < num_cameras; ++ i)
+	{
+		auto camera = MakeSharedPtr<Camera>();
+		camera->ProjParams(PI / 4, 1, 1, 1000);
+
+		auto camera_node = MakeSharedPtr<SceneNode>(L"Camera", SceneNode::SOA_Moveable);
+		camera_node->AddComponent(camera);
+		float3 const eye_pos(pos_dist(gen), pos_dist(gen), pos_dist(gen));
+		float3 const look_at(pos_dist(gen) / 4, pos_dist(gen) / 4, pos_dist(gen) / 4);
+		camera_node->TransformToParent(MathLib::inverse(MathLib::look_at_lh(eye_pos, look_at, float3(0, 1, 0))));
+		root_node.AddChild(camera_node);
+
+		cameras.push_back(camera.get());
+	}
+
+	root_node.Traverse([](SceneNode& node) {
+		node.MainThreadUpdate(0, 0);
+		node.UpdateTransforms();
+		return true;
+	});
+	root_node.UpdatePosBoundSubtree();
+
+	// Builds the tree
+	std::vector<SceneManager::VisibilityBitset> serial_visibilities(num_cameras);
+	std::vector<SceneManager::VisibilityBitset> parallel_visibilities(num_cameras);
+	scene_mgr.CullCameras(cameras, small_obj_threshold, parallel_visibilities);
+
+	Timer timer;
+	for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+	{
+		for (uint32_t i = 0; i < num_cameras; ++ i)
+		{
+			scene_mgr.CullCameras(std::span(&cameras[i], 1), small_obj_threshold, std::span(&serial_visibilities[i], 1));
+		}
+	}
+	double const serial_time = timer.elapsed() / num_iterations;
+
+	timer.restart();
+	for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+	{
+		scene_mgr.CullCameras(cameras, small_obj_threshold, parallel_visibilities);
+	}
+	double const parallel_time = timer.elapsed() / num_iterations;
+
+	uint32_t total_visible = 0;
+	for (uint32_t i = 0; i < num_cameras; ++ i)
+	{
+		if (serial_visibilities[i] != parallel_visibilities[i])
+		{
+			cout << "Camera " << i << " has different results in serial and parallel culling." << endl;
+			return 1;
+		}
+		total_visible += CountVisible(parallel_visibilities[i]);
+	}
+
+	cout << num_nodes << " nodes, " << num_cameras << " cameras, " << total_visible / num_cameras << " visible nodes per camera"
+		<< endl;
+	cout << "Serial: " << serial_time * 1000 << " ms" << endl;
+	cout << "Parallel: " << parallel_time * 1000 << " ms" << endl;
+	cout << "Speedup: " << serial_time / parallel_time << "x" << endl;
+
+	return 0;
+}
@@ -0,0 +1,181 @@
+/**
+ * @file DistanceFieldBenchmark.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/Math.hpp>
+#include <KFL/Timer.hpp>
+#include <KlayGE/DistanceField.hpp>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifndef KLAYGE_DEBUG
+#define CXXOPTS_NO_RTTI
+#endif
+#include <cxxopts.hpp>
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	// Anti-aliased random strokes at 2x resolution, roughly what KFontGen feeds into ComputeDistance for a complex glyph
+	std::vector<float> CreateGlyph(uint32_t size_2x, uint32_t seed)
+	{
+		uint32_t const sub_samples = 4;
+		float const half_width = 0.025f;
+
+		std::ranlux24_base gen(seed);
+		std::uniform_real_distribution<float> pos_dist(0.1f, 0.9f);
+
+		std::vector<float4> strokes;
+		for (uint32_t i = 0; i < 12; ++ i)
+		{
+			float const a = pos_dist(gen);
+			float const b = pos_dist(gen);
+			float const c = pos_dist(gen);
+			float4 const stroke = (i & 1) ? float4(std::min(a, c), b, std::max(a, c), b) : float4(a, std::min(b, c), a, std::max(b, c));
+			strokes.push_back(stroke + float4(-half_width, -half_width, half_width, half_width));
+		}
+
+		std::vector<float> ret(size_2x * size_2x);
+		for (uint32_t y = 0; y < size_2x; ++ y)
+		{
+			for (uint32_t x = 0; x < size_2x; ++ x)
+			{
+				uint32_t covered = 0;
+				for (uint32_t sy = 0; sy < sub_samples; ++ sy)
+				{
+					for (uint32_t sx = 0; sx < sub_samples; ++ sx)
+					{
+						float const px = (x + (sx + 0.5f) / sub_samples) / size_2x;
+						float const py = (y + (sy + 0.5f) / sub_samples) / size_2x;
+						for (auto const & stroke : strokes)
+						{
+							if ((px >= stroke.x()) && (px <= stroke.z()) && (py >= stroke.y()) && (py <= stroke.w()))
+							{
+								++ covered;
+								break;
+							}
+						}
+					}
+				}
+				ret[y * size_2x + x] = static_cast<float>(covered) / (sub_samples * sub_samples);
+			}
+		}
+		return ret;
+	}
+
+	double RunBenchmark(std::vector<std::vector<float>> const & glyphs, uint32_t size_2x, DistanceFieldAlgorithm algorithm,
+		uint32_t num_iterations, std::vector<std::vector<float>>& dist_data)
+	{
+		dist_data.resize(glyphs.size());
+
+		Timer timer;
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			for (size_t i = 0; i < glyphs.size(); ++ i)
+			{
+				ComputeDistance(glyphs[i], size_2x, size_2x, dist_data[i], algorithm);
+			}
+		}
+		return timer.elapsed() / (num_iterations * glyphs.size());
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t char_size;
+	uint32_t num_glyphs;
+	uint32_t num_iterations;
+
+	cxxopts::Options options("DistanceFieldBenchmark", "KlayGE distance field benchmark");
+	// clang-format off
+	options.add_options()
+		("H,help", "Produce help message.")
+		("C,char-size", "Character size.", cxxopts::value<uint32_t>(char_size)->default_value("64"))
+		("g,glyphs", "Number of glyphs.", cxxopts::value<uint32_t>(num_glyphs)->default_value("32"))
+		("i,iterations", "Number of iterations.", cxxopts::value<uint32_t>(num_iterations)->default_value("5"))
+		("v,version", "Version.");
+	// clang-format on
+
+	auto vm = options.parse(argc, argv);
+
+	if (vm.count("help") > 0)
+	{
+		cout << options.help() << endl;
+		return 1;
+	}
+	if (vm.count("version") > 0)
+	{
+		cout << "KlayGE distance field benchmark, Version 1.0.0" << endl;
+		return 1;
+	}
+	if ((char_size == 0) || (num_glyphs == 0) || (num_iterations == 0))
+	{
+		cout << "Need a non-empty character, at least one glyph and one iteration." << endl;
+		return 1;
+	}
+
+	uint32_t const size_2x = char_size * 2;
+	std::vector<std::vector<float>> glyphs(num_glyphs);
+	for (uint32_t i = 0; i < num_glyphs; ++ i)
+	{
+		glyphs[i] = CreateGlyph(size_2x, i);
+	}
+
+	std::vector<std::vector<float>> aa_dist;
+	std::vector<std::vector<float>> exact_dist;
+	double const aa_time = RunBenchmark(glyphs, size_2x, DistanceFieldAlgorithm::AAEuclidean, num_iterations, aa_dist);
+	double const exact_time = RunBenchmark(glyphs, size_2x, DistanceFieldAlgorithm::ExactEuclidean, num_iterations, exact_dist);
+
+	double sum_diff = 0;
+	float max_diff = 0;
+	size_t num_pixels = 0;
+	for (uint32_t i = 0; i < num_glyphs; ++ i)
+	{
+		for (size_t j = 0; j < aa_dist[i].size(); ++ j)
+		{
+			float const diff = std::abs(aa_dist[i][j] - exact_dist[i][j]);
+			sum_diff += diff;
+			max_diff = std::max(max_diff, diff);
+		}
+		num_pixels += aa_dist[i].size();
+	}
+
+	cout << num_glyphs << " glyphs, " << char_size << "x" << char_size << endl;
+	cout << "AAEuclidean: " << aa_time * 1000 << " ms per glyph" << endl;
+	cout << "ExactEuclidean: " << exact_time * 1000 << " ms per glyph" << endl;
+	cout << "Speedup: " << aa_time / exact_time << "x" << endl;
+	cout << "Difference: mean " << sum_diff / num_pixels << ", max " << max_diff << endl;
+
+	return 0;
+}
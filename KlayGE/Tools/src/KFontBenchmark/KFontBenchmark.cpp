@@ -0,0 +1,171 @@
+/**
+ * @file KFontBenchmark.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/CXX17/filesystem.hpp>
+#include <KFL/Timer.hpp>
+
+#include <kfont/kfont.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef KLAYGE_DEBUG
+#define CXXOPTS_NO_RTTI
+#endif
+#include <cxxopts.hpp>
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	struct BenchmarkResult
+	{
+		uintmax_t file_size;
+		double open_time;
+		double decode_time;
+		uint32_t num_glyphs;
+	};
+
+	BenchmarkResult RunBenchmark(std::string const & kfont_name, uint32_t num_iterations)
+	{
+		BenchmarkResult ret;
+		ret.file_size = FILESYSTEM_NS::file_size(kfont_name);
+
+		Timer timer;
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			KFont kfont;
+			kfont.Load(kfont_name);
+		}
+		ret.open_time = timer.elapsed() / num_iterations;
+
+		KFont kfont;
+		kfont.Load(kfont_name);
+		uint32_t const char_size = kfont.CharSize();
+		std::vector<uint8_t> char_data(char_size * char_size);
+
+		// Decodes every glyph in the order of the chars, as the text renders them
+		std::vector<int32_t> indices;
+		for (uint32_t ch = 0; ch < 0x10000; ++ ch)
+		{
+			int32_t const index = kfont.CharIndex(static_cast<wchar_t>(ch));
+			if (index >= 0)
+			{
+				indices.push_back(index);
+			}
+		}
+		ret.num_glyphs = static_cast<uint32_t>(indices.size());
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			for (auto const index : indices)
+			{
+				kfont.GetDistanceData(char_data.data(), char_size, index);
+			}
+		}
+		ret.decode_time = timer.elapsed() / num_iterations;
+
+		return ret;
+	}
+
+	void PrintResult(std::string const & name, BenchmarkResult const & result, BenchmarkResult const & baseline)
+	{
+		cout << name << ": " << result.file_size / 1024 << " KB, open " << result.open_time * 1000 << " ms ("
+			<< baseline.open_time / result.open_time << "x), " << result.num_glyphs / result.decode_time / 1000 << "K glyphs/s ("
+			<< baseline.decode_time / result.decode_time << "x)" << endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string input_name;
+	uint32_t num_iterations;
+
+	cxxopts::Options options("KFontBenchmark", "KlayGE kfont benchmark");
+	// clang-format off
+	options.add_options()
+		("H,help", "Produce help message.")
+		("I,input-name", "Input kfont name.", cxxopts::value<std::string>(input_name))
+		("i,iterations", "Number of iterations.", cxxopts::value<uint32_t>(num_iterations)->default_value("5"))
+		("v,version", "Version.");
+	// clang-format on
+
+	auto vm = options.parse(argc, argv);
+
+	if ((argc <= 1) || (vm.count("help") > 0))
+	{
+		cout << options.help() << endl;
+		return 1;
+	}
+	if (vm.count("version") > 0)
+	{
+		cout << "KlayGE kfont benchmark, Version 1.0.0" << endl;
+		return 1;
+	}
+	if (num_iterations == 0)
+	{
+		cout << "Need at least one iteration." << endl;
+		return 1;
+	}
+
+	KFont kfont;
+	if (!kfont.Load(input_name))
+	{
+		cout << "Couldn't load " << input_name << "." << endl;
+		return 1;
+	}
+
+	BenchmarkResult const baseline = RunBenchmark(input_name, num_iterations);
+	PrintResult("Input", baseline, baseline);
+
+	std::pair<KFont::DistanceCodec, char const *> const codecs[] = {
+		{KFont::DistanceCodec::Raw, "Raw"},
+		{KFont::DistanceCodec::Lzma, "LZMA"},
+		{KFont::DistanceCodec::DeltaLz, "DeltaLz"},
+	};
+	FILESYSTEM_NS::path const temp_dir = FILESYSTEM_NS::temp_directory_path();
+	for (auto const & codec : codecs)
+	{
+		std::string const output_name = (temp_dir / (std::string("KFontBenchmark_") + codec.second + ".kfont")).string();
+		kfont.Save(output_name, codec.first);
+
+		PrintResult(codec.second, RunBenchmark(output_name, num_iterations), baseline);
+
+		std::error_code ec;
+		FILESYSTEM_NS::remove(output_name, ec);
+	}
+
+	return 0;
+}
@@ -44,6 +44,7 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <map>
 #include <cstring>
 #include <atomic>
 
@@ -144,12 +145,12 @@ public:
 	ttf_to_dist(FT_Library ft_lib, FT_Face ft_face, uint32_t internal_char_size, uint32_t char_size,
 		uint32_t const * validate_chars, font_info* char_info, float* char_dist_data,
 		int32_t& cur_num_char, std::atomic<int32_t>& cur_package, uint32_t num_chars,
-		float& min_value, float& max_value, uint32_t num_chars_per_package)
+		float& min_value, float& max_value, uint32_t num_chars_per_package, DistanceFieldAlgorithm algorithm)
 		: ft_lib_(ft_lib), ft_face_(ft_face), internal_char_size_(internal_char_size), char_size_(char_size),
 			validate_chars_(validate_chars), char_info_(char_info), char_dist_data_(char_dist_data),
 			cur_num_char_(&cur_num_char), cur_package_(&cur_package), num_chars_(num_chars),
 			num_chars_per_package_(num_chars_per_package),
-			min_value_(&min_value), max_value_(&max_value)
+			min_value_(&min_value), max_value_(&max_value), algorithm_(algorithm)
 	{
 	}
 
@@ -250,7 +251,7 @@ public:
 						}
 					}
 
-					ComputeDistance(aa_char_bitmap_2x, char_size_ * 2, char_size_ * 2, dist_data);
+					ComputeDistance(aa_char_bitmap_2x, char_size_ * 2, char_size_ * 2, dist_data, algorithm_);
 
 					for (uint32_t i = 0; i < dist_data.size(); ++ i)
 					{
@@ -288,12 +289,14 @@ private:
 
 	float* min_value_;
 	float* max_value_;
+
+	DistanceFieldAlgorithm algorithm_;
 };
 
 void compute_distance(std::vector<font_info>& char_info, std::vector<float>& char_dist_data,
 						float& min_value, float& max_value,
 						int num_threads, std::vector<uint8_t> const & ttf, int start_code, int end_code,
-						uint32_t internal_char_size, uint32_t char_size)
+						uint32_t internal_char_size, uint32_t char_size, DistanceFieldAlgorithm algorithm)
 {
 	ThreadPool tp(1, num_threads);
 
@@ -336,7 +339,7 @@ void compute_distance(std::vector<font_info>& char_info, std::vector<float>& cha
 			joiners[i] = tp.QueueThread(ttf_to_dist(ft_libs[i], ft_faces[i], internal_char_size, char_size,
 				&validate_chars[0], &char_info[0], &char_dist_data[0], cur_num_char[i],
 				cur_package, static_cast<uint32_t>(validate_chars.size()),
-				std::ref(min_values[i]), std::ref(max_values[i]), 64));
+				std::ref(min_values[i]), std::ref(max_values[i]), 64, algorithm));
 		}
 	
 		Timer timer;
@@ -509,6 +512,7 @@ int main(int argc, char* argv[])
 	int start_code;
 	int end_code;
 	int num_threads;
+	std::string algorithm_name;
 
 	CpuInfo cpu;
 
@@ -522,6 +526,7 @@ int main(int argc, char* argv[])
 		("E,end-code", "End code.", cxxopts::value<int>(end_code)->default_value("65535"))
 		("C,char-size", "Character size.", cxxopts::value<uint32_t>(header.char_size)->default_value("32"))
 		("T,threads", "Number of Threads. (default: The number of CPU threads)", cxxopts::value<int>(num_threads))
+		("A,algorithm", "Distance field algorithm, aa or edt.", cxxopts::value<std::string>(algorithm_name)->default_value("edt"))
 		("V,version", "Version.");
 	// clang-format on
 
@@ -575,6 +580,22 @@ int main(int argc, char* argv[])
 		num_threads = cpu.NumHWThreads();
 	}
 
+	DistanceFieldAlgorithm algorithm;
+	if (algorithm_name == "aa")
+	{
+		algorithm = DistanceFieldAlgorithm::AAEuclidean;
+	}
+	else if (algorithm_name == "edt")
+	{
+		algorithm = DistanceFieldAlgorithm::ExactEuclidean;
+	}
+	else
+	{
+		cout << "Unknown distance field algorithm " << algorithm_name << "." << endl;
+		cout << options.help() << endl;
+		return 1;
+	}
+
 	std::vector<std::pair<int32_t, int32_t>> char_index;
 	std::vector<font_info> char_info(NUM_CHARS);
 	std::vector<float> char_dist_data;
@@ -593,7 +614,7 @@ int main(int argc, char* argv[])
 				for (size_t i = 0; i < char_info.size(); ++ i)
 				{
 					wchar_t ch = static_cast<wchar_t>(i);
-					std::pair<int32_t, uint32_t> const & offset_adv = kfont_input.CharIndexAdvance(ch);
+					std::pair<int32_t, uint32_t> const offset_adv = kfont_input.CharIndexAdvance(ch);
 					if (offset_adv.first != -1)
 					{
 						BOOST_ASSERT(offset_adv.first == static_cast<int32_t>(char_index.size()));
@@ -669,7 +690,7 @@ int main(int argc, char* argv[])
 	timer_stage.restart();
 	cout << "Compute distance field..." << endl;
 	compute_distance(char_info, char_dist_data, min_value, max_value, 
-		num_threads, ttf, start_code, end_code, internal_char_size, header.char_size);
+		num_threads, ttf, start_code, end_code, internal_char_size, header.char_size, algorithm);
 	cout << "\rTime elapsed: " << timer_stage.elapsed() << " s                                        " << endl;
 
 	timer_stage.restart();
@@ -727,7 +748,8 @@ int main(int argc, char* argv[])
 
 		if (!advance.empty())
 		{
-			unordered_map<int32_t, std::pair<int32_t, uint32_t>> char_index_advance;
+			// Sorted, so the chars are appended to the font
+			std::map<int32_t, std::pair<int32_t, uint32_t>> char_index_advance;
 			for (size_t i = 0; i < advance.size(); ++ i)
 			{
 				char_index_advance.emplace(advance[i].first, std::make_pair(-1, (advance[i].second.second << 16) + advance[i].second.first));
@@ -32,16 +32,26 @@
 #include <KFL/ErrorHandling.hpp>
 #include <KFL/Hash.hpp>
 #include <KFL/StringUtil.hpp>
+#include <KFL/Timer.hpp>
 #include <KFL/Util.hpp>
+#include <KlayGE/Context.hpp>
 #include <KlayGE/JudaTexture.hpp>
 #include <KlayGE/RenderDeviceCaps.hpp>
 #include <KlayGE/ResLoader.hpp>
 #include <KFL/CXX17/filesystem.hpp>
 
-#include <iostream>
+#include <algorithm>
+#include <atomic>
 #include <fstream>
-#include <vector>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <map>
+#include <mutex>
 #include <regex>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 #include <nonstd/scope.hpp>
 
@@ -127,11 +137,236 @@ MeshMetadata LoadMeshMetadata(std::string const & res_name, MeshMetadata const &
 	}
 }
 
-void Deploy(std::vector<std::string> const& res_names, std::string_view res_type, RenderDeviceCaps const& caps, std::string_view platform,
-	std::string_view dest_folder)
+// Bump these when a converter's output changes, so assets deployed by an older one are converted again
+uint32_t const TEXTURE_CONVERTER_VERSION = 1;
+uint32_t const MODEL_CONVERTER_VERSION = 1;
+uint32_t const HDR_COMPRESSOR_VERSION = 1;
+
+// Maps the deployed files to the hash of everything they are built from
+class DeployManifest
+{
+public:
+	explicit DeployManifest(std::string manifest_name)
+		: manifest_name_(std::move(manifest_name))
+	{
+		std::ifstream ifs(manifest_name_);
+		size_t hash;
+		std::string output_name;
+		while (ifs >> std::hex >> hash)
+		{
+			ifs.get();
+			if (std::getline(ifs, output_name))
+			{
+				entries_[output_name] = hash;
+			}
+		}
+	}
+
+	bool UpToDate(std::span<std::string const> output_names, size_t hash) const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (auto const& output_name : output_names)
+		{
+			auto iter = entries_.find(output_name);
+			if ((iter == entries_.end()) || (iter->second != hash) || !FILESYSTEM_NS::exists(output_name))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void Update(std::span<std::string const> output_names, size_t hash)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (auto const& output_name : output_names)
+		{
+			entries_[output_name] = hash;
+		}
+	}
+
+	void Save() const
+	{
+		// Written aside and renamed, so an interrupted deployment never leaves a half-written manifest behind
+		std::string const tmp_name = manifest_name_ + ".tmp";
+		{
+			std::ofstream ofs(tmp_name);
+			for (auto const& entry : entries_)
+			{
+				ofs << std::hex << entry.second << ' ' << entry.first << '\n';
+			}
+		}
+
+		std::error_code ec;
+		FILESYSTEM_NS::rename(tmp_name, manifest_name_, ec);
+	}
+
+private:
+	std::string manifest_name_;
+	std::map<std::string, size_t> entries_;
+	mutable std::mutex mutex_;
+};
+
+struct DeployJob
+{
+	std::string res_name;
+	std::string_view res_type;
+
+	// Empty for jobs whose tool decides by itself if it's up to date
+	std::vector<std::string> output_names;
+	size_t hash = 0;
+
+	std::function<bool()> convert;
+
+	bool skipped = false;
+	bool succeeded = false;
+	double seconds = 0;
+};
+
+void HashResource(size_t& seed, std::string const& res_name)
+{
+	ResIdentifierPtr res = ResLoader::Instance().Open(res_name);
+	if (res)
+	{
+		res->seekg(0, std::ios_base::end);
+		std::string content(static_cast<size_t>(res->tellg()), '\0');
+		res->seekg(0, std::ios_base::beg);
+		res->read(content.data(), content.size());
+		HashCombine(seed, HashValue(content));
+	}
+	HashCombine(seed, HashValue(res_name));
+}
+
+std::string OutputName(std::string const& res_name, std::string_view dest_folder, std::string_view extension)
+{
+	FILESYSTEM_NS::path res_path(res_name);
+	if (!dest_folder.empty())
+	{
+		res_path = FILESYSTEM_NS::path(dest_folder.begin(), dest_folder.end()) / res_path.filename();
+	}
+	return res_path.string() + std::string(extension);
+}
+
+void RunDeployJobs(std::vector<DeployJob>& jobs, DeployManifest& manifest, bool force, uint32_t num_threads)
+{
+	std::mutex output_mutex;
+	std::atomic<size_t> next_job(0);
+	auto worker = [&] {
+		for (;;)
+		{
+			size_t const index = next_job.fetch_add(1);
+			if (index >= jobs.size())
+			{
+				break;
+			}
+
+			auto& job = jobs[index];
+			bool const tracked = !job.output_names.empty();
+			if (!force && tracked && manifest.UpToDate(job.output_names, job.hash))
+			{
+				job.skipped = true;
+				job.succeeded = true;
+
+				std::lock_guard<std::mutex> lock(output_mutex);
+				std::cout << job.res_name << " is up to date" << std::endl;
+				continue;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(output_mutex);
+				std::cout << "Converting " << job.res_name << " to " << job.res_type << std::endl;
+			}
+
+			Timer timer;
+			job.succeeded = job.convert();
+			job.seconds = timer.elapsed();
+			if (job.succeeded && tracked)
+			{
+				manifest.Update(job.output_names, job.hash);
+			}
+
+			std::lock_guard<std::mutex> lock(output_mutex);
+			if (job.succeeded)
+			{
+				std::cout << "Converted " << job.res_name << " in " << job.seconds << " s" << std::endl;
+			}
+			else
+			{
+				std::cout << "Failed to convert " << job.res_name << std::endl;
+			}
+		}
+	};
+
+	num_threads = std::max(std::min(num_threads, static_cast<uint32_t>(jobs.size())), 1U);
+	auto& thread_pool = Context::Instance().ThreadPoolInstance();
+	std::vector<std::future<void>> joiners;
+	joiners.reserve(num_threads - 1);
+	for (uint32_t i = 1; i < num_threads; ++ i)
+	{
+		joiners.push_back(thread_pool.QueueThread(worker));
+	}
+	worker();
+	for (auto& joiner : joiners)
+	{
+		joiner.get();
+	}
+
+	manifest.Save();
+}
+
+void ReportDeployJobs(std::vector<DeployJob> const& jobs, double wall_seconds)
+{
+	std::vector<DeployJob const*> converted;
+	uint32_t num_skipped = 0;
+	uint32_t num_failed = 0;
+	double total_seconds = 0;
+	for (auto const& job : jobs)
+	{
+		if (job.skipped)
+		{
+			++ num_skipped;
+		}
+		else
+		{
+			converted.push_back(&job);
+			total_seconds += job.seconds;
+			if (!job.succeeded)
+			{
+				++ num_failed;
+			}
+		}
+	}
+
+	std::sort(converted.begin(), converted.end(), [](DeployJob const* lhs, DeployJob const* rhs) { return lhs->seconds > rhs->seconds; });
+
+	std::cout << std::endl << "Converted " << converted.size() << " asset(s) (" << num_failed << " failed), " << num_skipped
+		<< " up to date, in " << wall_seconds << " s (" << total_seconds << " s of conversion)" << std::endl;
+	for (auto const* job : converted)
+	{
+		std::cout << "  " << job->seconds << " s\t" << job->res_name << (job->succeeded ? "" : " (failed)") << std::endl;
+	}
+}
+
+bool Deploy(std::vector<std::string> const& res_names, std::string_view res_type, RenderDeviceCaps const& caps, std::string_view platform,
+	std::string_view dest_folder, bool force, uint32_t num_threads)
 {
 	size_t const res_type_hash = HashValue(std::move(res_type));
 
+	// Everything but the source that affects the outputs
+	size_t platform_hash = 0;
+	HashCombine(platform_hash, res_type_hash);
+	HashCombine(platform_hash, HashValue(platform));
+	HashResource(platform_hash, std::string(platform) + ".plat");
+
+	std::vector<DeployJob> jobs(res_names.size());
+	for (size_t i = 0; i < res_names.size(); ++ i)
+	{
+		jobs[i].res_name = res_names[i];
+		jobs[i].res_type = res_type;
+		jobs[i].hash = platform_hash;
+		HashResource(jobs[i].hash, res_names[i]);
+	}
+
 	if ((CT_HASH("albedo") == res_type_hash)
 		|| (CT_HASH("emissive") == res_type_hash)
 		|| (CT_HASH("glossiness") == res_type_hash)
@@ -142,142 +377,154 @@ void Deploy(std::vector<std::string> const& res_names, std::string_view res_type
 	{
 		TexMetadata const default_metadata = DefaultTextureMetadata(res_type_hash, caps);
 
-		TexConverter tc;
-		for (size_t i = 0; i < res_names.size(); ++ i)
+		for (auto& job : jobs)
 		{
-			std::string_view real_res_type;
-			auto metadata = LoadTextureMetadata(res_names[i], default_metadata);
+			job.output_names.push_back(OutputName(job.res_name, dest_folder, ".dds"));
+			HashCombine(job.hash, TEXTURE_CONVERTER_VERSION);
+			HashResource(job.hash, job.res_name + ".kmeta");
+
+			// The slot decides the real type, which is reported before the conversion starts
+			auto metadata = LoadTextureMetadata(job.res_name, default_metadata);
 			switch (metadata.Slot())
 			{
 			case RenderMaterial::TS_Albedo:
-				real_res_type = "albedo";
+				job.res_type = "albedo";
 				break;
 			case RenderMaterial::TS_MetalnessGlossiness:
-				real_res_type = "metalness & glossiness";
+				job.res_type = "metalness & glossiness";
 				break;
 			case RenderMaterial::TS_Emissive:
-				real_res_type = "emissive";
+				job.res_type = "emissive";
 				break;
 			case RenderMaterial::TS_Normal:
-				real_res_type = "normal";
+				job.res_type = "normal";
 				break;
 			case RenderMaterial::TS_Height:
-				real_res_type = "height";
+				job.res_type = "height";
 				break;
 			case RenderMaterial::TS_Occlusion:
-				real_res_type = "occlusion";
+				job.res_type = "occlusion";
 				break;
 
 			default:
 				KFL_UNREACHABLE("Invalid texture slot");
 			}
 
-			std::cout << "Converting " << res_names[i] << " to " << real_res_type << std::endl;
-
-			auto output_tex = tc.Load(metadata);
-			if (output_tex)
-			{
-				FILESYSTEM_NS::path res_path(res_names[i]);
-				if (!dest_folder.empty())
+			job.convert = [&job, metadata = std::move(metadata)] {
+				TexConverter tc;
+				auto output_tex = tc.Load(metadata);
+				if (output_tex)
 				{
-					res_path = FILESYSTEM_NS::path(dest_folder.begin(), dest_folder.end()) / res_path.filename();
+					SaveTexture(output_tex, job.output_names[0]);
 				}
-				SaveTexture(output_tex, res_path.string() + ".dds");
-			}
+				return output_tex != nullptr;
+			};
 		}
 	}
 	else if (CT_HASH("model") == res_type_hash)
 	{
 		MeshMetadata const default_metadata;
 
-		MeshConverter mc;
-		for (size_t i = 0; i < res_names.size(); ++ i)
+		for (auto& job : jobs)
 		{
-			std::cout << "Converting " << res_names[i] << " to " << res_type << std::endl;
+			job.output_names.push_back(OutputName(job.res_name, dest_folder, ".model_bin"));
+			HashCombine(job.hash, MODEL_CONVERTER_VERSION);
+			HashResource(job.hash, job.res_name + ".kmeta");
 
-			auto metadata = LoadMeshMetadata(res_names[i], default_metadata);
-			auto output_model = mc.Load(metadata);
-			if (output_model)
+			// LoD sources are converted and materials are embedded, so editing them changes the output too
+			auto const metadata = LoadMeshMetadata(job.res_name, default_metadata);
+			for (uint32_t lod = 1; lod < metadata.NumLods(); ++ lod)
+			{
+				HashResource(job.hash, std::string(metadata.LodFileName(lod)));
+			}
+			for (uint32_t i = 0; i < metadata.NumMaterials(); ++ i)
 			{
-				FILESYSTEM_NS::path res_path(res_names[i]);
-				if (!dest_folder.empty())
+				std::string_view const mtlml_name = metadata.MaterialFileName(i);
+				if (!mtlml_name.empty())
 				{
-					res_path = FILESYSTEM_NS::path(dest_folder.begin(), dest_folder.end()) / res_path.filename();
+					HashResource(job.hash, std::string(mtlml_name));
 				}
-				SaveModel(*output_model, res_path.string() + ".model_bin");
 			}
+
+			job.convert = [&job, metadata] {
+				MeshConverter mc;
+				auto output_model = mc.Load(metadata);
+				if (output_model)
+				{
+					SaveModel(*output_model, job.output_names[0]);
+				}
+				return output_model != nullptr;
+			};
 		}
 	}
-	else
+	else if (CT_HASH("cubemap") == res_type_hash)
 	{
-		std::ofstream ofs("convert.bat");
-
-		if (CT_HASH("cubemap") == res_type_hash)
+		std::string y_fmt;
+		std::string c_fmt;
+		if (caps.BestMatchTextureFormat(MakeSpan({EF_R16, EF_R16F})) == EF_R16)
 		{
-			std::string y_fmt;
-			std::string c_fmt;
-			if (caps.BestMatchTextureFormat(MakeSpan({EF_R16, EF_R16F})) == EF_R16)
-			{
-				y_fmt = "R16";
-			}
-			else
-			{
-				y_fmt = "R16F";
-			}
-			if (caps.BestMatchTextureFormat(MakeSpan({EF_BC5, EF_BC3})) == EF_BC5)
-			{
-				c_fmt = "BC5";
-			}
-			else
-			{
-				c_fmt = "BC3";
-			}
+			y_fmt = "R16";
+		}
+		else
+		{
+			y_fmt = "R16F";
+		}
+		if (caps.BestMatchTextureFormat(MakeSpan({EF_BC5, EF_BC3})) == EF_BC5)
+		{
+			c_fmt = "BC5";
+		}
+		else
+		{
+			c_fmt = "BC3";
+		}
 
-			for (size_t i = 0; i < res_names.size(); ++ i)
+		for (auto& job : jobs)
+		{
+			FILESYSTEM_NS::path const res_path(job.res_name);
+			FILESYSTEM_NS::path const output_folder =
+				dest_folder.empty() ? res_path.parent_path() : FILESYSTEM_NS::path(dest_folder.begin(), dest_folder.end());
+			std::string const base_name = (output_folder / res_path.stem()).string();
+			job.output_names.push_back(base_name + "_y" + res_path.extension().string());
+			job.output_names.push_back(base_name + "_c" + res_path.extension().string());
+			HashCombine(job.hash, HDR_COMPRESSOR_VERSION);
+
+			std::ostringstream ss;
+			ss << "HDRCompressor \"" << job.res_name << "\" " << y_fmt << ' ' << c_fmt;
+			if (!dest_folder.empty())
 			{
-				std::cout << "Converting " << res_names[i] << " to " << res_type << std::endl;
-
-				ofs << "@echo Processing: " << res_names[i] << std::endl;
-
-				ofs << "@echo off" << std::endl << std::endl;
-				ofs << "HDRCompressor \"" << res_names[i] << "\" " << y_fmt << ' ' << c_fmt;
-				if (!dest_folder.empty())
-				{
-					ofs << " \"" << dest_folder << "\"";
-				}
-				ofs << std::endl;
-				ofs << "@echo on" << std::endl << std::endl;
+				ss << " \"" << dest_folder << "\"";
 			}
+			job.convert = [command = ss.str()] { return system(command.c_str()) == 0; };
 		}
-		else if (CT_HASH("effect") == res_type_hash)
+	}
+	else if (CT_HASH("effect") == res_type_hash)
+	{
+		// FxmlJit follows the includes and checks the platform itself, so effects don't go in the manifest
+		for (auto& job : jobs)
 		{
-			for (size_t i = 0; i < res_names.size(); ++ i)
+			std::ostringstream ss;
+			ss << "FxmlJit -P " << platform << " -I \"" << job.res_name << "\"";
+			if (!dest_folder.empty())
 			{
-				std::cout << "Converting " << res_names[i] << " to " << res_type << std::endl;
-
-				ofs << "@echo Processing: " << res_names[i] << std::endl;
-
-				ofs << "@echo off" << std::endl << std::endl;
-				ofs << "FxmlJit -P " << platform << " -I \"" << res_names[i] << "\"";
-				if (!dest_folder.empty())
-				{
-					ofs << " -D \"" << dest_folder << "\"";
-				}
-				ofs << std::endl;
-				ofs << "@echo on" << std::endl << std::endl;
+				ss << " -D \"" << dest_folder << "\"";
 			}
+			job.convert = [command = ss.str()] { return system(command.c_str()) == 0; };
 		}
-		else
-		{
-			std::cout << "Error: Unknown resource type." << std::endl;
-		}
+	}
+	else
+	{
+		std::cout << "Error: Unknown resource type." << std::endl;
+		return false;
+	}
 
-		ofs.close();
+	FILESYSTEM_NS::path const manifest_folder(dest_folder.begin(), dest_folder.end());
+	DeployManifest manifest((manifest_folder / "PlatformDeployer.manifest").string());
 
-		int err = system("convert.bat");
-		err = system("del convert.bat");
-		KFL_UNUSED(err);
-	}
+	Timer timer;
+	RunDeployJobs(jobs, manifest, force, num_threads);
+	ReportDeployJobs(jobs, timer.elapsed());
+
+	return std::all_of(jobs.begin(), jobs.end(), [](DeployJob const& job) { return job.succeeded; });
 }
 
 int main(int argc, char* argv[])
@@ -288,6 +535,7 @@ int main(int argc, char* argv[])
 	std::string res_type;
 	std::string platform;
 	std::string dest_folder;
+	uint32_t num_threads;
 
 	cxxopts::Options options("PlatformDeployer", "KlayGE PlatformDeployer");
 	// clang-format off
@@ -297,6 +545,9 @@ int main(int argc, char* argv[])
 		("T,type", "Resource type (auto by default).", cxxopts::value<std::string>())
 		("P,platform", "Platform name.", cxxopts::value<std::string>())
 		("D,dest-folder", "Destination folder.", cxxopts::value<std::string>())
+		("j,jobs", "Number of assets converted concurrently (number of hardware threads by default).",
+			cxxopts::value<uint32_t>(num_threads)->default_value(std::to_string(std::max(std::thread::hardware_concurrency(), 1U))))
+		("F,force", "Convert all assets, even those unchanged since the last deployment.")
 		("v,version", "Version.");
 	// clang-format on
 
@@ -310,7 +561,7 @@ int main(int argc, char* argv[])
 	}
 	if (vm.count("version") > 0)
 	{
-		cout << "KlayGE PlatformDeployer, Version 2.0.0" << endl;
+		cout << "KlayGE PlatformDeployer, Version 2.1.0" << endl;
 		return 1;
 	}
 	if (vm.count("dest-folder") > 0)
@@ -491,7 +742,10 @@ int main(int argc, char* argv[])
 	}
 
 	PlatformDefinition platform_def(platform + ".plat");
-	Deploy(res_names, res_type, platform_def.device_caps, platform, dest_folder);
+	if (!Deploy(res_names, res_type, platform_def.device_caps, platform, dest_folder, vm.count("force") > 0, num_threads))
+	{
+		return 1;
+	}
 
 	return 0;
 }
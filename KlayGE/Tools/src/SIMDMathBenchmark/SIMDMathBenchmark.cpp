@@ -0,0 +1,531 @@
+/**
+ * @file SIMDMathBenchmark.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KFL/KFL.hpp>
+#include <KFL/AABBox.hpp>
+#include <KFL/Frustum.hpp>
+#include <KFL/Math.hpp>
+#include <KFL/SIMDMath.hpp>
+#include <KFL/Timer.hpp>
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifndef KLAYGE_DEBUG
+#define CXXOPTS_NO_RTTI
+#endif
+#include <cxxopts.hpp>
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	// Scalar references, the same code as MathLib before it dispatched to SIMDMathLib
+
+	float4x4 ScalarMul(float4x4 const & lhs, float4x4 const & rhs)
+	{
+		float4x4 ret;
+		for (int r = 0; r < 4; ++ r)
+		{
+			for (int c = 0; c < 4; ++ c)
+			{
+				ret(r, c) = lhs(r, 0) * rhs(0, c) + lhs(r, 1) * rhs(1, c) + lhs(r, 2) * rhs(2, c) + lhs(r, 3) * rhs(3, c);
+			}
+		}
+		return ret;
+	}
+
+	float4x4 ScalarInverse(float4x4 const & rhs)
+	{
+		float const * m = rhs.data();
+
+		float const _2132_2231(m[4] * m[9] - m[5] * m[8]);
+		float const _2133_2331(m[4] * m[10] - m[6] * m[8]);
+		float const _2134_2431(m[4] * m[11] - m[7] * m[8]);
+		float const _2142_2241(m[4] * m[13] - m[5] * m[12]);
+		float const _2143_2341(m[4] * m[14] - m[6] * m[12]);
+		float const _2144_2441(m[4] * m[15] - m[7] * m[12]);
+		float const _2233_2332(m[5] * m[10] - m[6] * m[9]);
+		float const _2234_2432(m[5] * m[11] - m[7] * m[9]);
+		float const _2243_2342(m[5] * m[14] - m[6] * m[13]);
+		float const _2244_2442(m[5] * m[15] - m[7] * m[13]);
+		float const _2334_2433(m[6] * m[11] - m[7] * m[10]);
+		float const _2344_2443(m[6] * m[15] - m[7] * m[14]);
+		float const _3142_3241(m[8] * m[13] - m[9] * m[12]);
+		float const _3143_3341(m[8] * m[14] - m[10] * m[12]);
+		float const _3144_3441(m[8] * m[15] - m[11] * m[12]);
+		float const _3243_3342(m[9] * m[14] - m[10] * m[13]);
+		float const _3244_3442(m[9] * m[15] - m[11] * m[13]);
+		float const _3344_3443(m[10] * m[15] - m[11] * m[14]);
+
+		float const det = m[0] * (m[5] * _3344_3443 - m[6] * _3244_3442 + m[7] * _3243_3342)
+			- m[1] * (m[4] * _3344_3443 - m[6] * _3144_3441 + m[7] * _3143_3341)
+			+ m[2] * (m[4] * _3244_3442 - m[5] * _3144_3441 + m[7] * _3142_3241)
+			- m[3] * (m[4] * _3243_3342 - m[5] * _3143_3341 + m[6] * _3142_3241);
+		if (MathLib::equal(det, 0.0f))
+		{
+			return rhs;
+		}
+
+		float const inv_det = 1 / det;
+		return float4x4(
+			+inv_det * (m[5] * _3344_3443 - m[6] * _3244_3442 + m[7] * _3243_3342),
+			-inv_det * (m[1] * _3344_3443 - m[2] * _3244_3442 + m[3] * _3243_3342),
+			+inv_det * (m[1] * _2344_2443 - m[2] * _2244_2442 + m[3] * _2243_2342),
+			-inv_det * (m[1] * _2334_2433 - m[2] * _2234_2432 + m[3] * _2233_2332),
+
+			-inv_det * (m[4] * _3344_3443 - m[6] * _3144_3441 + m[7] * _3143_3341),
+			+inv_det * (m[0] * _3344_3443 - m[2] * _3144_3441 + m[3] * _3143_3341),
+			-inv_det * (m[0] * _2344_2443 - m[2] * _2144_2441 + m[3] * _2143_2341),
+			+inv_det * (m[0] * _2334_2433 - m[2] * _2134_2431 + m[3] * _2133_2331),
+
+			+inv_det * (m[4] * _3244_3442 - m[5] * _3144_3441 + m[7] * _3142_3241),
+			-inv_det * (m[0] * _3244_3442 - m[1] * _3144_3441 + m[3] * _3142_3241),
+			+inv_det * (m[0] * _2244_2442 - m[1] * _2144_2441 + m[3] * _2142_2241),
+			-inv_det * (m[0] * _2234_2432 - m[1] * _2134_2431 + m[3] * _2132_2231),
+
+			-inv_det * (m[4] * _3243_3342 - m[5] * _3143_3341 + m[6] * _3142_3241),
+			+inv_det * (m[0] * _3243_3342 - m[1] * _3143_3341 + m[2] * _3142_3241),
+			-inv_det * (m[0] * _2243_2342 - m[1] * _2143_2341 + m[2] * _2142_2241),
+			+inv_det * (m[0] * _2233_2332 - m[1] * _2133_2331 + m[2] * _2132_2231));
+	}
+
+	AABBox ScalarTransformAABB(AABBox const & aabb, float4x4 const & mat)
+	{
+		float3 min, max;
+		min = max = MathLib::transform_coord(aabb.Corner(0), mat);
+		for (size_t j = 1; j < 8; ++ j)
+		{
+			float3 const vec = MathLib::transform_coord(aabb.Corner(j), mat);
+			min = MathLib::minimize(min, vec);
+			max = MathLib::maximize(max, vec);
+		}
+		return AABBox(min, max);
+	}
+
+	BoundOverlap ScalarIntersectAABBFrustum(AABBox const & aabb, Frustum const & frustum)
+	{
+		float3 const & min_pt = aabb.Min();
+		float3 const & max_pt = aabb.Max();
+
+		bool intersect = false;
+		for (uint32_t i = 0; i < 6; ++ i)
+		{
+			Plane const & plane = frustum.FrustumPlane(i);
+
+			float3 const v0((plane.a() < 0) ? min_pt.x() : max_pt.x(), (plane.b() < 0) ? min_pt.y() : max_pt.y(),
+				(plane.c() < 0) ? min_pt.z() : max_pt.z());
+			float3 const v1((plane.a() < 0) ? max_pt.x() : min_pt.x(), (plane.b() < 0) ? max_pt.y() : min_pt.y(),
+				(plane.c() < 0) ? max_pt.z() : min_pt.z());
+
+			if (MathLib::dot_coord(plane, v0) < 0)
+			{
+				return BoundOverlap::No;
+			}
+			if (MathLib::dot_coord(plane, v1) < 0)
+			{
+				intersect = true;
+			}
+		}
+
+		return intersect ? BoundOverlap::Partial : BoundOverlap::Yes;
+	}
+
+	float4 ScalarTransform(float4 const & v, float4x4 const & mat)
+	{
+		float4 ret;
+		for (int c = 0; c < 4; ++ c)
+		{
+			ret[c] = v.x() * mat(0, c) + v.y() * mat(1, c) + v.z() * mat(2, c) + v.w() * mat(3, c);
+		}
+		return ret;
+	}
+
+	Quaternion ScalarMulQuat(Quaternion const & lhs, Quaternion const & rhs)
+	{
+		return Quaternion(
+			lhs.x() * rhs.w() - lhs.y() * rhs.z() + lhs.z() * rhs.y() + lhs.w() * rhs.x(),
+			lhs.x() * rhs.z() + lhs.y() * rhs.w() - lhs.z() * rhs.x() + lhs.w() * rhs.y(),
+			lhs.y() * rhs.x() - lhs.x() * rhs.y() + lhs.z() * rhs.w() + lhs.w() * rhs.z(),
+			lhs.w() * rhs.w() - lhs.x() * rhs.x() - lhs.y() * rhs.y() - lhs.z() * rhs.z());
+	}
+
+	float MaxRelativeError(float const * lhs, float const * rhs, size_t num)
+	{
+		float ret = 0;
+		for (size_t i = 0; i < num; ++ i)
+		{
+			ret = std::max(ret, std::abs(lhs[i] - rhs[i]) / std::max(1.0f, std::abs(lhs[i])));
+		}
+		return ret;
+	}
+
+	class Reporter
+	{
+	public:
+		explicit Reporter(uint32_t num_iterations)
+			: num_iterations_(num_iterations)
+		{
+			cout << left << setw(20) << "Kernel" << right << setw(14) << "Scalar (ms)" << setw(14) << "SIMD (ms)" << setw(10)
+				 << "Speedup" << setw(14) << "Max error" << endl;
+		}
+
+		// Returns false if the SIMD results diverge from the scalar ones
+		bool Report(char const * name, double scalar_time, double simd_time, float max_error, float tolerance)
+		{
+			scalar_time = scalar_time * 1000 / num_iterations_;
+			simd_time = simd_time * 1000 / num_iterations_;
+			cout << left << setw(20) << name << right << fixed << setprecision(3) << setw(14) << scalar_time << setw(14) << simd_time
+				 << setw(9) << scalar_time / simd_time << "x" << scientific << setprecision(2) << setw(14) << max_error
+				 << defaultfloat << endl;
+			return max_error <= tolerance;
+		}
+
+	private:
+		uint32_t num_iterations_;
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t num_items;
+	uint32_t num_iterations;
+
+	cxxopts::Options options("SIMDMathBenchmark", "KlayGE SIMD math benchmark");
+	// clang-format off
+	options.add_options()
+		("H,help", "Produce help message.")
+		("n,items", "Number of items per kernel.", cxxopts::value<uint32_t>(num_items)->default_value("4096"))
+		("i,iterations", "Number of iterations.", cxxopts::value<uint32_t>(num_iterations)->default_value("200"))
+		("v,version", "Version.");
+	// clang-format on
+
+	auto vm = options.parse(argc, argv);
+
+	if (vm.count("help") > 0)
+	{
+		cout << options.help() << endl;
+		return 1;
+	}
+	if (vm.count("version") > 0)
+	{
+		cout << "KlayGE SIMD math benchmark, Version 1.0.0" << endl;
+		return 1;
+	}
+	if ((num_items == 0) || (num_iterations == 0))
+	{
+		cout << "Need at least one item and one iteration." << endl;
+		return 1;
+	}
+
+	std::ranlux24_base gen(0);
+	std::uniform_real_distribution<float> pos_dist(-100, 100);
+	std::uniform_real_distribution<float> scale_dist(0.5f, 4);
+	std::uniform_real_distribution<float> angle_dist(-PI, PI);
+
+	std::vector<float4x4> mats(num_items);
+	std::vector<AABBox> aabbs(num_items);
+	std::vector<Quaternion> quats(num_items);
+	for (uint32_t i = 0; i < num_items; ++ i)
+	{
+		mats[i] = MathLib::scaling(scale_dist(gen), scale_dist(gen), scale_dist(gen))
+			* MathLib::rotation_matrix_yaw_pitch_roll(angle_dist(gen), angle_dist(gen), angle_dist(gen))
+			* MathLib::translation(pos_dist(gen), pos_dist(gen), pos_dist(gen));
+
+		float3 const center(pos_dist(gen), pos_dist(gen), pos_dist(gen));
+		float3 const half_size(scale_dist(gen), scale_dist(gen), scale_dist(gen));
+		aabbs[i] = AABBox(center - half_size, center + half_size);
+
+		quats[i] = MathLib::rotation_quat_yaw_pitch_roll(angle_dist(gen), angle_dist(gen), angle_dist(gen));
+	}
+
+	float4x4 const view_proj = MathLib::look_at_lh(float3(0, 0, -150), float3(0, 0, 0), float3(0, 1, 0))
+		* MathLib::perspective_fov_lh(PI / 4, 1.0f, 1.0f, 300.0f);
+	Frustum frustum;
+	frustum.ClipMatrix(view_proj, MathLib::inverse(view_proj));
+
+	Reporter reporter(num_iterations);
+	bool all_match = true;
+	Timer timer;
+
+	{
+		std::vector<float4x4> scalar_results(num_items);
+		std::vector<float4x4> simd_results(num_items);
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			for (uint32_t i = 0; i < num_items; ++ i)
+			{
+				scalar_results[i] = ScalarMul(mats[i], mats[num_items - 1 - i]);
+			}
+		}
+		double const scalar_time = timer.elapsed();
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			for (uint32_t i = 0; i < num_items; ++ i)
+			{
+				simd_results[i] = MathLib::mul(mats[i], mats[num_items - 1 - i]);
+			}
+		}
+		double const simd_time = timer.elapsed();
+
+		all_match &= reporter.Report("Matrix multiply", scalar_time, simd_time,
+			MaxRelativeError(scalar_results[0].data(), simd_results[0].data(), num_items * 16), 1e-5f);
+	}
+	{
+		std::vector<float4x4> scalar_results(num_items);
+		std::vector<float4x4> simd_results(num_items);
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			for (uint32_t i = 0; i < num_items; ++ i)
+			{
+				scalar_results[i] = ScalarInverse(mats[i]);
+			}
+		}
+		double const scalar_time = timer.elapsed();
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			for (uint32_t i = 0; i < num_items; ++ i)
+			{
+				simd_results[i] = MathLib::inverse(mats[i]);
+			}
+		}
+		double const simd_time = timer.elapsed();
+
+		all_match &= reporter.Report("Matrix inverse", scalar_time, simd_time,
+			MaxRelativeError(scalar_results[0].data(), simd_results[0].data(), num_items * 16), 1e-4f);
+	}
+	{
+		std::vector<AABBox> scalar_results(num_items);
+		std::vector<AABBox> simd_results(num_items);
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			for (uint32_t i = 0; i < num_items; ++ i)
+			{
+				scalar_results[i] = ScalarTransformAABB(aabbs[i], mats[i]);
+			}
+		}
+		double const scalar_time = timer.elapsed();
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			for (uint32_t i = 0; i < num_items; ++ i)
+			{
+				simd_results[i] = MathLib::transform_aabb(aabbs[i], mats[i]);
+			}
+		}
+		double const simd_time = timer.elapsed();
+
+		float max_error = 0;
+		for (uint32_t i = 0; i < num_items; ++ i)
+		{
+			max_error = std::max(max_error, MaxRelativeError(&scalar_results[i].Min()[0], &simd_results[i].Min()[0], 3));
+			max_error = std::max(max_error, MaxRelativeError(&scalar_results[i].Max()[0], &simd_results[i].Max()[0], 3));
+		}
+		all_match &= reporter.Report("Transform AABB", scalar_time, simd_time, max_error, 1e-5f);
+	}
+	{
+		std::vector<BoundOverlap> scalar_results(num_items);
+		std::vector<BoundOverlap> simd_results(num_items);
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			for (uint32_t i = 0; i < num_items; ++ i)
+			{
+				scalar_results[i] = ScalarIntersectAABBFrustum(aabbs[i], frustum);
+			}
+		}
+		double const scalar_time = timer.elapsed();
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			for (uint32_t i = 0; i < num_items; ++ i)
+			{
+				simd_results[i] = MathLib::intersect_aabb_frustum(aabbs[i], frustum);
+			}
+		}
+		double const simd_time = timer.elapsed();
+
+		uint32_t num_mismatches = 0;
+		for (uint32_t i = 0; i < num_items; ++ i)
+		{
+			if (scalar_results[i] != simd_results[i])
+			{
+				++ num_mismatches;
+			}
+		}
+		all_match &= reporter.Report("AABB vs frustum", scalar_time, simd_time, static_cast<float>(num_mismatches), 0);
+	}
+	{
+		// Quaternions stay in SIMD registers across the products, as in a SIMD skinning loop
+		std::vector<SIMDVectorF4> simd_quats(num_items);
+		for (uint32_t i = 0; i < num_items; ++ i)
+		{
+			simd_quats[i] = SIMDMathLib::LoadQuaternion(quats[i]);
+		}
+
+		std::vector<Quaternion> scalar_results(num_items);
+		std::vector<SIMDVectorF4> simd_results(num_items);
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			for (uint32_t i = 0; i < num_items; ++ i)
+			{
+				uint32_t const j = num_items - 1 - i;
+				scalar_results[i] = ScalarMulQuat(quats[i], quats[j]) + ScalarMulQuat(quats[j], quats[i]);
+			}
+		}
+		double const scalar_time = timer.elapsed();
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			for (uint32_t i = 0; i < num_items; ++ i)
+			{
+				uint32_t const j = num_items - 1 - i;
+				simd_results[i] = SIMDMathLib::MultiplyQuat(simd_quats[i], simd_quats[j])
+					+ SIMDMathLib::MultiplyQuat(simd_quats[j], simd_quats[i]);
+			}
+		}
+		double const simd_time = timer.elapsed();
+
+		float max_error = 0;
+		for (uint32_t i = 0; i < num_items; ++ i)
+		{
+			Quaternion q;
+			SIMDMathLib::StoreQuaternion(q, simd_results[i]);
+			max_error = std::max(max_error, MaxRelativeError(&scalar_results[i][0], &q[0], 4));
+		}
+		all_match &= reporter.Report("Dual quat multiply", scalar_time, simd_time, max_error, 1e-6f);
+	}
+	{
+		// Batch API, two vectors per instruction on AVX2
+		std::vector<float4> vecs(num_items);
+		std::vector<SIMDVectorF4> simd_vecs(num_items);
+		for (uint32_t i = 0; i < num_items; ++ i)
+		{
+			vecs[i] = float4(pos_dist(gen), pos_dist(gen), pos_dist(gen), 1);
+			simd_vecs[i] = SIMDMathLib::LoadVector4(&vecs[i][0]);
+		}
+		SIMDMatrixF4 const simd_view_proj = SIMDMathLib::LoadMatrix(view_proj);
+
+		std::vector<float4> scalar_results(num_items);
+		std::vector<SIMDVectorF4> simd_results(num_items);
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			for (uint32_t i = 0; i < num_items; ++ i)
+			{
+				scalar_results[i] = ScalarTransform(vecs[i], view_proj);
+			}
+		}
+		double const scalar_time = timer.elapsed();
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			SIMDMathLib::TransformVector4(simd_results, simd_vecs, simd_view_proj);
+		}
+		double const simd_time = timer.elapsed();
+
+		float max_error = 0;
+		for (uint32_t i = 0; i < num_items; ++ i)
+		{
+			float4 v;
+			SIMDMathLib::StoreVector4(v, simd_results[i]);
+			max_error = std::max(max_error, MaxRelativeError(&scalar_results[i][0], &v[0], 4));
+		}
+		all_match &= reporter.Report("Bulk transform", scalar_time, simd_time, max_error, 1e-5f);
+	}
+	{
+		// Batch API, two matrix rows per instruction on AVX2
+		std::vector<SIMDMatrixF4> simd_lhs(num_items);
+		std::vector<SIMDMatrixF4> simd_rhs(num_items);
+		for (uint32_t i = 0; i < num_items; ++ i)
+		{
+			simd_lhs[i] = SIMDMathLib::LoadMatrix(mats[i]);
+			simd_rhs[i] = SIMDMathLib::LoadMatrix(mats[num_items - 1 - i]);
+		}
+
+		std::vector<float4x4> scalar_results(num_items);
+		std::vector<SIMDMatrixF4> simd_results(num_items);
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			for (uint32_t i = 0; i < num_items; ++ i)
+			{
+				scalar_results[i] = ScalarMul(mats[i], mats[num_items - 1 - i]);
+			}
+		}
+		double const scalar_time = timer.elapsed();
+
+		timer.restart();
+		for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+		{
+			SIMDMathLib::Multiply(simd_results, simd_lhs, simd_rhs);
+		}
+		double const simd_time = timer.elapsed();
+
+		float max_error = 0;
+		for (uint32_t i = 0; i < num_items; ++ i)
+		{
+			float4x4 m;
+			SIMDMathLib::StoreMatrix(m, simd_results[i]);
+			max_error = std::max(max_error, MaxRelativeError(scalar_results[i].data(), m.data(), 16));
+		}
+		all_match &= reporter.Report("Bulk multiply", scalar_time, simd_time, max_error, 1e-5f);
+	}
+
+	if (!all_match)
+	{
+		cout << "SIMD results diverge from the scalar references." << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,303 @@
+/**
+ * @file SkinningBenchmark.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/Math.hpp>
+#include <KFL/Timer.hpp>
+#include <KlayGE/Context.hpp>
+#include <KlayGE/Mesh.hpp>
+#include <KlayGE/SceneNode.hpp>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <nonstd/scope.hpp>
+
+#ifndef KLAYGE_DEBUG
+#define CXXOPTS_NO_RTTI
+#endif
+#include <cxxopts.hpp>
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	struct JointPose
+	{
+		Quaternion real;
+		Quaternion dual;
+		float scale;
+	};
+
+	// The per-joint evaluation SkinnedModel used before the flat joint array, as the baseline. Only handles positive scales.
+	void LegacyBuildBones(SkinnedModel& model, float frame, std::vector<float4>& bind_reals, std::vector<float4>& bind_duals)
+	{
+		auto const & key_frame_sets = *model.GetKeyFrameSets();
+		for (uint32_t i = 0; i < model.NumJoints(); ++ i)
+		{
+			auto& joint = *model.GetJoint(i);
+			auto [key_real, key_dual, key_scale] = key_frame_sets[i].Frame(frame);
+
+			auto* parent_joint = joint.BoundSceneNode()->Parent()->FirstComponentOfType<JointComponent>();
+			if (parent_joint == nullptr)
+			{
+				joint.BindParams(key_real, key_dual, key_scale);
+			}
+			else
+			{
+				if (MathLib::dot(key_real, parent_joint->BindReal()) < 0)
+				{
+					key_real = -key_real;
+					key_dual = -key_dual;
+				}
+
+				joint.BindParams(MathLib::mul_real(key_real, parent_joint->BindReal()),
+					MathLib::mul_dual(key_real, key_dual * parent_joint->BindScale(), parent_joint->BindReal(), parent_joint->BindDual()),
+					key_scale * parent_joint->BindScale());
+			}
+		}
+
+		for (uint32_t i = 0; i < model.NumJoints(); ++ i)
+		{
+			auto const & joint = *model.GetJoint(i);
+
+			Quaternion bind_real = MathLib::mul_real(joint.InverseOriginReal(), joint.BindReal());
+			Quaternion bind_dual = MathLib::mul_dual(joint.InverseOriginReal(), joint.InverseOriginDual(), joint.BindReal(), joint.BindDual());
+			float const bind_scale = joint.InverseOriginScale() * joint.BindScale();
+			if (MathLib::SignBit(bind_real.w()) < 0)
+			{
+				bind_real = -bind_real;
+				bind_dual = -bind_dual;
+			}
+
+			bind_reals[i] = float4(bind_real.x(), bind_real.y(), bind_real.z(), bind_real.w()) * bind_scale;
+			bind_duals[i] = float4(bind_dual.x(), bind_dual.y(), bind_dual.z(), bind_dual.w());
+		}
+	}
+
+	SkinnedModelPtr CreateCharacter(uint32_t num_joints, std::shared_ptr<std::vector<KeyFrameSet>> const & kfs,
+		std::vector<int32_t> const & parents)
+	{
+		auto model = MakeSharedPtr<SkinnedModel>(L"Character", SceneNode::SOA_Cullable);
+
+		std::vector<JointComponentPtr> joints(num_joints);
+		std::vector<SceneNodePtr> nodes(num_joints);
+		for (uint32_t i = 0; i < num_joints; ++ i)
+		{
+			joints[i] = MakeSharedPtr<JointComponent>();
+			joints[i]->BindParams((*kfs)[i].bind_real[0], (*kfs)[i].bind_dual[0], (*kfs)[i].bind_scale[0]);
+			joints[i]->InitInverseOriginParams();
+
+			nodes[i] = MakeSharedPtr<SceneNode>(L"Joint", 0);
+			nodes[i]->AddComponent(joints[i]);
+			if (parents[i] < 0)
+			{
+				model->RootNode()->AddChild(nodes[i]);
+			}
+			else
+			{
+				nodes[parents[i]]->AddChild(nodes[i]);
+			}
+		}
+
+		model->AssignJoints(joints.begin(), joints.end());
+		model->AttachKeyFrameSets(kfs);
+		return model;
+	}
+
+	float RelativeError(float value, float reference)
+	{
+		return std::abs(value - reference) / std::max(1.0f, std::abs(reference));
+	}
+
+	float MaxError(SkinnedModel const & model, std::vector<JointPose> const & reference)
+	{
+		float ret = 0;
+		for (uint32_t i = 0; i < model.NumJoints(); ++ i)
+		{
+			auto const & joint = *model.GetJoint(i);
+			for (uint32_t j = 0; j < 4; ++ j)
+			{
+				ret = std::max(ret, RelativeError(joint.BindReal()[j], reference[i].real[j]));
+				ret = std::max(ret, RelativeError(joint.BindDual()[j], reference[i].dual[j]));
+			}
+			ret = std::max(ret, RelativeError(joint.BindScale(), reference[i].scale));
+		}
+		return ret;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	auto on_exit = nonstd::make_scope_exit([] { Context::Destroy(); });
+
+	uint32_t num_characters;
+	uint32_t num_joints;
+	uint32_t num_keys;
+	uint32_t num_iterations;
+
+	cxxopts::Options options("SkinningBenchmark", "KlayGE skeletal animation benchmark");
+	// clang-format off
+	options.add_options()
+		("H,help", "Produce help message.")
+		("c,characters", "Number of characters.", cxxopts::value<uint32_t>(num_characters)->default_value("500"))
+		("j,joints", "Number of joints per character.", cxxopts::value<uint32_t>(num_joints)->default_value("64"))
+		("k,keys", "Number of key frames per joint.", cxxopts::value<uint32_t>(num_keys)->default_value("30"))
+		("i,iterations", "Number of iterations.", cxxopts::value<uint32_t>(num_iterations)->default_value("20"))
+		("v,version", "Version.");
+	// clang-format on
+
+	auto vm = options.parse(argc, argv);
+
+	if (vm.count("help") > 0)
+	{
+		cout << options.help() << endl;
+		return 1;
+	}
+	if (vm.count("version") > 0)
+	{
+		cout << "KlayGE skeletal animation benchmark, Version 1.0.0" << endl;
+		return 1;
+	}
+	if ((num_characters == 0) || (num_joints == 0) || (num_keys < 2) || (num_iterations == 0))
+	{
+		cout << "Need at least one character, one joint, two key frames and one iteration." << endl;
+		return 1;
+	}
+
+	std::ranlux24_base gen(0);
+	std::uniform_real_distribution<float> angle_dist(-PI / 4, PI / 4);
+	std::uniform_real_distribution<float> pos_dist(-0.5f, 0.5f);
+
+	// All characters share the clip, as clones of one loaded model do
+	uint32_t const frames_per_key = 4;
+	uint32_t const num_frames = num_keys * frames_per_key;
+	std::vector<int32_t> parents(num_joints);
+	auto kfs = MakeSharedPtr<std::vector<KeyFrameSet>>(num_joints);
+	for (uint32_t i = 0; i < num_joints; ++ i)
+	{
+		parents[i] = (i == 0) ? -1 : static_cast<int32_t>(gen() % i);
+
+		auto& kf = (*kfs)[i];
+		for (uint32_t k = 0; k < num_keys; ++ k)
+		{
+			Quaternion const rot = MathLib::rotation_quat_yaw_pitch_roll(angle_dist(gen), angle_dist(gen), angle_dist(gen));
+			kf.frame_id.push_back(k * frames_per_key);
+			kf.bind_real.push_back(rot);
+			kf.bind_dual.push_back(MathLib::quat_trans_to_udq(rot, float3(pos_dist(gen), 1 + pos_dist(gen), pos_dist(gen))));
+			kf.bind_scale.push_back(1);
+		}
+	}
+
+	std::vector<SkinnedModelPtr> characters(num_characters);
+	std::vector<SkinnedModel*> character_ptrs(num_characters);
+	std::vector<float> start_frames(num_characters);
+	for (uint32_t i = 0; i < num_characters; ++ i)
+	{
+		characters[i] = CreateCharacter(num_joints, kfs, parents);
+		character_ptrs[i] = characters[i].get();
+		start_frames[i] = static_cast<float>(gen() % num_frames);
+	}
+
+	// Each iteration advances every character by a fraction of a frame, as a 60 FPS update of a 30 FPS clip would
+	auto frame_of = [&start_frames, num_frames](uint32_t character, uint32_t iter) {
+		return std::fmod(start_frames[character] + (iter + 1) * 0.5f, static_cast<float>(num_frames));
+	};
+
+	std::vector<float4> bind_reals(num_joints);
+	std::vector<float4> bind_duals(num_joints);
+	Timer timer;
+	for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+	{
+		for (uint32_t i = 0; i < num_characters; ++ i)
+		{
+			LegacyBuildBones(*characters[i], frame_of(i, iter), bind_reals, bind_duals);
+		}
+	}
+	double const legacy_time = timer.elapsed() / num_iterations;
+
+	std::vector<std::vector<JointPose>> reference(num_characters, std::vector<JointPose>(num_joints));
+	for (uint32_t i = 0; i < num_characters; ++ i)
+	{
+		for (uint32_t j = 0; j < num_joints; ++ j)
+		{
+			auto const & joint = *characters[i]->GetJoint(j);
+			reference[i][j] = {joint.BindReal(), joint.BindDual(), joint.BindScale()};
+		}
+	}
+
+	timer.restart();
+	for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+	{
+		for (uint32_t i = 0; i < num_characters; ++ i)
+		{
+			characters[i]->SetFrame(frame_of(i, iter));
+		}
+	}
+	double const serial_time = timer.elapsed() / num_iterations;
+
+	float max_error = 0;
+	for (uint32_t i = 0; i < num_characters; ++ i)
+	{
+		max_error = std::max(max_error, MaxError(*characters[i], reference[i]));
+	}
+
+	std::vector<float> frames(num_characters);
+	timer.restart();
+	for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+	{
+		for (uint32_t i = 0; i < num_characters; ++ i)
+		{
+			// Offset by half a frame from the serial run, so no character is skipped as unchanged
+			frames[i] = frame_of(i, iter) + 0.25f;
+		}
+		SkinnedModel::SetFrames(character_ptrs, frames);
+	}
+	double const batch_time = timer.elapsed() / num_iterations;
+
+	cout << num_characters << " characters, " << num_joints << " joints, " << num_keys << " key frames per joint" << endl;
+	cout << "Legacy: " << num_characters / (legacy_time * 1000) << " characters/ms" << endl;
+	cout << "Flat joints: " << num_characters / (serial_time * 1000) << " characters/ms" << endl;
+	cout << "Batch: " << num_characters / (batch_time * 1000) << " characters/ms" << endl;
+	cout << "Speedup: " << legacy_time / batch_time << "x" << endl;
+	cout << "Max error: " << max_error << endl;
+	cout << "Key frames: " << num_joints * num_keys * (sizeof(uint32_t) + sizeof(Quaternion) * 2 + sizeof(float)) << " bytes, compressed "
+		<< characters[0]->GetAnimationClip()->CompressedSize() << " bytes" << endl;
+
+	if (max_error > 1e-3f)
+	{
+		cout << "Flat joint results diverge from the legacy evaluation." << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file TaskSchedulerBenchmark.cpp
+ * @author Minmin Gong
+ *
+ * @section DESCRIPTION
+ *
+ * This source file is part of KlayGE
+ * For the latest info, see http://www.klayge.org
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * You may alternatively use this source under the terms of
+ * the KlayGE Proprietary License (KPL). You can obtained such a license
+ * from http://www.klayge.org/licensing/.
+ */
+
+#include <KlayGE/KlayGE.hpp>
+#include <KFL/TaskScheduler.hpp>
+#include <KFL/Thread.hpp>
+#include <KFL/Timer.hpp>
+
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <vector>
+
+#ifndef KLAYGE_DEBUG
+#define CXXOPTS_NO_RTTI
+#endif
+#include <cxxopts.hpp>
+
+using namespace std;
+using namespace KlayGE;
+
+namespace
+{
+	// A tiny amount of work, so the time is mostly the overhead of the tasks
+	void Work(std::atomic<uint64_t>& sum, uint32_t index)
+	{
+		sum.fetch_add(index, std::memory_order_relaxed);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t num_tasks;
+	uint32_t num_workers;
+	uint32_t num_iterations;
+
+	cxxopts::Options options("TaskSchedulerBenchmark", "KlayGE task scheduler benchmark");
+	// clang-format off
+	options.add_options()
+		("H,help", "Produce help message.")
+		("n,tasks", "Number of tasks.", cxxopts::value<uint32_t>(num_tasks)->default_value("10000"))
+		("w,workers", "Number of workers. (default: One less than the number of CPU threads)",
+			cxxopts::value<uint32_t>(num_workers)->default_value("0"))
+		("i,iterations", "Number of iterations.", cxxopts::value<uint32_t>(num_iterations)->default_value("10"))
+		("v,version", "Version.");
+	// clang-format on
+
+	auto vm = options.parse(argc, argv);
+
+	if (vm.count("help") > 0)
+	{
+		cout << options.help() << endl;
+		return 1;
+	}
+	if (vm.count("version") > 0)
+	{
+		cout << "KlayGE task scheduler benchmark, Version 1.0.0" << endl;
+		return 1;
+	}
+	if ((num_tasks == 0) || (num_iterations == 0))
+	{
+		cout << "Need at least one task and one iteration." << endl;
+		return 1;
+	}
+
+	TaskScheduler task_scheduler(num_workers);
+	ThreadPool thread_pool(task_scheduler.NumWorkers(), task_scheduler.NumWorkers());
+
+	uint64_t const expected_sum = static_cast<uint64_t>(num_tasks) * (num_tasks - 1) / 2 * num_iterations;
+
+	std::atomic<uint64_t> thread_pool_sum(0);
+	Timer timer;
+	for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+	{
+		std::vector<std::future<void>> joiners(num_tasks);
+		for (uint32_t i = 0; i < num_tasks; ++ i)
+		{
+			joiners[i] = thread_pool.QueueThread([&thread_pool_sum, i] { Work(thread_pool_sum, i); });
+		}
+		for (auto& joiner : joiners)
+		{
+			joiner.wait();
+		}
+	}
+	double const thread_pool_time = timer.elapsed();
+
+	std::atomic<uint64_t> run_sum(0);
+	timer.restart();
+	for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+	{
+		TaskGroup group;
+		for (uint32_t i = 0; i < num_tasks; ++ i)
+		{
+			task_scheduler.Run(group, [&run_sum, i] { Work(run_sum, i); });
+		}
+		task_scheduler.Wait(group);
+	}
+	double const run_time = timer.elapsed();
+
+	std::atomic<uint64_t> parallel_for_sum(0);
+	timer.restart();
+	for (uint32_t iter = 0; iter < num_iterations; ++ iter)
+	{
+		task_scheduler.ParallelFor(0U, num_tasks, 1U, [&parallel_for_sum](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; ++ i)
+			{
+				Work(parallel_for_sum, i);
+			}
+		});
+	}
+	double const parallel_for_time = timer.elapsed();
+
+	if ((thread_pool_sum != expected_sum) || (run_sum != expected_sum) || (parallel_for_sum != expected_sum))
+	{
+		cout << "Some tasks didn't run exactly once." << endl;
+		return 1;
+	}
+
+	double const num_total_tasks = static_cast<double>(num_tasks) * num_iterations;
+	cout << num_tasks << " tasks, " << task_scheduler.NumWorkers() << " workers" << endl;
+	cout << "ThreadPool::QueueThread: " << thread_pool_time / num_total_tasks * 1e9 << " ns per task" << endl;
+	cout << "TaskScheduler::Run: " << run_time / num_total_tasks * 1e9 << " ns per task" << endl;
+	cout << "TaskScheduler::ParallelFor: " << parallel_for_time / num_total_tasks * 1e9 << " ns per task" << endl;
+
+	return 0;
+}
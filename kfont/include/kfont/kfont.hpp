@@ -33,9 +33,12 @@
 
 #pragma once
 
+#include <KFL/CXX20/span.hpp>
+#include <KFL/MappedFile.hpp>
+
+#include <string>
+#include <utility>
 #include <vector>
-#include <istream>
-#include <unordered_map>
 
 #ifndef KFONT_SOURCE
 	#define KLAYGE_LIB_NAME kfont
@@ -88,42 +91,86 @@ namespace KlayGE
 	#pragma pack(pop)
 #endif
 
+		// How the distance data of a char is stored
+		enum class DistanceCodec : uint8_t
+		{
+			Raw,
+			Lzma,
+			// Residuals of a plane predictor, compressed by byte oriented LZ77
+			DeltaLz
+		};
+
 	public:
 		KFont();
-		
+
+		// Version 3 files are memory mapped
 		bool Load(std::string const & file_name);
 		bool Load(ResIdentifierPtr const & kfont_input);
-		bool Save(std::string const & file_name);
+		bool Save(std::string const & file_name, DistanceCodec codec = DistanceCodec::DeltaLz);
 
 		uint32_t CharSize() const;
 		int16_t DistBase() const;
 		int16_t DistScale() const;
 
-		std::pair<int32_t, uint32_t> const & CharIndexAdvance(wchar_t ch) const;
+		std::pair<int32_t, uint32_t> CharIndexAdvance(wchar_t ch) const;
 		int32_t CharIndex(wchar_t ch) const;
 		uint32_t CharAdvance(wchar_t ch) const;
 
 		font_info const & CharInfo(int32_t index) const;
+		// Only reads the font, could be called from multiple threads
 		void GetDistanceData(uint8_t* p, uint32_t pitch, int32_t index) const;
-		void GetLZMADistanceData(uint8_t* p, uint32_t& size, int32_t index) const;
 
 		void CharSize(uint32_t size);
 		void DistBase(int16_t base);
 		void DistScale(int16_t scale);
 		void SetDistanceData(wchar_t ch, uint8_t const * p, uint32_t adv, font_info const & fi);
 		void SetLZMADistanceData(wchar_t ch, uint8_t const * p, uint32_t size, uint32_t adv, font_info const & fi);
+		// Orders the distance data the same as the chars
 		void Compact();
 
+	private:
+#ifdef KLAYGE_HAS_STRUCT_PACK
+	#pragma pack(push, 1)
+#endif
+		struct char_index_advance
+		{
+			int32_t ch;
+			int32_t index;
+			uint32_t advance;
+		};
+		static_assert(sizeof(char_index_advance) == 12);
+#ifdef KLAYGE_HAS_STRUCT_PACK
+	#pragma pack(pop)
+#endif
+
+		bool LoadV2(ResIdentifier& kfont_input, kfont_header const & header);
+		bool LoadV3(std::span<uint8_t const> kfont_data);
+		void MakeEditable();
+		void UpdateViews();
+		void AddChar(wchar_t ch, DistanceCodec codec, uint8_t const * p, uint32_t size, uint32_t adv, font_info const & fi);
+		std::span<uint8_t const> DistanceBlock(int32_t index) const;
+		void DecodeDistanceBlock(uint8_t* p, uint32_t pitch, std::span<uint8_t const> block) const;
+		std::vector<uint8_t> EncodeDistanceBlock(uint8_t const * p, DistanceCodec codec) const;
+
 	private:
 		uint32_t char_size_;
 		int16_t dist_base_;
 		int16_t dist_scale_;
-		std::unordered_map<int32_t, std::pair<int32_t, uint32_t>> char_index_advance_;
-		std::vector<font_info> char_info_;
-		std::vector<size_t> distances_addr_{0};
-		std::vector<uint8_t> distances_lzma_;
-		ResIdentifierPtr kfont_input_;
-		int64_t distances_lzma_start_;
+
+		// Point to either the file or the vectors below. The chars are sorted, and each block starts with its codec.
+		std::span<char_index_advance const> chars_;
+		std::span<font_info const> char_info_;
+		std::span<uint64_t const> block_offsets_;
+		std::span<uint8_t const> blocks_;
+
+		std::vector<char_index_advance> chars_storage_;
+		std::vector<font_info> char_info_storage_;
+		std::vector<uint64_t> block_offsets_storage_{0};
+		std::vector<uint8_t> blocks_storage_;
+		bool editable_ = true;
+
+		MappedFile mapped_file_;
+		std::vector<uint8_t> file_data_;
 	};
 }
 
@@ -30,12 +30,15 @@
 
 #include <KFL/KFL.hpp>
 #include <KFL/DllLoader.hpp>
+#include <KFL/ErrorHandling.hpp>
 #include <KFL/ResIdentifier.hpp>
+#include <KFL/CXX20/bit.hpp>
 #include <kfont/kfont.hpp>
 
 #include <fstream>
 #include <cstring>
 #include <algorithm>
+#include <array>
 #include <mutex>
 
 #include <boost/assert.hpp>
@@ -44,7 +47,10 @@
 
 namespace KlayGE
 {
-	uint32_t const KFONT_VERSION = 2;
+	uint32_t const KFONT_VERSION = 3;
+	uint32_t const KFONT_V2_VERSION = 2;
+	// The tables are read in place, so they start at a multiple of 8
+	uint32_t const KFONT_TABLE_START = 32;
 
 	std::mutex singleton_mutex;
 
@@ -116,10 +122,200 @@ namespace KlayGE
 	};
 	std::unique_ptr<LZMALoader> LZMALoader::instance_;
 
+	// Distance fields are close to planes, so a pixel is predicted from the plane through its left, upper, and upper left neighbors
+	uint8_t PredictDistance(uint8_t const * p, uint32_t pitch, uint32_t x, uint32_t y)
+	{
+		if (y == 0)
+		{
+			return (x == 0) ? 0 : p[x - 1];
+		}
+
+		uint8_t const * above = p - pitch;
+		if (x == 0)
+		{
+			return above[x];
+		}
+
+		return static_cast<uint8_t>(std::clamp(p[x - 1] + above[x] - above[x - 1], 0, 255));
+	}
+
+	void WriteLzLength(std::vector<uint8_t>& output, uint32_t length)
+	{
+		while (length >= 255)
+		{
+			output.push_back(255);
+			length -= 255;
+		}
+		output.push_back(static_cast<uint8_t>(length));
+	}
+
+	// Sequences of a token with the literal and match lengths in 4 bits each, extra length bytes, literals, and a 16-bit offset.
+	// The last sequence has only literals.
+	std::vector<uint8_t> LzCompress(std::span<uint8_t const> input)
+	{
+		uint32_t constexpr MIN_MATCH = 4;
+		uint32_t constexpr HASH_BITS = 12;
+		uint32_t constexpr MAX_OFFSET = 0xFFFF;
+
+		auto read32 = [&input](uint32_t pos)
+		{
+			uint32_t ret;
+			std::memcpy(&ret, &input[pos], sizeof(ret));
+			return ret;
+		};
+
+		auto write_sequence = [&input](std::vector<uint8_t>& output, uint32_t literal_begin, uint32_t literal_end, uint32_t offset,
+			uint32_t match_length)
+		{
+			uint32_t const literal_length = literal_end - literal_begin;
+			uint8_t token = static_cast<uint8_t>(std::min(literal_length, 15U) << 4);
+			if (match_length > 0)
+			{
+				token |= static_cast<uint8_t>(std::min(match_length - MIN_MATCH, 15U));
+			}
+			output.push_back(token);
+			if (literal_length >= 15)
+			{
+				WriteLzLength(output, literal_length - 15);
+			}
+			output.insert(output.end(), input.begin() + literal_begin, input.begin() + literal_end);
+			if (match_length > 0)
+			{
+				output.push_back(static_cast<uint8_t>(offset & 0xFF));
+				output.push_back(static_cast<uint8_t>(offset >> 8));
+				if (match_length - MIN_MATCH >= 15)
+				{
+					WriteLzLength(output, match_length - MIN_MATCH - 15);
+				}
+			}
+		};
+
+		uint32_t const input_size = static_cast<uint32_t>(input.size());
+
+		std::vector<uint8_t> output;
+		output.reserve(input_size / 2);
+
+		std::array<uint32_t, 1U << HASH_BITS> hash_table;
+		hash_table.fill(~0U);
+
+		uint32_t anchor = 0;
+		uint32_t pos = 0;
+		while (pos + MIN_MATCH <= input_size)
+		{
+			uint32_t const seq = read32(pos);
+			uint32_t const hash = (seq * 2654435761U) >> (32 - HASH_BITS);
+			uint32_t const candidate = hash_table[hash];
+			hash_table[hash] = pos;
+
+			if ((candidate != ~0U) && (pos - candidate <= MAX_OFFSET) && (read32(candidate) == seq))
+			{
+				uint32_t match_length = MIN_MATCH;
+				while ((pos + match_length < input_size) && (input[candidate + match_length] == input[pos + match_length]))
+				{
+					++ match_length;
+				}
+
+				write_sequence(output, anchor, pos, pos - candidate, match_length);
+				pos += match_length;
+				anchor = pos;
+			}
+			else
+			{
+				++ pos;
+			}
+		}
+		write_sequence(output, anchor, input_size, 0, 0);
+
+		return output;
+	}
+
+	bool LzDecompress(std::span<uint8_t> output, std::span<uint8_t const> input)
+	{
+		uint32_t constexpr MIN_MATCH = 4;
+
+		uint8_t const * src = input.data();
+		uint8_t const * const src_end = src + input.size();
+		uint8_t* dst = output.data();
+		uint8_t* const dst_end = dst + output.size();
+
+		auto read_length = [&src, src_end](uint32_t length)
+		{
+			if (length == 15)
+			{
+				uint8_t byte;
+				do
+				{
+					if (src == src_end)
+					{
+						return ~0U;
+					}
+					byte = *src;
+					++ src;
+					length += byte;
+				} while (byte == 255);
+			}
+			return length;
+		};
+
+		while (src < src_end)
+		{
+			uint8_t const token = *src;
+			++ src;
+
+			uint32_t const literal_length = read_length(token >> 4);
+			if ((literal_length > static_cast<uint32_t>(src_end - src)) || (literal_length > static_cast<uint32_t>(dst_end - dst)))
+			{
+				return false;
+			}
+			std::memcpy(dst, src, literal_length);
+			src += literal_length;
+			dst += literal_length;
+
+			if (src == src_end)
+			{
+				break;
+			}
+
+			if (src_end - src < 2)
+			{
+				return false;
+			}
+			uint32_t const offset = src[0] | (src[1] << 8);
+			src += 2;
+
+			uint32_t const match_length = read_length(token & 0xF);
+			if ((match_length == ~0U) || (offset == 0) || (offset > static_cast<uint32_t>(dst - output.data()))
+				|| (match_length + MIN_MATCH > static_cast<uint32_t>(dst_end - dst)))
+			{
+				return false;
+			}
+			// The match could overlap with itself
+			uint8_t const * match = dst - offset;
+			for (uint32_t i = 0; i < match_length + MIN_MATCH; ++ i)
+			{
+				dst[i] = match[i];
+			}
+			dst += match_length + MIN_MATCH;
+		}
+
+		return dst == dst_end;
+	}
+
 	KFont::KFont() = default;
 
 	bool KFont::Load(std::string const & file_name)
 	{
+		mapped_file_.Unmap();
+		if (mapped_file_.Map(file_name))
+		{
+			if (this->LoadV3(mapped_file_.Data()))
+			{
+				return true;
+			}
+			mapped_file_.Unmap();
+		}
+
+		// Older versions are read through a stream
 		ResIdentifierPtr kfont_input = MakeSharedPtr<ResIdentifier>(file_name, 0,
 			MakeSharedPtr<std::ifstream>(file_name.c_str(), std::ios_base::binary | std::ios_base::in));
 		return this->Load(kfont_input);
@@ -129,8 +325,6 @@ namespace KlayGE
 	{
 		if (kfont_input)
 		{
-			kfont_input_ = kfont_input;
-
 			kfont_header header;
 			kfont_input->read(&header, sizeof(header));
 			header.fourcc = LE2Native(header.fourcc);
@@ -141,157 +335,263 @@ namespace KlayGE
 			header.char_size = LE2Native(header.char_size);
 			header.base = LE2Native(header.base);
 			header.scale = LE2Native(header.scale);
-			if ((MakeFourCC<'K', 'F', 'N', 'T'>::value == header.fourcc) && (KFONT_VERSION == header.version))
+			if (MakeFourCC<'K', 'F', 'N', 'T'>::value == header.fourcc)
 			{
-				char_size_ = header.char_size;
-				dist_base_ = header.base;
-				dist_scale_ = header.scale;
+				if (KFONT_VERSION == header.version)
+				{
+					kfont_input->seekg(0, std::ios_base::end);
+					size_t const file_size = static_cast<size_t>(kfont_input->tellg());
+					kfont_input->seekg(0, std::ios_base::beg);
+
+					mapped_file_.Unmap();
+					file_data_.resize(file_size);
+					kfont_input->read(file_data_.data(), file_size);
+					return this->LoadV3(file_data_);
+				}
+				else if (KFONT_V2_VERSION == header.version)
+				{
+					return this->LoadV2(*kfont_input, header);
+				}
+			}
+		}
 
-				kfont_input->seekg(header.start_ptr, std::ios_base::beg);
+		return false;
+	}
 
-				std::vector<std::pair<int32_t, int32_t>> temp_char_index(header.non_empty_chars);
-				kfont_input->read(&temp_char_index[0], temp_char_index.size() * sizeof(temp_char_index[0]));
-				std::vector<std::pair<int32_t, uint32_t>> temp_char_advance(header.validate_chars);
-				kfont_input->read(&temp_char_advance[0], temp_char_advance.size() * sizeof(temp_char_advance[0]));
+	bool KFont::LoadV2(ResIdentifier& kfont_input, kfont_header const & header)
+	{
+		char_size_ = header.char_size;
+		dist_base_ = header.base;
+		dist_scale_ = header.scale;
 
-				for (auto& ci : temp_char_index)
-				{
-					ci.first = LE2Native(ci.first);
-					ci.second = LE2Native(ci.second);
+		kfont_input.seekg(header.start_ptr, std::ios_base::beg);
 
-					char_index_advance_.emplace(ci.first, std::make_pair(ci.second, 0));
-				}
-				for (auto& ca : temp_char_advance)
-				{
-					ca.first = LE2Native(ca.first);
-					ca.second = LE2Native(ca.second);
+		std::vector<std::pair<int32_t, int32_t>> temp_char_index(header.non_empty_chars);
+		kfont_input.read(temp_char_index.data(), temp_char_index.size() * sizeof(temp_char_index[0]));
+		std::vector<std::pair<int32_t, uint32_t>> temp_char_advance(header.validate_chars);
+		kfont_input.read(temp_char_advance.data(), temp_char_advance.size() * sizeof(temp_char_advance[0]));
 
-					auto iter = char_index_advance_.find(ca.first);
-					if (iter != char_index_advance_.end())
-					{
-						iter->second.second = ca.second;
-					}
-					else
-					{
-						char_index_advance_[ca.first] = std::make_pair(-1, ca.second);
-					}
-				}
+		chars_storage_.clear();
+		for (auto const & ca : temp_char_advance)
+		{
+			chars_storage_.push_back({LE2Native(ca.first), -1, LE2Native(ca.second)});
+		}
+		std::sort(chars_storage_.begin(), chars_storage_.end(),
+			[](char_index_advance const & lhs, char_index_advance const & rhs) { return lhs.ch < rhs.ch; });
+		for (auto const & ci : temp_char_index)
+		{
+			int32_t const ch = LE2Native(ci.first);
+			auto iter = std::lower_bound(chars_storage_.begin(), chars_storage_.end(), ch,
+				[](char_index_advance const & cia, int32_t value) { return cia.ch < value; });
+			if ((iter == chars_storage_.end()) || (iter->ch != ch))
+			{
+				iter = chars_storage_.insert(iter, {ch, -1, 0});
+			}
+			iter->index = LE2Native(ci.second);
+		}
 
-				char_info_.resize(header.non_empty_chars);
-				kfont_input->read(&char_info_[0], char_info_.size() * sizeof(char_info_[0]));
+		char_info_storage_.resize(header.non_empty_chars);
+		kfont_input.read(char_info_storage_.data(), char_info_storage_.size() * sizeof(char_info_storage_[0]));
+		for (auto& ci : char_info_storage_)
+		{
+			ci.left = LE2Native(ci.left);
+			ci.top = LE2Native(ci.top);
+			ci.width = LE2Native(ci.width);
+			ci.height = LE2Native(ci.height);
+		}
 
-				for (auto& ci : char_info_)
-				{
-					ci.left = LE2Native(ci.left);
-					ci.top = LE2Native(ci.top);
-					ci.width = LE2Native(ci.width);
-					ci.height = LE2Native(ci.height);
-				}
+		// Version 2 has only LZMA blocks, and no way to locate them without walking through all of them
+		block_offsets_storage_.assign(1, 0);
+		blocks_storage_.clear();
+		for (uint32_t i = 0; i < header.non_empty_chars; ++ i)
+		{
+			uint64_t len;
+			kfont_input.read(&len, sizeof(len));
+			len = LE2Native(len);
+
+			blocks_storage_.push_back(static_cast<uint8_t>(DistanceCodec::Lzma));
+			size_t const offset = blocks_storage_.size();
+			blocks_storage_.resize(offset + static_cast<size_t>(len));
+			kfont_input.read(&blocks_storage_[offset], static_cast<size_t>(len));
+			block_offsets_storage_.push_back(blocks_storage_.size());
+		}
 
-				distances_addr_.resize(header.non_empty_chars + 1);
-				distances_lzma_start_ = kfont_input->tellg();
-				size_t distances_lzma_size = 0;
+		mapped_file_.Unmap();
+		file_data_.clear();
+		editable_ = true;
+		this->UpdateViews();
 
-				for (uint32_t i = 0; i < header.non_empty_chars; ++ i)
-				{
-					distances_addr_[i] = distances_lzma_size;
+		return static_cast<bool>(kfont_input);
+	}
 
-					uint64_t len;
-					kfont_input->read(&len, sizeof(len));
-					len = LE2Native(len);
-					distances_lzma_size += static_cast<size_t>(len);
+	bool KFont::LoadV3(std::span<uint8_t const> kfont_data)
+	{
+		if (kfont_data.size() < KFONT_TABLE_START)
+		{
+			return false;
+		}
 
-					kfont_input->seekg(len, std::ios_base::cur);
-				}
+		kfont_header header;
+		std::memcpy(&header, kfont_data.data(), sizeof(header));
+		header.fourcc = LE2Native(header.fourcc);
+		header.version = LE2Native(header.version);
+		header.start_ptr = LE2Native(header.start_ptr);
+		header.validate_chars = LE2Native(header.validate_chars);
+		header.non_empty_chars = LE2Native(header.non_empty_chars);
+		header.char_size = LE2Native(header.char_size);
+		header.base = LE2Native(header.base);
+		header.scale = LE2Native(header.scale);
+		if ((MakeFourCC<'K', 'F', 'N', 'T'>::value != header.fourcc) || (KFONT_VERSION != header.version)
+			|| (header.start_ptr % sizeof(uint64_t) != 0))
+		{
+			return false;
+		}
 
-				distances_addr_[header.non_empty_chars] = distances_lzma_size;
+		size_t const offsets_size = (header.non_empty_chars + 1ULL) * sizeof(uint64_t);
+		size_t const chars_size = header.validate_chars * sizeof(char_index_advance);
+		size_t const info_size = header.non_empty_chars * sizeof(font_info);
+		size_t const blocks_start = header.start_ptr + offsets_size + chars_size + info_size;
+		if (blocks_start > kfont_data.size())
+		{
+			return false;
+		}
 
-				return true;
+		uint8_t const * p = kfont_data.data() + header.start_ptr;
+		std::span<uint64_t const> const block_offsets(reinterpret_cast<uint64_t const *>(p), header.non_empty_chars + 1);
+		p += offsets_size;
+		std::span<char_index_advance const> const chars(reinterpret_cast<char_index_advance const *>(p), header.validate_chars);
+		p += chars_size;
+		std::span<font_info const> const char_info(reinterpret_cast<font_info const *>(p), header.non_empty_chars);
+		std::span<uint8_t const> const blocks = kfont_data.subspan(blocks_start);
+
+		// Blocks are looked up without checks later, so everything that points into them is checked here. Every block has at
+		// least the codec byte.
+		if (LE2Native(block_offsets[0]) != 0)
+		{
+			return false;
+		}
+		for (size_t i = 1; i < block_offsets.size(); ++ i)
+		{
+			if (LE2Native(block_offsets[i]) <= LE2Native(block_offsets[i - 1]))
+			{
+				return false;
+			}
+		}
+		if (LE2Native(block_offsets.back()) > blocks.size())
+		{
+			return false;
+		}
+		for (auto const & cia : chars)
+		{
+			int32_t const index = LE2Native(cia.index);
+			if ((index < -1) || (index >= static_cast<int32_t>(header.non_empty_chars)))
+			{
+				return false;
 			}
 		}
 
-		return false;
+		char_size_ = header.char_size;
+		dist_base_ = header.base;
+		dist_scale_ = header.scale;
+
+		if constexpr (std::endian::native == std::endian::little)
+		{
+			chars_ = chars;
+			char_info_ = char_info;
+			block_offsets_ = block_offsets;
+			blocks_ = blocks;
+
+			chars_storage_.clear();
+			char_info_storage_.clear();
+			block_offsets_storage_.clear();
+			blocks_storage_.clear();
+			editable_ = false;
+		}
+		else
+		{
+			chars_storage_.assign(chars.begin(), chars.end());
+			for (auto& cia : chars_storage_)
+			{
+				cia.ch = LE2Native(cia.ch);
+				cia.index = LE2Native(cia.index);
+				cia.advance = LE2Native(cia.advance);
+			}
+			char_info_storage_.assign(char_info.begin(), char_info.end());
+			for (auto& ci : char_info_storage_)
+			{
+				ci.left = LE2Native(ci.left);
+				ci.top = LE2Native(ci.top);
+				ci.width = LE2Native(ci.width);
+				ci.height = LE2Native(ci.height);
+			}
+			block_offsets_storage_.assign(block_offsets.begin(), block_offsets.end());
+			for (auto& offset : block_offsets_storage_)
+			{
+				offset = LE2Native(offset);
+			}
+			blocks_storage_.assign(blocks.begin(), blocks.end());
+
+			editable_ = true;
+			this->UpdateViews();
+		}
+
+		return true;
 	}
 
-	bool KFont::Save(std::string const & file_name)
+	bool KFont::Save(std::string const & file_name, DistanceCodec codec)
 	{
+		// Releases the mapped file before it could be overwritten
+		this->Compact();
+
 		std::ofstream kfont_output(file_name.c_str(), std::ios_base::binary | std::ios_base::out);
 		if (kfont_output)
 		{
-			this->Compact();
+			std::vector<uint64_t> new_block_offsets(1, 0);
+			std::vector<uint8_t> new_blocks;
+			std::vector<uint8_t> decoded(char_size_ * char_size_);
+			for (size_t i = 0; i < char_info_.size(); ++ i)
+			{
+				auto const block = this->DistanceBlock(static_cast<int32_t>(i));
+				if (static_cast<DistanceCodec>(block[0]) == codec)
+				{
+					new_blocks.insert(new_blocks.end(), block.begin(), block.end());
+				}
+				else
+				{
+					this->DecodeDistanceBlock(decoded.data(), char_size_, block);
+					auto const encoded = this->EncodeDistanceBlock(decoded.data(), codec);
+					new_blocks.insert(new_blocks.end(), encoded.begin(), encoded.end());
+				}
+				new_block_offsets.push_back(Native2LE(static_cast<uint64_t>(new_blocks.size())));
+			}
 
 			kfont_header header;
 			header.fourcc = Native2LE(MakeFourCC<'K', 'F', 'N', 'T'>::value);
 			header.version = Native2LE(KFONT_VERSION);
-			header.start_ptr = Native2LE(static_cast<uint32_t>(sizeof(header)));
-			header.validate_chars = Native2LE(static_cast<uint32_t>(char_index_advance_.size()));
+			header.start_ptr = Native2LE(KFONT_TABLE_START);
+			header.validate_chars = Native2LE(static_cast<uint32_t>(chars_.size()));
 			header.non_empty_chars = Native2LE(static_cast<uint32_t>(char_info_.size()));
 			header.char_size = Native2LE(char_size_);
 			header.base = Native2LE(dist_base_);
 			header.scale = Native2LE(dist_scale_);
 
 			kfont_output.write(reinterpret_cast<char*>(&header), sizeof(header));
+			char const padding[KFONT_TABLE_START - sizeof(header)]{};
+			kfont_output.write(padding, sizeof(padding));
 
-			std::vector<int32_t> chars;
-			for (auto const & cia : char_index_advance_)
+			kfont_output.write(reinterpret_cast<char*>(new_block_offsets.data()),
+				static_cast<std::streamsize>(new_block_offsets.size() * sizeof(new_block_offsets[0])));
+			for (auto const & cia : chars_)
 			{
-				chars.push_back(cia.first);
+				char_index_advance const tcia{Native2LE(cia.ch), Native2LE(cia.index), Native2LE(cia.advance)};
+				kfont_output.write(reinterpret_cast<char const *>(&tcia), sizeof(tcia));
 			}
-			std::sort(chars.begin(), chars.end());
-
-			std::vector<std::pair<int32_t, int32_t>> temp_char_index;
-			std::vector<std::pair<int32_t, uint32_t>> temp_char_advance;
-			for (auto const & ch : chars)
-			{
-				std::pair<int32_t, uint32_t> const & ci = char_index_advance_[ch];
-
-				if (ci.first != -1)
-				{
-					temp_char_index.push_back(std::make_pair(ch, ci.first));
-				}
-				temp_char_advance.push_back(std::make_pair(ch, ci.second));
-			}
-			BOOST_ASSERT(temp_char_index.size() == char_info_.size());
-			BOOST_ASSERT(temp_char_advance.size() == char_index_advance_.size());
-
-			for (auto const & ci : temp_char_index)
-			{
-				auto tci = std::make_pair(Native2LE(ci.first), Native2LE(ci.second));
-				kfont_output.write(reinterpret_cast<char*>(&tci), sizeof(tci));
-			}
-			for (auto const & ca : temp_char_advance)
-			{
-				auto tca = std::make_pair(Native2LE(ca.first), Native2LE(ca.second));
-				kfont_output.write(reinterpret_cast<char*>(&tca), sizeof(tca));
-			}
-
-			for (auto const & ci : temp_char_index)
-			{
-				uint32_t const index = static_cast<uint32_t>(ci.second);
-
-				int16_t itmp;
-				itmp = Native2LE(char_info_[index].top);
-				kfont_output.write(reinterpret_cast<char*>(&itmp), sizeof(itmp));
-				itmp = Native2LE(char_info_[index].left);
-				kfont_output.write(reinterpret_cast<char*>(&itmp), sizeof(itmp));
-				uint16_t utmp;
-				utmp = Native2LE(char_info_[index].width);
-				kfont_output.write(reinterpret_cast<char*>(&utmp), sizeof(utmp));
-				utmp = Native2LE(char_info_[index].height);
-				kfont_output.write(reinterpret_cast<char*>(&utmp), sizeof(utmp));
-			}
-
-			for (auto const & ci : temp_char_index)
+			for (auto const & ci : char_info_)
 			{
-				uint32_t const index = static_cast<uint32_t>(ci.second);
-
-				size_t const addr = distances_addr_[index];
-				uint64_t const len = distances_addr_[index + 1] - addr;
-				uint64_t len_le = Native2LE(len);
-				kfont_output.write(reinterpret_cast<char*>(&len_le), sizeof(len_le));
-				kfont_output.write(reinterpret_cast<char*>(&distances_lzma_[addr]),
-					static_cast<std::streamsize>(len * sizeof(distances_lzma_[0])));
+				font_info const tci{Native2LE(ci.top), Native2LE(ci.left), Native2LE(ci.width), Native2LE(ci.height)};
+				kfont_output.write(reinterpret_cast<char const *>(&tci), sizeof(tci));
 			}
+			kfont_output.write(reinterpret_cast<char*>(new_blocks.data()), static_cast<std::streamsize>(new_blocks.size()));
 
 			return true;
 		}
@@ -314,17 +614,18 @@ namespace KlayGE
 		return dist_scale_;
 	}
 
-	std::pair<int32_t, uint32_t> const & KFont::CharIndexAdvance(wchar_t ch) const
+	std::pair<int32_t, uint32_t> KFont::CharIndexAdvance(wchar_t ch) const
 	{
-		auto iter = char_index_advance_.find(ch);
-		if (iter != char_index_advance_.end())
+		int32_t const key = static_cast<int32_t>(ch);
+		auto iter = std::lower_bound(chars_.begin(), chars_.end(), key,
+			[](char_index_advance const & cia, int32_t value) { return cia.ch < value; });
+		if ((iter != chars_.end()) && (iter->ch == key))
 		{
-			return iter->second;
+			return std::make_pair(iter->index, iter->advance);
 		}
 		else
 		{
-			static std::pair<int32_t, uint32_t> ret(-1, 0);
-			return ret;
+			return std::make_pair(-1, 0U);
 		}
 	}
 
@@ -344,47 +645,149 @@ namespace KlayGE
 	}
 
 	void KFont::GetDistanceData(uint8_t* p, uint32_t pitch, int32_t index) const
+	{
+		this->DecodeDistanceBlock(p, pitch, this->DistanceBlock(index));
+	}
+
+	std::span<uint8_t const> KFont::DistanceBlock(int32_t index) const
+	{
+		uint64_t const offset = block_offsets_[index];
+		return blocks_.subspan(static_cast<size_t>(offset), static_cast<size_t>(block_offsets_[index + 1] - offset));
+	}
+
+	void KFont::DecodeDistanceBlock(uint8_t* p, uint32_t pitch, std::span<uint8_t const> block) const
 	{
 		size_t const decoded_size = char_size_ * char_size_;
-		auto decoded = MakeUniquePtr<uint8_t[]>(decoded_size);
+		auto const payload = block.subspan(1);
+
+		switch (static_cast<DistanceCodec>(block[0]))
+		{
+		case DistanceCodec::Raw:
+			if (payload.size() != decoded_size)
+			{
+				TERRC(std::errc::illegal_byte_sequence);
+			}
+			for (uint32_t y = 0; y < char_size_; ++ y)
+			{
+				std::memcpy(p + y * pitch, &payload[y * char_size_], char_size_);
+			}
+			break;
+
+		case DistanceCodec::Lzma:
+			{
+				if (payload.size() < LZMA_PROPS_SIZE)
+				{
+					TERRC(std::errc::illegal_byte_sequence);
+				}
 
-		uint32_t size;
-		this->GetLZMADistanceData(nullptr, size, index);
+				auto decoded = MakeUniquePtr<uint8_t[]>(decoded_size);
+
+				SizeT s_out_len = decoded_size;
+				SizeT s_src_len = static_cast<SizeT>(payload.size() - LZMA_PROPS_SIZE);
+				if ((LZMALoader::Instance().LzmaUncompress(static_cast<Byte*>(&decoded[0]), &s_out_len, &payload[LZMA_PROPS_SIZE],
+						&s_src_len, payload.data(), LZMA_PROPS_SIZE) != SZ_OK)
+					|| (s_out_len != decoded_size))
+				{
+					TERRC(std::errc::illegal_byte_sequence);
+				}
 
-		auto in_data = MakeUniquePtr<uint8_t[]>(size);
-		this->GetLZMADistanceData(&in_data[0], size, index);
+				for (uint32_t y = 0; y < char_size_; ++ y)
+				{
+					std::memcpy(p + y * pitch, &decoded[y * char_size_], char_size_);
+				}
+			}
+			break;
 
-		SizeT s_out_len = decoded_size;
+		case DistanceCodec::DeltaLz:
+			{
+				auto residuals = MakeUniquePtr<uint8_t[]>(decoded_size);
+				if (!LzDecompress(std::span(residuals.get(), decoded_size), payload))
+				{
+					TERRC(std::errc::illegal_byte_sequence);
+				}
 
-		SizeT s_src_len = static_cast<SizeT>(size - LZMA_PROPS_SIZE);
-		LZMALoader::Instance().LzmaUncompress(static_cast<Byte*>(&decoded[0]), &s_out_len, &in_data[LZMA_PROPS_SIZE], &s_src_len,
-			&in_data[0], LZMA_PROPS_SIZE);
+				// Same as PredictDistance, with the borders taken out of the inner loop
+				uint8_t const * residual = residuals.get();
+				uint8_t left = 0;
+				for (uint32_t x = 0; x < char_size_; ++ x)
+				{
+					left = static_cast<uint8_t>(left + residual[x]);
+					p[x] = left;
+				}
+				residual += char_size_;
+				for (uint32_t y = 1; y < char_size_; ++ y, residual += char_size_)
+				{
+					uint8_t const * above = p;
+					p += pitch;
 
-		uint8_t const * char_data = &decoded[0];
-		for (uint32_t y = 0; y < char_size_; ++ y)
-		{
-			std::memcpy(p, char_data, char_size_);
-			p += pitch;
-			char_data += char_size_;
+					int a = static_cast<uint8_t>(residual[0] + above[0]);
+					p[0] = static_cast<uint8_t>(a);
+					for (uint32_t x = 1; x < char_size_; ++ x)
+					{
+						a = static_cast<uint8_t>(residual[x] + std::clamp(a + above[x] - above[x - 1], 0, 255));
+						p[x] = static_cast<uint8_t>(a);
+					}
+				}
+			}
+			break;
+
+		default:
+			TERRC(std::errc::illegal_byte_sequence);
 		}
 	}
 
-	void KFont::GetLZMADistanceData(uint8_t* p, uint32_t& size, int32_t index) const
+	std::vector<uint8_t> KFont::EncodeDistanceBlock(uint8_t const * p, DistanceCodec codec) const
 	{
-		size = static_cast<uint32_t>(distances_addr_[index + 1] - distances_addr_[index]);
-		if (p != nullptr)
+		uint32_t const len = char_size_ * char_size_;
+
+		std::vector<uint8_t> ret(1, static_cast<uint8_t>(codec));
+		switch (codec)
 		{
-			if (kfont_input_)
+		case DistanceCodec::Raw:
+			ret.insert(ret.end(), p, p + len);
+			break;
+
+		case DistanceCodec::Lzma:
 			{
-				kfont_input_->seekg(distances_lzma_start_ + (index + 1) * sizeof(uint64_t) + distances_addr_[index],
-					std::ios_base::beg);
-				kfont_input_->read(p, size);
+				SizeT out_len = static_cast<SizeT>(std::max(len * 11 / 10, 32U));
+				ret.resize(1 + LZMA_PROPS_SIZE + out_len);
+				SizeT out_props_size = LZMA_PROPS_SIZE;
+				LZMALoader::Instance().LzmaCompress(&ret[1 + LZMA_PROPS_SIZE], &out_len, static_cast<Byte const *>(p),
+					static_cast<SizeT>(len), &ret[1], &out_props_size, 5, std::min<uint32_t>(len, 1UL << 24), 3, 0, 2, 32, 1);
+				ret.resize(1 + LZMA_PROPS_SIZE + out_len);
 			}
-			else
+			break;
+
+		case DistanceCodec::DeltaLz:
 			{
-				memcpy(p, &distances_lzma_[distances_addr_[index]], size);
+				std::vector<uint8_t> residuals(len);
+				for (uint32_t y = 0; y < char_size_; ++ y)
+				{
+					uint8_t const * row = p + y * char_size_;
+					for (uint32_t x = 0; x < char_size_; ++ x)
+					{
+						residuals[y * char_size_ + x] = static_cast<uint8_t>(row[x] - PredictDistance(row, char_size_, x, y));
+					}
+				}
+
+				auto const compressed = LzCompress(residuals);
+				if (compressed.size() < len)
+				{
+					ret.insert(ret.end(), compressed.begin(), compressed.end());
+				}
+				else
+				{
+					ret[0] = static_cast<uint8_t>(DistanceCodec::Raw);
+					ret.insert(ret.end(), p, p + len);
+				}
 			}
+			break;
+
+		default:
+			KFL_UNREACHABLE("Invalid distance codec");
 		}
+
+		return ret;
 	}
 
 	void KFont::CharSize(uint32_t size)
@@ -404,82 +807,101 @@ namespace KlayGE
 
 	void KFont::SetDistanceData(wchar_t ch, uint8_t const * p, uint32_t adv, font_info const & fi)
 	{
-		uint64_t len = char_size_ * char_size_;
-		SizeT out_len = static_cast<SizeT>(std::max(len * 11 / 10, static_cast<uint64_t>(32)));
-		std::vector<uint8_t> output(LZMA_PROPS_SIZE + out_len);
-		SizeT out_props_size = LZMA_PROPS_SIZE;
-		LZMALoader::Instance().LzmaCompress(&output[LZMA_PROPS_SIZE], &out_len, static_cast<Byte const *>(p), static_cast<SizeT>(len),
-			&output[0], &out_props_size, 5, std::min<uint32_t>(static_cast<uint32_t>(len), 1UL << 24), 3, 0, 2, 32, 1);
-
-		output.resize(LZMA_PROPS_SIZE + out_len);
-
-		this->SetLZMADistanceData(ch, &output[0], static_cast<uint32_t>(output.size()), adv, fi);
+		this->AddChar(ch, DistanceCodec::Raw, p, char_size_ * char_size_, adv, fi);
 	}
 
 	void KFont::SetLZMADistanceData(wchar_t ch, uint8_t const * p, uint32_t size, uint32_t adv, font_info const & fi)
 	{
+		this->AddChar(ch, DistanceCodec::Lzma, p, size, adv, fi);
+	}
+
+	void KFont::AddChar(wchar_t ch, DistanceCodec codec, uint8_t const * p, uint32_t size, uint32_t adv, font_info const & fi)
+	{
+		this->MakeEditable();
+
+		int32_t const key = static_cast<int32_t>(ch);
+		auto iter = std::lower_bound(chars_storage_.begin(), chars_storage_.end(), key,
+			[](char_index_advance const & cia, int32_t value) { return cia.ch < value; });
+		if ((iter != chars_storage_.end()) && (iter->ch == key))
+		{
+			return;
+		}
+
 		int32_t ci;
 		if (size > 0)
 		{
-			ci = static_cast<int32_t>(distances_addr_.size() - 1);
-			uint32_t offset = static_cast<uint32_t>(distances_lzma_.size());
-			distances_addr_.back() = offset;
-			distances_addr_.push_back(offset + size);
-			distances_lzma_.insert(distances_lzma_.end(), p, p + size);
+			ci = static_cast<int32_t>(char_info_storage_.size());
+			blocks_storage_.push_back(static_cast<uint8_t>(codec));
+			blocks_storage_.insert(blocks_storage_.end(), p, p + size);
+			block_offsets_storage_.push_back(blocks_storage_.size());
 
-			char_info_.push_back(fi);
+			char_info_storage_.push_back(fi);
 
-			BOOST_ASSERT(distances_addr_.size() - 1 == char_info_.size());
-			BOOST_ASSERT(distances_addr_.back() == distances_lzma_.size());
+			BOOST_ASSERT(block_offsets_storage_.size() - 1 == char_info_storage_.size());
 		}
 		else
 		{
 			ci = -1;
 		}
-		char_index_advance_.emplace(ch, std::make_pair(ci, adv));
+		chars_storage_.insert(iter, {key, ci, adv});
+
+		this->UpdateViews();
 	}
 
 	void KFont::Compact()
 	{
-		std::vector<int32_t> chars;
-		for (auto const & cia : char_index_advance_)
-		{
-			chars.push_back(cia.first);
-		}
-		std::sort(chars.begin(), chars.end());
+		this->MakeEditable();
 
-		std::unordered_map<int32_t, std::pair<int32_t, uint32_t>> new_char_index_advance;
+		// Chars are always sorted. Reorders the blocks to follow them.
 		std::vector<font_info> new_char_info;
-		std::vector<size_t> new_distances_addr;
-		std::vector<uint8_t> new_distances_lzma;
-		for (auto const & ch : chars)
+		std::vector<uint64_t> new_block_offsets(1, 0);
+		std::vector<uint8_t> new_blocks;
+		new_char_info.reserve(char_info_storage_.size());
+		new_block_offsets.reserve(block_offsets_storage_.size());
+		new_blocks.reserve(blocks_storage_.size());
+		for (auto& cia : chars_storage_)
 		{
-			std::pair<int32_t, uint32_t> const & ci = char_index_advance_[ch];
-			int32_t new_ci;
-			if (ci.first != -1)
+			if (cia.index != -1)
 			{
-				new_ci = static_cast<int32_t>(new_char_info.size());
-
-				uint32_t old_offset = ci.first;
-				new_char_info.push_back(char_info_[old_offset]);
-				new_distances_addr.push_back(new_distances_lzma.size());
+				int32_t const old_index = cia.index;
+				cia.index = static_cast<int32_t>(new_char_info.size());
 
-				size_t addr = distances_addr_[old_offset];
-				size_t len = distances_addr_[old_offset + 1] - distances_addr_[old_offset];
-				uint8_t const * p = &distances_lzma_[addr];
-				new_distances_lzma.insert(new_distances_lzma.end(), p, p + len);
-			}
-			else
-			{
-				new_ci = -1;
+				new_char_info.push_back(char_info_storage_[old_index]);
+				auto const block = this->DistanceBlock(old_index);
+				new_blocks.insert(new_blocks.end(), block.begin(), block.end());
+				new_block_offsets.push_back(new_blocks.size());
 			}
-			new_char_index_advance.emplace(ch, std::make_pair(new_ci, ci.second));
 		}
-		new_distances_addr.push_back(new_distances_lzma.size());
 
-		char_index_advance_ = new_char_index_advance;
-		char_info_ = new_char_info;
-		distances_addr_ = new_distances_addr;
-		distances_lzma_ = new_distances_lzma;
+		char_info_storage_ = std::move(new_char_info);
+		block_offsets_storage_ = std::move(new_block_offsets);
+		blocks_storage_ = std::move(new_blocks);
+		this->UpdateViews();
+	}
+
+	void KFont::MakeEditable()
+	{
+		if (!editable_)
+		{
+			chars_storage_.assign(chars_.begin(), chars_.end());
+			char_info_storage_.assign(char_info_.begin(), char_info_.end());
+			block_offsets_storage_.assign(block_offsets_.begin(), block_offsets_.end());
+			blocks_storage_.assign(blocks_.begin(), blocks_.end());
+			editable_ = true;
+
+			mapped_file_.Unmap();
+			file_data_.clear();
+			file_data_.shrink_to_fit();
+
+			this->UpdateViews();
+		}
+	}
+
+	void KFont::UpdateViews()
+	{
+		chars_ = chars_storage_;
+		char_info_ = char_info_storage_;
+		block_offsets_ = block_offsets_storage_;
+		blocks_ = blocks_storage_;
 	}
 }